@@ -26,6 +26,7 @@ cbuffer ObjectCBuffer : register(b1)
     float CustomAlphaDiscard;
     uint OriginalInstanceCount;
     uint RenderingObjectFlags;
+    uint IndirectInstanceOffset; // first instance of the object in the GPU culler's (shared) instance buffer
 };
 
 struct QUAD_VS_IN
@@ -140,7 +140,7 @@ VS_OUTPUT VSMain_instancing(VS_INPUT_INSTANCING IN)
     VS_OUTPUT OUT = (VS_OUTPUT) 0;
 
     float4x4 WorldM = (RenderingObjectFlags & RENDERING_OBJECT_FLAG_GPU_INDIRECT_DRAW) ?
-        transpose(IndirectInstanceData[(int)OriginalInstanceCount * CurrentLod + IN.InstanceID].WorldMat) : IN.InstanceWorld;
+        transpose(IndirectInstanceData[(int)IndirectInstanceOffset + (int)OriginalInstanceCount * CurrentLod + IN.InstanceID].WorldMat) : IN.InstanceWorld;
 
     OUT.WorldPos = mul(IN.Position, WorldM).xyz;
     OUT.Position = mul(float4(OUT.WorldPos, 1.0f), ViewProjection);
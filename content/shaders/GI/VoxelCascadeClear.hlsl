@@ -0,0 +1,41 @@
+// Clears the update boxes of a voxel cascade before they are voxelized again (the rest of the cascade keeps its voxels).
+// Voxels are addressed toroidally: a voxel is stored at its world coordinate modulo the cascade resolution.
+// The dispatch covers the bounding box of all update boxes.
+
+#define VCT_MAX_UPDATE_BOXES 8 // should match with Common.h
+
+cbuffer VoxelCascadeClearCB : register(b0)
+{
+    float4 UpdateBoxesMin[VCT_MAX_UPDATE_BOXES]; // in voxels, relative to the cascade
+    float4 UpdateBoxesMax[VCT_MAX_UPDATE_BOXES];
+    float4 VoxelWindowOrigin; // xyz - first voxel of the cascade in world voxel coordinates, w - update boxes count
+    float4 DispatchOrigin; // xyz - min of the bounding box of the update boxes
+};
+
+RWTexture3D<float4> VoxelTexture : register(u0);
+
+[numthreads(4, 4, 4)]
+void CSMain(uint3 DTid : SV_DispatchThreadID)
+{
+    uint width, height, depth;
+    VoxelTexture.GetDimensions(width, height, depth);
+    int dimension = (int)width;
+
+    int3 cascadeVoxelPos = (int3)DispatchOrigin.xyz + (int3)DTid;
+    if (any(cascadeVoxelPos >= dimension))
+        return;
+
+    bool isInUpdateBoxes = false;
+    for (int i = 0; i < (int)VoxelWindowOrigin.w; i++)
+    {
+        if (all((float3)cascadeVoxelPos >= UpdateBoxesMin[i].xyz) && all((float3)cascadeVoxelPos < UpdateBoxesMax[i].xyz))
+        {
+            isInUpdateBoxes = true;
+            break;
+        }
+    }
+    if (!isInUpdateBoxes)
+        return;
+
+    VoxelTexture[((cascadeVoxelPos + (int3)VoxelWindowOrigin.xyz) % dimension + dimension) % dimension] = float4(0.0, 0.0, 0.0, 0.0);
+}
@@ -1,5 +1,5 @@
 #define PI 3.141592654
-#define NUM_VOXEL_CONES 6
+#define MAX_NUM_VOXEL_CONES 6 // DiffuseConesCount comes from the GI tier (1, 4 or 6)
 #define NUM_SHADOW_CASCADES 3
 #define NUM_VOXEL_CASCADES 2
 
@@ -10,6 +10,8 @@
 
 static const float4 colorWhite = { 1, 1, 1, 1 };
 static const float coneAperture = 0.577f; // 6 cones, 60deg each, tan(30deg) = aperture
+static const float coneAperture4 = 0.882f; // 4 cones, ~83deg each
+static const float coneAperture1 = 1.732f; // 1 cone, 120deg
 static const float3 diffuseConeDirections[] =
 {
     float3(0.0f, 1.0f, 0.0f),
@@ -23,6 +25,17 @@ static const float diffuseConeWeights[] =
 {
     0.25, 0.15, 0.15, 0.15, 0.15, 0.15
 };
+static const float3 diffuseConeDirections4[] =
+{
+    float3(0.0f, 1.0f, 0.0f),
+    float3(0.0f, 0.707107f, 0.707107f),
+    float3(0.612372f, 0.707107f, -0.353553f),
+    float3(-0.612372f, 0.707107f, -0.353553f)
+};
+static const float diffuseConeWeights4[] =
+{
+    0.25, 0.25, 0.25, 0.25
+};
 
 static const float specularOneDegree = 0.0174533f; //in radians
 static const int specularMaxDegreesCount = 2;
@@ -51,14 +64,38 @@ cbuffer VCTMainCB : register(b0)
     float VoxelSampleOffset;
     float GIPower;
     float PreviousRadianceDelta;
-    float2 pad1;
+    float DiffuseConesCount;
+    float pad1;
 };
 
+void GetDiffuseCone(int index, int conesCount, out float3 direction, out float weight, out float aperture)
+{
+    if (conesCount >= MAX_NUM_VOXEL_CONES)
+    {
+        direction = diffuseConeDirections[index];
+        weight = diffuseConeWeights[index];
+        aperture = coneAperture;
+    }
+    else if (conesCount >= 4)
+    {
+        direction = diffuseConeDirections4[index];
+        weight = diffuseConeWeights4[index];
+        aperture = coneAperture4;
+    }
+    else
+    {
+        direction = float3(0.0f, 1.0f, 0.0f);
+        weight = 1.0f;
+        aperture = coneAperture1;
+    }
+}
+
 float4 GetVoxel(float3 worldPosition, float3 weight, float lod, int cascadeIndex, int cascadeResolution)
 {   
-    float3 voxelTextureUV = (worldPosition - VoxelCameraPositions[cascadeIndex].xyz) / (0.5f * (float) cascadeResolution) * WorldVoxelScales[cascadeIndex].r;
+    // cascades are addressed toroidally (voxels stay at their world coordinate modulo the resolution), wrap sampler does the rest
+    float3 voxelTextureUV = worldPosition * WorldVoxelScales[cascadeIndex].r / (float) cascadeResolution;
     voxelTextureUV.y = -voxelTextureUV.y;
-    voxelTextureUV = voxelTextureUV * 0.5f + 0.5f + float3(VoxelSampleOffset, VoxelSampleOffset, VoxelSampleOffset);
+    voxelTextureUV += float3(VoxelSampleOffset, VoxelSampleOffset, VoxelSampleOffset);
     return voxelTextures[cascadeIndex].SampleLevel(LinearSampler, voxelTextureUV, lod);
 }
 
@@ -72,12 +109,18 @@ float4 TraceCone(float3 pos, float3 normal, float3 direction, float aperture, ou
     float3 startPos = pos + normal * dist;
     
     float3 weight = direction * direction;
+    float halfCascadeSize = 0.5f * cascadeResolution * voxelWorldSize;
 
     while (dist < MaxConeTraceDistance && color.a < 1.0f)
     {
+        float3 samplePos = startPos + dist * direction;
+        // outside of the cascade the wrapped texture contains the voxels from its opposite side
+        if (any(abs(samplePos - VoxelCameraPositions[cascadeIndex].xyz) > halfCascadeSize))
+            break;
+
         float diameter = 2.0f * aperture * dist;
         float lodLevel = log2(diameter / voxelWorldSize);
-        float4 voxelColor = GetVoxel(startPos + dist * direction, weight, lodLevel, cascadeIndex, cascadeResolution);
+        float4 voxelColor = GetVoxel(samplePos, weight, lodLevel, cascadeIndex, cascadeResolution);
     
         // front-to-back
         color += (1.0 - color.a) * voxelColor;
@@ -161,14 +204,19 @@ float4 CalculateIndirectDiffuse(float3 worldPos, float3 normal, out float ao)
             continue; //try to trace from next cascade
         else
         {
-            for (int i = 0; i < NUM_VOXEL_CONES; i++)
+            const int conesCount = (DiffuseConesCount >= MAX_NUM_VOXEL_CONES) ? MAX_NUM_VOXEL_CONES : ((DiffuseConesCount >= 4) ? 4 : 1);
+            for (int i = 0; i < conesCount; i++)
             {
+                float3 coneOffset;
+                float coneWeight, aperture;
+                GetDiffuseCone(i, conesCount, coneOffset, coneWeight, aperture);
+
                 coneDirection = normal;
-                coneDirection += diffuseConeDirections[i].x * right + diffuseConeDirections[i].z * up;
+                coneDirection += coneOffset.x * right + coneOffset.z * up;
                 coneDirection = normalize(coneDirection);
         
-                currentCascadeRadiance += TraceCone(worldPos, normal, coneDirection, coneAperture, tempAo, true, cascadeIndex, voxelCascadeResolutions[cascadeIndex]) * diffuseConeWeights[i];
-                currentCascadeAo += tempAo * diffuseConeWeights[i];
+                currentCascadeRadiance += TraceCone(worldPos, normal, coneDirection, aperture, tempAo, true, cascadeIndex, voxelCascadeResolutions[cascadeIndex]) * coneWeight;
+                currentCascadeAo += tempAo * coneWeight;
             }
 
             if (cascadeIndex == NUM_VOXEL_CASCADES - 1)
@@ -24,6 +24,7 @@ cbuffer VoxelizationDebug : register(b0)
 {
     float4x4 WorldVoxelCube;
     float4x4 ViewProjection;
+    float4 VoxelWindowOrigin; // first voxel of the cascade in world voxel coordinates (voxels are addressed toroidally)
 };
 
 Texture3D<float4> voxelTexture : register(t0);
@@ -43,8 +44,10 @@ GS_IN VSMain(VS_IN input)
     centerVoxelPos.y = input.vertexID / (width * width);
     centerVoxelPos.z = (input.vertexID / width) % width;
     
+    int3 texel = ((int3(centerVoxelPos) + int3(VoxelWindowOrigin.xyz)) % int(width) + int(width)) % int(width);
+
     output.position = float4(0.5f * centerVoxelPos, 1.0f);
-    output.color = voxelTexture.Load(int4(centerVoxelPos, 0));
+    output.color = voxelTexture.Load(int4(texel, 0));
     return output;
 }
 
@@ -1,22 +1,28 @@
 #include "IndirectCulling.hlsli"
 
-cbuffer MeshConstants : register(b0)
-{
-	uint4 IndexCount_StartIndexLoc_BaseVtxLoc_StartInstLoc[MAX_LOD_COUNT * MAX_MESH_COUNT];
-	uint OriginalInstancesCount;
-    uint3 pad;
-};
-
 cbuffer CameraConstants : register(b1)
 {
 	float4 FrustumPlanes[6];
 	float4 LODCameraSqrDistances;
 	float4 CameraPos; // .w - skip cull
+	float4x4 PrevViewProjection; // the one the Hi-Z pyramid (previous frame's depth) was rendered with
+	float4 HiZParams; // .x - occlusion cull enabled
 };
 
-StructuredBuffer<Instance> instanceData : register(t0);
-RWStructuredBuffer<Instance> newInstanceData : register(u0); // OriginalInstancesCount * MAX_LOD_COUNT
-RWBuffer<uint> argsBuffer : register(u1); // MAX_LOD_COUNT * MAX_MESH_COUNT * 5
+// instances of all indirectly rendered objects are frustum culled in one dispatch (CSMain), the ones in the frustum are then occlusion culled in another (CSOcclusion)
+StructuredBuffer<Instance> instanceData : register(t0); // InstancesCount
+StructuredBuffer<uint> instanceObjectIndices : register(t1); // InstancesCount
+StructuredBuffer<CullingObject> objectsData : register(t2);
+RWStructuredBuffer<Instance> newInstanceData : register(u0); // OriginalInstancesCount * MAX_LOD_COUNT * 2 per object
+RWBuffer<uint> argsBuffer : register(u1); // MAX_LOD_COUNT * 2 * MAX_MESH_COUNT * 5 per object
+
+// CSMain only
+RWBuffer<uint> occlusionCandidates : register(u2); // 1 + InstancesCount * OCCLUSION_CANDIDATE_SIZE
+RWBuffer<uint> occlusionDispatchArgs : register(u3); // 3 (Dispatch() args of CSOcclusion)
+
+// CSOcclusion only
+Texture2D<float> HiZLevels[HIZ_LEVELS] : register(t3); // HIZ_WIDTH x HIZ_HEIGHT, every next level is 2x smaller
+Buffer<uint> occlusionCandidatesToTest : register(t11); // after the Hi-Z levels, written by CSMain
 
 bool PerformFrustumCull(float4 aabbMin, float4 aabbMax)
 {
@@ -60,6 +66,66 @@ bool PerformFrustumCull(float4 aabbMin, float4 aabbMax)
 	return culled;
 }
 
+// max depth of the 4 texels of the Hi-Z level (resource arrays can only be indexed with literals, so we have to unroll)
+float LoadHiZMaxDepth(uint level, int2 minCoords, int2 maxCoords)
+{
+	float maxDepth = 1.0;
+
+	[unroll]
+	for (uint i = 0; i < HIZ_LEVELS; i++)
+	{
+		[branch]
+		if (i == level)
+		{
+			maxDepth = max(
+				max(HiZLevels[i].Load(int3(minCoords.x, minCoords.y, 0)), HiZLevels[i].Load(int3(maxCoords.x, minCoords.y, 0))),
+				max(HiZLevels[i].Load(int3(minCoords.x, maxCoords.y, 0)), HiZLevels[i].Load(int3(maxCoords.x, maxCoords.y, 0))));
+		}
+	}
+	return maxDepth;
+}
+
+// the AABB is projected with the previous frame's view-projection and its closest depth is tested against the farthest depth
+// of the Hi-Z level, where the projected rectangle covers at most 2x2 texels
+bool PerformOcclusionCull(float4 aabbMin, float4 aabbMax)
+{
+	float2 minUV = float2(1.0, 1.0);
+	float2 maxUV = float2(0.0, 0.0);
+	float minDepth = 1.0;
+
+	[unroll]
+	for (int i = 0; i < 8; i++)
+	{
+		float3 corner = float3((i & 1) ? aabbMax.x : aabbMin.x, (i & 2) ? aabbMax.y : aabbMin.y, (i & 4) ? aabbMax.z : aabbMin.z);
+		float4 clipPos = mul(float4(corner, 1.0), PrevViewProjection);
+
+		// crosses the near plane (i.e., the camera is inside or very close to the box)
+		if (clipPos.w <= 0.0)
+			return false;
+
+		float3 ndc = clipPos.xyz / clipPos.w;
+		float2 uv = ndc.xy * float2(0.5, -0.5) + float2(0.5, 0.5);
+		minUV = min(minUV, uv);
+		maxUV = max(maxUV, uv);
+		minDepth = min(minDepth, ndc.z);
+	}
+	minUV = saturate(minUV);
+	maxUV = saturate(maxUV);
+
+	float2 sizeInTexels = (maxUV - minUV) * float2(HIZ_WIDTH, HIZ_HEIGHT);
+	float level = ceil(log2(max(max(sizeInTexels.x, sizeInTexels.y), 1.0)));
+
+	// too big on the screen for the smallest level - not worth testing
+	if (level > HIZ_LEVELS - 1)
+		return false;
+
+	int2 levelSize = int2(HIZ_WIDTH, HIZ_HEIGHT) >> (uint)level;
+	int2 minCoords = min((int2)(minUV * levelSize), levelSize - 1);
+	int2 maxCoords = min((int2)(maxUV * levelSize), levelSize - 1);
+
+	return minDepth > LoadHiZMaxDepth((uint)level, minCoords, maxCoords);
+}
+
 int CalculateLodIndex(float4x4 worldMat)
 {
 	float3 pos = float3(worldMat[0][3], worldMat[1][3], worldMat[2][3]);
@@ -79,31 +145,71 @@ int CalculateLodIndex(float4x4 worldMat)
 	return -1;
 }
 
-[numthreads(64, 1, 1)]
+// appends the instance to the draw args of all meshes and to the new instances of the "LOD slot" (camera or shadow one)
+void AppendInstance(Instance data, CullingObject object, uint lodSlot)
+{
+	// we just need to copy the counters for all meshes in that lod
+	for (uint mesh = 0; mesh < object.MeshCount; mesh++)
+	{
+		uint offset = MAX_MESH_COUNT * lodSlot + mesh;
+
+		uint outIndex;
+		InterlockedAdd(argsBuffer[object.ArgsOffset + offset * 5 + 1], 1, outIndex);
+		if (mesh == 0)
+			newInstanceData[object.NewInstancesOffset + object.OriginalInstancesCount * lodSlot + outIndex] = data;
+	}
+}
+
+[numthreads(INDIRECT_DISPATCH_GROUP_SIZE, 1, 1)]
 void CSMain(int3 DTid : SV_DispatchThreadID)
 {
-	int index = DTid.x;
-	if (index >= OriginalInstancesCount)
+	uint index = DTid.x;
+	if (index >= InstancesCount)
 		return;
 
 	Instance data = instanceData[index];
+	CullingObject object = objectsData[instanceObjectIndices[index]];
 
-	bool isCulled = CameraPos.w > 0.0 ? false : PerformFrustumCull(data.AABBmin, data.AABBmax);
-	if (!isCulled)
-	{
-		int lod = CalculateLodIndex(data.WorldMat);
-		if (lod == -1)
-			return;
+	if (CameraPos.w <= 0.0 && PerformFrustumCull(data.AABBmin, data.AABBmax))
+		return;
 
-		// we just need to copy the counters for all meshes in that lod
-		for (int mesh = 0; mesh < MAX_MESH_COUNT; mesh++)
-		{
-			uint offset = MAX_MESH_COUNT * lod + mesh;
+	int lod = CalculateLodIndex(data.WorldMat);
+	if (lod == -1)
+		return;
 
-			uint outIndex;
-			InterlockedAdd(argsBuffer[offset * 5 + 1], 1, outIndex);
-			if (mesh == 0)
-				newInstanceData[OriginalInstancesCount * lod + outIndex] = data;
-		}
+	// shadow casters: the instance is in the frustum
+	AppendInstance(data, object, SHADOW_LOD_OFFSET + lod);
+
+	if (HiZParams.x > 0.0)
+	{
+		uint candidateIndex;
+		InterlockedAdd(occlusionCandidates[0], 1, candidateIndex);
+		occlusionCandidates[1 + candidateIndex * OCCLUSION_CANDIDATE_SIZE + 0] = index;
+		occlusionCandidates[1 + candidateIndex * OCCLUSION_CANDIDATE_SIZE + 1] = lod;
+
+		// a new thread group for CSOcclusion
+		if (candidateIndex % INDIRECT_DISPATCH_GROUP_SIZE == 0)
+			InterlockedAdd(occlusionDispatchArgs[0], 1);
+		return;
 	}
+
+	AppendInstance(data, object, lod);
+}
+
+// dispatched indirectly over the instances that passed the frustum test in CSMain
+[numthreads(INDIRECT_DISPATCH_GROUP_SIZE, 1, 1)]
+void CSOcclusion(int3 DTid : SV_DispatchThreadID)
+{
+	uint candidateIndex = DTid.x;
+	if (candidateIndex >= occlusionCandidatesToTest[0])
+		return;
+
+	uint index = occlusionCandidatesToTest[1 + candidateIndex * OCCLUSION_CANDIDATE_SIZE + 0];
+	uint lod = occlusionCandidatesToTest[1 + candidateIndex * OCCLUSION_CANDIDATE_SIZE + 1];
+
+	Instance data = instanceData[index];
+	if (PerformOcclusionCull(data.AABBmin, data.AABBmax))
+		return;
+
+	AppendInstance(data, objectsData[instanceObjectIndices[index]], lod);
 }
\ No newline at end of file
@@ -1,10 +1,42 @@
 //These should match the cpp ones in Common.h
 #define MAX_LOD_COUNT 3
 #define MAX_MESH_COUNT 32
+#define INDIRECT_DISPATCH_GROUP_SIZE 64
+
+// hierarchical depth (Hi-Z) pyramid for the occlusion culling: power-of-two base, every level is a separate texture
+#define HIZ_WIDTH 512
+#define HIZ_HEIGHT 256
+#define HIZ_LEVELS 8
+
+// shadow casters are not occlusion culled (they can cast visible shadows), so they have their own DrawIndexedInstanced() args and instances
+// in the "LOD slots" after the camera ones
+#define SHADOW_LOD_OFFSET MAX_LOD_COUNT
+
+// instances in the frustum are occlusion culled in a second dispatch that is sized on the GPU (Dispatch() args are incremented per INDIRECT_DISPATCH_GROUP_SIZE candidates)
+// candidates buffer: the count, then the instance index and the lod of every candidate (should match INDIRECT_OCCLUSION_CANDIDATE_SIZE in Common.h)
+#define OCCLUSION_CANDIDATE_SIZE 2
 
 struct Instance
 {
 	float4x4 WorldMat;
 	float4 AABBmin;
 	float4 AABBmax;
+};
+
+// should match the cpp one in ER_GPUCuller.h
+struct CullingObject
+{
+	uint OriginalInstancesCount;
+	uint FirstInstance; // in the batched instances buffer
+	uint NewInstancesOffset; // in the new instances buffer (OriginalInstancesCount * MAX_LOD_COUNT * 2 entries per object: camera and shadow LODs)
+	uint ArgsOffset; // in the args buffer (in UINTs)
+	uint MeshCount;
+	uint3 pad;
+};
+
+cbuffer CullingConstants : register(b0)
+{
+	uint InstancesCount; // all batched instances
+	uint ArgsCount; // all batched args (in UINTs)
+	uint2 pad;
 };
\ No newline at end of file
@@ -1,27 +1,24 @@
 #include "IndirectCulling.hlsli"
 
-cbuffer MeshConstants : register(b0)
-{
-	uint4 IndexCount_StartIndexLoc_BaseVtxLoc_StartInstLoc[MAX_LOD_COUNT * MAX_MESH_COUNT];
-	uint OriginalInstancesCount;
-    uint3 pad;
-};
-
-RWBuffer<uint> argsBuffer : register(u0); // MAX_LOD_COUNT * MAX_MESH_COUNT * 5
+StructuredBuffer<uint> initialArgsBuffer : register(t0); // ArgsCount
+RWBuffer<uint> argsBuffer : register(u0); // ArgsCount: MAX_LOD_COUNT * 2 * MAX_MESH_COUNT * 5 per object
+RWBuffer<uint> occlusionDispatchArgs : register(u1); // 3
+RWBuffer<uint> occlusionCandidates : register(u2); // only the count is reset
 
-[numthreads(1, 1, 1)]
+[numthreads(INDIRECT_DISPATCH_GROUP_SIZE, 1, 1)]
 void CSMain(int3 DTid : SV_DispatchThreadID)
 {
-	for (int lod = 0; lod < MAX_LOD_COUNT; lod++)
+	uint index = DTid.x;
+	if (index == 0)
 	{
-		for (int mesh = 0; mesh < MAX_MESH_COUNT; mesh++)
-		{
-			uint offset = MAX_MESH_COUNT * lod + mesh;
-			argsBuffer[offset * 5 + 0] = IndexCount_StartIndexLoc_BaseVtxLoc_StartInstLoc[offset].x;
-			argsBuffer[offset * 5 + 1] = 0;
-			argsBuffer[offset * 5 + 2] = IndexCount_StartIndexLoc_BaseVtxLoc_StartInstLoc[offset].y;
-			argsBuffer[offset * 5 + 3] = IndexCount_StartIndexLoc_BaseVtxLoc_StartInstLoc[offset].z;
-			argsBuffer[offset * 5 + 4] = IndexCount_StartIndexLoc_BaseVtxLoc_StartInstLoc[offset].w;
-		}
+		occlusionDispatchArgs[0] = 0;
+		occlusionDispatchArgs[1] = 1;
+		occlusionDispatchArgs[2] = 1;
+		occlusionCandidates[0] = 0;
 	}
+
+	if (index >= ArgsCount)
+		return;
+
+	argsBuffer[index] = initialArgsBuffer[index];
 }
\ No newline at end of file
@@ -0,0 +1,32 @@
+// Builds one level of the hierarchical depth (Hi-Z) pyramid that is used for the occlusion culling of the indirectly rendered instances.
+// Level 0 is built from the depth buffer (of any size), other levels - from the previous level.
+// Every texel keeps the farthest depth of all source texels it covers, so the test against it is always conservative.
+
+cbuffer HiZConstants : register(b0)
+{
+	float4 SourceDestSize; // xy - source size, zw - destination size
+};
+
+Texture2D<float> Source : register(t0);
+RWTexture2D<float> Destination : register(u0);
+
+[numthreads(8, 8, 1)]
+void CSMain(uint3 DTid : SV_DispatchThreadID)
+{
+	uint2 destSize = (uint2)SourceDestSize.zw;
+	if (DTid.x >= destSize.x || DTid.y >= destSize.y)
+		return;
+
+	float2 scale = SourceDestSize.xy / SourceDestSize.zw;
+	uint2 start = (uint2)floor(DTid.xy * scale);
+	uint2 end = min((uint2)ceil((DTid.xy + 1) * scale), (uint2)SourceDestSize.xy);
+
+	float maxDepth = 0.0;
+	for (uint y = start.y; y < end.y; y++)
+	{
+		for (uint x = start.x; x < end.x; x++)
+			maxDepth = max(maxDepth, Source.Load(int3(x, y, 0)));
+	}
+
+	Destination[DTid.xy] = maxDepth;
+}
@@ -3,6 +3,7 @@
 // 
 // Supports:
 // - instancing
+// - position-only vertex input for objects without alpha testing (no pixel shader, depth only)
 //
 // Written by Gen Afanasev for 'EveryRay Rendering Engine', 2017-2022
 // ================================================================================================
@@ -42,6 +43,20 @@ struct VS_INPUT_INSTANCING
     uint InstanceID : SV_InstanceID;
 };
 
+struct VS_INPUT_POSITION
+{
+    float4 Position : POSITION;
+};
+
+struct VS_INPUT_POSITION_INSTANCING
+{
+    float4 Position : POSITION;
+    
+    //instancing;
+    row_major float4x4 InstanceWorld : WORLD; // not used with indirect rendering
+    uint InstanceID : SV_InstanceID;
+};
+
 struct VS_OUTPUT
 {
     float4 Position : SV_Position;
@@ -69,7 +84,7 @@ VS_OUTPUT VSMain_instancing(VS_INPUT_INSTANCING IN)
     VS_OUTPUT OUT = (VS_OUTPUT) 0;
 
     float4x4 WorldM = (RenderingObjectFlags & RENDERING_OBJECT_FLAG_GPU_INDIRECT_DRAW) ?
-        transpose(IndirectInstanceData[(int)OriginalInstanceCount * CurrentLod + IN.InstanceID].WorldMat) : IN.InstanceWorld;
+        transpose(IndirectInstanceData[(int)IndirectInstanceOffset + (int)OriginalInstanceCount * CurrentLod + IN.InstanceID].WorldMat) : IN.InstanceWorld;
     float3 WorldPos = mul(IN.Position, WorldM).xyz;
     OUT.Position = mul(float4(WorldPos, 1.0f), LightViewProjection);
     OUT.Depth = OUT.Position.zw;
@@ -78,6 +93,18 @@ VS_OUTPUT VSMain_instancing(VS_INPUT_INSTANCING IN)
     return OUT;
 }
 
+float4 VSMain_PositionOnly(VS_INPUT_POSITION IN) : SV_Position
+{
+    return mul(IN.Position, WorldLightViewProjection);
+}
+float4 VSMain_PositionOnly_instancing(VS_INPUT_POSITION_INSTANCING IN) : SV_Position
+{
+    float4x4 WorldM = (RenderingObjectFlags & RENDERING_OBJECT_FLAG_GPU_INDIRECT_DRAW) ?
+        transpose(IndirectInstanceData[(int)IndirectInstanceOffset + (int)OriginalInstanceCount * CurrentLod + IN.InstanceID].WorldMat) : IN.InstanceWorld;
+    float3 WorldPos = mul(IN.Position, WorldM).xyz;
+    return mul(float4(WorldPos, 1.0f), LightViewProjection);
+}
+
 float4 PSMain(VS_OUTPUT IN) : SV_Target
 {
     float alphaValue = AlbedoTexture.Sample(Sampler, IN.TextureCoordinate).a;
@@ -268,6 +268,11 @@ void CSMain(uint3 threadID : SV_DispatchThreadID, uint groupIndex : SV_GroupInde
     uint stride;
     terrainVertices.GetDimensions(vertexCount, stride);
 #endif
+    uint positionsCount;
+    uint positionsStride;
+    InputOutputPositions.GetDimensions(positionsCount, positionsStride);
+    if (threadID.x >= positionsCount)
+        return;
     
     float x = InputOutputPositions[threadID.x].x;
     float z = InputOutputPositions[threadID.x].z;
@@ -4,6 +4,8 @@
 // Supports:
 // - Shadow Mapping
 // - Instancing
+// - Toroidal addressing: voxels are stored at their world coordinate modulo the cascade resolution,
+//   so a scrolled cascade keeps its voxels and only the update boxes are voxelized again
 //
 // TODO:
 // - store normals in voxels
@@ -12,6 +14,8 @@
 // Written by Gen Afanasev for 'EveryRay Rendering Engine', 2017-2022
 // ================================================================================================
 
+#define VCT_MAX_UPDATE_BOXES 8 // should match with Common.h
+
 cbuffer VoxelizationCB : register(b0)
 {
     float4x4 World;
@@ -20,6 +24,9 @@ cbuffer VoxelizationCB : register(b0)
     float4 ShadowTexelSize;
     float4 ShadowCascadeDistances;
     float4 VoxelCameraPos;
+    float4 VoxelWindowOrigin; // xyz - first voxel of the cascade in world voxel coordinates, w - update boxes count
+    float4 UpdateBoxesMin[VCT_MAX_UPDATE_BOXES]; // in voxels, relative to the cascade
+    float4 UpdateBoxesMax[VCT_MAX_UPDATE_BOXES];
     float VoxelTextureDimension;
     float WorldVoxelScale;
 };
@@ -161,12 +168,31 @@ float GetShadow(float3 ShadowCoord, float depthDistance)
     return CalculateShadow(ShadowCoord);
 }
 
+bool IsInUpdateBoxes(float3 voxelPos)
+{
+    for (int i = 0; i < (int)VoxelWindowOrigin.w; i++)
+    {
+        if (all(voxelPos >= UpdateBoxesMin[i].xyz) && all(voxelPos < UpdateBoxesMax[i].xyz))
+            return true;
+    }
+    return false;
+}
+
 void PSMain(PS_IN input)
 {
     float3 voxelPos = input.VoxelPos.rgb;
     voxelPos.y = -voxelPos.y;
     
-    int3 finalVoxelPos = int3((float)VoxelTextureDimension * float3(0.5f * voxelPos + float3(0.5f, 0.5f, 0.5f)));
+    int3 cascadeVoxelPos = int3((float)VoxelTextureDimension * float3(0.5f * voxelPos + float3(0.5f, 0.5f, 0.5f)));
+    // meshes can be bigger than the cascade (only xy of the projected axis is clipped by the rasterizer)
+    if (any(cascadeVoxelPos < 0) || any(cascadeVoxelPos >= (int)VoxelTextureDimension))
+        return;
+    // the rest of the cascade is already voxelized (and maybe by other objects)
+    if (!IsInUpdateBoxes((float3)cascadeVoxelPos))
+        return;
+
+    int dimension = (int)VoxelTextureDimension;
+    int3 finalVoxelPos = ((cascadeVoxelPos + (int3)VoxelWindowOrigin.xyz) % dimension + dimension) % dimension;
     float4 colorRes = AlbedoTexture.Sample(LinearSampler, input.UV);
     
     //voxelPos.y = -voxelPos.y;
@@ -88,7 +88,16 @@ using namespace DirectX;
 #define NUM_SHADOW_CASCADES 3
 #define MAX_LOD 3
 #define MAX_MESH_COUNT 32 // should match with IndirectCulling.hlsli
+#define INDIRECT_DRAW_ARGS_COUNT 5 // DrawIndexedInstanced()
+#define INDIRECT_DISPATCH_ARGS_COUNT 3 // Dispatch()
+#define INDIRECT_SHADOW_LOD_OFFSET MAX_LOD // shadow casters (not occlusion culled) have their own draw args/instances after the camera LODs, should match with IndirectCulling.hlsli
+#define INDIRECT_DISPATCH_GROUP_SIZE 64 // should match with IndirectCulling.hlsli
+#define INDIRECT_OCCLUSION_CANDIDATE_SIZE 2 // instance index and lod (in UINTs) of the instances that are occlusion culled on GPU, should match with IndirectCulling.hlsli
+#define INDIRECT_HIZ_WIDTH 512 // should match with IndirectCulling.hlsli
+#define INDIRECT_HIZ_HEIGHT 256 // should match with IndirectCulling.hlsli
+#define INDIRECT_HIZ_LEVELS 8 // should match with IndirectCulling.hlsli
 #define MAX_NUM_POINT_LIGHTS 64 // keep in sync with Lighting.hlsli; deprecate or bump once tiled rendering is implemented
+#define VCT_MAX_UPDATE_BOXES 8 // should match with Voxelization.hlsl and GI/VoxelCascadeClear.hlsl
 
 template <typename T>
 inline T ER_DivideByMultiple(T value, unsigned int alignment) {	return (T)((value + alignment - 1) / alignment); }
@@ -2,25 +2,10 @@
 
 namespace EveryRay_Core
 {
+	std::atomic<UINT> ER_CoreServicesContainer::sServiceSlotsCount(0);
+
 	ER_CoreServicesContainer::ER_CoreServicesContainer()
 		: mServices()
 	{
 	}
-
-	void ER_CoreServicesContainer::AddService(UINT typeID, void* service)
-	{
-		mServices.insert(std::pair<UINT, void*>(typeID, service));
-	}
-
-	void ER_CoreServicesContainer::RemoveService(UINT typeID)
-	{
-		mServices.erase(typeID);
-	}
-
-	void* ER_CoreServicesContainer::FindService(UINT typeID) const
-	{
-		std::map<UINT, void*>::const_iterator it = mServices.find(typeID);
-
-		return (it != mServices.end() ? it->second : nullptr);
-	}
 }
\ No newline at end of file
@@ -1,22 +1,53 @@
 #pragma once
 
 #include "Common.h"
+#include <atomic>
 
 namespace EveryRay_Core
 {
+	// Services are registered by their type (or by a base type, i.e. AddService<ER_Camera>(cameraFPS)).
+	// Every type gets its own slot on first use, so a lookup is a single array access and always returns the registered type.
 	class ER_CoreServicesContainer
 	{
 	public:
 		ER_CoreServicesContainer();
 
-		void AddService(UINT typeID, void* service);
-		void RemoveService(UINT typeID);
-		void* FindService(UINT typeID) const;
+		template<typename T>
+		void AddService(T* service)
+		{
+			const UINT slot = GetServiceSlot<T>();
+			if (slot >= mServices.size())
+				mServices.resize(slot + 1, nullptr);
+			mServices[slot] = service;
+		}
+
+		template<typename T>
+		void RemoveService()
+		{
+			const UINT slot = GetServiceSlot<T>();
+			if (slot < mServices.size())
+				mServices[slot] = nullptr;
+		}
+
+		template<typename T>
+		T* FindService() const
+		{
+			const UINT slot = GetServiceSlot<T>();
+			return (slot < mServices.size() ? static_cast<T*>(mServices[slot]) : nullptr);
+		}
 
 	private:
 		ER_CoreServicesContainer(const ER_CoreServicesContainer& rhs);
 		ER_CoreServicesContainer& operator=(const ER_CoreServicesContainer& rhs);
 
-		std::map<UINT, void*> mServices;
+		template<typename T>
+		static UINT GetServiceSlot()
+		{
+			static const UINT slot = sServiceSlotsCount++;
+			return slot;
+		}
+
+		static std::atomic<UINT> sServiceSlotsCount;
+		std::vector<void*> mServices; // by slot
 	};
 }
\ No newline at end of file
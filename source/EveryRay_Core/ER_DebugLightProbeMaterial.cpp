@@ -60,7 +60,7 @@ namespace EveryRay_Core
 	void ER_DebugLightProbeMaterial::PrepareForRendering(ER_MaterialSystems neededSystems, ER_RenderingObject* aObj, int meshIndex, int aProbeType, ER_RHI_GPURootSignature* rs)
 	{
 		auto rhi = ER_Material::GetCore()->GetRHI();
-		ER_Camera* camera = (ER_Camera*)(ER_Material::GetCore()->GetServices().FindService(ER_Camera::TypeIdClass()));
+		ER_Camera* camera = ER_Material::GetCore()->GetServices().FindService<ER_Camera>();
 		
 		assert(aObj);
 		assert(camera);
@@ -123,8 +123,7 @@ namespace EveryRay_Core
 		if (mProxyModel)
 			mProxyModel->ApplyTransform(transformMatrix);
 
-		for (auto listener : RotationUpdateEvent->GetListeners())
-			listener();
+		RotationUpdateEvent->Invoke();
 	}
 
 	void ER_DirectionalLight::DrawProxyModel(ER_RHI_GPUTexture* aRenderTarget, ER_RHI_GPUTexture* aDepth, const ER_CoreTime & time, ER_RHI_GPURootSignature* rs)
@@ -135,7 +134,7 @@ namespace EveryRay_Core
 
 	void ER_DirectionalLight::UpdateProxyModel(const ER_CoreTime & time, const XMFLOAT4X4& viewMatrix, const XMFLOAT4X4& projectionMatrix)
 	{
-		ER_Camera* camera = (ER_Camera*)(GetCore()->GetServices().FindService(ER_Camera::TypeIdClass()));
+		ER_Camera* camera = GetCore()->GetServices().FindService<ER_Camera>();
 		assert(camera);
 
 		XMFLOAT3 gizmoPos = XMFLOAT3(
@@ -37,7 +37,7 @@ namespace EveryRay_Core
 		for (int i = 0; i < MAX_POINT_LIGHTS_IN_EDITOR_COUNT; i++)
 			mEditorPointLightsNames[i] = (char*)malloc(sizeof(char) * MAX_NAME_CHAR_LENGTH);
 
-		mCamera = (ER_CameraFPS*)(GetCore()->GetServices().FindService(ER_Camera::TypeIdClass()));
+		mCamera = static_cast<ER_CameraFPS*>(GetCore()->GetServices().FindService<ER_Camera>());
 	}
 
 	ER_Editor::~ER_Editor()
@@ -94,7 +94,9 @@ namespace EveryRay_Core
 				ImGui::SliderFloat("Far Plane", &farPlaneDist, 150.0f, 200000.0f);
 				mCamera->SetFarPlaneDistance(farPlaneDist);
 				ImGui::Checkbox("CPU frustum culling", &ER_Utility::IsMainCameraCPUCulling);
+				ImGui::Checkbox("CPU occlusion culling (software)", &ER_Utility::IsMainCameraCPUOcclusionCulling);
 				ImGui::Checkbox("GPU frustum culling", &ER_Utility::IsMainCameraGPUCulling);
+				ImGui::Checkbox("GPU occlusion culling (Hi-Z)", &ER_Utility::IsMainCameraGPUOcclusionCulling);
 			}
 
 			if (ImGui::CollapsingHeader("Environment - Lights"))
@@ -87,13 +87,12 @@ namespace EveryRay_Core
 			//ER_OUTPUT_LOG(ER_Utility::ToWideString(name).c_str());
 		}
 
-		for (auto listener : FoliageSystemInitializedEvent->GetListeners())
-			listener();
+		FoliageSystemInitializedEvent->Invoke();
 	}
 
 	void ER_FoliageManager::Update(const ER_CoreTime& gameTime)
 	{
-		ER_Camera* camera = (ER_Camera*)(mCore->GetServices().FindService(ER_Camera::TypeIdClass()));
+		ER_Camera* camera = mCore->GetServices().FindService<ER_Camera>();
 
 		if (mEnabled)
 		{
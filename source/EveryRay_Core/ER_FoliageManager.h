@@ -119,6 +119,12 @@ namespace EveryRay_Core
 		float GetPatchPositionY(int i) { return mPatchesBufferCPU[i].yPos; }
 		float GetPatchPositionZ(int i) { return mPatchesBufferCPU[i].zPos; }
 		const XMFLOAT3& GetDistributionCenter() { return mDistributionCenter; }
+		float GetDistributionRadius() { return mDistributionRadius + 0.1f; } // as passed to the constructor
+		float GetScale() { return mScale; }
+		FoliageBillboardType GetType() { return mType; }
+		bool IsPlacedOnTerrain() { return mIsPlacedOnTerrain; }
+		int GetTerrainSplatChannel() { return mTerrainSplatChannel; }
+		float GetPlacementHeightDelta() { return mPlacementHeightDelta; }
 
 		void UpdateBuffersGPU();
 		void UpdateBuffersCPU();
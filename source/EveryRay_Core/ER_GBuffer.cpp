@@ -123,10 +123,10 @@ namespace EveryRay_Core {
 			if (renderingObject->IsInstanced())
 				psoName = ER_Utility::IsWireframe ? psoNameInstancedWireframe : psoNameInstanced;
 
-			auto materialInfo = renderingObject->GetMaterials().find(ER_MaterialHelper::gbufferMaterialName);
-			if (materialInfo != renderingObject->GetMaterials().end())
+			ER_Material* gbufferMaterial = renderingObject->GetMaterial(ER_MaterialHelper::gbufferMaterialID);
+			if (gbufferMaterial)
 			{
-				ER_GBufferMaterial* material = static_cast<ER_GBufferMaterial*>(materialInfo->second);
+				ER_GBufferMaterial* material = static_cast<ER_GBufferMaterial*>(gbufferMaterial);
 				if (!rhi->IsPSOReady(psoName))
 				{
 					rhi->InitializePSO(psoName);
@@ -143,7 +143,7 @@ namespace EveryRay_Core {
 				for (int meshIndex = 0; meshIndex < renderingObject->GetMeshCount(); meshIndex++)
 				{
 					material->PrepareForRendering(materialSystems, renderingObject, meshIndex, mRootSignature);
-					renderingObject->Draw(ER_MaterialHelper::gbufferMaterialName, true, meshIndex);
+					renderingObject->Draw(ER_MaterialHelper::gbufferMaterialID, true, meshIndex);
 				}
 			}
 		}
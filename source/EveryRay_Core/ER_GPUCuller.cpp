@@ -12,12 +12,23 @@
 #include "ER_RenderingObject.h"
 #include "ER_Utility.h"
 
+#include <algorithm>
+
 #define GPU_CULL_PASS_ROOT_DESCRIPTOR_TABLE_SRV_INDEX 0
 #define GPU_CULL_PASS_ROOT_DESCRIPTOR_TABLE_UAV_INDEX 1
 #define GPU_CULL_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX 2
 
-#define GPU_CULL_CLEAR_PASS_ROOT_DESCRIPTOR_TABLE_UAV_INDEX 0
-#define GPU_CULL_CLEAR_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX 1
+#define GPU_CULL_OCCLUSION_PASS_ROOT_DESCRIPTOR_TABLE_SRV_INDEX 0
+#define GPU_CULL_OCCLUSION_PASS_ROOT_DESCRIPTOR_TABLE_UAV_INDEX 1
+#define GPU_CULL_OCCLUSION_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX 2
+
+#define GPU_CULL_CLEAR_PASS_ROOT_DESCRIPTOR_TABLE_SRV_INDEX 0
+#define GPU_CULL_CLEAR_PASS_ROOT_DESCRIPTOR_TABLE_UAV_INDEX 1
+#define GPU_CULL_CLEAR_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX 2
+
+#define GPU_CULL_HIZ_PASS_ROOT_DESCRIPTOR_TABLE_SRV_INDEX 0
+#define GPU_CULL_HIZ_PASS_ROOT_DESCRIPTOR_TABLE_UAV_INDEX 1
+#define GPU_CULL_HIZ_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX 2
 
 namespace EveryRay_Core
 {
@@ -31,13 +42,20 @@ namespace EveryRay_Core
 	{
 		DeleteObject(mIndirectCullingCS);
 		DeleteObject(mIndirectCullingRS);
+		DeleteObject(mIndirectCullingOcclusionCS);
+		DeleteObject(mIndirectCullingOcclusionRS);
 		DeleteObject(mIndirectCullingClearCS);
 		DeleteObject(mIndirectCullingClearRS);
+		DeleteObject(mHiZCS);
+		DeleteObject(mHiZRS);
+		DeletePointerCollection(mHiZLevels);
 
-#if ER_PLATFORM_WIN64_DX11
-		mMeshConstantBuffer.Release();
-#endif
+		ReleaseBatch();
+
+		mCullingConstantBuffer.Release();
 		mCameraConstantBuffer.Release();
+		for (int i = 0; i < INDIRECT_HIZ_LEVELS; i++)
+			mHiZConstantBuffers[i].Release();
 	}
 
 	void ER_GPUCuller::Initialize()
@@ -46,37 +64,195 @@ namespace EveryRay_Core
 
 		mIndirectCullingCS = rhi->CreateGPUShader();
 		mIndirectCullingCS->CompileShader(rhi, "content\\shaders\\IndirectCulling.hlsl", "CSMain", ER_COMPUTE);
+		mIndirectCullingOcclusionCS = rhi->CreateGPUShader();
+		mIndirectCullingOcclusionCS->CompileShader(rhi, "content\\shaders\\IndirectCulling.hlsl", "CSOcclusion", ER_COMPUTE);
 		mIndirectCullingClearCS = rhi->CreateGPUShader();
 		mIndirectCullingClearCS->CompileShader(rhi, "content\\shaders\\IndirectCullingClear.hlsl", "CSMain", ER_COMPUTE);
+		mHiZCS = rhi->CreateGPUShader();
+		mHiZCS->CompileShader(rhi, "content\\shaders\\IndirectCullingHiZ.hlsl", "CSMain", ER_COMPUTE);
 
 		//root signatures
 		mIndirectCullingRS = rhi->CreateRootSignature(3, 0);
 		if (mIndirectCullingRS)
 		{
-			mIndirectCullingRS->InitDescriptorTable(rhi, GPU_CULL_PASS_ROOT_DESCRIPTOR_TABLE_UAV_INDEX, { ER_RHI_DESCRIPTOR_RANGE_TYPE::ER_RHI_DESCRIPTOR_RANGE_TYPE_UAV }, { 0 }, { 2 });
-			mIndirectCullingRS->InitDescriptorTable(rhi, GPU_CULL_PASS_ROOT_DESCRIPTOR_TABLE_SRV_INDEX, { ER_RHI_DESCRIPTOR_RANGE_TYPE::ER_RHI_DESCRIPTOR_RANGE_TYPE_SRV }, { 0 }, { 1 });
+			mIndirectCullingRS->InitDescriptorTable(rhi, GPU_CULL_PASS_ROOT_DESCRIPTOR_TABLE_UAV_INDEX, { ER_RHI_DESCRIPTOR_RANGE_TYPE::ER_RHI_DESCRIPTOR_RANGE_TYPE_UAV }, { 0 }, { 4 });
+			mIndirectCullingRS->InitDescriptorTable(rhi, GPU_CULL_PASS_ROOT_DESCRIPTOR_TABLE_SRV_INDEX, { ER_RHI_DESCRIPTOR_RANGE_TYPE::ER_RHI_DESCRIPTOR_RANGE_TYPE_SRV }, { 0 }, { 3 });
 			mIndirectCullingRS->InitDescriptorTable(rhi, GPU_CULL_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX, { ER_RHI_DESCRIPTOR_RANGE_TYPE::ER_RHI_DESCRIPTOR_RANGE_TYPE_CBV }, { 0 }, { 2 });
 			mIndirectCullingRS->Finalize(rhi, "ER_RHI_GPURootSignature: Indirect Culling Main");
 		}
 
-		mIndirectCullingClearRS = rhi->CreateRootSignature(2, 0);
+		mIndirectCullingOcclusionRS = rhi->CreateRootSignature(3, 0);
+		if (mIndirectCullingOcclusionRS)
+		{
+			mIndirectCullingOcclusionRS->InitDescriptorTable(rhi, GPU_CULL_OCCLUSION_PASS_ROOT_DESCRIPTOR_TABLE_UAV_INDEX, { ER_RHI_DESCRIPTOR_RANGE_TYPE::ER_RHI_DESCRIPTOR_RANGE_TYPE_UAV }, { 0 }, { 2 });
+			mIndirectCullingOcclusionRS->InitDescriptorTable(rhi, GPU_CULL_OCCLUSION_PASS_ROOT_DESCRIPTOR_TABLE_SRV_INDEX, { ER_RHI_DESCRIPTOR_RANGE_TYPE::ER_RHI_DESCRIPTOR_RANGE_TYPE_SRV }, { 0 }, { 3 + INDIRECT_HIZ_LEVELS + 1 });
+			mIndirectCullingOcclusionRS->InitDescriptorTable(rhi, GPU_CULL_OCCLUSION_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX, { ER_RHI_DESCRIPTOR_RANGE_TYPE::ER_RHI_DESCRIPTOR_RANGE_TYPE_CBV }, { 0 }, { 2 });
+			mIndirectCullingOcclusionRS->Finalize(rhi, "ER_RHI_GPURootSignature: Indirect Culling Occlusion");
+		}
+
+		mIndirectCullingClearRS = rhi->CreateRootSignature(3, 0);
 		if (mIndirectCullingClearRS)
 		{
-			mIndirectCullingClearRS->InitDescriptorTable(rhi, GPU_CULL_CLEAR_PASS_ROOT_DESCRIPTOR_TABLE_UAV_INDEX, { ER_RHI_DESCRIPTOR_RANGE_TYPE::ER_RHI_DESCRIPTOR_RANGE_TYPE_UAV }, { 0 }, { 1 });
+			mIndirectCullingClearRS->InitDescriptorTable(rhi, GPU_CULL_CLEAR_PASS_ROOT_DESCRIPTOR_TABLE_SRV_INDEX, { ER_RHI_DESCRIPTOR_RANGE_TYPE::ER_RHI_DESCRIPTOR_RANGE_TYPE_SRV }, { 0 }, { 1 });
+			mIndirectCullingClearRS->InitDescriptorTable(rhi, GPU_CULL_CLEAR_PASS_ROOT_DESCRIPTOR_TABLE_UAV_INDEX, { ER_RHI_DESCRIPTOR_RANGE_TYPE::ER_RHI_DESCRIPTOR_RANGE_TYPE_UAV }, { 0 }, { 3 });
 			mIndirectCullingClearRS->InitDescriptorTable(rhi, GPU_CULL_CLEAR_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX, { ER_RHI_DESCRIPTOR_RANGE_TYPE::ER_RHI_DESCRIPTOR_RANGE_TYPE_CBV }, { 0 }, { 1 });
 			mIndirectCullingClearRS->Finalize(rhi, "ER_RHI_GPURootSignature: Indirect Culling Clear");
 		}
 
+		mHiZRS = rhi->CreateRootSignature(3, 0);
+		if (mHiZRS)
+		{
+			mHiZRS->InitDescriptorTable(rhi, GPU_CULL_HIZ_PASS_ROOT_DESCRIPTOR_TABLE_SRV_INDEX, { ER_RHI_DESCRIPTOR_RANGE_TYPE::ER_RHI_DESCRIPTOR_RANGE_TYPE_SRV }, { 0 }, { 1 });
+			mHiZRS->InitDescriptorTable(rhi, GPU_CULL_HIZ_PASS_ROOT_DESCRIPTOR_TABLE_UAV_INDEX, { ER_RHI_DESCRIPTOR_RANGE_TYPE::ER_RHI_DESCRIPTOR_RANGE_TYPE_UAV }, { 0 }, { 1 });
+			mHiZRS->InitDescriptorTable(rhi, GPU_CULL_HIZ_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX, { ER_RHI_DESCRIPTOR_RANGE_TYPE::ER_RHI_DESCRIPTOR_RANGE_TYPE_CBV }, { 0 }, { 1 });
+			mHiZRS->Finalize(rhi, "ER_RHI_GPURootSignature: Indirect Culling Hi-Z");
+		}
+
+		//Hi-Z levels
+		for (int i = 0; i < INDIRECT_HIZ_LEVELS; i++)
+		{
+			ER_RHI_GPUTexture* level = rhi->CreateGPUTexture(L"ER_RHI_GPUTexture: GPU Culler - Hi-Z Level " + std::to_wstring(i));
+			level->CreateGPUTextureResource(rhi, INDIRECT_HIZ_WIDTH >> i, INDIRECT_HIZ_HEIGHT >> i, 1u, ER_FORMAT_R32_FLOAT, ER_BIND_SHADER_RESOURCE | ER_BIND_UNORDERED_ACCESS, 1);
+			mHiZLevels.push_back(level);
+		}
+
 		//cbuffers
-#if ER_PLATFORM_WIN64_DX11
-		mMeshConstantBuffer.Initialize(rhi, "ER_RHI_GPUBuffer: GPU Culler Mesh CB");
-#endif
+		mCullingConstantBuffer.Initialize(rhi, "ER_RHI_GPUBuffer: GPU Culler Culling CB");
 		mCameraConstantBuffer.Initialize(rhi, "ER_RHI_GPUBuffer: GPU Culler Camera CB");
+		for (int i = 0; i < INDIRECT_HIZ_LEVELS; i++)
+			mHiZConstantBuffers[i].Initialize(rhi, "ER_RHI_GPUBuffer: GPU Culler Hi-Z CB " + std::to_string(i));
+	}
+
+	void ER_GPUCuller::ReleaseBatch()
+	{
+		DeleteObject(mInstancesBuffer);
+		DeleteObject(mInstanceObjectIndicesBuffer);
+		DeleteObject(mObjectsBuffer);
+		DeleteObject(mNewInstancesBuffer);
+		DeleteObject(mArgsBuffer);
+		DeleteObject(mInitialArgsBuffer);
+		DeleteObject(mOcclusionCandidatesBuffer);
+		DeleteObject(mOcclusionDispatchArgsBuffer);
+
+		mBatchedObjects.clear();
+		mBatchedInstancesCount = 0;
+		mBatchedArgsCount = 0;
+	}
+
+	void ER_GPUCuller::UpdateBatch(ER_Scene* aScene)
+	{
+		assert(aScene);
+
+		mTempBatchObjects.clear();
+		bool isBatchChanged = false;
+		for (ER_SceneObject& obPair : aScene->objects)
+		{
+			ER_RenderingObject* aObj = obPair.second;
+			if (!aObj->IsGPUIndirectlyRendered() || !aObj->IsIndirectInstanceDataReady())
+				continue;
+
+			// new objects (even if they reuse the memory of the removed ones) do not point to our buffers yet
+			if (aObj->GetIndirectArgsBuffer() != mArgsBuffer)
+				isBatchChanged = true;
+			mTempBatchObjects.push_back(aObj);
+		}
+
+		if (!isBatchChanged && mTempBatchObjects == mBatchedObjects)
+			return;
+
+		auto rhi = mCore.GetRHI();
+
+		// old buffers might still be used by the frames in flight
+		if (mArgsBuffer)
+		{
+			rhi->WaitForGpuOnGraphicsFence();
+			rhi->WaitForGpuOnComputeFence();
+		}
+		ReleaseBatch();
+
+		mBatchedObjects = mTempBatchObjects;
+		if (mBatchedObjects.empty())
+			return;
+
+		const UINT argsPerObject = INDIRECT_DRAW_ARGS_COUNT * MAX_MESH_COUNT * (MAX_LOD + INDIRECT_SHADOW_LOD_OFFSET);
+
+		std::vector<IndirectInstanceData> instances;
+		std::vector<UINT> instanceObjectIndices;
+		std::vector<IndirectCullingObjectData> objects(mBatchedObjects.size());
+		std::vector<UINT> initialArgs(mBatchedObjects.size() * argsPerObject);
+
+		UINT newInstancesCount = 0;
+		for (UINT objectIndex = 0; objectIndex < static_cast<UINT>(mBatchedObjects.size()); objectIndex++)
+		{
+			ER_RenderingObject* aObj = mBatchedObjects[objectIndex];
+			const std::vector<IndirectInstanceData>& objectInstances = aObj->GetIndirectInstanceData();
+
+			IndirectCullingObjectData& objectData = objects[objectIndex];
+			objectData.OriginalInstancesCount = static_cast<UINT>(objectInstances.size());
+			objectData.FirstInstance = static_cast<UINT>(instances.size());
+			objectData.NewInstancesOffset = newInstancesCount;
+			objectData.ArgsOffset = objectIndex * argsPerObject;
+			objectData.MeshCount = static_cast<UINT>(std::min(aObj->GetMeshCount(), MAX_MESH_COUNT));
+
+			instances.insert(instances.end(), objectInstances.begin(), objectInstances.end());
+			instanceObjectIndices.insert(instanceObjectIndices.end(), objectInstances.size(), objectIndex);
+			newInstancesCount += objectData.OriginalInstancesCount * (MAX_LOD + INDIRECT_SHADOW_LOD_OFFSET);
+
+			// draw args (of the camera and shadow LODs) with zero instance counts (the counters are incremented during culling)
+			const XMINT4* drawArgs = aObj->GetIndirectDrawArgsArray();
+			UINT* args = &initialArgs[objectData.ArgsOffset];
+			for (int i = 0; i < (MAX_LOD + INDIRECT_SHADOW_LOD_OFFSET) * MAX_MESH_COUNT; i++)
+			{
+				const XMINT4& meshDrawArgs = drawArgs[i % (MAX_LOD * MAX_MESH_COUNT)];
+				args[i * INDIRECT_DRAW_ARGS_COUNT + 0] = static_cast<UINT>(meshDrawArgs.x);
+				args[i * INDIRECT_DRAW_ARGS_COUNT + 1] = 0;
+				args[i * INDIRECT_DRAW_ARGS_COUNT + 2] = static_cast<UINT>(meshDrawArgs.y);
+				args[i * INDIRECT_DRAW_ARGS_COUNT + 3] = static_cast<UINT>(meshDrawArgs.z);
+				args[i * INDIRECT_DRAW_ARGS_COUNT + 4] = static_cast<UINT>(meshDrawArgs.w);
+			}
+		}
+		mBatchedInstancesCount = static_cast<UINT>(instances.size());
+		mBatchedArgsCount = static_cast<UINT>(initialArgs.size());
+
+		mInstancesBuffer = rhi->CreateGPUBuffer("ER_RHI_GPUBuffer: GPU Culler - Instances Buffer");
+		mInstancesBuffer->CreateGPUBufferResource(rhi, &instances[0], mBatchedInstancesCount, sizeof(IndirectInstanceData), false,
+			ER_BIND_SHADER_RESOURCE, 0, ER_RESOURCE_MISC_BUFFER_STRUCTURED);
+		mInstanceObjectIndicesBuffer = rhi->CreateGPUBuffer("ER_RHI_GPUBuffer: GPU Culler - Instance Object Indices Buffer");
+		mInstanceObjectIndicesBuffer->CreateGPUBufferResource(rhi, &instanceObjectIndices[0], mBatchedInstancesCount, sizeof(UINT), false,
+			ER_BIND_SHADER_RESOURCE, 0, ER_RESOURCE_MISC_BUFFER_STRUCTURED);
+		mObjectsBuffer = rhi->CreateGPUBuffer("ER_RHI_GPUBuffer: GPU Culler - Objects Buffer");
+		mObjectsBuffer->CreateGPUBufferResource(rhi, &objects[0], static_cast<UINT>(objects.size()), sizeof(IndirectCullingObjectData), false,
+			ER_BIND_SHADER_RESOURCE, 0, ER_RESOURCE_MISC_BUFFER_STRUCTURED);
+		mNewInstancesBuffer = rhi->CreateGPUBuffer("ER_RHI_GPUBuffer: GPU Culler - New Instances Buffer");
+		mNewInstancesBuffer->CreateGPUBufferResource(rhi, nullptr, newInstancesCount, sizeof(IndirectInstanceData), false,
+			ER_BIND_UNORDERED_ACCESS | ER_BIND_SHADER_RESOURCE, 0, ER_RESOURCE_MISC_BUFFER_STRUCTURED, ER_FORMAT_UNKNOWN);
+		mInitialArgsBuffer = rhi->CreateGPUBuffer("ER_RHI_GPUBuffer: GPU Culler - Initial Args Buffer");
+		mInitialArgsBuffer->CreateGPUBufferResource(rhi, &initialArgs[0], mBatchedArgsCount, sizeof(UINT), false,
+			ER_BIND_SHADER_RESOURCE, 0, ER_RESOURCE_MISC_BUFFER_STRUCTURED);
+		mArgsBuffer = rhi->CreateGPUBuffer("ER_RHI_GPUBuffer: GPU Culler - Args Buffer");
+		mArgsBuffer->CreateGPUBufferResource(rhi, nullptr, mBatchedArgsCount, sizeof(UINT), false,
+			ER_BIND_UNORDERED_ACCESS | ER_BIND_SHADER_RESOURCE, 0, ER_RESOURCE_MISC_DRAWINDIRECT_ARGS, ER_RHI_FORMAT::ER_FORMAT_R32_UINT);
+
+		// both are reset in the clear pass every frame
+		mOcclusionCandidatesBuffer = rhi->CreateGPUBuffer("ER_RHI_GPUBuffer: GPU Culler - Occlusion Candidates Buffer");
+		mOcclusionCandidatesBuffer->CreateGPUBufferResource(rhi, nullptr, 1 + mBatchedInstancesCount * INDIRECT_OCCLUSION_CANDIDATE_SIZE, sizeof(UINT), false,
+			ER_BIND_UNORDERED_ACCESS | ER_BIND_SHADER_RESOURCE, 0, ER_RESOURCE_MISC_NONE, ER_RHI_FORMAT::ER_FORMAT_R32_UINT);
+		mOcclusionDispatchArgsBuffer = rhi->CreateGPUBuffer("ER_RHI_GPUBuffer: GPU Culler - Occlusion Dispatch Args Buffer");
+		mOcclusionDispatchArgsBuffer->CreateGPUBufferResource(rhi, nullptr, INDIRECT_DISPATCH_ARGS_COUNT, sizeof(UINT), false,
+			ER_BIND_UNORDERED_ACCESS, 0, ER_RESOURCE_MISC_DRAWINDIRECT_ARGS, ER_RHI_FORMAT::ER_FORMAT_R32_UINT);
+
+		for (UINT objectIndex = 0; objectIndex < static_cast<UINT>(mBatchedObjects.size()); objectIndex++)
+			mBatchedObjects[objectIndex]->SetIndirectBatch(mNewInstancesBuffer, mArgsBuffer, objects[objectIndex].NewInstancesOffset, objects[objectIndex].ArgsOffset);
+
+		ER_OUTPUT_LOG((L"[ER Logger][ER_GPUCuller] Rebuilt the batch: " + std::to_wstring(mBatchedObjects.size()) + L" objects, " + std::to_wstring(mBatchedInstancesCount) + L" instances\n").c_str());
 	}
 
 	void ER_GPUCuller::ClearCounters(ER_Scene* aScene)
 	{
 		assert(aScene);
+		if (!mArgsBuffer)
+			return;
+
 		auto rhi = mCore.GetRHI();
 
 		rhi->SetRootSignature(mIndirectCullingClearRS, true);
@@ -89,47 +265,76 @@ namespace EveryRay_Core
 		}
 		rhi->SetPSO(mPSOClearName, true);
 
-		for (ER_SceneObject& obPair : aScene->objects)
-		{
-			ER_RenderingObject* aObj = obPair.second;
-
-			if (!aObj->IsGPUIndirectlyRendered())
-				continue;
+		rhi->SetShaderResources(ER_COMPUTE, { mInitialArgsBuffer }, 0, mIndirectCullingClearRS, GPU_CULL_CLEAR_PASS_ROOT_DESCRIPTOR_TABLE_SRV_INDEX, true);
+		rhi->SetUnorderedAccessResources(ER_COMPUTE, { mArgsBuffer, mOcclusionDispatchArgsBuffer, mOcclusionCandidatesBuffer }, 0, mIndirectCullingClearRS, GPU_CULL_CLEAR_PASS_ROOT_DESCRIPTOR_TABLE_UAV_INDEX, true);
+		rhi->SetConstantBuffers(ER_COMPUTE, { mCullingConstantBuffer.Buffer() }, 0, mIndirectCullingClearRS, GPU_CULL_CLEAR_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX, true);
+		rhi->Dispatch(ER_DivideByMultiple(mBatchedArgsCount, INDIRECT_DISPATCH_GROUP_SIZE), 1u, 1u);
 
-			if (!aObj->GetIndirectArgsBuffer() || !aObj->GetIndirectNewInstanceBuffer())
-				continue;
-
-			rhi->ClearUAV(aObj->GetIndirectNewInstanceBuffer(), 0);
+		rhi->UnsetPSO();
+		rhi->UnbindResourcesFromShader(ER_COMPUTE);
+	}
 
-			rhi->SetUnorderedAccessResources(ER_COMPUTE,
-				{
-					aObj->GetIndirectArgsBuffer()
-				}, 0, mIndirectCullingRS, GPU_CULL_CLEAR_PASS_ROOT_DESCRIPTOR_TABLE_UAV_INDEX, true);
+	// one dispatch per level: level 0 is built from the depth buffer, every next level - from the previous one
+	void ER_GPUCuller::BuildHiZ(ER_RHI_GPUTexture* aDepth)
+	{
+		assert(aDepth);
+		auto rhi = mCore.GetRHI();
 
-			ER_RHI_GPUBuffer* meshConstants = nullptr;
-#if ER_PLATFORM_WIN64_DX11
-			UpdateMeshesConstantBuffer(aObj);
-			meshConstants = mMeshConstantBuffer.Buffer();
-#else
-			meshConstants = aObj->GetIndirectMeshConstantBuffer();
-#endif
-			rhi->SetConstantBuffers(ER_COMPUTE, { meshConstants }, 0, mIndirectCullingClearRS, GPU_CULL_CLEAR_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX, true);
+		rhi->SetRootSignature(mHiZRS, true);
+		if (!rhi->IsPSOReady(mPSOHiZName, true))
+		{
+			rhi->InitializePSO(mPSOHiZName, true);
+			rhi->SetShader(mHiZCS);
+			rhi->SetRootSignatureToPSO(mPSOHiZName, mHiZRS, true);
+			rhi->FinalizePSO(mPSOHiZName, true);
+		}
+		rhi->SetPSO(mPSOHiZName, true);
 
-			rhi->Dispatch(1u, 1u, 1u);
+		for (int i = 0; i < INDIRECT_HIZ_LEVELS; i++)
+		{
+			ER_RHI_GPUTexture* source = (i == 0) ? aDepth : mHiZLevels[i - 1];
+			ER_RHI_GPUTexture* destination = mHiZLevels[i];
+
+			mHiZConstantBuffers[i].Data.SourceDestSize = XMFLOAT4(static_cast<float>(source->GetWidth()), static_cast<float>(source->GetHeight()),
+				static_cast<float>(destination->GetWidth()), static_cast<float>(destination->GetHeight()));
+			mHiZConstantBuffers[i].ApplyChanges(rhi);
+
+			// UAV first: the previous level is still bound as UAV (DX11 would not bind it as SRV otherwise)
+			rhi->SetUnorderedAccessResources(ER_COMPUTE, { destination }, 0, mHiZRS, GPU_CULL_HIZ_PASS_ROOT_DESCRIPTOR_TABLE_UAV_INDEX, true);
+			rhi->SetShaderResources(ER_COMPUTE, { source }, 0, mHiZRS, GPU_CULL_HIZ_PASS_ROOT_DESCRIPTOR_TABLE_SRV_INDEX, true);
+			rhi->SetConstantBuffers(ER_COMPUTE, { mHiZConstantBuffers[i].Buffer() }, 0, mHiZRS, GPU_CULL_HIZ_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX, true);
+			rhi->Dispatch(ER_DivideByMultiple(destination->GetWidth(), 8u), ER_DivideByMultiple(destination->GetHeight(), 8u), 1u);
 		}
+
 		rhi->UnsetPSO();
 		rhi->UnbindResourcesFromShader(ER_COMPUTE);
 	}
 
-	void ER_GPUCuller::PerformCull(ER_Scene* aScene)
+	void ER_GPUCuller::PerformCull(ER_Scene* aScene, ER_RHI_GPUTexture* aPrevFrameDepth)
 	{
 		assert(aScene);
 
-		ClearCounters(aScene);
+		// the depth of the previous frame was rendered with the previous view-projection, so we have to track it even if nothing is culled
+		const XMMATRIX prevViewProjection = XMLoadFloat4x4(&mPrevViewProjection);
+		const bool isOcclusionCulling = ER_Utility::IsMainCameraGPUOcclusionCulling && aPrevFrameDepth && mHasPrevViewProjection;
+		XMStoreFloat4x4(&mPrevViewProjection, mCamera.ViewProjectionMatrix());
+		mHasPrevViewProjection = true;
+
+		if (!mArgsBuffer)
+			return;
 
-		mIndirectCullsCounterPerFrame = 0;
 		auto rhi = mCore.GetRHI();
 
+		if (isOcclusionCulling)
+			BuildHiZ(aPrevFrameDepth);
+
+		mCullingConstantBuffer.Data.InstancesCount = mBatchedInstancesCount;
+		mCullingConstantBuffer.Data.ArgsCount = mBatchedArgsCount;
+		mCullingConstantBuffer.Data.pad = XMINT2(0, 0);
+		mCullingConstantBuffer.ApplyChanges(rhi);
+
+		ClearCounters(aScene);
+
 		rhi->SetRootSignature(mIndirectCullingRS, true);
 		if (!rhi->IsPSOReady(mPSOName, true))
 		{
@@ -147,53 +352,48 @@ namespace EveryRay_Core
 			ER_Utility::DistancesLOD[1] * ER_Utility::DistancesLOD[1],
 			ER_Utility::DistancesLOD[2] * ER_Utility::DistancesLOD[2], 0.0f);
 		mCameraConstantBuffer.Data.CameraPos = XMFLOAT4(mCamera.Position().x, mCamera.Position().y, mCamera.Position().z, ER_Utility::IsMainCameraGPUCulling ? -1.0f : 1.0f);
+		mCameraConstantBuffer.Data.PrevViewProjection = XMMatrixTranspose(prevViewProjection);
+		mCameraConstantBuffer.Data.HiZParams = XMFLOAT4(isOcclusionCulling ? 1.0f : 0.0f, 0.0f, 0.0f, 0.0f);
 		mCameraConstantBuffer.ApplyChanges(rhi);
 
-		for (ER_SceneObject& obPair : aScene->objects)
-		{
-			ER_RenderingObject* aObj = obPair.second;
-
-			if (!aObj->IsGPUIndirectlyRendered())
-				continue;
+		rhi->SetShaderResources(ER_COMPUTE, { mInstancesBuffer, mInstanceObjectIndicesBuffer, mObjectsBuffer }, 0, mIndirectCullingRS, GPU_CULL_PASS_ROOT_DESCRIPTOR_TABLE_SRV_INDEX, true);
+		rhi->SetUnorderedAccessResources(ER_COMPUTE, { mNewInstancesBuffer, mArgsBuffer, mOcclusionCandidatesBuffer, mOcclusionDispatchArgsBuffer },
+			0, mIndirectCullingRS, GPU_CULL_PASS_ROOT_DESCRIPTOR_TABLE_UAV_INDEX, true);
+		rhi->SetConstantBuffers(ER_COMPUTE, { mCullingConstantBuffer.Buffer(), mCameraConstantBuffer.Buffer() },
+			0, mIndirectCullingRS, GPU_CULL_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX, true);
+		rhi->Dispatch(ER_DivideByMultiple(mBatchedInstancesCount, INDIRECT_DISPATCH_GROUP_SIZE), 1u, 1u);
 
-			if (!aObj->GetIndirectArgsBuffer() || !aObj->GetIndirectNewInstanceBuffer() || !aObj->GetIndirectOriginalInstanceBuffer())
-				continue;
-
-			rhi->SetShaderResources(ER_COMPUTE, { aObj->GetIndirectOriginalInstanceBuffer() }, 0, mIndirectCullingRS, GPU_CULL_PASS_ROOT_DESCRIPTOR_TABLE_SRV_INDEX, true);
-			
-			rhi->SetUnorderedAccessResources(ER_COMPUTE,
-				{ 
-					aObj->GetIndirectNewInstanceBuffer(),
-					aObj->GetIndirectArgsBuffer()
-				}, 0, mIndirectCullingRS, GPU_CULL_PASS_ROOT_DESCRIPTOR_TABLE_UAV_INDEX, true);
-
-			ER_RHI_GPUBuffer* meshConstants = nullptr;
-#if ER_PLATFORM_WIN64_DX11
-			UpdateMeshesConstantBuffer(aObj);
-			meshConstants = mMeshConstantBuffer.Buffer();
-#else
-			meshConstants = aObj->GetIndirectMeshConstantBuffer();
-#endif
-			rhi->SetConstantBuffers(ER_COMPUTE, { meshConstants, mCameraConstantBuffer.Buffer() },
-				0, mIndirectCullingRS, GPU_CULL_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX, true);
-
-			rhi->Dispatch(ER_DivideByMultiple(static_cast<UINT>(aObj->GetInstanceCount()), 64u), 1u, 1u);
-			mIndirectCullsCounterPerFrame++;
-		}
 		rhi->UnsetPSO();
 		rhi->UnbindResourcesFromShader(ER_COMPUTE);
-	}
 
-#if ER_PLATFORM_WIN64_DX11
-	void ER_GPUCuller::UpdateMeshesConstantBuffer(const ER_RenderingObject* aObj)
-	{
-		auto rhi = mCore.GetRHI();
-
-		const XMINT4* argsArray = aObj->GetIndirectDrawArgsArray();
-		memcpy(mMeshConstantBuffer.Data.IndexCount_StartIndexLoc_BaseVtxLoc_StartInstLoc, argsArray, sizeof(XMINT4) * MAX_LOD * MAX_MESH_COUNT);
-		mMeshConstantBuffer.Data.OriginalInstancesCount = aObj->GetInstanceCount();
-		mMeshConstantBuffer.Data.pad = XMINT3(0,0,0);
-		mMeshConstantBuffer.ApplyChanges(rhi);
+		// instances in the frustum were gathered by the pass above, which also counted the thread groups for them
+		if (isOcclusionCulling)
+		{
+			rhi->SetRootSignature(mIndirectCullingOcclusionRS, true);
+			if (!rhi->IsPSOReady(mPSOOcclusionName, true))
+			{
+				rhi->InitializePSO(mPSOOcclusionName, true);
+				rhi->SetShader(mIndirectCullingOcclusionCS);
+				rhi->SetRootSignatureToPSO(mPSOOcclusionName, mIndirectCullingOcclusionRS, true);
+				rhi->FinalizePSO(mPSOOcclusionName, true);
+			}
+			rhi->SetPSO(mPSOOcclusionName, true);
+
+			mOcclusionCullingSRVs.clear();
+			mOcclusionCullingSRVs.push_back(mInstancesBuffer);
+			mOcclusionCullingSRVs.push_back(mInstanceObjectIndicesBuffer);
+			mOcclusionCullingSRVs.push_back(mObjectsBuffer);
+			mOcclusionCullingSRVs.insert(mOcclusionCullingSRVs.end(), mHiZLevels.begin(), mHiZLevels.end());
+			mOcclusionCullingSRVs.push_back(mOcclusionCandidatesBuffer);
+
+			rhi->SetShaderResources(ER_COMPUTE, mOcclusionCullingSRVs, 0, mIndirectCullingOcclusionRS, GPU_CULL_OCCLUSION_PASS_ROOT_DESCRIPTOR_TABLE_SRV_INDEX, true);
+			rhi->SetUnorderedAccessResources(ER_COMPUTE, { mNewInstancesBuffer, mArgsBuffer }, 0, mIndirectCullingOcclusionRS, GPU_CULL_OCCLUSION_PASS_ROOT_DESCRIPTOR_TABLE_UAV_INDEX, true);
+			rhi->SetConstantBuffers(ER_COMPUTE, { mCullingConstantBuffer.Buffer(), mCameraConstantBuffer.Buffer() },
+				0, mIndirectCullingOcclusionRS, GPU_CULL_OCCLUSION_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX, true);
+			rhi->DispatchIndirect(mOcclusionDispatchArgsBuffer, 0);
+
+			rhi->UnsetPSO();
+			rhi->UnbindResourcesFromShader(ER_COMPUTE);
+		}
 	}
-#endif
 }
\ No newline at end of file
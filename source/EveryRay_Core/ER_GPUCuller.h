@@ -11,23 +11,48 @@ namespace EveryRay_Core
 
 	namespace IndirectCullingCBufferData
 	{
-#if ER_PLATFORM_WIN64_DX11
-		struct ER_ALIGN_GPU_BUFFER MeshConstants
+		struct ER_ALIGN_GPU_BUFFER CullingConstants
 		{
-			XMINT4 IndexCount_StartIndexLoc_BaseVtxLoc_StartInstLoc[MAX_LOD * MAX_MESH_COUNT];
-			UINT OriginalInstancesCount;
-			XMINT3 pad;
+			UINT InstancesCount;
+			UINT ArgsCount;
+			XMINT2 pad;
 		};
-#endif
 
 		struct ER_ALIGN_GPU_BUFFER CameraConstants
 		{
 			XMFLOAT4 FrustumPlanes[6];
 			XMFLOAT4 LodCameraDistances;
 			XMFLOAT4 CameraPos;
+			XMMATRIX PrevViewProjection;
+			XMFLOAT4 HiZParams;
+		};
+
+		struct ER_ALIGN_GPU_BUFFER HiZConstants
+		{
+			XMFLOAT4 SourceDestSize;
 		};
 	}
 
+	// should match "CullingObject" in IndirectCulling.hlsli
+	struct IndirectCullingObjectData
+	{
+		UINT OriginalInstancesCount;
+		UINT FirstInstance;
+		UINT NewInstancesOffset;
+		UINT ArgsOffset;
+		UINT MeshCount;
+		UINT pad[3];
+	};
+
+	// Culls the instances of all indirectly rendered objects in one dispatch (+ one dispatch for clearing the args and one for the occlusion culling).
+	// Instances of all objects are batched into shared buffers with per-object metadata (instance count and offsets in the output buffers),
+	// the objects draw from the shared buffers with their offsets. The batch is only rebuilt when the set of indirectly rendered objects changes.
+	// Instances are also occlusion culled against a hierarchical depth (Hi-Z) pyramid that is built from the previous frame's depth
+	// (every level is a separate texture, so we do not need per-mip views). Bounds are projected with the previous frame's view-projection,
+	// so the test is consistent with the depth; instances that become visible again appear one frame later.
+	// Only the instances in the frustum are occlusion tested: the first dispatch gathers them and counts the thread groups for the second one,
+	// which is dispatched indirectly (i.e., sized on the GPU without readbacks or a worst-case dispatch).
+	// Occluded instances can still cast visible shadows, so shadow casters get their own args/instances without the occlusion test (see INDIRECT_SHADOW_LOD_OFFSET).
 	class ER_GPUCuller : public ER_CoreComponent
 	{
 	public:
@@ -35,25 +60,51 @@ namespace EveryRay_Core
 		~ER_GPUCuller();
 
 		void Initialize();
-		void PerformCull(ER_Scene* aScene);
+		void UpdateBatch(ER_Scene* aScene); // has to be called after the objects are updated (their instance data is ready after the first update)
+		void PerformCull(ER_Scene* aScene, ER_RHI_GPUTexture* aPrevFrameDepth = nullptr); // no occlusion culling without the depth
 		void ClearCounters(ER_Scene* aScene);
 
+		int GetBatchedObjectsCount() const { return static_cast<int>(mBatchedObjects.size()); }
+		UINT GetBatchedInstancesCount() const { return mBatchedInstancesCount; }
 	private:
+		void ReleaseBatch();
+		void BuildHiZ(ER_RHI_GPUTexture* aDepth);
+
 		ER_Core& mCore;
 		ER_Camera& mCamera;
 
 		ER_RHI_GPUShader* mIndirectCullingCS = nullptr;
+		ER_RHI_GPUShader* mIndirectCullingOcclusionCS = nullptr;
 		ER_RHI_GPUShader* mIndirectCullingClearCS = nullptr;
-#if ER_PLATFORM_WIN64_DX11
-		void UpdateMeshesConstantBuffer(const ER_RenderingObject* aObj);
-		ER_RHI_GPUConstantBuffer<IndirectCullingCBufferData::MeshConstants> mMeshConstantBuffer;
-#endif
+		ER_RHI_GPUConstantBuffer<IndirectCullingCBufferData::CullingConstants> mCullingConstantBuffer;
 		ER_RHI_GPUConstantBuffer<IndirectCullingCBufferData::CameraConstants> mCameraConstantBuffer;
 		ER_RHI_GPURootSignature* mIndirectCullingRS = nullptr;
+		ER_RHI_GPURootSignature* mIndirectCullingOcclusionRS = nullptr;
 		ER_RHI_GPURootSignature* mIndirectCullingClearRS = nullptr;
 		const std::string mPSOName = "ER_RHI_GPUPipelineStateObject: Indirect Cull Pass";
+		const std::string mPSOOcclusionName = "ER_RHI_GPUPipelineStateObject: Indirect Cull Pass Occlusion";
 		const std::string mPSOClearName = "ER_RHI_GPUPipelineStateObject: Indirect Cull Pass Clear";
+
+		ER_RHI_GPUShader* mHiZCS = nullptr;
+		ER_RHI_GPURootSignature* mHiZRS = nullptr;
+		ER_RHI_GPUConstantBuffer<IndirectCullingCBufferData::HiZConstants> mHiZConstantBuffers[INDIRECT_HIZ_LEVELS]; // one per level (all levels are built in one submission)
+		std::vector<ER_RHI_GPUTexture*> mHiZLevels;
+		std::vector<ER_RHI_GPUResource*> mOcclusionCullingSRVs; // to avoid allocations every frame
+		const std::string mPSOHiZName = "ER_RHI_GPUPipelineStateObject: Indirect Cull Pass Hi-Z";
+		XMFLOAT4X4 mPrevViewProjection;
+		bool mHasPrevViewProjection = false;
 		
-		int mIndirectCullsCounterPerFrame = 0;
+		std::vector<ER_RenderingObject*> mBatchedObjects;
+		std::vector<ER_RenderingObject*> mTempBatchObjects; // to avoid allocations when checking the batch every frame
+		ER_RHI_GPUBuffer* mInstancesBuffer = nullptr; // original instances of all objects
+		ER_RHI_GPUBuffer* mInstanceObjectIndicesBuffer = nullptr; // object index for every instance
+		ER_RHI_GPUBuffer* mObjectsBuffer = nullptr; // IndirectCullingObjectData for every object
+		ER_RHI_GPUBuffer* mNewInstancesBuffer = nullptr; // culled instances of all objects (per LOD, camera and shadow ones)
+		ER_RHI_GPUBuffer* mArgsBuffer = nullptr; // draw args of all objects
+		ER_RHI_GPUBuffer* mInitialArgsBuffer = nullptr; // args with zero instance counts (copied to mArgsBuffer before culling)
+		ER_RHI_GPUBuffer* mOcclusionCandidatesBuffer = nullptr; // instances in the frustum (count + instance index and lod of every candidate)
+		ER_RHI_GPUBuffer* mOcclusionDispatchArgsBuffer = nullptr; // Dispatch() args of the occlusion culling (a thread group per INDIRECT_DISPATCH_GROUP_SIZE candidates)
+		UINT mBatchedInstancesCount = 0;
+		UINT mBatchedArgsCount = 0;
 	};
 }
\ No newline at end of file
@@ -1,9 +1,11 @@
 // Simple "generic" event system in EveryRay Rendering Engine
 // works with named/anonymous listeners
+// - listeners are stored contiguously and dispatched in place (Invoke() does not allocate or copy them)
+// - named listeners are found by pre-hashed handles (get them once with GetListenerHandle() and reuse), names are only hashed when listeners are added/removed
+// - listeners must not add/remove listeners of the same event while it is being invoked
 
 #pragma once
 #include <string>
-#include <unordered_map>
 #include <vector>
 #include <functional>
 #include "ER_CoreException.h"
@@ -12,51 +14,94 @@ template<typename T>
 class ER_GenericEvent
 {
 public:
+	using ListenerHandle = size_t;
+
+	static ListenerHandle GetListenerHandle(const std::string& pName) { return std::hash<std::string>()(pName); }
+
 	void AddListener(const std::string& pName, T pEventHandlerMethod)
 	{
-		if (mNamedListeners.find(pName) == mNamedListeners.end())
-			mNamedListeners[pName] = pEventHandlerMethod;
+		ListenerHandle handle = GetListenerHandle(pName);
+		for (const Listener& listener : mListeners)
+		{
+			if (listener.IsNamed && listener.Handle == handle)
+			{
+				if (listener.Name != pName)
+				{
+					std::string msg = "Listener's name has the same hash as the name of another listener: " + pName + ", " + listener.Name;
+					throw EveryRay_Core::ER_CoreException(msg.c_str());
+				}
+				return;
+			}
+		}
+		mListeners.push_back({ pEventHandlerMethod, pName, handle, true });
 	}
 	void AddListener(T pEventHandlerMethod)
 	{
-		mAnonymousListeners.push_back(pEventHandlerMethod);
+		mListeners.push_back({ pEventHandlerMethod, std::string(), 0, false });
 	}
 	void RemoveListener(const std::string& pName)
 	{
-		if (mNamedListeners.find(pName) != mNamedListeners.end())
-			mNamedListeners.erase(pName);
+		RemoveListener(GetListenerHandle(pName));
+	}
+	void RemoveListener(ListenerHandle pHandle)
+	{
+		for (auto it = mListeners.begin(); it != mListeners.end(); it++)
+		{
+			if (it->IsNamed && it->Handle == pHandle)
+			{
+				mListeners.erase(it);
+				return;
+			}
+		}
 	}
 	void RemoveAllListeners()
 	{
-		mNamedListeners.clear();
-		mAnonymousListeners.clear();
+		mListeners.clear();
 	}
 
-	std::vector<T> GetListeners()
+	// calls all listeners (in the order they were added)
+	template<typename... Args>
+	void Invoke(Args&&... args) const
 	{
-		std::vector<T> allListeners;
-		for (auto listener : mNamedListeners)
+		for (const Listener& listener : mListeners)
 		{
-			allListeners.push_back(listener.second);
+			if (listener.Handler)
+				listener.Handler(std::forward<Args>(args)...);
 		}
-		allListeners.insert(allListeners.end(), mAnonymousListeners.begin(), mAnonymousListeners.end());
-		return allListeners;
 	}
 
-	T GetListener(const std::string& pName)
+	// nullptr if there is no such listener; the pointer is valid until listeners are added/removed
+	const T* FindListener(ListenerHandle pHandle) const
 	{
-		auto it = mNamedListeners.find(pName);
-		if (it != mNamedListeners.end())
-			return it->second;
+		for (const Listener& listener : mListeners)
+		{
+			if (listener.IsNamed && listener.Handle == pHandle)
+				return &listener.Handler;
+		}
+		return nullptr;
+	}
+
+	const T& GetListener(const std::string& pName) const
+	{
+		const T* listener = FindListener(GetListenerHandle(pName));
+		if (listener)
+			return *listener;
 		else
 		{
 			std::string msg = "Listener was not found: " + pName;
 			throw EveryRay_Core::ER_CoreException(msg.c_str());
 		}
 	}
-	
+
+	bool HasListeners() const { return !mListeners.empty(); }
 
 private:
-	std::unordered_map<std::string, T> mNamedListeners;
-	std::vector<T> mAnonymousListeners;
-};
\ No newline at end of file
+	struct Listener
+	{
+		T Handler;
+		std::string Name; // only for named listeners
+		ListenerHandle Handle;
+		bool IsNamed;
+	};
+	std::vector<Listener> mListeners;
+};
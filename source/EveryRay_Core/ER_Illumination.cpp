@@ -27,6 +27,7 @@
 #include "ER_RenderingObject.h"
 #include "ER_Skybox.h"
 #include "ER_VolumetricFog.h"
+#include "ER_Settings.h"
 
 static const std::string voxelizationPSONames[NUM_VOXEL_GI_CASCADES] =
 {
@@ -41,6 +42,9 @@ static const std::string voxelizationPSONames[NUM_VOXEL_GI_CASCADES] =
 #define VCT_DEBUG_PASS_ROOT_DESCRIPTOR_TABLE_SRV_INDEX 0
 #define VCT_DEBUG_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX 1
 
+#define VCT_CLEAR_PASS_ROOT_DESCRIPTOR_TABLE_UAV_INDEX 0
+#define VCT_CLEAR_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX 1
+
 #define UPSAMPLE_BLUR_PASS_ROOT_DESCRIPTOR_TABLE_SRV_INDEX 0
 #define UPSAMPLE_BLUR_PASS_ROOT_DESCRIPTOR_TABLE_UAV_INDEX 1
 #define UPSAMPLE_BLUR_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX 2
@@ -60,8 +64,6 @@ static const std::string voxelizationPSONames[NUM_VOXEL_GI_CASCADES] =
 
 namespace EveryRay_Core {
 
-	const float voxelCascadesSizes[NUM_VOXEL_GI_CASCADES] = { 128.0, 128.0 };
-
 	ER_Illumination::ER_Illumination(ER_Core& game, ER_Camera& camera, const ER_DirectionalLight& light, const ER_ShadowMapper& shadowMapper, const ER_Scene* scene, GIQuality quality)
 		: 
 		ER_CoreComponent(game),
@@ -83,6 +85,24 @@ namespace EveryRay_Core {
 			mVCTDownscaleFactor = 0.75;
 			break;
 		}
+
+		// tier values from graphics_config.json
+		{
+			const int voxelCascadeResolution = ER_Settings::GIVoxelCascadeResolution;
+			if (voxelCascadeResolution < VCT_MIN_VOXEL_CASCADE_RESOLUTION || voxelCascadeResolution > VCT_MAX_VOXEL_CASCADE_RESOLUTION ||
+				(voxelCascadeResolution & (voxelCascadeResolution - 1)) != 0)
+				throw ER_CoreException("ER_Illumination: Voxel cascade resolution of the GI tier has to be a power of 2 in [32, 256]. Check graphics_config.json");
+
+			for (int i = 0; i < NUM_VOXEL_GI_CASCADES; i++)
+			{
+				mVoxelCascadesSizes[i] = static_cast<float>(voxelCascadeResolution);
+				mWorldVoxelScales[i] *= mVoxelCascadesSizes[i] / VCT_REFERENCE_VOXEL_CASCADE_RESOLUTION;
+			}
+
+			mVCTDiffuseConesCount = ER_Settings::GIDiffuseConesCount;
+			if (mVCTDiffuseConesCount != 1 && mVCTDiffuseConesCount != 4 && mVCTDiffuseConesCount != 6)
+				throw ER_CoreException("ER_Illumination: Diffuse cones count of the GI tier has to be 1, 4 or 6 (see VoxelConeTracingMain.hlsl). Check graphics_config.json");
+		}
 		Initialize(scene);
 	}
 
@@ -90,6 +110,7 @@ namespace EveryRay_Core {
 	{
 		DeleteObject(mVCTMainCS);
 		DeleteObject(mUpsampleBlurCS);
+		DeleteObject(mVoxelCascadeClearCS);
 		DeleteObject(mCompositeIlluminationCS);
 		DeleteObject(mVCTVoxelizationDebugVS);
 		DeleteObject(mVCTVoxelizationDebugGS);
@@ -106,10 +127,10 @@ namespace EveryRay_Core {
 		for (int i = 0; i < NUM_VOXEL_GI_CASCADES; i++)
 		{
 			DeleteObject(mVCTVoxelCascades3DRTs[i]);
+			DeleteObject(mVoxelizationInstanceBuffers[i]);
 			DeleteObject(mDebugVoxelZonesGizmos[i]);
 		}
 		DeleteObject(mVCTVoxelizationDebugRT);
-		DeleteObject(mVCTMainRT);
 		DeleteObject(mVCTUpsampleAndBlurRT);
 		DeleteObject(mLocalIlluminationRT);
 		DeleteObject(mFinalIlluminationRT);
@@ -121,6 +142,7 @@ namespace EveryRay_Core {
 		DeleteObject(mDeferredLightingRS);
 		DeleteObject(mVoxelizationRS);
 		DeleteObject(mVoxelizationDebugRS);
+		DeleteObject(mVoxelCascadeClearRS);
 		DeleteObject(mForwardLightingRS);
 		DeleteObject(mDebugProbesRenderRS);
 
@@ -128,6 +150,8 @@ namespace EveryRay_Core {
 		{
 			mVoxelizationDebugConstantBuffer.Release();
 			mVoxelConeTracingMainConstantBuffer.Release();
+			for (int i = 0; i < NUM_VOXEL_GI_CASCADES; i++)
+				mVoxelCascadeClearConstantBuffers[i].Release();
 		}
 
 		mUpsampleBlurConstantBuffer.Release();
@@ -158,6 +182,9 @@ namespace EveryRay_Core {
 
 				mVCTMainCS = rhi->CreateGPUShader();
 				mVCTMainCS->CompileShader(rhi, "content\\shaders\\GI\\VoxelConeTracingMain.hlsl", "CSMain", ER_COMPUTE);
+
+				mVoxelCascadeClearCS = rhi->CreateGPUShader();
+				mVoxelCascadeClearCS->CompileShader(rhi, "content\\shaders\\GI\\VoxelCascadeClear.hlsl", "CSMain", ER_COMPUTE);
 			}
 
 			mUpsampleBlurCS = rhi->CreateGPUShader();
@@ -214,6 +241,8 @@ namespace EveryRay_Core {
 			{
 				mVoxelizationDebugConstantBuffer.Initialize(rhi, "ER_RHI_GPUBuffer: Voxelization Debug CB");
 				mVoxelConeTracingMainConstantBuffer.Initialize(rhi, "ER_RHI_GPUBuffer: Voxel Cone Tracing Main CB");
+				for (int i = 0; i < NUM_VOXEL_GI_CASCADES; i++)
+					mVoxelCascadeClearConstantBuffers[i].Initialize(rhi, "ER_RHI_GPUBuffer: Voxel Cascade Clear CB #" + std::to_string(i));
 			}
 			mCompositeTotalIlluminationConstantBuffer.Initialize(rhi, "ER_RHI_GPUBuffer: Composite Total Illumination CB");
 			mUpsampleBlurConstantBuffer.Initialize(rhi, "ER_RHI_GPUBuffer: Upsample+Blur CB");
@@ -226,24 +255,24 @@ namespace EveryRay_Core {
 		{
 			if (mCurrentGIQuality != GIQuality::GI_LOW)
 			{
+				std::vector<XMFLOAT4X4> zeroInstances(VCT_MAX_VOXELIZATION_INSTANCES, XMFLOAT4X4());
 				for (int i = 0; i < NUM_VOXEL_GI_CASCADES; i++)
 				{
 					mVCTVoxelCascades3DRTs[i] = rhi->CreateGPUTexture(L"ER_RHI_GPUTexture: Voxel Cone Tracing 3D Cascade #" + std::to_wstring(i));
-					mVCTVoxelCascades3DRTs[i]->CreateGPUTextureResource(rhi, voxelCascadesSizes[i], voxelCascadesSizes[i], 1u,
-						ER_FORMAT_R8G8B8A8_UNORM, ER_BIND_SHADER_RESOURCE | ER_BIND_RENDER_TARGET | ER_BIND_UNORDERED_ACCESS, 6, voxelCascadesSizes[i]);
+					mVCTVoxelCascades3DRTs[i]->CreateGPUTextureResource(rhi, mVoxelCascadesSizes[i], mVoxelCascadesSizes[i], 1u,
+						ER_FORMAT_R8G8B8A8_UNORM, ER_BIND_SHADER_RESOURCE | ER_BIND_RENDER_TARGET | ER_BIND_UNORDERED_ACCESS, 6, mVoxelCascadesSizes[i]);
+
+					mVoxelizationInstanceBuffers[i] = rhi->CreateGPUBuffer("ER_RHI_GPUBuffer: Voxelization Instance Buffer #" + std::to_string(i));
+					mVoxelizationInstanceBuffers[i]->CreateGPUBufferResource(rhi, &zeroInstances[0], VCT_MAX_VOXELIZATION_INSTANCES, sizeof(XMFLOAT4X4), true, ER_BIND_VERTEX_BUFFER);
 
 					mVoxelCameraPositions[i] = XMFLOAT4(mCamera.Position().x, mCamera.Position().y, mCamera.Position().z, 1.0f);
 
 					mDebugVoxelZonesGizmos[i] = new ER_RenderableAABB(*mCore, XMFLOAT4(0.1f, 0.34f, 0.1f, 1.0f));
-					float maxBB = voxelCascadesSizes[i] / mWorldVoxelScales[i] * 0.5f;
+					float maxBB = mVoxelCascadesSizes[i] / mWorldVoxelScales[i] * 0.5f;
 					mLocalVoxelCascadesAABBs[i].first = XMFLOAT3(-maxBB, -maxBB, -maxBB);
 					mLocalVoxelCascadesAABBs[i].second = XMFLOAT3(maxBB, maxBB, maxBB);
 					mDebugVoxelZonesGizmos[i]->InitializeGeometry({ mLocalVoxelCascadesAABBs[i].first, mLocalVoxelCascadesAABBs[i].second });
 				}
-				mVCTMainRT = rhi->CreateGPUTexture(L"ER_RHI_GPUTexture: Voxel Cone Tracing Main RT");
-				mVCTMainRT->CreateGPUTextureResource(rhi, static_cast<UINT>(mCore->ScreenWidth()) * mVCTDownscaleFactor, static_cast<UINT>(mCore->ScreenHeight()) * mVCTDownscaleFactor, 1u,
-					ER_FORMAT_R8G8B8A8_UNORM, ER_BIND_SHADER_RESOURCE | ER_BIND_UNORDERED_ACCESS, 1);
-
 				mVCTUpsampleAndBlurRT = rhi->CreateGPUTexture(L"ER_RHI_GPUTexture: Voxel Cone Tracing Upsample+Blur RT");
 				mVCTUpsampleAndBlurRT->CreateGPUTextureResource(rhi, static_cast<UINT>(mCore->ScreenWidth()), static_cast<UINT>(mCore->ScreenHeight()), 1u,
 					ER_FORMAT_R8G8B8A8_UNORM, ER_BIND_SHADER_RESOURCE | ER_BIND_UNORDERED_ACCESS, 1);
@@ -307,6 +336,14 @@ namespace EveryRay_Core {
 					mVCTRS->InitDescriptorTable(rhi, VCT_MAIN_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX, { ER_RHI_DESCRIPTOR_RANGE_TYPE::ER_RHI_DESCRIPTOR_RANGE_TYPE_CBV }, { 0 }, { 1 }, ER_RHI_SHADER_VISIBILITY_ALL);
 					mVCTRS->Finalize(rhi, "ER_RHI_GPURootSignature: Voxel Cone Tracing Main Pass");
 				}
+
+				mVoxelCascadeClearRS = rhi->CreateRootSignature(2, 0);
+				if (mVoxelCascadeClearRS)
+				{
+					mVoxelCascadeClearRS->InitDescriptorTable(rhi, VCT_CLEAR_PASS_ROOT_DESCRIPTOR_TABLE_UAV_INDEX, { ER_RHI_DESCRIPTOR_RANGE_TYPE::ER_RHI_DESCRIPTOR_RANGE_TYPE_UAV }, { 0 }, { 1 }, ER_RHI_SHADER_VISIBILITY_ALL);
+					mVoxelCascadeClearRS->InitDescriptorTable(rhi, VCT_CLEAR_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX, { ER_RHI_DESCRIPTOR_RANGE_TYPE::ER_RHI_DESCRIPTOR_RANGE_TYPE_CBV }, { 0 }, { 1 }, ER_RHI_SHADER_VISIBILITY_ALL);
+					mVoxelCascadeClearRS->Finalize(rhi, "ER_RHI_GPURootSignature: Voxel Cascade Clear Pass");
+				}
 			}
 
 			mUpsampleAndBlurRS = rhi->CreateRootSignature(3, 1);
@@ -370,12 +407,6 @@ namespace EveryRay_Core {
 		materialSystems.mDirectionalLight = &mDirectionalLight;
 		materialSystems.mShadowMapper = &mShadowMapper;
 		materialSystems.mProbesManager = mProbesManager;
-
-		for (auto& obj : scene->objects)
-		{
-			if (obj.second->IsForwardShading())
-				mForwardPassObjects.emplace(obj);
-		}
 	}
 
 	void ER_Illumination::DrawLocalIllumination(ER_GBuffer* gbuffer, ER_Skybox* skybox)
@@ -408,7 +439,8 @@ namespace EveryRay_Core {
 	// Dynamic GI based on "Interactive Indirect Illumination Using Voxel Cone Tracing" by C.Crassin et al.
 	// https://research.nvidia.com/sites/default/files/pubs/2011-09_Interactive-Indirect-Illumination/GIVoxels-pg2011-authors.pdf
 	// Note: static GI uses light probes (if the scene has them) and that is already built in Deferred/Forward lighting
-	void ER_Illumination::DrawDynamicGlobalIllumination(ER_GBuffer* gbuffer, const ER_CoreTime& gameTime)
+	// Graphics part of dynamic GI: voxelization of the cascades (and the debug voxels view)
+	void ER_Illumination::DrawDynamicGlobalIlluminationVoxelization(const ER_CoreTime& gameTime)
 	{
 		ER_RHI* rhi = GetCore()->GetRHI();
 
@@ -417,14 +449,66 @@ namespace EveryRay_Core {
 
 		if (!mIsVCTEnabled)
 		{
-			rhi->ClearUAV(mVCTMainRT, clearColorBlack);
-			rhi->ClearUAV(mVCTUpsampleAndBlurRT, clearColorBlack);
+			// cascades are not kept up to date while VCT is disabled
+			for (int cascade = 0; cascade < NUM_VOXEL_GI_CASCADES; cascade++)
+				mVoxelCascadesUpdateRegions[cascade].IsFull = true;
 			return;
 		}
 
 		ER_RHI_Rect currentRect = { 0.0f, 0.0f, mCore->ScreenWidth(), mCore->ScreenHeight() };
 		ER_RHI_Viewport currentViewport = rhi->GetCurrentViewport();
 		ER_RHI_RASTERIZER_STATE currentRS = rhi->GetCurrentRasterizerState();
+
+		bool isAnyCascadePartiallyUpdated = false;
+		for (int cascade = 0; cascade < NUM_VOXEL_GI_CASCADES; cascade++)
+		{
+			mIsVoxelCascadeChanged[cascade] |= mVoxelCascadesUpdateRegions[cascade].IsFull || mVoxelCascadesUpdateRegions[cascade].BoxesCount > 0;
+			isAnyCascadePartiallyUpdated |= (!mVoxelCascadesUpdateRegions[cascade].IsFull && mVoxelCascadesUpdateRegions[cascade].BoxesCount > 0);
+		}
+
+		// fully updated cascades are cleared with ClearUAV() below, others only in their update boxes
+		if (isAnyCascadePartiallyUpdated)
+		{
+			rhi->BeginEventTag("EveryRay: Voxel Cone Tracing - Clear Update Boxes");
+			rhi->SetRootSignature(mVoxelCascadeClearRS, true);
+			if (!rhi->IsPSOReady(mVoxelCascadeClearPSOName, true))
+			{
+				rhi->InitializePSO(mVoxelCascadeClearPSOName, true);
+				rhi->SetShader(mVoxelCascadeClearCS);
+				rhi->SetRootSignatureToPSO(mVoxelCascadeClearPSOName, mVoxelCascadeClearRS, true);
+				rhi->FinalizePSO(mVoxelCascadeClearPSOName, true);
+			}
+			rhi->SetPSO(mVoxelCascadeClearPSOName, true);
+			for (int cascade = 0; cascade < NUM_VOXEL_GI_CASCADES; cascade++)
+			{
+				const VoxelCascadeUpdateRegion& region = mVoxelCascadesUpdateRegions[cascade];
+				if (region.IsFull || region.BoxesCount == 0)
+					continue;
+
+				XMFLOAT3 dispatchMin = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+				XMFLOAT3 dispatchMax = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+				for (int i = 0; i < region.BoxesCount; i++)
+				{
+					mVoxelCascadeClearConstantBuffers[cascade].Data.UpdateBoxesMin[i] = region.BoxesMin[i];
+					mVoxelCascadeClearConstantBuffers[cascade].Data.UpdateBoxesMax[i] = region.BoxesMax[i];
+					dispatchMin = XMFLOAT3(std::min(dispatchMin.x, region.BoxesMin[i].x), std::min(dispatchMin.y, region.BoxesMin[i].y), std::min(dispatchMin.z, region.BoxesMin[i].z));
+					dispatchMax = XMFLOAT3(std::max(dispatchMax.x, region.BoxesMax[i].x), std::max(dispatchMax.y, region.BoxesMax[i].y), std::max(dispatchMax.z, region.BoxesMax[i].z));
+				}
+				mVoxelCascadeClearConstantBuffers[cascade].Data.VoxelWindowOrigin = XMFLOAT4(mVoxelCascadesOrigins[cascade].x, mVoxelCascadesOrigins[cascade].y, mVoxelCascadesOrigins[cascade].z, static_cast<float>(region.BoxesCount));
+				mVoxelCascadeClearConstantBuffers[cascade].Data.DispatchOrigin = XMFLOAT4(dispatchMin.x, dispatchMin.y, dispatchMin.z, 0.0f);
+				mVoxelCascadeClearConstantBuffers[cascade].ApplyChanges(rhi);
+
+				rhi->SetUnorderedAccessResources(ER_COMPUTE, { mVCTVoxelCascades3DRTs[cascade] }, 0, mVoxelCascadeClearRS, VCT_CLEAR_PASS_ROOT_DESCRIPTOR_TABLE_UAV_INDEX, true);
+				rhi->SetConstantBuffers(ER_COMPUTE, { mVoxelCascadeClearConstantBuffers[cascade].Buffer() }, 0, mVoxelCascadeClearRS, VCT_CLEAR_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX, true);
+				rhi->Dispatch(
+					ER_DivideByMultiple(static_cast<UINT>(dispatchMax.x - dispatchMin.x), 4u),
+					ER_DivideByMultiple(static_cast<UINT>(dispatchMax.y - dispatchMin.y), 4u),
+					ER_DivideByMultiple(static_cast<UINT>(dispatchMax.z - dispatchMin.z), 4u));
+			}
+			rhi->UnsetPSO();
+			rhi->UnbindResourcesFromShader(ER_COMPUTE);
+			rhi->EndEventTag();
+		}
 		
 		ER_MaterialSystems materialSystems;
 		materialSystems.mCamera = &mCamera;
@@ -438,51 +522,51 @@ namespace EveryRay_Core {
 			rhi->SetRootSignature(mVoxelizationRS);
 			for (int cascade = 0; cascade < NUM_VOXEL_GI_CASCADES; cascade++)
 			{
-				ER_RHI_Viewport vctViewport = { 0.0f, 0.0f, voxelCascadesSizes[cascade], voxelCascadesSizes[cascade] };
+				const VoxelCascadeUpdateRegion& region = mVoxelCascadesUpdateRegions[cascade];
+				if (!region.IsFull && region.BoxesCount == 0)
+					continue; // nothing changed in the cascade
+
+				ER_RHI_Viewport vctViewport = { 0.0f, 0.0f, mVoxelCascadesSizes[cascade], mVoxelCascadesSizes[cascade] };
 				rhi->SetViewport(vctViewport);
 
-				ER_RHI_Rect vctRect = { 0.0f, 0.0f, voxelCascadesSizes[cascade], voxelCascadesSizes[cascade] };
+				ER_RHI_Rect vctRect = { 0.0f, 0.0f, mVoxelCascadesSizes[cascade], mVoxelCascadesSizes[cascade] };
 				rhi->SetRect(vctRect);
 
-				rhi->ClearUAV(mVCTVoxelCascades3DRTs[cascade], clearColorBlack);
+				if (region.IsFull)
+					rhi->ClearUAV(mVCTVoxelCascades3DRTs[cascade], clearColorBlack);
 
 				if (rhi->GetAPI() == ER_GRAPHICS_API::DX11)
 					rhi->SetRenderTargets({}, nullptr, mVCTVoxelCascades3DRTs[cascade]);
 				else
 					rhi->SetUnorderedAccessResources(ER_PIXEL, { mVCTVoxelCascades3DRTs[cascade] }, 0, mVoxelizationRS, VOXELIZATION_MAT_ROOT_DESCRIPTOR_TABLE_UAV_INDEX);
 
-				const std::string materialName = ER_MaterialHelper::voxelizationMaterialName + "_" + std::to_string(cascade);
+				const ER_MaterialID materialID = ER_MaterialHelper::GetMaterialID(ER_MaterialHelper::voxelizationMaterialName + "_" + std::to_string(cascade));
 				const std::string psoName = voxelizationPSONames[cascade];
+				const XMFLOAT4 voxelWindowOrigin = XMFLOAT4(mVoxelCascadesOrigins[cascade].x, mVoxelCascadesOrigins[cascade].y, mVoxelCascadesOrigins[cascade].z, static_cast<float>(region.BoxesCount));
 
-				for (auto& obj : mVoxelizationObjects[cascade])
+				// draws are already culled against the cascade (per instance/mesh) in CPUCullObjectsAgainstVoxelCascades(), camera culling does not apply here
+				for (const VoxelizationDraw& draw : mVoxelizationDraws[cascade])
 				{
-					if (!obj.second->IsInVoxelization())
+					ER_RenderingObject* renderingObject = draw.Object;
+					ER_Material* material = renderingObject->GetMaterial(materialID);
+					if (!material)
 						continue;
 
-					ER_RenderingObject* renderingObject = obj.second;
-					auto materialInfo = renderingObject->GetMaterials().find(materialName);
-					if (materialInfo != renderingObject->GetMaterials().end())
+					if (!rhi->IsPSOReady(psoName))
 					{
-						ER_Material* material = materialInfo->second;
-						for (int meshIndex = 0; meshIndex < obj.second->GetMeshCount(); meshIndex++)
-						{
-							if (!rhi->IsPSOReady(psoName))
-							{
-								rhi->InitializePSO(psoName);
-								material->PrepareShaders();
-								rhi->SetRasterizerState(ER_RHI_RASTERIZER_STATE::ER_NO_CULLING_NO_DEPTH_SCISSOR_ENABLED);
-								rhi->SetRootSignatureToPSO(psoName, mVoxelizationRS);
-								rhi->SetTopologyTypeToPSO(psoName, ER_RHI_PRIMITIVE_TYPE::ER_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-								rhi->SetRenderTargetFormats({});
-								rhi->FinalizePSO(psoName);
-							}
-							rhi->SetPSO(psoName);
-							static_cast<ER_VoxelizationMaterial*>(material)->PrepareForRendering(materialSystems, renderingObject, meshIndex,
-								mWorldVoxelScales[cascade], voxelCascadesSizes[cascade], mVoxelCameraPositions[cascade], mVoxelizationRS);
-							renderingObject->Draw(materialName, true, meshIndex);
-							rhi->UnsetPSO();
-						}
+						rhi->InitializePSO(psoName);
+						material->PrepareShaders();
+						rhi->SetRasterizerState(ER_RHI_RASTERIZER_STATE::ER_NO_CULLING_NO_DEPTH_SCISSOR_ENABLED);
+						rhi->SetRootSignatureToPSO(psoName, mVoxelizationRS);
+						rhi->SetTopologyTypeToPSO(psoName, ER_RHI_PRIMITIVE_TYPE::ER_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+						rhi->SetRenderTargetFormats({});
+						rhi->FinalizePSO(psoName);
 					}
+					rhi->SetPSO(psoName);
+					static_cast<ER_VoxelizationMaterial*>(material)->PrepareForRendering(materialSystems, renderingObject, draw.MeshIndex,
+						mWorldVoxelScales[cascade], mVoxelCascadesSizes[cascade], mVoxelCameraPositions[cascade], voxelWindowOrigin, region.BoxesMin, region.BoxesMax, mVoxelizationRS);
+					renderingObject->DrawLODWithInstances(materialID, draw.MeshIndex, 0, mVoxelizationInstanceBuffers[cascade], draw.InstancesCount, draw.FirstInstance);
+					rhi->UnsetPSO();
 				}
 
 				//voxelize extra objects
@@ -502,6 +586,9 @@ namespace EveryRay_Core {
 			}
 		}
 		rhi->EndEventTag();
+
+		for (int cascade = 0; cascade < NUM_VOXEL_GI_CASCADES; cascade++)
+			mVoxelCascadesUpdateRegions[cascade].IsFull = false;
 		
 		if (mVCTDebugMode == VCT_DEBUG_VOXELS)
 		{
@@ -516,7 +603,7 @@ namespace EveryRay_Core {
 			int cascade = mVCTVoxelsDebugSelectedCascade;
 			{
 				float scale = 1.0f / (mWorldVoxelScales[cascade] * 0.5f);
-				float sizeTranslateShift = -voxelCascadesSizes[cascade] / mWorldVoxelScales[cascade] * 0.5f;
+				float sizeTranslateShift = -mVoxelCascadesSizes[cascade] / mWorldVoxelScales[cascade] * 0.5f;
 				mVoxelizationDebugConstantBuffer.Data.WorldVoxelCube =
 					XMMatrixScaling(scale, scale, scale) *
 					XMMatrixTranslation(
@@ -524,6 +611,7 @@ namespace EveryRay_Core {
 						sizeTranslateShift - mVoxelCameraPositions[cascade].y,
 						sizeTranslateShift + mVoxelCameraPositions[cascade].z);
 				mVoxelizationDebugConstantBuffer.Data.ViewProjection = XMMatrixTranspose(mCamera.ViewMatrix() * mCamera.ProjectionMatrix());
+				mVoxelizationDebugConstantBuffer.Data.VoxelWindowOrigin = mVoxelCascadesOrigins[cascade];
 				mVoxelizationDebugConstantBuffer.ApplyChanges(rhi);
 
 				rhi->ClearRenderTarget(mVCTVoxelizationDebugRT, clearColorBlack);
@@ -549,7 +637,7 @@ namespace EveryRay_Core {
 				rhi->SetConstantBuffers(ER_VERTEX,   { mVoxelizationDebugConstantBuffer.Buffer() }, 0, mVoxelizationDebugRS, VCT_DEBUG_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX);
 				rhi->SetConstantBuffers(ER_GEOMETRY, { mVoxelizationDebugConstantBuffer.Buffer() }, 0, mVoxelizationDebugRS, VCT_DEBUG_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX);
 				rhi->SetConstantBuffers(ER_PIXEL,    { mVoxelizationDebugConstantBuffer.Buffer() }, 0, mVoxelizationDebugRS, VCT_DEBUG_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX);
-				rhi->DrawInstanced(voxelCascadesSizes[cascade] * voxelCascadesSizes[cascade] * voxelCascadesSizes[cascade], 1, 0, 0);
+				rhi->DrawInstanced(mVoxelCascadesSizes[cascade] * mVoxelCascadesSizes[cascade] * mVoxelCascadesSizes[cascade], 1, 0, 0);
 				rhi->UnsetPSO();
 
 				rhi->UnbindRenderTargets();
@@ -560,14 +648,28 @@ namespace EveryRay_Core {
 			}
 			rhi->EndEventTag();
 		}
-		else // main pass
+	}
+
+	// Compute part of dynamic GI: cone tracing and then upsampling/blurring (both can be recorded into the async compute queue)
+	void ER_Illumination::DrawDynamicGlobalIlluminationConeTracing(ER_GBuffer* gbuffer, ER_RHI_GPUTexture* aConeTracingRT)
+	{
+		ER_RHI* rhi = GetCore()->GetRHI();
+
+		if (mCurrentGIQuality == GIQuality::GI_LOW || !mIsVCTEnabled)
+			return;
+
+		assert(aConeTracingRT);
+		if (mVCTDebugMode != VCT_DEBUG_VOXELS) // main pass
 		{
-			rhi->BeginEventTag("EveryRay: Voxel Cone Tracing - Main");
-			rhi->UnbindRenderTargets();
+			rhi->BeginEventTag("EveryRay: Voxel Cone Tracing - Main", rhi->IsRecordingAsyncComputePass());
 
 			for (int i = 0; i < NUM_VOXEL_GI_CASCADES; i++)
 			{
-				rhi->GenerateMips(mVCTVoxelCascades3DRTs[i]);
+				if (mIsVoxelCascadeChanged[i])
+				{
+					rhi->GenerateMips(mVCTVoxelCascades3DRTs[i]);
+					mIsVoxelCascadeChanged[i] = false;
+				}
 				mVoxelConeTracingMainConstantBuffer.Data.VoxelCameraPositions[i] = mVoxelCameraPositions[i];
 				mVoxelConeTracingMainConstantBuffer.Data.WorldVoxelScales[i] = XMFLOAT4(mWorldVoxelScales[i], 0.0, 0.0, 0.0);
 			}
@@ -582,7 +684,8 @@ namespace EveryRay_Core {
 			mVoxelConeTracingMainConstantBuffer.Data.VoxelSampleOffset = mVCTVoxelSampleOffset;
 			mVoxelConeTracingMainConstantBuffer.Data.GIPower = mVCTGIPower;
 			mVoxelConeTracingMainConstantBuffer.Data.PreviousRadianceDelta = mVCTPreviousRadianceDelta;
-			mVoxelConeTracingMainConstantBuffer.Data.pad0 = XMFLOAT2(0.0, 0.0);
+			mVoxelConeTracingMainConstantBuffer.Data.DiffuseConesCount = static_cast<float>(mVCTDiffuseConesCount);
+			mVoxelConeTracingMainConstantBuffer.Data.pad0 = 0.0f;
 			mVoxelConeTracingMainConstantBuffer.ApplyChanges(rhi);
 
 			rhi->SetRootSignature(mVCTRS, true);
@@ -603,16 +706,31 @@ namespace EveryRay_Core {
 			for (int i = 0; i < NUM_VOXEL_GI_CASCADES; i++)
 				resources[4 + i] = mVCTVoxelCascades3DRTs[i];
 			rhi->SetShaderResources(ER_COMPUTE, resources, 0, mVCTRS, VCT_MAIN_PASS_ROOT_DESCRIPTOR_TABLE_SRV_INDEX, true);
-			rhi->SetUnorderedAccessResources(ER_COMPUTE, { mVCTMainRT }, 0, mVCTRS, VCT_MAIN_PASS_ROOT_DESCRIPTOR_TABLE_UAV_INDEX, true);
+			rhi->SetUnorderedAccessResources(ER_COMPUTE, { aConeTracingRT }, 0, mVCTRS, VCT_MAIN_PASS_ROOT_DESCRIPTOR_TABLE_UAV_INDEX, true);
 			rhi->SetConstantBuffers(ER_COMPUTE, { mVoxelConeTracingMainConstantBuffer.Buffer() }, 0, mVCTRS, VCT_MAIN_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX, true);
-			rhi->Dispatch(ER_DivideByMultiple(static_cast<UINT>(mVCTMainRT->GetWidth()), 8u), ER_DivideByMultiple(static_cast<UINT>(mVCTMainRT->GetHeight()), 8u), 1u);
+			rhi->Dispatch(ER_DivideByMultiple(static_cast<UINT>(aConeTracingRT->GetWidth()), 8u), ER_DivideByMultiple(static_cast<UINT>(aConeTracingRT->GetHeight()), 8u), 1u);
 			rhi->UnsetPSO();
 			rhi->UnbindResourcesFromShader(ER_COMPUTE);
 
-			rhi->EndEventTag();
+			rhi->EndEventTag(rhi->IsRecordingAsyncComputePass());
+		}
+	}
+
+	void ER_Illumination::UpsampleDynamicGlobalIllumination(ER_RHI_GPUTexture* aConeTracingRT)
+	{
+		ER_RHI* rhi = GetCore()->GetRHI();
+
+		if (mCurrentGIQuality == GIQuality::GI_LOW)
+			return;
+
+		if (!mIsVCTEnabled)
+		{
+			rhi->ClearUAV(mVCTUpsampleAndBlurRT, clearColorBlack);
+			return;
 		}
 
-		rhi->BeginEventTag("EveryRay: Voxel Cone Tracing - Upsample/Blur");
+		assert(aConeTracingRT);
+		rhi->BeginEventTag("EveryRay: Voxel Cone Tracing - Upsample/Blur", rhi->IsRecordingAsyncComputePass());
 		{
 			mUpsampleBlurConstantBuffer.Data.Upsample = true;
 			mUpsampleBlurConstantBuffer.ApplyChanges(rhi);
@@ -627,14 +745,14 @@ namespace EveryRay_Core {
 			}
 			rhi->SetPSO(mUpsampleBlurPSOName, true);
 			rhi->SetSamplers(ER_COMPUTE, { ER_RHI_SAMPLER_STATE::ER_TRILINEAR_WRAP });
-			rhi->SetShaderResources(ER_COMPUTE, { mVCTMainRT }, 0, mUpsampleAndBlurRS, UPSAMPLE_BLUR_PASS_ROOT_DESCRIPTOR_TABLE_SRV_INDEX, true);
+			rhi->SetShaderResources(ER_COMPUTE, { aConeTracingRT }, 0, mUpsampleAndBlurRS, UPSAMPLE_BLUR_PASS_ROOT_DESCRIPTOR_TABLE_SRV_INDEX, true);
 			rhi->SetUnorderedAccessResources(ER_COMPUTE, { mVCTUpsampleAndBlurRT }, 0, mUpsampleAndBlurRS, UPSAMPLE_BLUR_PASS_ROOT_DESCRIPTOR_TABLE_UAV_INDEX, true);
 			rhi->SetConstantBuffers(ER_COMPUTE, { mUpsampleBlurConstantBuffer.Buffer() }, 0, mUpsampleAndBlurRS, UPSAMPLE_BLUR_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX, true);
 			rhi->Dispatch(ER_DivideByMultiple(static_cast<UINT>(mVCTUpsampleAndBlurRT->GetWidth()), 8u), ER_DivideByMultiple(static_cast<UINT>(mVCTUpsampleAndBlurRT->GetHeight()), 8u), 1u);
 			rhi->UnsetPSO();
 			rhi->UnbindResourcesFromShader(ER_COMPUTE);
 		}
-		rhi->EndEventTag();
+		rhi->EndEventTag(rhi->IsRecordingAsyncComputePass());
 	}
 
 	// Combine GI output (Voxel Cone Tracing) with local illumination output
@@ -776,6 +894,9 @@ namespace EveryRay_Core {
 
 		// voxel data
 		{
+			// scrolls the cascades (and adds their newly exposed slabs to the update boxes)
+			UpdateVoxelCameraPosition();
+
 			for (int cascade = 0; cascade < NUM_VOXEL_GI_CASCADES; cascade++)
 			{
 				if (mIsVCTVoxelCameraPositionsUpdated[cascade])
@@ -791,12 +912,10 @@ namespace EveryRay_Core {
 					if (mDebugVoxelZonesGizmos[cascade])
 						mDebugVoxelZonesGizmos[cascade]->Update(mWorldVoxelCascadesAABBs[cascade]);
 				}
-				
-				// we need it every frame because objects can be dynamic
-				CPUCullObjectsAgainstVoxelCascade(scene, cascade);
 			}
 
-			UpdateVoxelCameraPosition();
+			// we need it every frame because objects can be dynamic
+			CPUCullObjectsAgainstVoxelCascades(scene);
 		}
 
 		UpdateImGui();
@@ -821,11 +940,13 @@ namespace EveryRay_Core {
 				ImGui::SliderFloat("VCT AO Falloff", &mVCTAoFalloff, 0.0f, 2.0f);
 				ImGui::SliderFloat("VCT Sampling Factor", &mVCTSamplingFactor, 0.01f, 3.0f);
 				ImGui::SliderFloat("VCT Sample Offset", &mVCTVoxelSampleOffset, -0.1f, 0.1f);
+				std::string tierText = "VCT Tier (graphics_config.json): " + std::to_string(static_cast<int>(mVoxelCascadesSizes[0])) + " voxels, " + std::to_string(mVCTDiffuseConesCount) + " diffuse cones";
+				ImGui::Text(tierText.c_str());
 				if (ImGui::CollapsingHeader("Voxel Cascades Properties"))
 				{
 					for (int cascade = 0; cascade < NUM_VOXEL_GI_CASCADES; cascade++)
 					{
-						std::string objectsInVolumeText = "Num objects in VCT Voxel Cascade " + std::to_string(cascade) + ": " + std::to_string(static_cast<int>(mVoxelizationObjects[cascade].size()));
+						std::string objectsInVolumeText = "Num objects voxelized in VCT Voxel Cascade " + std::to_string(cascade) + " (this frame): " + std::to_string(mVoxelizationObjectsCount[cascade]);
 						ImGui::Text(objectsInVolumeText.c_str());
 
 						std::string name = "Voxel Cascade " + std::to_string(cascade) + " Scale";
@@ -869,7 +990,7 @@ namespace EveryRay_Core {
 		if (mFoliageSystem)
 		{
 			//only first cascade due to performance
-			mFoliageSystem->SetVoxelizationParams(&mWorldVoxelScales[0], &voxelCascadesSizes[0], &mVoxelCameraPositions[0]);
+			mFoliageSystem->SetVoxelizationParams(&mWorldVoxelScales[0], &mVoxelCascadesSizes[0], &mVoxelCameraPositions[0]);
 		}
 	}
 
@@ -878,21 +999,105 @@ namespace EveryRay_Core {
 		if (mCurrentGIQuality == GIQuality::GI_LOW)
 			return;
 
+		// voxels store the shadows from the sun
+		const XMFLOAT3& sunDirection = mDirectionalLight.Direction();
+		const bool isSunChanged = sunDirection.x != mVoxelizationLastSunDirection.x || sunDirection.y != mVoxelizationLastSunDirection.y || sunDirection.z != mVoxelizationLastSunDirection.z;
+		mVoxelizationLastSunDirection = sunDirection;
+
+		const XMFLOAT3& cameraPosition = mCamera.Position();
 		for (int i = 0; i < NUM_VOXEL_GI_CASCADES; i++)
 		{
-			float halfCascadeBox = 0.5f * (voxelCascadesSizes[i] / mWorldVoxelScales[i] * 0.5f);
-			XMFLOAT3 voxelGridBoundsMax = XMFLOAT3{ mVoxelCameraPositions[i].x + halfCascadeBox, mVoxelCameraPositions[i].y + halfCascadeBox, mVoxelCameraPositions[i].z + halfCascadeBox };
-			XMFLOAT3 voxelGridBoundsMin = XMFLOAT3{ mVoxelCameraPositions[i].x - halfCascadeBox, mVoxelCameraPositions[i].y - halfCascadeBox, mVoxelCameraPositions[i].z - halfCascadeBox };
-			
-			if (mCamera.Position().x < voxelGridBoundsMin.x || mCamera.Position().y < voxelGridBoundsMin.y || mCamera.Position().z < voxelGridBoundsMin.z ||
-				mCamera.Position().x > voxelGridBoundsMax.x || mCamera.Position().y > voxelGridBoundsMax.y || mCamera.Position().z > voxelGridBoundsMax.z || mIsVCTAlwaysUpdated)
+			VoxelCascadeUpdateRegion& region = mVoxelCascadesUpdateRegions[i];
+			region.BoxesCount = 0;
+			if (isSunChanged || mIsVCTAlwaysUpdated)
+				region.IsFull = true;
+
+			const float scale = mWorldVoxelScales[i];
+			if (scale != mVoxelizationLastWorldVoxelScales[i])
 			{
-				mVoxelCameraPositions[i] = XMFLOAT4(mCamera.Position().x, mCamera.Position().y, mCamera.Position().z, 1.0f);
-				mIsVCTVoxelCameraPositionsUpdated[i] = true;
+				float maxBB = mVoxelCascadesSizes[i] / scale * 0.5f;
+				mLocalVoxelCascadesAABBs[i].first = XMFLOAT3(-maxBB, -maxBB, -maxBB);
+				mLocalVoxelCascadesAABBs[i].second = XMFLOAT3(maxBB, maxBB, maxBB);
+				mVoxelizationLastWorldVoxelScales[i] = scale;
+				region.IsFull = true;
 			}
-			else
-				mIsVCTVoxelCameraPositionsUpdated[i] = false;
+
+			// camera and cascade center in world voxel coordinates (y is flipped, like in the voxel textures)
+			const float dimension = mVoxelCascadesSizes[i];
+			const XMFLOAT3 cameraVoxel = XMFLOAT3(cameraPosition.x * scale, -cameraPosition.y * scale, cameraPosition.z * scale);
+			const XMFLOAT3 center = XMFLOAT3(mVoxelCascadesOrigins[i].x + 0.5f * dimension, mVoxelCascadesOrigins[i].y + 0.5f * dimension, mVoxelCascadesOrigins[i].z + 0.5f * dimension);
+
+			// the cascade scrolls in whole steps once the camera is more than a step away from its center
+			const float step = static_cast<float>(VCT_SCROLL_STEP_IN_VOXELS);
+			mIsVCTVoxelCameraPositionsUpdated[i] = region.IsFull ||
+				fabs(cameraVoxel.x - center.x) > step || fabs(cameraVoxel.y - center.y) > step || fabs(cameraVoxel.z - center.z) > step;
+			if (!mIsVCTVoxelCameraPositionsUpdated[i])
+				continue;
+
+			const XMFLOAT3 newCenter = XMFLOAT3(std::round(cameraVoxel.x / step) * step, std::round(cameraVoxel.y / step) * step, std::round(cameraVoxel.z / step) * step);
+			const float delta[3] = { newCenter.x - center.x, newCenter.y - center.y, newCenter.z - center.z };
+			mVoxelCascadesOrigins[i] = XMFLOAT4(newCenter.x - 0.5f * dimension, newCenter.y - 0.5f * dimension, newCenter.z - 0.5f * dimension, 0.0f);
+			mVoxelCameraPositions[i] = XMFLOAT4(newCenter.x / scale, -newCenter.y / scale, newCenter.z / scale, 1.0f);
+
+			if (fabs(delta[0]) >= dimension || fabs(delta[1]) >= dimension || fabs(delta[2]) >= dimension)
+				region.IsFull = true;
+
+			// newly exposed slabs (voxels that stayed inside of the cascade are already at the right place in the texture)
+			for (int axis = 0; axis < 3 && !region.IsFull; axis++)
+			{
+				if (delta[axis] == 0.0f)
+					continue;
+
+				float boxMin[3] = { 0.0f, 0.0f, 0.0f };
+				float boxMax[3] = { dimension, dimension, dimension };
+				if (delta[axis] > 0.0f)
+					boxMin[axis] = dimension - delta[axis];
+				else
+					boxMax[axis] = -delta[axis];
+				AddVoxelCascadeUpdateBox(i, XMFLOAT3(boxMin[0], boxMin[1], boxMin[2]), XMFLOAT3(boxMax[0], boxMax[1], boxMax[2]));
+			}
+		}
+	}
+
+	// box in voxels, relative to the cascade
+	void ER_Illumination::AddVoxelCascadeUpdateBox(int cascade, const XMFLOAT3& boxMin, const XMFLOAT3& boxMax)
+	{
+		VoxelCascadeUpdateRegion& region = mVoxelCascadesUpdateRegions[cascade];
+		if (region.IsFull)
+			return;
+
+		const float dimension = mVoxelCascadesSizes[cascade];
+		const XMFLOAT3 clampedMin = XMFLOAT3(std::max(boxMin.x, 0.0f), std::max(boxMin.y, 0.0f), std::max(boxMin.z, 0.0f));
+		const XMFLOAT3 clampedMax = XMFLOAT3(std::min(boxMax.x, dimension), std::min(boxMax.y, dimension), std::min(boxMax.z, dimension));
+		if (clampedMin.x >= clampedMax.x || clampedMin.y >= clampedMax.y || clampedMin.z >= clampedMax.z)
+			return;
+
+		if (region.BoxesCount == VCT_MAX_UPDATE_BOXES)
+		{
+			region.IsFull = true;
+			return;
 		}
+
+		const int index = region.BoxesCount++;
+		region.BoxesMin[index] = XMFLOAT4(clampedMin.x, clampedMin.y, clampedMin.z, 0.0f);
+		region.BoxesMax[index] = XMFLOAT4(clampedMax.x, clampedMax.y, clampedMax.z, 0.0f);
+
+		// world space AABB of the box for culling the draws
+		const float scale = mWorldVoxelScales[cascade];
+		const XMFLOAT4& origin = mVoxelCascadesOrigins[cascade];
+		region.BoxesWorldAABBs[index].first = XMFLOAT3((origin.x + clampedMin.x) / scale, -(origin.y + clampedMax.y) / scale, (origin.z + clampedMin.z) / scale);
+		region.BoxesWorldAABBs[index].second = XMFLOAT3((origin.x + clampedMax.x) / scale, -(origin.y + clampedMin.y) / scale, (origin.z + clampedMax.z) / scale);
+	}
+
+	void ER_Illumination::AddVoxelCascadeUpdateBox(int cascade, const ER_AABB& worldAABB)
+	{
+		const float scale = mWorldVoxelScales[cascade];
+		const XMFLOAT4& origin = mVoxelCascadesOrigins[cascade];
+
+		// expanded by a voxel, because partially covered voxels of the neighbours could have been written by the object, too
+		AddVoxelCascadeUpdateBox(cascade,
+			XMFLOAT3(floor(worldAABB.first.x * scale) - origin.x - 1.0f, floor(-worldAABB.second.y * scale) - origin.y - 1.0f, floor(worldAABB.first.z * scale) - origin.z - 1.0f),
+			XMFLOAT3(ceil(worldAABB.second.x * scale) - origin.x + 1.0f, ceil(-worldAABB.first.y * scale) - origin.y + 1.0f, ceil(worldAABB.second.z * scale) - origin.z + 1.0f));
 	}
 
 	void ER_Illumination::UpdatePointLightsDataCPU()
@@ -1000,23 +1205,30 @@ namespace EveryRay_Core {
 		rhi->SetRenderTargets({ aRenderTarget }, gbuffer->GetDepth());
 		rhi->SetRootSignature(mForwardLightingRS);
 		rhi->SetTopologyType(ER_RHI_PRIMITIVE_TYPE::ER_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-		for (auto& obj : mForwardPassObjects)
-			obj.second->Draw(ER_MaterialHelper::forwardLightingNonMaterialName);
-
-		rhi->UnsetPSO();
 
 		auto scene = mCore->GetLevel()->mScene;
 		assert(scene);
+
+		// objects are not cached here: they can be streamed in/out of the scene
+		for (auto& obj : scene->objects)
+		{
+			if (obj.second->IsForwardShading())
+				obj.second->Draw(ER_MaterialHelper::forwardLightingNonMaterialID);
+		}
+
+		rhi->UnsetPSO();
+
 		// Passes for all other materials (which are called "standard") that are rendered in "Forward" way into local illumination RT.
 		// This can be used for all kinds of materials that are layered onto each other (transparent ones can also be rendered here).
 		// TODO: We'd better render objects in batches per material in order to reduce SetRootSignature()/SetPSO() calls etc. Code below is not optimal
 		for (auto& it = scene->objects.begin(); it != scene->objects.end(); it++)
 		{
-			for (auto& mat : it->second->GetMaterials())
+			const std::vector<ER_MaterialID>& materialIDs = it->second->GetMaterialIDs();
+			for (ER_MaterialID materialID : materialIDs)
 			{
-				if (mat.second->IsStandard())
+				if (it->second->GetMaterial(materialID)->IsStandard())
 				{
-					it->second->Draw(mat.first);
+					it->second->Draw(materialID);
 					rhi->UnsetPSO();
 				}
 			}
@@ -1165,35 +1377,228 @@ namespace EveryRay_Core {
 		return mGbuffer->GetDepth();
 	}
 
-	void ER_Illumination::CPUCullObjectsAgainstVoxelCascade(const ER_Scene* scene, int cascade)
+	static bool IsAABBIntersecting(const ER_AABB& a, const ER_AABB& b)
+	{
+		return (a.first.x <= b.second.x && a.second.x >= b.first.x) &&
+			(a.first.y <= b.second.y && a.second.y >= b.first.y) &&
+			(a.first.z <= b.second.z && a.second.z >= b.first.z);
+	}
+
+	static bool IsAABBInside(const ER_AABB& a, const ER_AABB& b)
+	{
+		return (a.first.x >= b.first.x && a.second.x <= b.second.x) &&
+			(a.first.y >= b.first.y && a.second.y <= b.second.y) &&
+			(a.first.z >= b.first.z && a.second.z <= b.second.z);
+	}
+
+	static bool IsAABBEqual(const ER_AABB& a, const ER_AABB& b)
+	{
+		return a.first.x == b.first.x && a.first.y == b.first.y && a.first.z == b.first.z &&
+			a.second.x == b.second.x && a.second.y == b.second.y && a.second.z == b.second.z;
+	}
+
+	static float GetAABBMaxExtent(const ER_AABB& aabb)
+	{
+		return std::max(aabb.second.x - aabb.first.x, std::max(aabb.second.y - aabb.first.y, aabb.second.z - aabb.first.z));
+	}
+
+	// world space AABB of a local space AABB (thread-safe, unlike ER_RenderingObject::UpdateAABB())
+	static ER_AABB TransformAABB(const ER_AABB& aabb, const XMMATRIX& transform)
+	{
+		XMVECTOR minVec = XMVectorReplicate(FLT_MAX);
+		XMVECTOR maxVec = XMVectorReplicate(-FLT_MAX);
+		for (int i = 0; i < 8; i++)
+		{
+			XMVECTOR corner = XMVectorSet(
+				(i & 1) ? aabb.second.x : aabb.first.x,
+				(i & 2) ? aabb.second.y : aabb.first.y,
+				(i & 4) ? aabb.second.z : aabb.first.z, 1.0f);
+			corner = XMVector3TransformCoord(corner, transform);
+			minVec = XMVectorMin(minVec, corner);
+			maxVec = XMVectorMax(maxVec, corner);
+		}
+
+		ER_AABB result;
+		XMStoreFloat3(&result.first, minVec);
+		XMStoreFloat3(&result.second, maxVec);
+		return result;
+	}
+
+	void ER_Illumination::CPUCullObjectsAgainstVoxelCascades(const ER_Scene* scene)
 	{
 		if (mCurrentGIQuality == GIQuality::GI_LOW)
 			return;
 
+		// objects that moved, appeared or disappeared since the last frame are revoxelized in their old and new regions
+		// (AABBs are kept by scene ID, so streamed in/out objects only update their own regions, removed objects are left with an empty AABB)
+		const ER_AABB emptyAABB = { XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX), XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX) };
+		mVoxelizationChangedAABBs.clear();
+		mVoxelizationCurrentObjectsAABBs.assign(mVoxelizationLastObjectsAABBs.size(), emptyAABB);
+		for (size_t i = 0; i < scene->objects.size(); i++)
+		{
+			ER_RenderingObject* renderingObject = scene->objects[i].second;
+			const int sceneID = renderingObject->GetSceneID();
+			assert(sceneID >= 0);
+			if (sceneID >= static_cast<int>(mVoxelizationCurrentObjectsAABBs.size()))
+				mVoxelizationCurrentObjectsAABBs.resize(sceneID + 1, emptyAABB);
+
+			ER_AABB& currentAABB = mVoxelizationCurrentObjectsAABBs[sceneID];
+			if (renderingObject->IsInVoxelization() && renderingObject->IsLoaded())
+			{
+				if (renderingObject->IsInstanced())
+				{
+					for (UINT instance = 0; instance < renderingObject->GetInstanceCount(); instance++)
+					{
+						const ER_AABB& instanceAABB = renderingObject->GetInstanceAABB(instance);
+						currentAABB.first = XMFLOAT3(std::min(currentAABB.first.x, instanceAABB.first.x), std::min(currentAABB.first.y, instanceAABB.first.y), std::min(currentAABB.first.z, instanceAABB.first.z));
+						currentAABB.second = XMFLOAT3(std::max(currentAABB.second.x, instanceAABB.second.x), std::max(currentAABB.second.y, instanceAABB.second.y), std::max(currentAABB.second.z, instanceAABB.second.z));
+					}
+				}
+				else
+					currentAABB = renderingObject->GetGlobalAABB();
+			}
+		}
+
+		mVoxelizationLastObjectsAABBs.resize(mVoxelizationCurrentObjectsAABBs.size(), emptyAABB);
+		for (size_t sceneID = 0; sceneID < mVoxelizationCurrentObjectsAABBs.size(); sceneID++)
+		{
+			const ER_AABB& currentAABB = mVoxelizationCurrentObjectsAABBs[sceneID];
+			ER_AABB& lastAABB = mVoxelizationLastObjectsAABBs[sceneID];
+			if (IsAABBEqual(currentAABB, lastAABB))
+				continue;
+
+			if (!IsAABBEqual(lastAABB, emptyAABB))
+				mVoxelizationChangedAABBs.push_back(lastAABB);
+			if (!IsAABBEqual(currentAABB, emptyAABB))
+				mVoxelizationChangedAABBs.push_back(currentAABB);
+			lastAABB = currentAABB;
+		}
+
+		// every cascade only writes into its own arrays, so they are culled in parallel
+		if (scene->objects.size() < VCT_MIN_OBJECTS_FOR_PARALLEL_CULLING)
+		{
+			for (int cascade = 0; cascade < NUM_VOXEL_GI_CASCADES; cascade++)
+				CPUCullObjectsAgainstVoxelCascade(scene, cascade);
+		}
+		else
+		{
+			std::vector<std::thread> threads;
+			threads.reserve(NUM_VOXEL_GI_CASCADES - 1);
+			for (int cascade = 1; cascade < NUM_VOXEL_GI_CASCADES; cascade++)
+				threads.push_back(std::thread([this, scene, cascade]() { CPUCullObjectsAgainstVoxelCascade(scene, cascade); }));
+
+			CPUCullObjectsAgainstVoxelCascade(scene, 0);
+
+			for (auto& t : threads)
+				t.join();
+		}
+
+		ER_RHI* rhi = mCore->GetRHI();
+		for (int cascade = 0; cascade < NUM_VOXEL_GI_CASCADES; cascade++)
+		{
+			if (!mVoxelizationInstances[cascade].empty())
+				rhi->UpdateBuffer(mVoxelizationInstanceBuffers[cascade], &mVoxelizationInstances[cascade][0], static_cast<int>(mVoxelizationInstances[cascade].size() * sizeof(XMFLOAT4X4)));
+		}
+	}
+
+	void ER_Illumination::CPUCullObjectsAgainstVoxelCascade(const ER_Scene* scene, int cascade)
+	{
 		assert(cascade < NUM_VOXEL_GI_CASCADES);
 
-		//TODO add instancing support
-		//TODO fix repetition checks when the object AABB is bigger than the lower cascade (i.e. sponza)
-		//TODO add optimization for culling objects by checking its volume size in second+ cascades
-		//TODO add indirect drawing support (GPU cull)
-		//TODO add multithreading per cascade
+		std::vector<VoxelizationDraw>& draws = mVoxelizationDraws[cascade];
+		std::vector<XMFLOAT4X4>& instances = mVoxelizationInstances[cascade];
+		draws.clear();
+		instances.clear();
+		mVoxelizationObjectsCount[cascade] = 0;
+
+		const ER_AABB& cascadeAABB = mWorldVoxelCascadesAABBs[cascade];
+		VoxelCascadeUpdateRegion& region = mVoxelCascadesUpdateRegions[cascade];
+		for (const ER_AABB& changedAABB : mVoxelizationChangedAABBs)
+		{
+			if (IsAABBIntersecting(changedAABB, cascadeAABB))
+				AddVoxelCascadeUpdateBox(cascade, changedAABB);
+		}
+
+		if (region.IsFull)
+		{
+			const float dimension = mVoxelCascadesSizes[cascade];
+			region.BoxesCount = 1;
+			region.BoxesMin[0] = XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f);
+			region.BoxesMax[0] = XMFLOAT4(dimension, dimension, dimension, 0.0f);
+			region.BoxesWorldAABBs[0] = cascadeAABB;
+		}
+		else if (region.BoxesCount == 0)
+			return; // nothing to voxelize in this frame
+
+		// only the draws inside of the update boxes are needed (boxes are always inside of the cascade)
+		auto isInUpdateRegion = [&region](const ER_AABB& aabb)
+		{
+			for (int i = 0; i < region.BoxesCount; i++)
+			{
+				if (IsAABBIntersecting(aabb, region.BoxesWorldAABBs[i]))
+					return true;
+			}
+			return false;
+		};
+
+		const ER_MaterialID materialID = ER_MaterialHelper::GetMaterialID(ER_MaterialHelper::voxelizationMaterialName + "_" + std::to_string(cascade));
+		const float minObjectSize = (cascade > 0) ? VCT_MIN_OBJECT_SIZE_IN_VOXELS / mWorldVoxelScales[cascade] : 0.0f;
+
+		int objectsCount = 0;
 		for (auto& objectInfo : scene->objects)
 		{
-			if (!objectInfo.second->IsInVoxelization())
+			ER_RenderingObject* renderingObject = objectInfo.second;
+			if (!renderingObject->IsInVoxelization() || !renderingObject->IsLoaded())
+				continue;
+
+			if (!renderingObject->GetMaterial(materialID))
 				continue;
 
-			ER_AABB& aabbObj = objectInfo.second->GetGlobalAABB();
+			const size_t drawsCountBefore = draws.size();
+			if (renderingObject->IsInstanced())
+			{
+				// instances are culled one by one and copied into the instance buffer of the cascade (works for GPU indirectly rendered objects, too)
+				const std::vector<InstancedData>& instancesData = renderingObject->GetInstancesData();
+				const UINT firstInstance = static_cast<UINT>(instances.size());
+				for (UINT i = 0; i < static_cast<UINT>(instancesData.size()); i++)
+				{
+					if (instances.size() >= VCT_MAX_VOXELIZATION_INSTANCES)
+						break;
+
+					const ER_AABB& aabb = renderingObject->GetInstanceAABB(i);
+					if (isInUpdateRegion(aabb) && GetAABBMaxExtent(aabb) >= minObjectSize)
+						instances.push_back(instancesData[i].World);
+				}
+
+				const UINT instancesCount = static_cast<UINT>(instances.size()) - firstInstance;
+				if (instancesCount > 0)
+				{
+					for (int meshIndex = 0; meshIndex < renderingObject->GetMeshCount(); meshIndex++)
+						draws.push_back({ renderingObject, meshIndex, firstInstance, instancesCount });
+				}
+			}
+			else
+			{
+				const ER_AABB& aabb = renderingObject->GetGlobalAABB();
+				if (!isInUpdateRegion(aabb) || GetAABBMaxExtent(aabb) < minObjectSize)
+					continue;
+
+				// objects that do not fit into the cascade (i.e., sponza) or the update boxes are culled per mesh,
+				// fragments of the meshes that are partially outside are discarded in the voxelization shader
+				const bool isCulledPerMesh = renderingObject->GetMeshCount() > 1 && (!region.IsFull || !IsAABBInside(aabb, cascadeAABB));
+				for (int meshIndex = 0; meshIndex < renderingObject->GetMeshCount(); meshIndex++)
+				{
+					if (isCulledPerMesh &&
+						!isInUpdateRegion(TransformAABB(renderingObject->GetModel()->GetMeshAABB(meshIndex), renderingObject->GetTransformationMatrix())))
+						continue;
 
-			bool isColliding = objectInfo.second->IsInstanced() ||
-				((aabbObj.first.x <= mWorldVoxelCascadesAABBs[cascade].second.x && aabbObj.second.x >= mWorldVoxelCascadesAABBs[cascade].first.x) &&
-				 (aabbObj.first.y <= mWorldVoxelCascadesAABBs[cascade].second.y && aabbObj.second.y >= mWorldVoxelCascadesAABBs[cascade].first.y) &&
-				 (aabbObj.first.z <= mWorldVoxelCascadesAABBs[cascade].second.z && aabbObj.second.z >= mWorldVoxelCascadesAABBs[cascade].first.z));
+					draws.push_back({ renderingObject, meshIndex, 0, 0 });
+				}
+			}
 
-			auto it = mVoxelizationObjects[cascade].find(objectInfo.first);
-			if (isColliding && (it == mVoxelizationObjects[cascade].end()))
-				mVoxelizationObjects[cascade].insert(objectInfo);
-			else if (!isColliding && (it != mVoxelizationObjects[cascade].end()))
-				mVoxelizationObjects[cascade].erase(it);
+			if (draws.size() > drawsCountBefore)
+				objectsCount++;
 		}
+		mVoxelizationObjectsCount[cascade] = objectsCount;
 	}
 }
\ No newline at end of file
@@ -8,6 +8,13 @@
 // Voxel Cone Tracing (dynamic indirect illumination)
 #define NUM_VOXEL_GI_CASCADES 2
 #define NUM_VOXEL_GI_TEX_MIPS 6
+#define VCT_MAX_VOXELIZATION_INSTANCES 20000 // per cascade; instances above the limit are not voxelized
+#define VCT_MIN_OBJECT_SIZE_IN_VOXELS 1.0f // smaller objects (or instances) are not voxelized in the second+ cascades (they barely affect coarse voxels)
+#define VCT_MIN_OBJECTS_FOR_PARALLEL_CULLING 64 // below that cascades are culled on the calling thread
+#define VCT_SCROLL_STEP_IN_VOXELS 16 // cascades scroll in these steps (keeps the first mips aligned to the world; smaller - more frequent, but thinner slabs to voxelize)
+#define VCT_REFERENCE_VOXEL_CASCADE_RESOLUTION 128 // world voxel scales are set for that resolution (and adjusted for others, so the cascades cover the same volume)
+#define VCT_MIN_VOXEL_CASCADE_RESOLUTION (1 << (NUM_VOXEL_GI_TEX_MIPS - 1))
+#define VCT_MAX_VOXEL_CASCADE_RESOLUTION 256
 
 // These are common SRVs which are shared between Deferred/Forward lighting shaders. Keep them in sync with Lighting.hlsli!
 #define LIGHTING_SRV_INDEX_MAX_RESERVED_FOR_TEXTURES		4 // until which index bindings are reserved for textures (in both Deferred/Forward)
@@ -55,13 +62,9 @@ namespace EveryRay_Core
 	class ER_Skybox;
 	class ER_VolumetricFog;
 
-	// TODO: At the moment our GIQuality config only affects VCT and it's final output RT resolution (off, 0.5, 0.75), we can also add:
-	// - dynamic gi: 
-	// - - voxel resolution for vct per config (currently its hardcoded in 'voxelCascadesSizes')
-	// - - cone amounts per voxel trace (currently everything is hardcoded with 6 cones)
-	// - static gi:
-	// - - limit the amount of reflection probes per config
-	// - maybe something else...
+	// GIQuality affects VCT (off, 0.5 or 0.75 of the final output RT resolution) and is also a tier in 'gi_quality_tiers' of graphics_config.json (see ER_Settings):
+	// - dynamic gi: voxel cascades resolution and the amount of diffuse cones per voxel trace (VCT is off on GI_LOW, so only medium and high tiers use them)
+	// - static gi: limit of the specular probes in the volume around the camera (all tiers)
 	enum GIQuality
 	{
 		GI_LOW = 0,
@@ -90,6 +93,14 @@ namespace EveryRay_Core
 		{
 			XMMATRIX WorldVoxelCube;
 			XMMATRIX ViewProjection;
+			XMFLOAT4 VoxelWindowOrigin;
+		};
+		struct ER_ALIGN_GPU_BUFFER VoxelCascadeClearCB
+		{
+			XMFLOAT4 UpdateBoxesMin[VCT_MAX_UPDATE_BOXES];
+			XMFLOAT4 UpdateBoxesMax[VCT_MAX_UPDATE_BOXES];
+			XMFLOAT4 VoxelWindowOrigin;
+			XMFLOAT4 DispatchOrigin;
 		};
 		struct ER_ALIGN_GPU_BUFFER VoxelConeTracingMainCB
 		{
@@ -105,7 +116,8 @@ namespace EveryRay_Core
 			float VoxelSampleOffset;
 			float GIPower;
 			float PreviousRadianceDelta;
-			XMFLOAT2 pad0;
+			float DiffuseConesCount;
+			float pad0;
 		};
 		struct ER_ALIGN_GPU_BUFFER CompositeTotalIlluminationCB
 		{
@@ -160,7 +172,10 @@ namespace EveryRay_Core
 		void Initialize(const ER_Scene* scene);
 
 		void DrawLocalIllumination(ER_GBuffer* gbuffer, ER_Skybox* skybox);
-		void DrawDynamicGlobalIllumination(ER_GBuffer* gbuffer, const ER_CoreTime& gameTime);
+		void DrawDynamicGlobalIlluminationVoxelization(const ER_CoreTime& gameTime);
+		// cone tracing goes into a downscaled RT (transient texture of the render graph, see GetVCTDownscaleFactor()) that is then upsampled/blurred
+		void DrawDynamicGlobalIlluminationConeTracing(ER_GBuffer* gbuffer, ER_RHI_GPUTexture* aConeTracingRT);
+		void UpsampleDynamicGlobalIllumination(ER_RHI_GPUTexture* aConeTracingRT);
 		void CompositeTotalIllumination(ER_GBuffer* gbuffer);
 
 		void DrawDebugGizmos(ER_RHI_GPUTexture* aRenderTarget, ER_RHI_GPUTexture* aDepth, ER_RHI_GPURootSignature* rs);
@@ -178,6 +193,7 @@ namespace EveryRay_Core
 
 		ER_RHI_GPUTexture* GetLocalIlluminationRT() const { return mLocalIlluminationRT; }
 		ER_RHI_GPUTexture* GetFinalIlluminationRT() const { return mFinalIlluminationRT; }
+		float GetVCTDownscaleFactor() const { return mVCTDownscaleFactor; }
 		ER_RHI_GPUTexture* GetGBufferDepth() const;
 
 		void SetSSS(bool val) { mIsSSS = val; }
@@ -205,7 +221,10 @@ namespace EveryRay_Core
 
 		void UpdatePointLightsDataCPU();
 
+		void CPUCullObjectsAgainstVoxelCascades(const ER_Scene* scene);
 		void CPUCullObjectsAgainstVoxelCascade(const ER_Scene* scene, int cascade);
+		void AddVoxelCascadeUpdateBox(int cascade, const XMFLOAT3& boxMin, const XMFLOAT3& boxMax);
+		void AddVoxelCascadeUpdateBox(int cascade, const ER_AABB& worldAABB);
 
 		ER_Camera& mCamera;
 		const ER_DirectionalLight& mDirectionalLight;
@@ -216,8 +235,43 @@ namespace EveryRay_Core
 		ER_VolumetricFog* mVolumetricFog = nullptr;
 		ER_GBuffer* mGbuffer = nullptr;
 
-		using RenderingObjectInfo = std::map<std::string, ER_RenderingObject*>;
-		RenderingObjectInfo mVoxelizationObjects[NUM_VOXEL_GI_CASCADES];
+		// One draw call of the voxelization pass. Draws are rebuilt every frame into flat arrays (one per cascade),
+		// so that every cascade can be culled on its own thread without any synchronization.
+		struct VoxelizationDraw
+		{
+			ER_RenderingObject* Object;
+			int MeshIndex;
+			UINT FirstInstance; // in the instance buffer of the cascade
+			UINT InstancesCount; // 0 for non-instanced objects
+		};
+
+		// Cascades scroll toroidally: a voxel is stored at its world voxel coordinate modulo the resolution, so the voxels that stay
+		// inside of a moved cascade are not touched. Only the update boxes (newly exposed slabs and the regions of the objects
+		// that changed) are cleared and voxelized again; when nothing changed, the cascade is not voxelized at all.
+		struct VoxelCascadeUpdateRegion
+		{
+			XMFLOAT4 BoxesMin[VCT_MAX_UPDATE_BOXES]; // in voxels, relative to the cascade (inclusive)
+			XMFLOAT4 BoxesMax[VCT_MAX_UPDATE_BOXES]; // exclusive
+			ER_AABB BoxesWorldAABBs[VCT_MAX_UPDATE_BOXES];
+			int BoxesCount = 0;
+			bool IsFull = true; // the whole cascade (on start, too many boxes, far jumps, changed sun, etc.)
+		};
+		VoxelCascadeUpdateRegion mVoxelCascadesUpdateRegions[NUM_VOXEL_GI_CASCADES];
+		XMFLOAT4 mVoxelCascadesOrigins[NUM_VOXEL_GI_CASCADES] = { XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f), XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f) }; // first voxel of the cascade in world voxel coordinates (y is flipped, like in the voxel textures)
+		std::vector<ER_AABB> mVoxelizationLastObjectsAABBs; // per scene ID (for finding the objects that changed, appeared or disappeared)
+		std::vector<ER_AABB> mVoxelizationCurrentObjectsAABBs; // per scene ID
+		std::vector<ER_AABB> mVoxelizationChangedAABBs; // regions of the objects that changed in this frame (old and new)
+		XMFLOAT3 mVoxelizationLastSunDirection = XMFLOAT3(0.0f, 0.0f, 0.0f);
+		float mVoxelizationLastWorldVoxelScales[NUM_VOXEL_GI_CASCADES] = { 0.0f, 0.0f };
+		bool mIsVoxelCascadeChanged[NUM_VOXEL_GI_CASCADES] = { true, true }; // voxelized since the last mips generation
+		ER_RHI_GPUConstantBuffer<IlluminationCBufferData::VoxelCascadeClearCB> mVoxelCascadeClearConstantBuffers[NUM_VOXEL_GI_CASCADES];
+		ER_RHI_GPUShader* mVoxelCascadeClearCS = nullptr;
+		ER_RHI_GPURootSignature* mVoxelCascadeClearRS = nullptr;
+		std::string mVoxelCascadeClearPSOName = "ER_RHI_GPUPipelineStateObject: VCT GI - Voxel Cascade Clear Pass";
+		std::vector<VoxelizationDraw> mVoxelizationDraws[NUM_VOXEL_GI_CASCADES];
+		std::vector<XMFLOAT4X4> mVoxelizationInstances[NUM_VOXEL_GI_CASCADES]; // world matrices of the instances inside of the cascade (same layout as InstancedData)
+		ER_RHI_GPUBuffer* mVoxelizationInstanceBuffers[NUM_VOXEL_GI_CASCADES] = { nullptr, nullptr };
+		int mVoxelizationObjectsCount[NUM_VOXEL_GI_CASCADES] = { 0, 0 };
 
 		ER_RHI_GPUConstantBuffer<IlluminationCBufferData::VoxelizationDebugCB> mVoxelizationDebugConstantBuffer;
 		ER_RHI_GPUConstantBuffer<IlluminationCBufferData::VoxelConeTracingMainCB> mVoxelConeTracingMainConstantBuffer;
@@ -229,7 +283,6 @@ namespace EveryRay_Core
 
 		ER_RHI_GPUTexture* mVCTVoxelCascades3DRTs[NUM_VOXEL_GI_CASCADES] = { nullptr, nullptr };
 		ER_RHI_GPUTexture* mVCTVoxelizationDebugRT = nullptr;
-		ER_RHI_GPUTexture* mVCTMainRT = nullptr;
 		ER_RHI_GPUTexture* mVCTUpsampleAndBlurRT = nullptr;
 
 		ER_RHI_GPUTexture* mLocalIlluminationRT = nullptr;
@@ -300,7 +353,9 @@ namespace EveryRay_Core
 		ER_AABB mLocalVoxelCascadesAABBs[NUM_VOXEL_GI_CASCADES]; // constant, must not change after initialization
 		ER_AABB mWorldVoxelCascadesAABBs[NUM_VOXEL_GI_CASCADES]; // dynamic, changes with camera movement (not in every frame in order to save perf)
 		ER_RenderableAABB* mDebugVoxelZonesGizmos[NUM_VOXEL_GI_CASCADES] = { nullptr, nullptr };
-		float mWorldVoxelScales[NUM_VOXEL_GI_CASCADES] = { 2.0f, 0.5f };
+		float mWorldVoxelScales[NUM_VOXEL_GI_CASCADES] = { 2.0f, 0.5f }; // for VCT_REFERENCE_VOXEL_CASCADE_RESOLUTION
+		float mVoxelCascadesSizes[NUM_VOXEL_GI_CASCADES] = { VCT_REFERENCE_VOXEL_CASCADE_RESOLUTION, VCT_REFERENCE_VOXEL_CASCADE_RESOLUTION }; // resolution (in voxels)
+		int mVCTDiffuseConesCount = 6;
 
 		float mVCTIndirectDiffuseStrength = 0.4f;
 		float mVCTIndirectSpecularStrength = 1.0f;
@@ -311,8 +366,8 @@ namespace EveryRay_Core
 		float mVCTGIPower = 1.0f;
 		float mVCTPreviousRadianceDelta = 0.01f;
 		float mVCTDownscaleFactor = 0.5f; // % from full-res RT
-		bool mIsVCTVoxelCameraPositionsUpdated[NUM_VOXEL_GI_CASCADES] = { true, true }; // whether the volume was updated in the last frame
-		bool mIsVCTAlwaysUpdated = false; // update volumes every frame (only for debugging)
+		bool mIsVCTVoxelCameraPositionsUpdated[NUM_VOXEL_GI_CASCADES] = { true, true }; // whether the volume was moved in the last frame
+		bool mIsVCTAlwaysUpdated = false; // fully revoxelize volumes every frame (only for debugging)
 		
 		VCTDebugMode mVCTDebugMode = VCTDebugMode::VCT_DEBUG_NONE;
 		int mVCTVoxelsDebugSelectedCascade = 0; // cascade for VCTDebugMode::VCT_DEBUG_VOXELS
@@ -335,7 +390,6 @@ namespace EveryRay_Core
 		bool mShowDebugWindow = false;
 		bool mDebugShadowCascades = false; // only works in deferred mode
 
-		RenderingObjectInfo mForwardPassObjects;
 		GIQuality mCurrentGIQuality;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,154 @@
+#include "ER_InstanceBufferPool.h"
+#include "ER_Core.h"
+#include "ER_CoreException.h"
+#include "RHI\ER_RHI.h"
+
+namespace EveryRay_Core
+{
+	ER_InstanceBufferPool::ER_InstanceBufferPool(ER_Core& pCore, UINT aStride, UINT aInitialCapacity)
+		: mCore(pCore), mStride(aStride)
+	{
+		assert(mStride > 0);
+		Grow(std::max(aInitialCapacity, 1u));
+		RecreateBuffer();
+	}
+
+	ER_InstanceBufferPool::~ER_InstanceBufferPool()
+	{
+		DeleteObject(mBuffer);
+	}
+
+	ER_InstanceBufferRange ER_InstanceBufferPool::Allocate(UINT aCount)
+	{
+		ER_InstanceBufferRange range;
+		if (aCount == 0)
+			return range;
+
+		const std::lock_guard<std::mutex> lock(mMutex);
+
+		// first fit
+		auto freeRange = std::find_if(mFreeRanges.begin(), mFreeRanges.end(), [aCount](const ER_InstanceBufferRange& aFreeRange) { return aFreeRange.Count >= aCount; });
+		if (freeRange == mFreeRanges.end())
+		{
+			Grow(std::max(mCapacity * 2, mCapacity + aCount));
+			// new space is always at the end (merged with the last free range if it ends there)
+			freeRange = mFreeRanges.end() - 1;
+			assert(freeRange->Count >= aCount);
+		}
+
+		range.Offset = freeRange->Offset;
+		range.Count = aCount;
+
+		freeRange->Offset += aCount;
+		freeRange->Count -= aCount;
+		if (freeRange->Count == 0)
+			mFreeRanges.erase(freeRange);
+
+		mAllocatedCount += aCount;
+		return range;
+	}
+
+	void ER_InstanceBufferPool::Free(ER_InstanceBufferRange& aRange)
+	{
+		if (!aRange.IsValid())
+			return;
+
+		const std::lock_guard<std::mutex> lock(mMutex);
+		assert(aRange.Offset + aRange.Count <= mCapacity);
+		assert(mAllocatedCount >= aRange.Count);
+		mAllocatedCount -= aRange.Count;
+
+		auto next = std::lower_bound(mFreeRanges.begin(), mFreeRanges.end(), aRange.Offset,
+			[](const ER_InstanceBufferRange& aFreeRange, UINT aOffset) { return aFreeRange.Offset < aOffset; });
+		auto inserted = mFreeRanges.insert(next, aRange);
+
+		// merge with the neighbours
+		auto afterInserted = inserted + 1;
+		if (afterInserted != mFreeRanges.end() && inserted->Offset + inserted->Count == afterInserted->Offset)
+		{
+			inserted->Count += afterInserted->Count;
+			mFreeRanges.erase(afterInserted);
+		}
+		if (inserted != mFreeRanges.begin())
+		{
+			auto beforeInserted = inserted - 1;
+			if (beforeInserted->Offset + beforeInserted->Count == inserted->Offset)
+			{
+				beforeInserted->Count += inserted->Count;
+				mFreeRanges.erase(inserted);
+			}
+		}
+
+		aRange = ER_InstanceBufferRange();
+	}
+
+	void ER_InstanceBufferPool::Update(const ER_InstanceBufferRange& aRange, const void* aData, UINT aCount)
+	{
+		if (aCount == 0)
+			return;
+
+		const std::lock_guard<std::mutex> lock(mMutex);
+		assert(aCount <= aRange.Count);
+		assert(aRange.Offset + aRange.Count <= mCapacity);
+
+		memcpy(&mData[static_cast<size_t>(aRange.Offset) * mStride], aData, static_cast<size_t>(aCount) * mStride);
+		mIsDirty = true;
+	}
+
+	void ER_InstanceBufferPool::Flush()
+	{
+		const std::lock_guard<std::mutex> lock(mMutex);
+		if (mBufferCapacity != mCapacity)
+			RecreateBuffer();
+
+		if (!mIsDirty)
+			return;
+
+		const UINT usedEnd = GetUsedEnd();
+		if (usedEnd > 0)
+			mCore.GetRHI()->UpdateBuffer(mBuffer, &mData[0], static_cast<int>(usedEnd * mStride));
+		mIsDirty = false;
+	}
+
+	// Only grows the CPU side: allocations can happen on worker threads while the GPU buffer is used for rendering
+	void ER_InstanceBufferPool::Grow(UINT aMinCapacity)
+	{
+		assert(aMinCapacity > mCapacity);
+
+		const UINT oldCapacity = mCapacity;
+		mCapacity = aMinCapacity;
+		mData.resize(static_cast<size_t>(mCapacity) * mStride);
+
+		if (!mFreeRanges.empty() && mFreeRanges.back().Offset + mFreeRanges.back().Count == oldCapacity)
+			mFreeRanges.back().Count += mCapacity - oldCapacity;
+		else
+			mFreeRanges.push_back({ oldCapacity, mCapacity - oldCapacity });
+
+		std::wstring msg = L"[ER Logger][ER_InstanceBufferPool] Instance buffer pool capacity: " + std::to_wstring(mCapacity) + L" instances\n";
+		ER_OUTPUT_LOG(msg.c_str());
+	}
+
+	void ER_InstanceBufferPool::RecreateBuffer()
+	{
+		ER_RHI* rhi = mCore.GetRHI();
+
+		// old buffer might still be used by the frames in flight
+		if (mBuffer)
+		{
+			rhi->WaitForGpuOnGraphicsFence();
+			DeleteObject(mBuffer);
+		}
+
+		mBuffer = rhi->CreateGPUBuffer("ER_RHI_GPUBuffer: ER_InstanceBufferPool - Instance Buffer");
+		mBuffer->CreateGPUBufferResource(rhi, &mData[0], mCapacity, mStride, true, ER_BIND_VERTEX_BUFFER);
+		mBufferCapacity = mCapacity;
+		mIsDirty = true;
+	}
+
+	UINT ER_InstanceBufferPool::GetUsedEnd() const
+	{
+		if (!mFreeRanges.empty() && mFreeRanges.back().Offset + mFreeRanges.back().Count == mCapacity)
+			return mFreeRanges.back().Offset;
+		return mCapacity;
+	}
+}
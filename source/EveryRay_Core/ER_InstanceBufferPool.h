@@ -0,0 +1,60 @@
+#pragma once
+#include "Common.h"
+
+#define INSTANCE_BUFFER_POOL_INITIAL_CAPACITY 4096 // in instances
+
+namespace EveryRay_Core
+{
+	class ER_Core;
+	class ER_RHI_GPUBuffer;
+
+	// range of instances in the pool (offset is used as the start instance location of the draws)
+	struct ER_InstanceBufferRange
+	{
+		UINT Offset = 0;
+		UINT Count = 0;
+
+		bool IsValid() const { return Count > 0; }
+	};
+
+	// One dynamic instance (vertex) buffer shared by all objects that are instanced directly (not GPU indirectly rendered).
+	// Objects suballocate ranges for their actual instance counts (per LOD group) instead of owning buffers of the max size.
+	// - instance data is written to a CPU copy of the pool and uploaded once per frame in Flush() (with one map for all objects)
+	// - the pool grows when there is no free range for an allocation (ranges keep their offsets), the GPU buffer is recreated in the next Flush()
+	// - ranges can be allocated/updated from multiple threads (i.e., scene loading and streaming), Flush() is called from the main thread
+	class ER_InstanceBufferPool
+	{
+	public:
+		ER_InstanceBufferPool(ER_Core& pCore, UINT aStride, UINT aInitialCapacity = INSTANCE_BUFFER_POOL_INITIAL_CAPACITY);
+		~ER_InstanceBufferPool();
+
+		ER_InstanceBufferRange Allocate(UINT aCount);
+		void Free(ER_InstanceBufferRange& aRange); // invalidates the range
+		void Update(const ER_InstanceBufferRange& aRange, const void* aData, UINT aCount); // aCount <= aRange.Count
+
+		// (re)creates the GPU buffer if the pool has grown and uploads the CPU copy (up to the last allocated instance) if anything has changed;
+		// call after all ranges are updated for the frame and before drawing
+		void Flush();
+
+		ER_RHI_GPUBuffer* GetBuffer() const { return mBuffer; }
+		UINT GetStride() const { return mStride; }
+		UINT GetCapacity() const { return mCapacity; }
+		UINT GetAllocatedCount() const { return mAllocatedCount; }
+	private:
+		void Grow(UINT aMinCapacity);
+		void RecreateBuffer();
+		UINT GetUsedEnd() const;
+
+		ER_Core& mCore;
+		ER_RHI_GPUBuffer* mBuffer = nullptr;
+		std::vector<unsigned char> mData; // CPU copy of the whole pool
+		std::vector<ER_InstanceBufferRange> mFreeRanges; // sorted by offset, adjacent ranges are merged
+		UINT mStride = 0;
+		UINT mCapacity = 0;
+		UINT mBufferCapacity = 0; // of the GPU buffer (less than mCapacity until the next Flush() after growing)
+		UINT mAllocatedCount = 0;
+		bool mIsDirty = false;
+
+		std::mutex mMutex;
+	};
+}
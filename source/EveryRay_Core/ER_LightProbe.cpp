@@ -215,6 +215,7 @@ namespace EveryRay_Core
 				// This is incorrect and might cause issues like: 
 				// Probe P is next to object A, but object A is far from main camera => A does not have lod 0, probe P can not render A.
 				const int lod = 0;
+				const ER_MaterialID materialID = ER_MaterialHelper::GetMaterialID(materialListenerName + "_" + std::to_string(cubeMapFaceIndex));
 
 				//TODO change to culled objects per face (not a priority since we compute probes once)
 				for (auto& object : objectsToRender)
@@ -225,14 +226,14 @@ namespace EveryRay_Core
 					if (!object.second->IsInLightProbe())
 						continue;
 				
-					auto materialInfo = object.second->GetMaterials().find(materialListenerName + "_" + std::to_string(cubeMapFaceIndex));
-					if (materialInfo != object.second->GetMaterials().end())
+					ER_Material* material = object.second->GetMaterial(materialID);
+					if (material)
 					{
 						for (int meshIndex = 0; meshIndex < object.second->GetMeshCount(); meshIndex++)
 						{
-							materialInfo->second->PrepareShaders();
-							static_cast<ER_RenderToLightProbeMaterial*>(materialInfo->second)->PrepareForRendering(matSystems, object.second, meshIndex, mCubemapCameras[cubeMapFaceIndex], nullptr);
-							object.second->DrawLOD(materialInfo->first, false, meshIndex, lod, true);
+							material->PrepareShaders();
+							static_cast<ER_RenderToLightProbeMaterial*>(material)->PrepareForRendering(matSystems, object.second, meshIndex, mCubemapCameras[cubeMapFaceIndex], nullptr);
+							object.second->DrawLOD(materialID, false, meshIndex, lod, true);
 						}
 					}
 				}
@@ -11,6 +11,7 @@
 #include "ER_Model.h"
 #include "ER_Scene.h"
 #include "ER_RenderableAABB.h"
+#include "ER_Settings.h"
 #include "ER_QuadRenderer.h"
 #include "ER_DebugLightProbeMaterial.h"
 #include "ER_MaterialsCallbacks.h"
@@ -51,7 +52,7 @@ namespace EveryRay_Core
 			mTempSpecularCubemapDepthBuffers[i]->CreateGPUTextureResource(rhi, SPECULAR_PROBE_SIZE, SPECULAR_PROBE_SIZE, 1u, ER_FORMAT_D24_UNORM_S8_UINT, ER_BIND_SHADER_RESOURCE | ER_BIND_DEPTH_STENCIL);
 		}
 
-		mQuadRenderer = (ER_QuadRenderer*)game.GetServices().FindService(ER_QuadRenderer::TypeIdClass());
+		mQuadRenderer = game.GetServices().FindService<ER_QuadRenderer>();
 		assert(mQuadRenderer);
 		mConvolutionPS = rhi->CreateGPUShader();
 		mConvolutionPS->CompileShader(rhi, "content\\shaders\\IBL\\ProbeConvolution.hlsl", "PSMain", ER_PIXEL);
@@ -80,8 +81,13 @@ namespace EveryRay_Core
 		mDistanceBetweenSpecularProbes = scene->IsValueInSceneRoot("light_probes_specular_distance") ? scene->GetValueFromSceneRoot<float>("light_probes_specular_distance") : -1.0f;
 		if (mDistanceBetweenSpecularProbes > 0)
 		{
-			mSpecularProbesVolumeSize = MAX_CUBEMAPS_IN_VOLUME_PER_AXIS * mDistanceBetweenSpecularProbes * 0.5f;
-			mMaxSpecularProbesInVolumeCount = MAX_CUBEMAPS_IN_VOLUME_PER_AXIS * MAX_CUBEMAPS_IN_VOLUME_PER_AXIS * MAX_CUBEMAPS_IN_VOLUME_PER_AXIS;
+			// the volume around the camera is shrunk to the limit of the GI tier (graphics_config.json)
+			int cubemapsInVolumePerAxis = MAX_CUBEMAPS_IN_VOLUME_PER_AXIS;
+			while (cubemapsInVolumePerAxis > 1 && cubemapsInVolumePerAxis * cubemapsInVolumePerAxis * cubemapsInVolumePerAxis > ER_Settings::GISpecularProbesLimit)
+				cubemapsInVolumePerAxis--;
+
+			mSpecularProbesVolumeSize = cubemapsInVolumePerAxis * mDistanceBetweenSpecularProbes * 0.5f;
+			mMaxSpecularProbesInVolumeCount = cubemapsInVolumePerAxis * cubemapsInVolumePerAxis * cubemapsInVolumePerAxis;
 
 			SetupSpecularProbes(game, camera, scene, light, shadowMapper);
 		}
@@ -237,17 +243,16 @@ namespace EveryRay_Core
 		DeleteObjects(diffuseProbeCellsIndicesCPUBuffer);
 		
 		std::string name = "Debug diffuse lightprobes ";
-		scene->objects.emplace_back(name, new ER_RenderingObject(name, scene->objects.size(), core, camera,
+		mDiffuseProbeRenderingObject = scene->AddRenderingObject(name, new ER_RenderingObject(name, scene->objects.size(), core, camera,
 			ER_Utility::GetFilePath("content\\models\\sphere_lowpoly.fbx"), false, true));
 
 		MaterialShaderEntries shaderEntries;
 		shaderEntries.vertexEntry += "_instancing";
 
-		mDiffuseProbeRenderingObject = scene->objects[static_cast<int>(scene->objects.size()) - 1].second;
 		mDiffuseProbeRenderingObject->LoadMaterial(new ER_DebugLightProbeMaterial(core, shaderEntries, HAS_VERTEX_SHADER | HAS_PIXEL_SHADER, true), ER_MaterialHelper::debugLightProbeMaterialName);
 		mDiffuseProbeRenderingObject->LoadRenderBuffers();
 		mDiffuseProbeRenderingObject->LoadInstanceBuffers();
-		mDiffuseProbeRenderingObject->ResetInstanceData(mDiffuseProbesCountTotal, true);
+		mDiffuseProbeRenderingObject->ResetInstanceData(mDiffuseProbesCountTotal);
 		for (int i = 0; i < mDiffuseProbesCountTotal; i++) {
 			const XMFLOAT3& pos = mDiffuseProbes[i].GetPosition();
 			XMMATRIX worldT = XMMatrixTranslation(pos.x, pos.y, pos.z);
@@ -362,17 +367,16 @@ namespace EveryRay_Core
 		mSpecularProbesTexArrayIndicesGPUBuffer->CreateGPUBufferResource(rhi, mSpecularProbesTexArrayIndicesCPUBuffer, mSpecularProbesCountTotal, sizeof(int), true, ER_BIND_SHADER_RESOURCE, 0, ER_RESOURCE_MISC_BUFFER_STRUCTURED);
 
 		std::string name = "Debug specular lightprobes ";
-		scene->objects.emplace_back(name, new ER_RenderingObject(name, scene->objects.size(), game, camera,
+		mSpecularProbeRenderingObject = scene->AddRenderingObject(name, new ER_RenderingObject(name, scene->objects.size(), game, camera,
 			ER_Utility::GetFilePath("content\\models\\sphere_lowpoly.fbx"), false, true));
 		
 		MaterialShaderEntries shaderEntries;
 		shaderEntries.vertexEntry += "_instancing";
 
-		mSpecularProbeRenderingObject = scene->objects[static_cast<int>(scene->objects.size()) - 1].second;
 		mSpecularProbeRenderingObject->LoadMaterial(new ER_DebugLightProbeMaterial(game, shaderEntries, HAS_VERTEX_SHADER | HAS_PIXEL_SHADER, true), ER_MaterialHelper::debugLightProbeMaterialName);
 		mSpecularProbeRenderingObject->LoadRenderBuffers();
 		mSpecularProbeRenderingObject->LoadInstanceBuffers();
-		mSpecularProbeRenderingObject->ResetInstanceData(mSpecularProbesCountTotal, true);
+		mSpecularProbeRenderingObject->ResetInstanceData(mSpecularProbesCountTotal);
 		for (int i = 0; i < mSpecularProbesCountTotal; i++) {
 			const XMFLOAT3& pos = mSpecularProbes[i].GetPosition();
 			XMMATRIX worldT = XMMatrixTranslation(pos.x, pos.y, pos.z);
@@ -550,8 +554,6 @@ namespace EveryRay_Core
 		ER_RHI* rhi = game.GetRHI();
 
 		int numThreads = std::thread::hardware_concurrency();
-		if (game.GetRHI()->GetAPI() != ER_GRAPHICS_API::DX11)
-			numThreads = 1; //TODO fix this on DX12 (need to support multiple command lists)
 
 		assert(numThreads > 0);
 
@@ -619,8 +621,6 @@ namespace EveryRay_Core
 
 			std::vector<std::thread> threads;
 			int numThreads = std::thread::hardware_concurrency();
-			if (game.GetRHI()->GetAPI() != ER_GRAPHICS_API::DX11)
-				numThreads = 1; //TODO fix this on DX12 (need to support multiple command lists)
 
 			threads.reserve(numThreads);
 
@@ -671,10 +671,10 @@ namespace EveryRay_Core
 		rhi->SetRootSignature(rs);
 		if (probeObject && ready)
 		{
-			auto materialInfo = probeObject->GetMaterials().find(ER_MaterialHelper::debugLightProbeMaterialName);
-			if (materialInfo != probeObject->GetMaterials().end())
+			ER_Material* probeMaterial = probeObject->GetMaterial(ER_MaterialHelper::debugLightProbeMaterialID);
+			if (probeMaterial)
 			{
-				ER_DebugLightProbeMaterial* material = static_cast<ER_DebugLightProbeMaterial*>(materialInfo->second);
+				ER_DebugLightProbeMaterial* material = static_cast<ER_DebugLightProbeMaterial*>(probeMaterial);
 				if (!rhi->IsPSOReady(psoName))
 				{
 					rhi->InitializePSO(psoName);
@@ -689,7 +689,7 @@ namespace EveryRay_Core
 				}
 				rhi->SetPSO(psoName);
 				material->PrepareForRendering(materialSystems, probeObject, 0, static_cast<int>(aType), rs);
-				probeObject->Draw(ER_MaterialHelper::debugLightProbeMaterialName);
+				probeObject->Draw(ER_MaterialHelper::debugLightProbeMaterialID);
 				rhi->UnsetPSO();
 			}
 		}
@@ -732,27 +732,29 @@ namespace EveryRay_Core
 
 		if (probeRenderingObject)
 		{
-			auto& oldInstancedData = probeRenderingObject->GetInstancesData();
+			const auto& oldInstancedData = probeRenderingObject->GetInstancesData();
 			assert(oldInstancedData.size() == probes.size());
 
 			for (int i = 0; i < oldInstancedData.size(); i++)
 			{
+				XMFLOAT4X4 world = oldInstancedData[i].World;
 				bool isCulled = probes[i].IsCulled();
 				//writing culling flag to [4][4] of world instanced matrix
-				oldInstancedData[i].World._44 = isCulled ? 1.0f : 0.0f;
+				world._44 = isCulled ? 1.0f : 0.0f;
 				//writing cubemap index to [0][0] of world instanced matrix (since we don't need scale)
-				oldInstancedData[i].World._11 = -1.0f;
+				world._11 = -1.0f;
 				if (!isCulled)
 				{
 					if (aType == DIFFUSE_PROBE)
-						oldInstancedData[i].World._11 = static_cast<float>(i);
+						world._11 = static_cast<float>(i);
 					else
 					{
-						oldInstancedData[i].World._11 = static_cast<float>(mNonCulledSpecularProbesCount);
+						world._11 = static_cast<float>(mNonCulledSpecularProbesCount);
 						mNonCulledSpecularProbesCount++;
 						mNonCulledSpecularProbesIndices.push_back(i);
 					}
 				}
+				probeRenderingObject->SetInstanceTransform(i, XMLoadFloat4x4(&world));
 			}
 
 			probeRenderingObject->UpdateInstanceBuffer(oldInstancedData);
@@ -50,6 +50,7 @@ namespace EveryRay_Core
 		void PrepareShaders();
 
 		bool IsStandard() { return mIsStandard; };
+		bool IsPositionOnly() { return mIsPositionOnly; };
 	protected:
 		ER_RHI_InputLayout* mInputLayout = nullptr;
 		ER_RHI_GPUShader* mVertexShader = nullptr;
@@ -60,5 +61,6 @@ namespace EveryRay_Core
 		MaterialShaderEntries mShaderEntries;
 
 		bool mIsStandard = true; // non-standard materials (like shadow map, voxelization, gbuffer, etc.) are processed in their systems (ER_ShadowMapper, ER_Illumination, etc.)
+		bool mIsPositionOnly = false; // material only reads positions (i.e., depth without alpha testing), so ER_RenderingObject binds its position-only vertex stream
 	};
 }
\ No newline at end of file
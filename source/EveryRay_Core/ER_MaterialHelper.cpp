@@ -1,5 +1,6 @@
 
 #include "ER_MaterialHelper.h"
+#include "ER_CoreException.h"
 
 namespace EveryRay_Core
 {
@@ -14,4 +15,53 @@ namespace EveryRay_Core
 	const std::string ER_MaterialHelper::furShellMaterialName = "FurShellMaterial";
 
 	const std::string ER_MaterialHelper::forwardLightingNonMaterialName = "FORWARD_LIGHTING_NON_MATERIAL";
+
+	namespace
+	{
+		struct MaterialIDsRegistry
+		{
+			std::unordered_map<std::string, ER_MaterialID> IDs;
+			std::vector<std::string> Names; // by ID
+			std::mutex Mutex; // objects (and their materials) can be loaded from multiple threads
+		};
+
+		MaterialIDsRegistry& GetMaterialIDsRegistry()
+		{
+			static MaterialIDsRegistry registry;
+			return registry;
+		}
+	}
+
+	const ER_MaterialID ER_MaterialHelper::gbufferMaterialID = ER_MaterialHelper::GetMaterialID(ER_MaterialHelper::gbufferMaterialName);
+	const ER_MaterialID ER_MaterialHelper::debugLightProbeMaterialID = ER_MaterialHelper::GetMaterialID(ER_MaterialHelper::debugLightProbeMaterialName);
+	const ER_MaterialID ER_MaterialHelper::forwardLightingNonMaterialID = ER_MaterialHelper::GetMaterialID(ER_MaterialHelper::forwardLightingNonMaterialName);
+
+	ER_MaterialID ER_MaterialHelper::GetMaterialID(const std::string& materialName)
+	{
+		MaterialIDsRegistry& registry = GetMaterialIDsRegistry();
+		std::lock_guard<std::mutex> lock(registry.Mutex);
+
+		auto it = registry.IDs.find(materialName);
+		if (it != registry.IDs.end())
+			return it->second;
+
+		if (registry.Names.size() >= MAX_MATERIAL_IDS)
+		{
+			std::string msg = "ER_MaterialHelper: Too many material names, increase MAX_MATERIAL_IDS. Failed to register: " + materialName;
+			throw ER_CoreException(msg.c_str());
+		}
+
+		ER_MaterialID id = static_cast<ER_MaterialID>(registry.Names.size());
+		registry.Names.push_back(materialName);
+		registry.IDs.emplace(materialName, id);
+		return id;
+	}
+
+	std::string ER_MaterialHelper::GetMaterialName(ER_MaterialID materialID)
+	{
+		MaterialIDsRegistry& registry = GetMaterialIDsRegistry();
+		std::lock_guard<std::mutex> lock(registry.Mutex);
+
+		return (materialID >= 0 && materialID < static_cast<ER_MaterialID>(registry.Names.size())) ? registry.Names[materialID] : std::string();
+	}
 }
\ No newline at end of file
@@ -2,8 +2,12 @@
 
 #include "Common.h"
 
+#define MAX_MATERIAL_IDS 64 // every distinct material name (i.e., "ShadowMapMaterial 0", "FurShellMaterial_3") takes one ID; bump if needed
+
 namespace EveryRay_Core
 {
+	using ER_MaterialID = int; // index of the material in ER_RenderingObject; names are only used when materials are loaded/saved
+
 	class ER_MaterialHelper
 	{
 	public:
@@ -18,5 +22,13 @@ namespace EveryRay_Core
 		static const std::string furShellMaterialName;
 
 		static const std::string forwardLightingNonMaterialName;
+
+		static const ER_MaterialID gbufferMaterialID;
+		static const ER_MaterialID debugLightProbeMaterialID;
+		static const ER_MaterialID forwardLightingNonMaterialID;
+
+		// registers the name on first use (thread-safe); do not call it per object in render passes, get the ID once instead
+		static ER_MaterialID GetMaterialID(const std::string& materialName);
+		static std::string GetMaterialName(ER_MaterialID materialID);
 	};
 }
\ No newline at end of file
@@ -9,81 +9,85 @@
 
 #include "assimp\scene.h"
 
+#define OPTIMIZE_MESHES_ON_IMPORT 1 // comment if you need the original index/vertex order of the imported meshes (i.e., for debugging)
+
 namespace EveryRay_Core
 {
-	ER_Mesh::ER_Mesh(ER_Model& model, ER_ModelMaterial& material, aiMesh& mesh) : mModel(model), mMaterial(material), mName(mesh.mName.C_Str()), mVertices(), mNormals(), mTangents(), mBiNormals(), mTextureCoordinates(), mVertexColors(), mFaceCount(0), mIndices()
+	ER_Mesh::ER_Mesh(ER_Model& model, ER_ModelMaterial& material, aiMesh& mesh) : mModel(model), mMaterial(material), mName(mesh.mName.C_Str()), mInterleavedVertices(), mVertices(), mFaceCount(0), mIndices()
 	{
-		// Vertices
-		mVertices.reserve(mesh.mNumVertices);
+		// Vertices (interleaved + position-only streams, both allocated once)
+		// Note: only the first UV channel is used by the engine, so the other channels, binormals and vertex colors are not stored
+		const bool hasNormals = mesh.HasNormals();
+		const bool hasTangents = mesh.HasTangentsAndBitangents();
+		const bool hasTextureCoordinates = mesh.HasTextureCoords(0);
+
+		mVertices.resize(mesh.mNumVertices);
+		mInterleavedVertices.resize(mesh.mNumVertices);
 		for (UINT i = 0; i < mesh.mNumVertices; i++)
 		{
-			mVertices.push_back(XMFLOAT3(reinterpret_cast<const float*>(&mesh.mVertices[i])));
+			const aiVector3D& position = mesh.mVertices[i];
+			mVertices[i] = XMFLOAT3(position.x, position.y, position.z);
+
+			VertexPositionTextureNormalTangent& vertex = mInterleavedVertices[i];
+			vertex.Position = XMFLOAT4(position.x, position.y, position.z, 1.0f);
+			vertex.TextureCoordinates = hasTextureCoordinates ? XMFLOAT2(mesh.mTextureCoords[0][i].x, mesh.mTextureCoords[0][i].y) : XMFLOAT2(0.0f, 0.0f);
+			vertex.Normal = hasNormals ? XMFLOAT3(reinterpret_cast<const float*>(&mesh.mNormals[i])) : XMFLOAT3(0.0f, 0.0f, 0.0f);
+			vertex.Tangent = hasTangents ? XMFLOAT3(reinterpret_cast<const float*>(&mesh.mTangents[i])) : XMFLOAT3(0.0f, 0.0f, 0.0f);
 		}
 
-		// Normals
-		if (mesh.HasNormals())
+		// Faces
+		if (mesh.HasFaces())
 		{
-			mNormals.reserve(mesh.mNumVertices);
-			for (UINT i = 0; i < mesh.mNumVertices; i++)
-			{
-				mNormals.push_back(XMFLOAT3(reinterpret_cast<const float*>(&mesh.mNormals[i])));
-			}
-		}
+			mFaceCount = mesh.mNumFaces;
 
-		// Tangents and Binormals
-		if (mesh.HasTangentsAndBitangents())
-		{
-			mTangents.reserve(mesh.mNumVertices);
-			mBiNormals.reserve(mesh.mNumVertices);
-			for (UINT i = 0; i < mesh.mNumVertices; i++)
+			size_t indexCount = 0;
+			for (UINT i = 0; i < mFaceCount; i++)
+				indexCount += mesh.mFaces[i].mNumIndices;
+			mIndices.reserve(indexCount);
+
+			for (UINT i = 0; i < mFaceCount; i++)
 			{
-				mTangents.push_back(XMFLOAT3(reinterpret_cast<const float*>(&mesh.mTangents[i])));
-				mBiNormals.push_back(XMFLOAT3(reinterpret_cast<const float*>(&mesh.mBitangents[i])));
+				const aiFace& face = mesh.mFaces[i];
+				mIndices.insert(mIndices.end(), face.mIndices, face.mIndices + face.mNumIndices);
 			}
 		}
 
-		// Texture Coordinates
-		UINT uvChannelCount = mesh.GetNumUVChannels();
-		for (UINT i = 0; i < uvChannelCount; i++)
-		{
-			std::vector<XMFLOAT3> textureCoordinates;
-			textureCoordinates.reserve(mesh.mNumVertices);
-
-			aiVector3D* aiTextureCoordinates = mesh.mTextureCoords[i];
-			for (UINT j = 0; j < mesh.mNumVertices; j++)
-				textureCoordinates.push_back(XMFLOAT3(reinterpret_cast<const float*>(&aiTextureCoordinates[j])));
-
-			mTextureCoordinates.push_back(textureCoordinates);
-		}
+#if OPTIMIZE_MESHES_ON_IMPORT
+		if (mesh.mPrimitiveTypes == aiPrimitiveType_TRIANGLE)
+			Optimize(hasNormals);
+#endif
+	}
 
-		// Vertex Colors
-		UINT colorChannelCount = mesh.GetNumColorChannels();
-		for (UINT i = 0; i < colorChannelCount; i++)
-		{
-			std::vector<XMFLOAT4> vertexColors;
-			vertexColors.reserve(mesh.mNumVertices);
+	// Reorders indices for the post-transform vertex cache and for less overdraw, then reorders vertices for fetch locality (see ER_MeshOptimizer).
+	// Note: duplicated vertices are already welded by assimp at this point (aiProcess_JoinIdenticalVertices in ER_Model)
+	void ER_Mesh::Optimize(bool hasNormals)
+	{
+		const UINT vertexCount = static_cast<UINT>(mVertices.size());
+		if (vertexCount == 0 || mIndices.size() < 3 || mIndices.size() % 3 != 0)
+			return;
 
-			aiColor4D* aiVertexColors = mesh.mColors[i];
-			for (UINT j = 0; j < mesh.mNumVertices; j++)
-				vertexColors.push_back(XMFLOAT4(reinterpret_cast<const float*>(&aiVertexColors[j])));
+		mOptimizerStats.VertexCountBefore = vertexCount;
+		mOptimizerStats.ACMRBefore = ER_MeshOptimizer::CalculateACMR(mIndices, vertexCount, ER_MeshOptimizer::ACMR_FIFO_CACHE_SIZE, &mOptimizerStats.ATVRBefore);
 
-			mVertexColors.push_back(vertexColors);
-		}
-
-		// Faces (note: could pre-reserve if we limit primitive types)
-		if (mesh.HasFaces())
+		ER_MeshOptimizer::OptimizeVertexCache(mIndices, vertexCount);
 		{
-			mFaceCount = mesh.mNumFaces;
-			for (UINT i = 0; i < mFaceCount; i++)
+			std::vector<XMFLOAT3> normals;
+			if (hasNormals)
 			{
-				aiFace* face = &mesh.mFaces[i];
-
-				for (UINT j = 0; j < face->mNumIndices; j++)
-				{
-					mIndices.push_back(face->mIndices[j]);
-				}
+				normals.reserve(vertexCount);
+				for (const VertexPositionTextureNormalTangent& vertex : mInterleavedVertices)
+					normals.push_back(vertex.Normal);
 			}
+			ER_MeshOptimizer::OptimizeOverdraw(mIndices, mVertices, normals);
 		}
+
+		std::vector<UINT> remap;
+		const UINT newVertexCount = ER_MeshOptimizer::OptimizeVertexFetch(mIndices, vertexCount, remap);
+		ER_MeshOptimizer::RemapVertexStream(mVertices, remap, newVertexCount);
+		ER_MeshOptimizer::RemapVertexStream(mInterleavedVertices, remap, newVertexCount);
+
+		mOptimizerStats.VertexCountAfter = newVertexCount;
+		mOptimizerStats.ACMRAfter = ER_MeshOptimizer::CalculateACMR(mIndices, newVertexCount, ER_MeshOptimizer::ACMR_FIFO_CACHE_SIZE, &mOptimizerStats.ATVRAfter);
 	}
 
 	/*ER_Mesh::ER_Mesh(Model & model, ER_ModelMaterial * material)
@@ -114,29 +118,9 @@ namespace EveryRay_Core
 		return mVertices;
 	}
 
-	const std::vector<XMFLOAT3>& ER_Mesh::Normals() const
-	{
-		return mNormals;
-	}
-
-	const std::vector<XMFLOAT3>& ER_Mesh::Tangents() const
+	const std::vector<VertexPositionTextureNormalTangent>& ER_Mesh::InterleavedVertices() const
 	{
-		return mTangents;
-	}
-
-	const std::vector<XMFLOAT3>& ER_Mesh::BiNormals() const
-	{
-		return mBiNormals;
-	}
-
-	const std::vector<std::vector<XMFLOAT3>>& ER_Mesh::TextureCoordinates() const
-	{
-		return mTextureCoordinates;
-	}
-
-	const std::vector<std::vector<XMFLOAT4>>& ER_Mesh::VertexColors() const
-	{
-		return mVertexColors;
+		return mInterleavedVertices;
 	}
 
 	UINT ER_Mesh::FaceCount() const
@@ -158,90 +142,41 @@ namespace EveryRay_Core
 
 	void ER_Mesh::CreateVertexBuffer_Position(ER_RHI_GPUBuffer* vertexBuffer) const
 	{
-		const std::vector<XMFLOAT3>& sourceVertices = Vertices();
 		std::vector<VertexPosition> vertices;
-		vertices.reserve(sourceVertices.size());
-
-		for (UINT i = 0; i < sourceVertices.size(); i++)
-		{
-			XMFLOAT3 position = sourceVertices.at(i);
+		vertices.reserve(mVertices.size());
+		for (const XMFLOAT3& position : mVertices)
 			vertices.push_back(VertexPosition(XMFLOAT4(position.x, position.y, position.z, 1.0f)));
-		}
 
 		assert(vertexBuffer);
 		vertexBuffer->CreateGPUBufferResource(mModel.GetCore().GetRHI(), &vertices[0], static_cast<UINT>(vertices.size()), sizeof(VertexPosition), false, ER_BIND_VERTEX_BUFFER);
 	}
 
-	void ER_Mesh::CreateVertexBuffer_PositionUv(ER_RHI_GPUBuffer* vertexBuffer, int uvChannel) const
+	void ER_Mesh::CreateVertexBuffer_PositionUv(ER_RHI_GPUBuffer* vertexBuffer) const
 	{
-		const std::vector<XMFLOAT3>& sourceVertices = Vertices();
-		const std::vector<XMFLOAT3>& textureCoordinates = mTextureCoordinates[uvChannel];
-		assert(textureCoordinates.size() == sourceVertices.size());
-
 		std::vector<VertexPositionTexture> vertices;
-		vertices.reserve(sourceVertices.size());
-		for (UINT i = 0; i < sourceVertices.size(); i++)
-		{
-			XMFLOAT3 position = sourceVertices.at(i);
-			XMFLOAT3 uv = textureCoordinates.at(i);
-			vertices.push_back(VertexPositionTexture(XMFLOAT4(position.x, position.y, position.z, 1.0f), XMFLOAT2(uv.x, uv.y)));
-		}
+		vertices.reserve(mInterleavedVertices.size());
+		for (const VertexPositionTextureNormalTangent& vertex : mInterleavedVertices)
+			vertices.push_back(VertexPositionTexture(vertex.Position, vertex.TextureCoordinates));
 
 		assert(vertexBuffer);
 		vertexBuffer->CreateGPUBufferResource(mModel.GetCore().GetRHI(), &vertices[0], static_cast<UINT>(vertices.size()), sizeof(VertexPositionTexture), false, ER_BIND_VERTEX_BUFFER);
 	}
 
-	void ER_Mesh::CreateVertexBuffer_PositionUvNormal(ER_RHI_GPUBuffer* vertexBuffer, int uvChannel) const
+	void ER_Mesh::CreateVertexBuffer_PositionUvNormal(ER_RHI_GPUBuffer* vertexBuffer) const
 	{
-		const std::vector<XMFLOAT3>& sourceVertices = Vertices();
-		const std::vector<XMFLOAT3>& textureCoordinates = mTextureCoordinates[uvChannel];
-		assert(textureCoordinates.size() == sourceVertices.size());
-
-		const std::vector<XMFLOAT3>& normals = Normals();
-		assert(normals.size() == sourceVertices.size());
-
 		std::vector<VertexPositionTextureNormal> vertices;
-		vertices.reserve(sourceVertices.size());
-
-		for (UINT i = 0; i < sourceVertices.size(); i++)
-		{
-			XMFLOAT3 position = sourceVertices.at(i);
-			XMFLOAT3 uv = textureCoordinates.at(i);
-			XMFLOAT3 normal = normals.at(i);
-
-			vertices.push_back(VertexPositionTextureNormal(XMFLOAT4(position.x, position.y, position.z, 1.0f), XMFLOAT2(uv.x, uv.y), normal));
-		}
+		vertices.reserve(mInterleavedVertices.size());
+		for (const VertexPositionTextureNormalTangent& vertex : mInterleavedVertices)
+			vertices.push_back(VertexPositionTextureNormal(vertex.Position, vertex.TextureCoordinates, vertex.Normal));
 
 		assert(vertexBuffer);
 		vertexBuffer->CreateGPUBufferResource(mModel.GetCore().GetRHI(), &vertices[0], static_cast<UINT>(vertices.size()), sizeof(VertexPositionTextureNormal), false, ER_BIND_VERTEX_BUFFER);
 	}
 
-	void ER_Mesh::CreateVertexBuffer_PositionUvNormalTangent(ER_RHI_GPUBuffer* vertexBuffer, int uvChannel) const
+	// Main stream is already stored in this layout, so we upload it without any intermediate copies
+	void ER_Mesh::CreateVertexBuffer_PositionUvNormalTangent(ER_RHI_GPUBuffer* vertexBuffer) const
 	{
-		const std::vector<XMFLOAT3>& sourceVertices = Vertices();
-		const std::vector<XMFLOAT3>& textureCoordinates = mTextureCoordinates[uvChannel];
-		assert(textureCoordinates.size() == sourceVertices.size());
-
-		const std::vector<XMFLOAT3>& normals = Normals();
-		assert(normals.size() == sourceVertices.size());
-
-		const std::vector<XMFLOAT3>& tangents = Tangents();
-		assert(tangents.size() == sourceVertices.size());
-
-		std::vector<VertexPositionTextureNormalTangent> vertices;
-		vertices.reserve(sourceVertices.size());
-
-		for (UINT i = 0; i < sourceVertices.size(); i++)
-		{
-			XMFLOAT3 position = sourceVertices.at(i);
-			XMFLOAT3 uv = textureCoordinates.at(i);
-			XMFLOAT3 normal = normals.at(i);
-			XMFLOAT3 tangent = tangents.at(i);
-
-			vertices.push_back(VertexPositionTextureNormalTangent(XMFLOAT4(position.x, position.y, position.z, 1.0f), XMFLOAT2(uv.x, uv.y), normal, tangent));
-		}
-
 		assert(vertexBuffer);
-		vertexBuffer->CreateGPUBufferResource(mModel.GetCore().GetRHI(), &vertices[0], static_cast<UINT>(vertices.size()), sizeof(VertexPositionTextureNormalTangent), false, ER_BIND_VERTEX_BUFFER);
+		vertexBuffer->CreateGPUBufferResource(mModel.GetCore().GetRHI(), (void*)(mInterleavedVertices.data()), static_cast<UINT>(mInterleavedVertices.size()), sizeof(VertexPositionTextureNormalTangent), false, ER_BIND_VERTEX_BUFFER);
 	}
 }
\ No newline at end of file
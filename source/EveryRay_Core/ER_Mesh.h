@@ -2,6 +2,8 @@
 
 #include "Common.h"
 #include "RHI/ER_RHI.h"
+#include "ER_MeshOptimizer.h"
+#include "ER_VertexDeclarations.h"
 
 struct aiMesh;
 
@@ -21,32 +23,28 @@ namespace EveryRay_Core
 		const std::string& Name() const;
 
 		const std::vector<XMFLOAT3>& Vertices() const;
-		const std::vector<XMFLOAT3>& Normals() const;
-		const std::vector<XMFLOAT3>& Tangents() const;
-		const std::vector<XMFLOAT3>& BiNormals() const;
-		const std::vector<std::vector<XMFLOAT3>>& TextureCoordinates() const;
-		const std::vector<std::vector<XMFLOAT4>>& VertexColors() const;
+		const std::vector<VertexPositionTextureNormalTangent>& InterleavedVertices() const;
 		const std::vector<UINT>& Indices() const;
 		UINT FaceCount() const;
+		const ER_MeshOptimizerStats& GetOptimizerStats() const { return mOptimizerStats; }
 
 		void CreateIndexBuffer(ER_RHI_GPUBuffer* indexBuffer) const;
 
 		void CreateVertexBuffer_Position(ER_RHI_GPUBuffer* vertexBuffer) const;
-		void CreateVertexBuffer_PositionUv(ER_RHI_GPUBuffer* vertexBuffer, int uvChannel = 0) const;
-		void CreateVertexBuffer_PositionUvNormal(ER_RHI_GPUBuffer* vertexBuffer, int uvChannel = 0) const;
-		void CreateVertexBuffer_PositionUvNormalTangent(ER_RHI_GPUBuffer* vertexBuffer, int uvChannel = 0) const;
+		void CreateVertexBuffer_PositionUv(ER_RHI_GPUBuffer* vertexBuffer) const;
+		void CreateVertexBuffer_PositionUvNormal(ER_RHI_GPUBuffer* vertexBuffer) const;
+		void CreateVertexBuffer_PositionUvNormalTangent(ER_RHI_GPUBuffer* vertexBuffer) const;
 
 	private:
+		void Optimize(bool hasNormals);
+
 		ER_Model& mModel;
 		ER_ModelMaterial& mMaterial;
 		std::string mName;
-		std::vector<XMFLOAT3> mVertices;
-		std::vector<XMFLOAT3> mNormals;
-		std::vector<XMFLOAT3> mTangents;
-		std::vector<XMFLOAT3> mBiNormals;
-		std::vector<std::vector<XMFLOAT3>> mTextureCoordinates;
-		std::vector<std::vector<XMFLOAT4>> mVertexColors;
+		std::vector<VertexPositionTextureNormalTangent> mInterleavedVertices; // main stream: position, uv (channel 0), normal, tangent in one allocation
+		std::vector<XMFLOAT3> mVertices; // position-only stream: CPU-side queries (AABB, culling, etc.) and depth-only vertex buffers
 		UINT mFaceCount;
 		std::vector<UINT> mIndices;
+		ER_MeshOptimizerStats mOptimizerStats;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,357 @@
+#include "ER_MeshOptimizer.h"
+
+#include <algorithm>
+
+namespace EveryRay_Core
+{
+	// FIFO cache simulation via timestamps: the vertex is in the cache if it was added less than "cacheSize" insertions ago
+	static UINT UpdateFIFOCache(UINT a, UINT b, UINT c, UINT cacheSize, std::vector<UINT>& cacheTimestamps, UINT& timestamp)
+	{
+		UINT misses = 0;
+		if (timestamp - cacheTimestamps[a] > cacheSize) { cacheTimestamps[a] = timestamp++; misses++; }
+		if (timestamp - cacheTimestamps[b] > cacheSize) { cacheTimestamps[b] = timestamp++; misses++; }
+		if (timestamp - cacheTimestamps[c] > cacheSize) { cacheTimestamps[c] = timestamp++; misses++; }
+		return misses;
+	}
+
+	float ER_MeshOptimizer::CalculateACMR(const std::vector<UINT>& indices, UINT vertexCount, UINT cacheSize, float* outATVR)
+	{
+		assert(indices.size() % 3 == 0);
+		if (indices.empty() || vertexCount == 0)
+		{
+			if (outATVR)
+				*outATVR = 0.0f;
+			return 0.0f;
+		}
+
+		std::vector<UINT> cacheTimestamps(vertexCount, 0);
+		UINT timestamp = cacheSize + 1;
+		UINT misses = 0;
+
+		for (size_t i = 0; i < indices.size(); i += 3)
+			misses += UpdateFIFOCache(indices[i], indices[i + 1], indices[i + 2], cacheSize, cacheTimestamps, timestamp);
+
+		if (outATVR)
+			*outATVR = static_cast<float>(misses) / static_cast<float>(vertexCount);
+
+		return static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+	}
+
+	// Tom Forsyth's linear-speed vertex cache optimisation
+	// https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html
+	void ER_MeshOptimizer::OptimizeVertexCache(std::vector<UINT>& indices, UINT vertexCount)
+	{
+		assert(indices.size() % 3 == 0);
+		const UINT triangleCount = static_cast<UINT>(indices.size() / 3);
+		if (triangleCount == 0 || vertexCount == 0)
+			return;
+
+		const float cacheDecayPower = 1.5f;
+		const float lastTriangleScore = 0.75f;
+		const float valenceBoostScale = 2.0f;
+		const float valenceBoostPower = 0.5f;
+
+		auto vertexScore = [&](int cachePosition, UINT remainingTriangles) -> float
+		{
+			if (remainingTriangles == 0)
+				return -1.0f; // no triangles need this vertex anymore
+
+			float score = 0.0f;
+			if (cachePosition >= 0)
+			{
+				if (cachePosition < 3) // the vertex was used in the last triangle
+					score = lastTriangleScore;
+				else
+				{
+					const float scaler = 1.0f / static_cast<float>(FORSYTH_CACHE_SIZE - 3);
+					score = powf(1.0f - static_cast<float>(cachePosition - 3) * scaler, cacheDecayPower);
+				}
+			}
+			// bonus points for having low amount of triangles still using this vertex
+			score += valenceBoostScale * powf(static_cast<float>(remainingTriangles), -valenceBoostPower);
+			return score;
+		};
+
+		// vertex -> triangles adjacency
+		std::vector<UINT> remainingTriangles(vertexCount, 0);
+		for (UINT index : indices)
+		{
+			assert(index < vertexCount);
+			remainingTriangles[index]++;
+		}
+
+		std::vector<UINT> adjacencyOffsets(vertexCount + 1, 0);
+		for (UINT v = 0; v < vertexCount; v++)
+			adjacencyOffsets[v + 1] = adjacencyOffsets[v] + remainingTriangles[v];
+
+		std::vector<UINT> adjacency(indices.size());
+		{
+			std::vector<UINT> fillCounts(vertexCount, 0);
+			for (UINT tri = 0; tri < triangleCount; tri++)
+			{
+				for (int k = 0; k < 3; k++)
+				{
+					UINT v = indices[tri * 3 + k];
+					adjacency[adjacencyOffsets[v] + fillCounts[v]++] = tri;
+				}
+			}
+		}
+
+		std::vector<float> vertexScores(vertexCount);
+		for (UINT v = 0; v < vertexCount; v++)
+			vertexScores[v] = vertexScore(-1, remainingTriangles[v]);
+
+		std::vector<float> triangleScores(triangleCount);
+		for (UINT tri = 0; tri < triangleCount; tri++)
+			triangleScores[tri] = vertexScores[indices[tri * 3 + 0]] + vertexScores[indices[tri * 3 + 1]] + vertexScores[indices[tri * 3 + 2]];
+
+		std::vector<bool> emitted(triangleCount, false);
+		std::vector<UINT> result;
+		result.reserve(indices.size());
+
+		UINT cache[FORSYTH_CACHE_SIZE + 3];
+		UINT cacheCount = 0;
+		UINT newCache[FORSYTH_CACHE_SIZE + 3];
+
+		UINT inputCursor = 0; // for finding a new starting triangle when the cache runs dry
+		int bestTriangle = -1;
+
+		for (UINT emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+		{
+			if (bestTriangle < 0)
+			{
+				// nothing adjacent to the cache: take the best of the remaining triangles (linear scan from the cursor, amortized)
+				while (inputCursor < triangleCount && emitted[inputCursor])
+					inputCursor++;
+				assert(inputCursor < triangleCount);
+
+				bestTriangle = static_cast<int>(inputCursor);
+				float bestScore = triangleScores[inputCursor];
+				for (UINT tri = inputCursor + 1; tri < triangleCount && tri < inputCursor + FORSYTH_CACHE_SIZE; tri++)
+				{
+					if (!emitted[tri] && triangleScores[tri] > bestScore)
+					{
+						bestScore = triangleScores[tri];
+						bestTriangle = static_cast<int>(tri);
+					}
+				}
+			}
+
+			const UINT tri = static_cast<UINT>(bestTriangle);
+			const UINT a = indices[tri * 3 + 0];
+			const UINT b = indices[tri * 3 + 1];
+			const UINT c = indices[tri * 3 + 2];
+
+			result.push_back(a);
+			result.push_back(b);
+			result.push_back(c);
+			emitted[tri] = true;
+
+			// remove the triangle from its vertices' adjacency
+			for (UINT v : { a, b, c })
+			{
+				UINT* begin = &adjacency[adjacencyOffsets[v]];
+				UINT* end = begin + remainingTriangles[v];
+				UINT* it = std::find(begin, end, tri);
+				assert(it != end);
+				std::swap(*it, *(end - 1));
+				remainingTriangles[v]--;
+			}
+
+			// push the triangle's vertices to the front of the LRU cache
+			UINT newCacheCount = 0;
+			newCache[newCacheCount++] = a;
+			newCache[newCacheCount++] = b;
+			newCache[newCacheCount++] = c;
+			for (UINT i = 0; i < cacheCount; i++)
+			{
+				UINT v = cache[i];
+				if (v != a && v != b && v != c)
+					newCache[newCacheCount++] = v;
+			}
+
+			// update scores of the vertices in (or just evicted from) the cache and of their triangles
+			bestTriangle = -1;
+			float bestScore = -FLT_MAX;
+			for (UINT i = 0; i < newCacheCount; i++)
+			{
+				UINT v = newCache[i];
+				int position = (i < FORSYTH_CACHE_SIZE) ? static_cast<int>(i) : -1;
+
+				float newScore = vertexScore(position, remainingTriangles[v]);
+				float scoreDelta = newScore - vertexScores[v];
+				vertexScores[v] = newScore;
+
+				for (UINT j = 0; j < remainingTriangles[v]; j++)
+				{
+					UINT adjacentTri = adjacency[adjacencyOffsets[v] + j];
+					triangleScores[adjacentTri] += scoreDelta;
+					if (triangleScores[adjacentTri] > bestScore)
+					{
+						bestScore = triangleScores[adjacentTri];
+						bestTriangle = static_cast<int>(adjacentTri);
+					}
+				}
+			}
+
+			cacheCount = std::min(newCacheCount, FORSYTH_CACHE_SIZE);
+			memcpy(cache, newCache, cacheCount * sizeof(UINT));
+		}
+
+		indices.swap(result);
+	}
+
+	void ER_MeshOptimizer::OptimizeOverdraw(std::vector<UINT>& indices, const std::vector<XMFLOAT3>& positions, const std::vector<XMFLOAT3>& normals, float threshold)
+	{
+		assert(indices.size() % 3 == 0);
+		const UINT triangleCount = static_cast<UINT>(indices.size() / 3);
+		const UINT vertexCount = static_cast<UINT>(positions.size());
+		if (triangleCount < 2 || vertexCount == 0)
+			return;
+
+		const UINT cacheSize = ACMR_FIFO_CACHE_SIZE;
+		std::vector<UINT> cacheTimestamps(vertexCount, 0);
+		UINT timestamp = cacheSize + 1;
+
+		// 1) hard cluster boundaries - triangles that miss the cache completely (the previous ordering "restarts" there)
+		std::vector<UINT> hardClusters;
+		for (UINT tri = 0; tri < triangleCount; tri++)
+		{
+			UINT misses = UpdateFIFOCache(indices[tri * 3 + 0], indices[tri * 3 + 1], indices[tri * 3 + 2], cacheSize, cacheTimestamps, timestamp);
+			if (tri == 0 || misses == 3)
+				hardClusters.push_back(tri);
+		}
+
+		// 2) soft cluster boundaries - split hard clusters further as long as every piece stays under the ACMR threshold
+		std::vector<UINT> clusters;
+		for (size_t it = 0; it < hardClusters.size(); it++)
+		{
+			const UINT start = hardClusters[it];
+			const UINT end = (it + 1 < hardClusters.size()) ? hardClusters[it + 1] : triangleCount;
+			assert(start < end);
+
+			timestamp += cacheSize + 1; // reset cache
+			UINT clusterMisses = 0;
+			for (UINT tri = start; tri < end; tri++)
+				clusterMisses += UpdateFIFOCache(indices[tri * 3 + 0], indices[tri * 3 + 1], indices[tri * 3 + 2], cacheSize, cacheTimestamps, timestamp);
+
+			const float clusterThreshold = threshold * (static_cast<float>(clusterMisses) / static_cast<float>(end - start));
+			const size_t clusterOffset = clusters.size();
+			clusters.push_back(start);
+
+			timestamp += cacheSize + 1; // reset cache
+			UINT runningMisses = 0;
+			UINT runningTriangles = 0;
+			for (UINT tri = start; tri < end; tri++)
+			{
+				runningMisses += UpdateFIFOCache(indices[tri * 3 + 0], indices[tri * 3 + 1], indices[tri * 3 + 2], cacheSize, cacheTimestamps, timestamp);
+				runningTriangles++;
+
+				if (static_cast<float>(runningMisses) / static_cast<float>(runningTriangles) <= clusterThreshold && tri + 1 < end)
+				{
+					clusters.push_back(tri + 1);
+					timestamp += cacheSize + 1; // reset cache
+					runningMisses = 0;
+					runningTriangles = 0;
+				}
+			}
+
+			// the last piece is above the target ACMR by definition, so we merge it with the previous one
+			if (runningTriangles > 0 && clusters.size() - clusterOffset > 1)
+				clusters.pop_back();
+		}
+
+		if (clusters.size() < 2)
+			return;
+
+		// 3) sort clusters by how much they face "outwards" of the mesh: those are likely to occlude the rest of the mesh
+		const bool hasNormals = (normals.size() == positions.size());
+		XMVECTOR meshCentroid = XMVectorZero();
+		float meshArea = 0.0f;
+
+		struct ClusterInfo
+		{
+			XMFLOAT3 Centroid;
+			XMFLOAT3 Normal;
+			UINT Start;
+			UINT End;
+			float SortKey;
+		};
+		std::vector<ClusterInfo> clusterInfos(clusters.size());
+
+		for (size_t i = 0; i < clusters.size(); i++)
+		{
+			ClusterInfo& info = clusterInfos[i];
+			info.Start = clusters[i];
+			info.End = (i + 1 < clusters.size()) ? clusters[i + 1] : triangleCount;
+
+			XMVECTOR centroid = XMVectorZero();
+			XMVECTOR normal = XMVectorZero();
+			float clusterArea = 0.0f;
+
+			for (UINT tri = info.Start; tri < info.End; tri++)
+			{
+				const UINT a = indices[tri * 3 + 0];
+				const UINT b = indices[tri * 3 + 1];
+				const UINT c = indices[tri * 3 + 2];
+
+				XMVECTOR p0 = XMLoadFloat3(&positions[a]);
+				XMVECTOR p1 = XMLoadFloat3(&positions[b]);
+				XMVECTOR p2 = XMLoadFloat3(&positions[c]);
+
+				XMVECTOR faceNormal = XMVector3Cross(p1 - p0, p2 - p0); // length is 2x area
+				float area = XMVectorGetX(XMVector3Length(faceNormal)) * 0.5f;
+
+				// winding can differ between importers/flags, so we trust the authored normals if we have them
+				if (hasNormals)
+				{
+					XMVECTOR vertexNormalsSum = XMLoadFloat3(&normals[a]) + XMLoadFloat3(&normals[b]) + XMLoadFloat3(&normals[c]);
+					if (XMVectorGetX(XMVector3Dot(faceNormal, vertexNormalsSum)) < 0.0f)
+						faceNormal = XMVectorNegate(faceNormal);
+				}
+
+				centroid += (p0 + p1 + p2) * (area / 3.0f);
+				normal += faceNormal;
+				clusterArea += area;
+			}
+
+			meshCentroid += centroid;
+			meshArea += clusterArea;
+
+			XMStoreFloat3(&info.Centroid, (clusterArea > 0.0f) ? centroid / clusterArea : centroid);
+			XMStoreFloat3(&info.Normal, XMVector3Normalize(normal));
+		}
+
+		if (meshArea > 0.0f)
+			meshCentroid /= meshArea;
+
+		for (ClusterInfo& info : clusterInfos)
+			info.SortKey = XMVectorGetX(XMVector3Dot(XMLoadFloat3(&info.Centroid) - meshCentroid, XMLoadFloat3(&info.Normal)));
+
+		std::stable_sort(clusterInfos.begin(), clusterInfos.end(), [](const ClusterInfo& lhs, const ClusterInfo& rhs) { return lhs.SortKey > rhs.SortKey; });
+
+		std::vector<UINT> result;
+		result.reserve(indices.size());
+		for (const ClusterInfo& info : clusterInfos)
+			result.insert(result.end(), indices.begin() + info.Start * 3, indices.begin() + info.End * 3);
+
+		indices.swap(result);
+	}
+
+	UINT ER_MeshOptimizer::OptimizeVertexFetch(std::vector<UINT>& indices, UINT vertexCount, std::vector<UINT>& outRemap)
+	{
+		outRemap.clear();
+		outRemap.resize(vertexCount, UINT_MAX);
+
+		UINT newVertexCount = 0;
+		for (UINT& index : indices)
+		{
+			assert(index < vertexCount);
+			if (outRemap[index] == UINT_MAX)
+				outRemap[index] = newVertexCount++;
+			index = outRemap[index];
+		}
+
+		return newVertexCount;
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include "Common.h"
+
+namespace EveryRay_Core
+{
+	struct ER_MeshOptimizerStats
+	{
+		UINT VertexCountBefore = 0;
+		UINT VertexCountAfter = 0;
+		float ACMRBefore = 0.0f; // average cache miss ratio (misses per triangle, 0.5 is ideal, 3.0 is the worst)
+		float ACMRAfter = 0.0f;
+		float ATVRBefore = 0.0f; // average transformed vertex ratio (misses per vertex, 1.0 is ideal)
+		float ATVRAfter = 0.0f;
+	};
+
+	// Import-time optimizations for indexed triangle lists (vertex welding is done by assimp before that):
+	// 1) post-transform vertex cache reordering (Tom Forsyth's "Linear-Speed Vertex Cache Optimisation")
+	// 2) overdraw-aware cluster reordering (based on Sander et al. "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw")
+	// 3) vertex fetch reordering (vertices are sorted by their first use in the index buffer, unused ones are removed)
+	// Order matters: each step preserves the results of the previous one as much as possible.
+	class ER_MeshOptimizer
+	{
+	public:
+		static const UINT ACMR_FIFO_CACHE_SIZE = 16; // conservative post-transform cache size for stats
+		static const UINT FORSYTH_CACHE_SIZE = 32;
+
+		static float CalculateACMR(const std::vector<UINT>& indices, UINT vertexCount, UINT cacheSize = ACMR_FIFO_CACHE_SIZE, float* outATVR = nullptr);
+
+		static void OptimizeVertexCache(std::vector<UINT>& indices, UINT vertexCount);
+		// "threshold" is the max allowed ACMR degradation after the reordering (i.e., 1.05 means 5%)
+		static void OptimizeOverdraw(std::vector<UINT>& indices, const std::vector<XMFLOAT3>& positions, const std::vector<XMFLOAT3>& normals, float threshold = 1.05f);
+		// returns new vertex count; "outRemap" is [old vertex index] -> [new vertex index] (or UINT_MAX if unused)
+		static UINT OptimizeVertexFetch(std::vector<UINT>& indices, UINT vertexCount, std::vector<UINT>& outRemap);
+
+		template <typename T>
+		static void RemapVertexStream(std::vector<T>& stream, const std::vector<UINT>& remap, UINT newVertexCount)
+		{
+			if (stream.empty())
+				return;
+
+			assert(stream.size() == remap.size());
+			std::vector<T> remapped(newVertexCount);
+			for (size_t i = 0; i < remap.size(); i++)
+			{
+				if (remap[i] != UINT_MAX)
+					remapped[remap[i]] = stream[i];
+			}
+			stream.swap(remapped);
+		}
+	private:
+		ER_MeshOptimizer();
+		ER_MeshOptimizer(const ER_MeshOptimizer& rhs);
+		ER_MeshOptimizer& operator=(const ER_MeshOptimizer& rhs);
+	};
+}
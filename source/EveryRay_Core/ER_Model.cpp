@@ -5,6 +5,7 @@
 #include "ER_ModelMaterial.h"
 #include "ER_Core.h"
 #include "ER_CoreException.h"
+#include "ER_Utility.h"
 
 #include "assimp\Importer.hpp"
 #include "assimp\scene.h"
@@ -17,7 +18,8 @@ namespace EveryRay_Core
 	{
 		Assimp::Importer importer;
 
-		UINT flags = aiProcess_Triangulate /*| aiProcess_JoinIdenticalVertices*/ | aiProcess_SortByPType | aiProcess_FlipWindingOrder;
+		// welding identical vertices is important for the post-transform cache (see ER_Mesh::Optimize())
+		UINT flags = aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_SortByPType | aiProcess_FlipWindingOrder;
 		if (flipUVs)
 		{
 			flags |= aiProcess_FlipUVs;
@@ -52,6 +54,33 @@ namespace EveryRay_Core
 		}
 
 		mFilename = filename;
+
+		// report import-time mesh optimization results for the whole model
+		{
+			UINT importedVertexCount = 0, optimizedVertexCount = 0;
+			float acmrBefore = 0.0f, acmrAfter = 0.0f;
+			UINT optimizedMeshCount = 0;
+			for (const ER_Mesh& mesh : mMeshes)
+			{
+				const ER_MeshOptimizerStats& stats = mesh.GetOptimizerStats();
+				if (stats.VertexCountBefore == 0)
+					continue;
+
+				importedVertexCount += stats.VertexCountBefore;
+				optimizedVertexCount += stats.VertexCountAfter;
+				acmrBefore += stats.ACMRBefore;
+				acmrAfter += stats.ACMRAfter;
+				optimizedMeshCount++;
+			}
+
+			if (optimizedMeshCount > 0)
+			{
+				std::string msg = "[ER Logger][ER_Model] Optimized meshes of " + mFilename +
+					": vertices " + std::to_string(importedVertexCount) + " -> " + std::to_string(optimizedVertexCount) +
+					", avg. ACMR " + std::to_string(acmrBefore / optimizedMeshCount) + " -> " + std::to_string(acmrAfter / optimizedMeshCount) + '\n';
+				ER_OUTPUT_LOG(ER_Utility::ToWideString(msg).c_str());
+			}
+		}
 	}
 
 	ER_Model::~ER_Model()
@@ -90,25 +119,35 @@ namespace EveryRay_Core
 
 	const ER_AABB& ER_Model::GenerateAABB()
 	{
-		std::vector<XMFLOAT3> vertices;
-
-		for (ER_Mesh& mesh : mMeshes)
-			vertices.insert(vertices.end(), mesh.Vertices().begin(), mesh.Vertices().end());
-
 		XMFLOAT3 minVertex = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
 		XMFLOAT3 maxVertex = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
 
-		for (UINT i = 0; i < vertices.size(); i++)
+		mMeshesAABBs.clear();
+		mMeshesAABBs.reserve(mMeshes.size());
+		for (const ER_Mesh& mesh : mMeshes)
 		{
-			//Get the smallest vertex 
-			minVertex.x = std::min(minVertex.x, vertices[i].x);    // Find smallest x value in model
-			minVertex.y = std::min(minVertex.y, vertices[i].y);    // Find smallest y value in model
-			minVertex.z = std::min(minVertex.z, vertices[i].z);    // Find smallest z value in model
-
-			//Get the largest vertex 
-			maxVertex.x = std::max(maxVertex.x, vertices[i].x);    // Find largest x value in model
-			maxVertex.y = std::max(maxVertex.y, vertices[i].y);    // Find largest y value in model
-			maxVertex.z = std::max(maxVertex.z, vertices[i].z);    // Find largest z value in model
+			XMFLOAT3 minMeshVertex = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+			XMFLOAT3 maxMeshVertex = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+			for (const XMFLOAT3& vertex : mesh.Vertices())
+			{
+				minMeshVertex.x = std::min(minMeshVertex.x, vertex.x);
+				minMeshVertex.y = std::min(minMeshVertex.y, vertex.y);
+				minMeshVertex.z = std::min(minMeshVertex.z, vertex.z);
+				maxMeshVertex.x = std::max(maxMeshVertex.x, vertex.x);
+				maxMeshVertex.y = std::max(maxMeshVertex.y, vertex.y);
+				maxMeshVertex.z = std::max(maxMeshVertex.z, vertex.z);
+
+				//Get the smallest vertex 
+				minVertex.x = std::min(minVertex.x, vertex.x);    // Find smallest x value in model
+				minVertex.y = std::min(minVertex.y, vertex.y);    // Find smallest y value in model
+				minVertex.z = std::min(minVertex.z, vertex.z);    // Find smallest z value in model
+
+				//Get the largest vertex 
+				maxVertex.x = std::max(maxVertex.x, vertex.x);    // Find largest x value in model
+				maxVertex.y = std::max(maxVertex.y, vertex.y);    // Find largest y value in model
+				maxVertex.z = std::max(maxVertex.z, vertex.z);    // Find largest z value in model
+			}
+			mMeshesAABBs.push_back({ minMeshVertex, maxMeshVertex });
 		}
 
 		mAABB = { minVertex, maxVertex };
@@ -24,6 +24,7 @@ namespace EveryRay_Core
 		const std::string& GetFileName() { return mFilename; }
 		const char* GetFileNameChar() { return mFilename.c_str(); }
 		const ER_AABB& GenerateAABB();
+		const ER_AABB& GetMeshAABB(int index) const { return mMeshesAABBs.at(index); } // local space, valid after GenerateAABB()
 		bool IsLoaded() { return mIsLoaded; }
 	private:
 		ER_Model(const ER_Model& rhs);
@@ -31,6 +32,7 @@ namespace EveryRay_Core
 
 		ER_Core& mCore;
 		ER_AABB mAABB;
+		std::vector<ER_AABB> mMeshesAABBs;
 		std::vector<ER_Mesh> mMeshes;
 		std::vector<ER_ModelMaterial> mMaterials;
 		std::string mFilename;
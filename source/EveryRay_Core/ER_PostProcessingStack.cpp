@@ -13,6 +13,8 @@
 #include "ER_RenderableAABB.h"
 #include "ER_Scene.h"
 
+#include <algorithm>
+
 #define LINEARFOG_PASS_ROOT_DESCRIPTOR_TABLE_SRV_INDEX 0
 #define LINEARFOG_PASS_ROOT_DESCRIPTOR_TABLE_CBV_INDEX 1
 
@@ -266,6 +268,7 @@ namespace EveryRay_Core {
 		if (mPostEffectsVolumes.size() < MAX_POST_EFFECT_VOLUMES)
 		{
 			mPostEffectsVolumes.emplace_back(mCore, aTransform, aValues, aName);
+			mIsPostEffectsVolumesGridDirty = true;
 
 			std::string message = "[ER Logger][ER_PostProcessingStack] Added a new volume: " + aName + "\n";
 			ER_OUTPUT_LOG(ER_Utility::ToWideString(message).c_str());
@@ -364,8 +367,14 @@ namespace EveryRay_Core {
 		}
 
 		ImGui::Separator();
+		if (!isEditorActive)
+		{
+			ImGui::Text("Active volumes (by priority):");
+			for (auto& activeVolume : mActivePostEffectsVolumes)
+				ImGui::Text("- %s: %.2f", mPostEffectsVolumes[activeVolume.first].name.c_str(), activeVolume.second);
+		}
 		ImGui::Checkbox("Show debug gizmo volumes", &mShowDebugVolumes);
-		ImGui::TextWrapped("Only saving transforms is supported for now!");
+		ImGui::TextWrapped("Only saving transforms, priorities, blend distances and weights is supported for now!");
 		if (ImGui::Button("Save volume changes"))
 			mCore.GetLevel()->mScene->SavePostProcessingVolumesData();
 		ImGui::SameLine();
@@ -421,6 +430,11 @@ namespace EveryRay_Core {
 				ImGuizmo::RecomposeMatrixFromComponents(mEditorPostEffectsVolumeMatrixTranslation,
 					mEditorPostEffectsVolumeMatrixRotation, mEditorPostEffectsVolumeMatrixScale, mEditorCurrentPostEffectsVolumeTransformMatrix);
 				ImGui::Checkbox("Volume enabled", &(mPostEffectsVolumes[mSelectedEditorPostEffectsVolumeIndex].isEnabled));
+				PostEffectsVolumeValues& selectedValues = mPostEffectsVolumes[mSelectedEditorPostEffectsVolumeIndex].values;
+				ImGui::InputInt("Priority", &selectedValues.priority);
+				if (ImGui::SliderFloat("Blend distance", &selectedValues.blendDistance, 0.0f, 100.0f))
+					mIsPostEffectsVolumesGridDirty = true;
+				ImGui::SliderFloat("Weight", &selectedValues.weight, 0.0f, 1.0f);
 				ImGui::End();
 
 				ImGuiIO& io = ImGui::GetIO();
@@ -430,6 +444,7 @@ namespace EveryRay_Core {
 
 				XMFLOAT4X4 mat(mEditorCurrentPostEffectsVolumeTransformMatrix);
 				mPostEffectsVolumes[mSelectedEditorPostEffectsVolumeIndex].SetTransform(mat, true);
+				mIsPostEffectsVolumesGridDirty = true;
 			}
 			else
 				ImGui::End();
@@ -460,7 +475,7 @@ namespace EveryRay_Core {
 
 		//final resolve to main RT (pre-UI)
 		{
-			ER_QuadRenderer* quad = (ER_QuadRenderer*)mCore.GetServices().FindService(ER_QuadRenderer::TypeIdClass());
+			ER_QuadRenderer* quad = mCore.GetServices().FindService<ER_QuadRenderer>();
 			assert(quad);
 			assert(mRenderTargetBeforeResolve);
 
@@ -487,9 +502,55 @@ namespace EveryRay_Core {
 		rhi->UnbindResourcesFromShader(ER_PIXEL);
 	}
 
+	static UINT64 GetPostEffectsVolumesGridCellKey(int x, int y, int z)
+	{
+		// 21 bits per axis (signed)
+		const UINT64 mask = (1ull << 21) - 1;
+		return ((static_cast<UINT64>(x) & mask) << 42) | ((static_cast<UINT64>(y) & mask) << 21) | (static_cast<UINT64>(z) & mask);
+	}
+
+	static int GetPostEffectsVolumesGridCellCoord(float value)
+	{
+		return static_cast<int>(std::floor(value / POST_EFFECT_VOLUMES_GRID_CELL_SIZE));
+	}
+
+	// Volumes are static most of the time, so we only rebuild the grid when they are added or edited
+	void ER_PostProcessingStack::UpdatePostEffectsVolumesGrid()
+	{
+		mPostEffectsVolumesGrid.clear();
+		mPostEffectsVolumesOutsideGrid.clear();
+
+		for (int i = 0; i < static_cast<int>(mPostEffectsVolumes.size()); i++)
+		{
+			const ER_AABB& aabb = mPostEffectsVolumes[i].aabb;
+			const float blendDistance = std::max(mPostEffectsVolumes[i].values.blendDistance, 0.0f);
+
+			const int minX = GetPostEffectsVolumesGridCellCoord(aabb.first.x - blendDistance);
+			const int minY = GetPostEffectsVolumesGridCellCoord(aabb.first.y - blendDistance);
+			const int minZ = GetPostEffectsVolumesGridCellCoord(aabb.first.z - blendDistance);
+			const int maxX = GetPostEffectsVolumesGridCellCoord(aabb.second.x + blendDistance);
+			const int maxY = GetPostEffectsVolumesGridCellCoord(aabb.second.y + blendDistance);
+			const int maxZ = GetPostEffectsVolumesGridCellCoord(aabb.second.z + blendDistance);
+
+			const INT64 cellsCount = static_cast<INT64>(maxX - minX + 1) * (maxY - minY + 1) * (maxZ - minZ + 1);
+			if (cellsCount > POST_EFFECT_VOLUMES_GRID_MAX_CELLS_PER_VOLUME)
+			{
+				mPostEffectsVolumesOutsideGrid.push_back(i);
+				continue;
+			}
+
+			for (int x = minX; x <= maxX; x++)
+				for (int y = minY; y <= maxY; y++)
+					for (int z = minZ; z <= maxZ; z++)
+						mPostEffectsVolumesGrid[GetPostEffectsVolumesGridCellKey(x, y, z)].push_back(i);
+		}
+
+		mIsPostEffectsVolumesGridDirty = false;
+	}
+
 	void ER_PostProcessingStack::UpdatePostEffectsVolumes()
 	{
-		mCurrentActivePostEffectsVolumeIndex = -1;
+		mActivePostEffectsVolumes.clear();
 
 		if (ER_Utility::IsEditorMode && ER_Utility::IsPostEffectsVolumeEditor)
 		{
@@ -503,28 +564,44 @@ namespace EveryRay_Core {
 		}
 		else
 			mAreValuesSetFromVolumeForEditing = false;
-		
-		// TODO: add priority system at some point
-		for (int i = 0; i < static_cast<int>(mPostEffectsVolumes.size()); i++)
-		{
-			if (!mPostEffectsVolumes[i].isEnabled)
-				continue;
 
-			ER_AABB& aabb = mPostEffectsVolumes[i].aabb;
+		if (mIsPostEffectsVolumesGridDirty)
+			UpdatePostEffectsVolumesGrid();
 
-			bool isColliding =
-				(mCamera.Position().x <= aabb.second.x && mCamera.Position().x >= aabb.first.x) &&
-				(mCamera.Position().y <= aabb.second.y && mCamera.Position().y >= aabb.first.y) &&
-				(mCamera.Position().z <= aabb.second.z && mCamera.Position().z >= aabb.first.z);
-
-			if (isColliding)
-			{
-				mCurrentActivePostEffectsVolumeIndex = i;
-				break;
-			}
+		const XMFLOAT3& cameraPos = mCamera.Position();
+		auto addActiveVolume = [&](int index)
+		{
+			if (!mPostEffectsVolumes[index].isEnabled)
+				return;
+
+			const float factor = mPostEffectsVolumes[index].GetBlendFactor(cameraPos);
+			if (factor > 0.0f)
+				mActivePostEffectsVolumes.push_back(std::make_pair(index, factor));
+		};
+
+		// the camera is always in one cell, so there are no duplicates
+		auto cell = mPostEffectsVolumesGrid.find(GetPostEffectsVolumesGridCellKey(
+			GetPostEffectsVolumesGridCellCoord(cameraPos.x), GetPostEffectsVolumesGridCellCoord(cameraPos.y), GetPostEffectsVolumesGridCellCoord(cameraPos.z)));
+		if (cell != mPostEffectsVolumesGrid.end())
+		{
+			for (int index : cell->second)
+				addActiveVolume(index);
 		}
+		for (int index : mPostEffectsVolumesOutsideGrid)
+			addActiveVolume(index);
 
-		SetPostEffectsValuesFromVolume(mCurrentActivePostEffectsVolumeIndex);
+		// lower priorities first; for equal priorities the volume that was added first wins (i.e., is applied last)
+		std::sort(mActivePostEffectsVolumes.begin(), mActivePostEffectsVolumes.end(),
+			[this](const std::pair<int, float>& a, const std::pair<int, float>& b)
+			{
+				const int priorityA = mPostEffectsVolumes[a.first].values.priority;
+				const int priorityB = mPostEffectsVolumes[b.first].values.priority;
+				return priorityA != priorityB ? priorityA < priorityB : a.first > b.first;
+			});
+
+		SetPostEffectsValuesFromVolume(-1);
+		for (auto& activeVolume : mActivePostEffectsVolumes)
+			BlendPostEffectsValuesFromVolume(activeVolume.first, activeVolume.second);
 	}
 
 	void ER_PostProcessingStack::SetPostEffectsValuesFromVolume(int index /*= -1*/)
@@ -580,6 +657,39 @@ namespace EveryRay_Core {
 		}
 	}
 
+	// Floats are interpolated from the current (already blended) values, switches and LUTs are taken from the volume when it dominates (factor >= 0.5)
+	void ER_PostProcessingStack::BlendPostEffectsValuesFromVolume(int index, float factor)
+	{
+		assert(index >= 0 && index < static_cast<int>(mPostEffectsVolumes.size()));
+
+		const PostEffectsVolume& volume = mPostEffectsVolumes[index];
+		const PostEffectsVolumeValues& values = volume.values;
+		const bool isDominant = factor >= 0.5f;
+		auto blend = [factor](float current, float target) { return current + (target - current) * factor; };
+		auto valueOrDefault = [](float value, float defaultValue) { return value > std::numeric_limits<float>::epsilon() ? value : defaultValue; };
+
+		if (isDominant)
+		{
+			mUseLinearFog = values.linearFogEnable;
+			mUseTonemap = values.tonemappingEnable;
+			mUseSSR = values.ssrEnable;
+			mUseSSS = values.sssEnable;
+			mUseVignette = values.vignetteEnable;
+			mUseColorGrading = values.colorGradingEnable;
+			mColorGradingLUT = volume.colorGradingLUT ? volume.colorGradingLUT : mColorGradingDefaultLUT;
+		}
+
+		for (int i = 0; i < 3; i++)
+			mLinearFogColor[i] = blend(mLinearFogColor[i], values.linearFogColor[i]);
+		mLinearFogDensity = blend(mLinearFogDensity, valueOrDefault(values.linearFogDensity, mLinearFogDensityDefault));
+
+		mSSRMaxThickness = blend(mSSRMaxThickness, valueOrDefault(values.ssrMaxThickness, mSSRMaxThicknessDefault));
+		mSSRStepSize = blend(mSSRStepSize, valueOrDefault(values.ssrStepSize, mSSRStepSizeDefault));
+
+		mVignetteSoftness = blend(mVignetteSoftness, valueOrDefault(values.vignetteSoftness, mVignetteSoftnessDefault));
+		mVignetteRadius = blend(mVignetteRadius, valueOrDefault(values.vignetteRadius, mVignetteRadiusDefault));
+	}
+
 	void ER_PostProcessingStack::PrepareDrawingTonemapping(ER_RHI_GPUTexture* aInputTexture, ER_GBuffer* gbuffer)
 	{
 		assert(aInputTexture);
@@ -1022,6 +1132,22 @@ namespace EveryRay_Core {
 			debugGizmoAABB->Update(aabb);
 	}
 
+	float PostEffectsVolume::GetBlendFactor(const XMFLOAT3& aPosition) const
+	{
+		const float dx = std::max(std::max(aabb.first.x - aPosition.x, 0.0f), aPosition.x - aabb.second.x);
+		const float dy = std::max(std::max(aabb.first.y - aPosition.y, 0.0f), aPosition.y - aabb.second.y);
+		const float dz = std::max(std::max(aabb.first.z - aPosition.z, 0.0f), aPosition.z - aabb.second.z);
+		const float distance = sqrt(dx * dx + dy * dy + dz * dz);
+
+		float factor = 0.0f;
+		if (distance <= 0.0f)
+			factor = 1.0f;
+		else if (values.blendDistance > 0.0f && distance < values.blendDistance)
+			factor = 1.0f - distance / values.blendDistance;
+
+		return factor * std::min(std::max(values.weight, 0.0f), 1.0f);
+	}
+
 	void PostEffectsVolume::DrawDebugVolume(ER_RHI_GPUTexture* aRenderTarget, ER_RHI_GPUTexture* aDepth, ER_RHI_GPURootSignature* rs)
 	{
 		if (debugGizmoAABB && isEnabled)
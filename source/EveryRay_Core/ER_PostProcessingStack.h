@@ -3,7 +3,9 @@
 #include "ER_Core.h"
 #include "ER_CoreTime.h"
 
-#define MAX_POST_EFFECT_VOLUMES 64
+#define MAX_POST_EFFECT_VOLUMES 1024
+#define POST_EFFECT_VOLUMES_GRID_CELL_SIZE 32.0f
+#define POST_EFFECT_VOLUMES_GRID_MAX_CELLS_PER_VOLUME 64 // bigger volumes are not put into the grid and are always tested
 
 namespace EveryRay_Core
 {
@@ -70,6 +72,13 @@ namespace EveryRay_Core
 		bool ssrEnable;
 		float ssrMaxThickness;
 		float ssrStepSize;
+
+		// overlapping volumes are applied from the lowest to the highest priority (the higher one overrides the lower)
+		int priority = 0;
+		// distance from the volume's bounds at which it starts to blend in (0 - no blending, i.e., only inside the volume)
+		float blendDistance = 0.0f;
+		// max contribution of the volume ([0, 1])
+		float weight = 1.0f;
 	};
 	struct PostEffectsVolume
 	{
@@ -93,7 +102,10 @@ namespace EveryRay_Core
 				values.sssEnable == aVolume.values.sssEnable &&
 				values.ssrEnable == aVolume.values.ssrEnable &&
 				values.ssrMaxThickness == aVolume.values.ssrMaxThickness &&
-				values.ssrStepSize == aVolume.values.ssrStepSize;
+				values.ssrStepSize == aVolume.values.ssrStepSize &&
+				values.priority == aVolume.values.priority &&
+				values.blendDistance == aVolume.values.blendDistance &&
+				values.weight == aVolume.values.weight;
 		}
 
 		void UpdateDebugVolumeAABB();
@@ -102,6 +114,9 @@ namespace EveryRay_Core
 		void SetTransform(const XMFLOAT4X4& aTransform, bool updateAABB = true);
 		const XMFLOAT4X4& GetTransform() const { return worldTransform; }
 
+		// 1.0 inside of the volume, fades to 0.0 at "blendDistance" from its bounds (multiplied by "weight")
+		float GetBlendFactor(const XMFLOAT3& aPosition) const;
+
 		PostEffectsVolumeValues values = {};
 
 		XMFLOAT4X4 worldTransform = 
@@ -204,7 +219,9 @@ namespace EveryRay_Core
 		bool isWindowOpened = false;
 	private:
 		void UpdatePostEffectsVolumes();
+		void UpdatePostEffectsVolumesGrid();
 		void SetPostEffectsValuesFromVolume(int index = -1);
+		void BlendPostEffectsValuesFromVolume(int index, float factor);
 
 		void PrepareDrawingTonemapping(ER_RHI_GPUTexture* aInputTexture, ER_GBuffer* gbuffer);
 		void PrepareDrawingSSR(const ER_CoreTime& gameTime, ER_RHI_GPUTexture* aInputTexture, ER_GBuffer* gbuffer);
@@ -221,7 +238,11 @@ namespace EveryRay_Core
 
 		// volumes
 		std::vector<PostEffectsVolume> mPostEffectsVolumes;
-		int mCurrentActivePostEffectsVolumeIndex = -1; // the one we are currently in
+		std::vector<std::pair<int, float>> mActivePostEffectsVolumes; // the ones we are currently in or close to (index, blend factor), sorted by priority
+		// uniform grid of the volumes' bounds (extended by their blend distances), so that we only test the volumes around the camera
+		std::unordered_map<UINT64, std::vector<int>> mPostEffectsVolumesGrid;
+		std::vector<int> mPostEffectsVolumesOutsideGrid;
+		bool mIsPostEffectsVolumesGridDirty = true;
 		int mSelectedEditorPostEffectsVolumeIndex = -1; // the one selected for editing via ImGui
 		int mPrevSelectedEditorPostEffectsVolumeIndex = -1; // the one selected for editing via ImGui in last frame
 		bool mAreValuesSetFromVolumeForEditing = false;
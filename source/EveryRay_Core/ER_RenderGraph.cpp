@@ -0,0 +1,281 @@
+#include "ER_RenderGraph.h"
+#include "ER_Utility.h"
+
+namespace EveryRay_Core
+{
+	ER_RenderGraphResourceHandle ER_RenderGraphPassBuilder::CreateTexture(const std::string& aName, const ER_RenderGraphTextureDesc& aDesc)
+	{
+		return mGraph.CreateTexture(aName, aDesc);
+	}
+
+	ER_RenderGraphResourceHandle ER_RenderGraphPassBuilder::Read(ER_RenderGraphResourceHandle aHandle, ER_RHI_RESOURCE_STATE aState)
+	{
+		mGraph.AddPassAccess(mPassIndex, aHandle, aState, true, false);
+		return aHandle;
+	}
+
+	ER_RenderGraphResourceHandle ER_RenderGraphPassBuilder::Write(ER_RenderGraphResourceHandle aHandle, ER_RHI_RESOURCE_STATE aState)
+	{
+		mGraph.AddPassAccess(mPassIndex, aHandle, aState, false, true);
+		return aHandle;
+	}
+
+	ER_RenderGraphResourceHandle ER_RenderGraphPassBuilder::ReadWrite(ER_RenderGraphResourceHandle aHandle, ER_RHI_RESOURCE_STATE aState)
+	{
+		mGraph.AddPassAccess(mPassIndex, aHandle, aState, true, true);
+		return aHandle;
+	}
+
+	void ER_RenderGraphPassBuilder::SetHasSideEffects()
+	{
+		mGraph.SetPassHasSideEffects(mPassIndex);
+	}
+
+	void ER_RenderGraphPassBuilder::SetAsyncCompute()
+	{
+		mGraph.SetPassAsyncCompute(mPassIndex);
+	}
+
+	ER_RenderGraph::ER_RenderGraph()
+	{
+	}
+
+	ER_RenderGraph::~ER_RenderGraph()
+	{
+		ReleaseTransientTextures();
+	}
+
+	ER_RenderGraphResourceHandle ER_RenderGraph::ImportResource(const std::string& aName, ER_RHI_GPUResource* aResource, bool isOutput)
+	{
+		const ER_RenderGraphResourceHandle handle = AddResource(aName, ER_RENDER_GRAPH_RESOURCE_IMPORTED, isOutput);
+		mGPUResources.resize(mResources.size(), nullptr);
+		mGPUResources[handle] = aResource;
+		return handle;
+	}
+
+	int ER_RenderGraph::AddPass(const std::string& aName, const std::function<void(ER_RenderGraphPassBuilder&)>& aSetup, const ER_RenderGraphPassExecuteFunc& aExecute)
+	{
+		const int passIndex = ER_RenderGraphCompiler::AddPass(aName);
+		mPassesExecuteFuncs.resize(mPasses.size());
+		mPassesExecuteFuncs[passIndex] = aExecute;
+
+		ER_RenderGraphPassBuilder builder(*this, passIndex);
+		if (aSetup)
+			aSetup(builder);
+
+		return passIndex;
+	}
+
+	void ER_RenderGraph::Clear()
+	{
+		ER_RenderGraphCompiler::Clear();
+		mGPUResources.clear();
+		mPassesExecuteFuncs.clear();
+	}
+
+	void ER_RenderGraph::ReleaseTransientTextures()
+	{
+		for (auto& pooledTexture : mTransientTexturesPool)
+			DeleteObject(pooledTexture.Texture);
+		mTransientTexturesPool.clear();
+
+		for (int i = 0; i < static_cast<int>(mGPUResources.size()); i++)
+		{
+			if (mResources[i].Type == ER_RENDER_GRAPH_RESOURCE_TRANSIENT)
+				mGPUResources[i] = nullptr;
+		}
+	}
+
+	ER_RHI_GPUResource* ER_RenderGraph::GetResource(ER_RenderGraphResourceHandle aHandle) const
+	{
+		assert(aHandle >= 0 && aHandle < GetResourcesCount());
+		return aHandle < static_cast<int>(mGPUResources.size()) ? mGPUResources[aHandle] : nullptr;
+	}
+
+	bool ER_RenderGraph::Compile()
+	{
+		const bool isCompiled = ER_RenderGraphCompiler::Compile();
+		for (const std::string& message : mCompileMessages)
+		{
+			std::string logMessage = "[ER Logger][ER_RenderGraph] " + message + "\n";
+			ER_OUTPUT_LOG(ER_Utility::ToWideString(logMessage).c_str());
+		}
+		return isCompiled;
+	}
+
+	void ER_RenderGraph::Execute(ER_RHI* aRHI)
+	{
+		assert(aRHI);
+		if (!mIsCompiled && !Compile())
+			return;
+
+		// get physical textures from the pool (textures are never released between frames, only re-used)
+		for (auto& pooledTexture : mTransientTexturesPool)
+			pooledTexture.IsUsed = false;
+
+		std::vector<ER_RHI_GPUTexture*> physicalTextures(mPhysicalTexturesDescs.size(), nullptr);
+		for (int i = 0; i < GetPhysicalTexturesCount(); i++)
+		{
+			const ER_RenderGraphTextureDesc& desc = mPhysicalTexturesDescs[i];
+			for (auto& pooledTexture : mTransientTexturesPool)
+			{
+				if (!pooledTexture.IsUsed && pooledTexture.Desc == desc)
+				{
+					pooledTexture.IsUsed = true;
+					physicalTextures[i] = pooledTexture.Texture;
+					break;
+				}
+			}
+
+			if (!physicalTextures[i])
+			{
+				ER_RenderGraphPooledTexture pooledTexture;
+				pooledTexture.Desc = desc;
+				pooledTexture.IsUsed = true;
+				pooledTexture.Texture = aRHI->CreateGPUTexture(L"ER_RHI_GPUTexture: Render Graph Transient Texture #" + std::to_wstring(mTransientTexturesPool.size()));
+				pooledTexture.Texture->CreateGPUTextureResource(aRHI, desc.Width, desc.Height, 1u,
+					static_cast<ER_RHI_FORMAT>(desc.Format), static_cast<ER_RHI_BIND_FLAG>(desc.BindFlags), desc.Mips);
+				mTransientTexturesPool.push_back(pooledTexture);
+				physicalTextures[i] = pooledTexture.Texture;
+			}
+		}
+
+		mGPUResources.resize(mResources.size(), nullptr);
+		for (int i = 0; i < GetResourcesCount(); i++)
+		{
+			const ER_RenderGraphResource& resource = mResources[i];
+			if (resource.Type == ER_RENDER_GRAPH_RESOURCE_TRANSIENT)
+				mGPUResources[i] = resource.PhysicalIndex >= 0 ? physicalTextures[resource.PhysicalIndex] : nullptr;
+		}
+
+		// Async compute: graphics work is split into "segments" (submissions) and compute work into "batches".
+		// - an async pass needs the graphics segment that it depends on (or shares a resource with) to be submitted before its batch starts
+		// - a graphics pass waits on the GPU for the compute batch it depends on (or that still uses its resource) before its segment starts
+		const bool isAsyncCompute = mIsAsyncComputeEnabled;
+		assert(!isAsyncCompute || aRHI->IsAsyncComputeSupported()); // transitions were batched without async compute passes
+		const int computeCommandListIndex = 0;
+		bool isComputeBatchOpen = false;
+		int currentGraphicsSegment = 0;
+		int currentComputeBatch = 0; // the one that is being recorded (or the next one)
+		int waitedComputeBatches = 0; // by the graphics queue
+		std::vector<int> passesSubmissions(mPasses.size(), -1); // graphics segment or compute batch
+		std::vector<int> resourcesLastGraphicsSegments(mResources.size(), -1);
+		std::vector<int> resourcesLastComputeBatches(mResources.size(), -1);
+
+		auto submitComputeBatch = [&]()
+		{
+			if (!isComputeBatchOpen)
+				return;
+
+			aRHI->EndComputeCommandList(computeCommandListIndex);
+			aRHI->ExecuteCommandLists(computeCommandListIndex, true);
+			isComputeBatchOpen = false;
+			currentComputeBatch++;
+		};
+
+		std::vector<ER_RHI_GPUResource*> transitionResources;
+		std::vector<ER_RHI_RESOURCE_STATE> transitionStates;
+		for (int passIndex : mExecutionOrder)
+		{
+			ER_RenderGraphPass& pass = mPasses[passIndex];
+			const bool isAsyncPass = isAsyncCompute && pass.IsAsyncCompute;
+
+			if (isAsyncPass)
+			{
+				bool isWaitingForGraphics = false;
+				for (int dependency : pass.Dependencies)
+					isWaitingForGraphics |= !mPasses[dependency].IsAsyncCompute && passesSubmissions[dependency] == currentGraphicsSegment;
+				for (auto& access : pass.Accesses)
+					isWaitingForGraphics |= resourcesLastGraphicsSegments[access.Handle] == currentGraphicsSegment;
+
+				if (isWaitingForGraphics)
+				{
+					submitComputeBatch();
+					aRHI->FlushGraphicsCommandList();
+					currentGraphicsSegment++;
+				}
+
+				if (!isComputeBatchOpen)
+				{
+					aRHI->WaitForGraphicsOnComputeQueue();
+					aRHI->BeginComputeCommandList(computeCommandListIndex);
+					isComputeBatchOpen = true;
+				}
+
+				// async passes are transitioned by the RHI when their resources are bound (it knows which states are legal on the compute queue)
+				passesSubmissions[passIndex] = currentComputeBatch;
+				for (auto& access : pass.Accesses)
+					resourcesLastComputeBatches[access.Handle] = currentComputeBatch;
+			}
+			else
+			{
+				if (isAsyncCompute)
+				{
+					bool isWaitingForCompute = false;
+					for (int dependency : pass.Dependencies)
+						isWaitingForCompute |= mPasses[dependency].IsAsyncCompute && passesSubmissions[dependency] >= waitedComputeBatches;
+					for (auto& access : pass.Accesses)
+					{
+						// reading in the non-pixel shader resource state does not need a transition, so it can be shared with the compute queue
+						const bool isSharedRead = access.IsRead && !access.IsWrite && access.State == ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+						isWaitingForCompute |= !isSharedRead && resourcesLastComputeBatches[access.Handle] >= waitedComputeBatches;
+					}
+
+					if (isWaitingForCompute)
+					{
+						submitComputeBatch();
+						aRHI->FlushGraphicsCommandList();
+						aRHI->WaitForComputeOnGraphicsQueue();
+						currentGraphicsSegment++;
+						waitedComputeBatches = currentComputeBatch;
+					}
+
+					passesSubmissions[passIndex] = currentGraphicsSegment;
+					for (auto& access : pass.Accesses)
+						resourcesLastGraphicsSegments[access.Handle] = currentGraphicsSegment;
+				}
+
+				transitionResources.clear();
+				transitionStates.clear();
+				for (auto& transition : pass.Transitions)
+				{
+					ER_RHI_GPUResource* resource = mGPUResources[transition.Handle];
+					if (resource)
+					{
+						transitionResources.push_back(resource);
+						transitionStates.push_back(static_cast<ER_RHI_RESOURCE_STATE>(transition.State));
+					}
+				}
+				if (!transitionResources.empty())
+					aRHI->TransitionResources(transitionResources, transitionStates, aRHI->GetCurrentGraphicsCommandListIndex());
+
+				// all resources of the pass are in their declared states now: binding them in the pass skips the per-binding transitions of the RHI
+				transitionResources.clear();
+				transitionStates.clear();
+				for (auto& access : pass.Accesses)
+				{
+					if (mGPUResources[access.Handle])
+					{
+						transitionResources.push_back(mGPUResources[access.Handle]);
+						transitionStates.push_back(static_cast<ER_RHI_RESOURCE_STATE>(access.State));
+					}
+				}
+				aRHI->SetRenderGraphResources(transitionResources, transitionStates);
+			}
+
+			// only async passes are recorded into the open compute command list (graphics passes in between go to the graphics one)
+			aRHI->SetIsRecordingAsyncComputePass(isAsyncPass);
+			aRHI->BeginEventTag("EveryRay: " + pass.Name, isAsyncPass);
+			if (mPassesExecuteFuncs[passIndex])
+				mPassesExecuteFuncs[passIndex](aRHI, *this);
+			aRHI->EndEventTag(isAsyncPass);
+			aRHI->SetIsRecordingAsyncComputePass(false);
+
+			if (!isAsyncPass)
+				aRHI->SetRenderGraphResources({}, {});
+		}
+
+		// the rest of the frame does not depend on it, graphics queue waits for it before the frame is finished
+		submitComputeBatch();
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "Common.h"
+#include "RHI/ER_RHI.h"
+#include "ER_RenderGraphCompiler.h"
+
+#include <functional>
+
+namespace EveryRay_Core
+{
+	class ER_RenderGraph;
+
+	typedef std::function<void(ER_RHI* aRHI, ER_RenderGraph& aGraph)> ER_RenderGraphPassExecuteFunc;
+
+	class ER_RenderGraphPassBuilder
+	{
+	public:
+		ER_RenderGraphResourceHandle CreateTexture(const std::string& aName, const ER_RenderGraphTextureDesc& aDesc);
+		ER_RenderGraphResourceHandle Read(ER_RenderGraphResourceHandle aHandle, ER_RHI_RESOURCE_STATE aState = ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+		ER_RenderGraphResourceHandle Write(ER_RenderGraphResourceHandle aHandle, ER_RHI_RESOURCE_STATE aState = ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_RENDER_TARGET);
+		// for the passes that do not overwrite the whole resource (blending on top of it, UAV read-modify-write, etc.)
+		ER_RenderGraphResourceHandle ReadWrite(ER_RenderGraphResourceHandle aHandle, ER_RHI_RESOURCE_STATE aState = ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_UNORDERED_ACCESS);
+		void SetHasSideEffects();
+		void SetAsyncCompute();
+	private:
+		friend class ER_RenderGraph;
+		ER_RenderGraphPassBuilder(ER_RenderGraph& aGraph, int aPassIndex) : mGraph(aGraph), mPassIndex(aPassIndex) {}
+
+		ER_RenderGraph& mGraph;
+		int mPassIndex;
+	};
+
+	// Frame render graph on top of ER_RHI:
+	// - passes declare which resources they read and write (and in which state) instead of relying on a hardcoded order and per-binding transitions
+	// - "Compile()" derives the execution order from the dependencies, culls the passes whose results are never used,
+	//   computes lifetimes of transient textures (and aliases the ones that do not overlap) and batches all transitions of a pass into one call
+	// - the compile step lives in ER_RenderGraphCompiler (standard library only), this class only binds it to the RHI in "Execute()"
+	// - async compute passes (if enabled) are scheduled as early as possible and recorded into the compute queue; the queues are synchronized on the GPU
+	//   only where a pass depends on (or shares a resource with) the work of the other queue
+	// The graph can be built once and executed every frame: it only has to be re-compiled when passes or resources change.
+	class ER_RenderGraph : public ER_RenderGraphCompiler
+	{
+	public:
+		ER_RenderGraph();
+		~ER_RenderGraph();
+
+		ER_RenderGraphResourceHandle ImportResource(const std::string& aName, ER_RHI_GPUResource* aResource, bool isOutput = false);
+		int AddPass(const std::string& aName, const std::function<void(ER_RenderGraphPassBuilder&)>& aSetup, const ER_RenderGraphPassExecuteFunc& aExecute);
+
+		bool Compile(); // logs the messages of the compiler
+		void Execute(ER_RHI* aRHI);
+		void Clear(); // removes passes and resources, keeps the transient textures pool
+		void ReleaseTransientTextures(); // GPU must be idle
+
+		ER_RHI_GPUResource* GetResource(ER_RenderGraphResourceHandle aHandle) const;
+		ER_RHI_GPUTexture* GetTexture(ER_RenderGraphResourceHandle aHandle) const { return static_cast<ER_RHI_GPUTexture*>(GetResource(aHandle)); }
+	private:
+		struct ER_RenderGraphPooledTexture
+		{
+			ER_RenderGraphTextureDesc Desc;
+			ER_RHI_GPUTexture* Texture = nullptr;
+			bool IsUsed = false;
+		};
+
+		std::vector<ER_RHI_GPUResource*> mGPUResources; // by handle: imported or (after execution started) transient, nullptr for virtual
+		std::vector<ER_RenderGraphPassExecuteFunc> mPassesExecuteFuncs; // by pass index
+		std::vector<ER_RenderGraphPooledTexture> mTransientTexturesPool; // persistent between frames and recompilations
+	};
+}
@@ -0,0 +1,403 @@
+#include "ER_RenderGraphCompiler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <queue>
+
+namespace EveryRay_Core
+{
+	ER_RenderGraphResourceHandle ER_RenderGraphCompiler::AddResource(const std::string& aName, ER_RenderGraphResourceType aType, bool isOutput)
+	{
+		ER_RenderGraphResource resource;
+		resource.Name = aName;
+		resource.Type = aType;
+		resource.IsOutput = isOutput;
+		mResources.push_back(resource);
+
+		mIsCompiled = false;
+		return static_cast<ER_RenderGraphResourceHandle>(mResources.size() - 1);
+	}
+
+	ER_RenderGraphResourceHandle ER_RenderGraphCompiler::CreateVirtualResource(const std::string& aName, bool isOutput)
+	{
+		return AddResource(aName, ER_RENDER_GRAPH_RESOURCE_VIRTUAL, isOutput);
+	}
+
+	ER_RenderGraphResourceHandle ER_RenderGraphCompiler::CreateTexture(const std::string& aName, const ER_RenderGraphTextureDesc& aDesc)
+	{
+		assert(aDesc.Width > 0 && aDesc.Height > 0);
+
+		const ER_RenderGraphResourceHandle handle = AddResource(aName, ER_RENDER_GRAPH_RESOURCE_TRANSIENT);
+		mResources[handle].Desc = aDesc;
+		return handle;
+	}
+
+	int ER_RenderGraphCompiler::AddPass(const std::string& aName)
+	{
+		mPasses.emplace_back();
+		mPasses.back().Name = aName;
+
+		mIsCompiled = false;
+		return static_cast<int>(mPasses.size() - 1);
+	}
+
+	void ER_RenderGraphCompiler::AddPassAccess(int aPassIndex, ER_RenderGraphResourceHandle aHandle, ER_RenderGraphResourceState aState, bool isRead, bool isWrite)
+	{
+		assert(aPassIndex >= 0 && aPassIndex < GetPassesCount());
+		assert(aHandle >= 0 && aHandle < GetResourcesCount());
+		mIsCompiled = false;
+
+		ER_RenderGraphPass& pass = mPasses[aPassIndex];
+		for (auto& access : pass.Accesses)
+		{
+			if (access.Handle == aHandle)
+			{
+				assert(access.State == aState);
+				access.IsRead |= isRead;
+				access.IsWrite |= isWrite;
+				return;
+			}
+		}
+
+		ER_RenderGraphResourceAccess access;
+		access.Handle = aHandle;
+		access.State = aState;
+		access.IsRead = isRead;
+		access.IsWrite = isWrite;
+		pass.Accesses.push_back(access);
+	}
+
+	void ER_RenderGraphCompiler::Clear()
+	{
+		mPasses.clear();
+		mResources.clear();
+		mExecutionOrder.clear();
+		mPhysicalTexturesDescs.clear();
+		mCompileMessages.clear();
+		mIsCompiled = false;
+	}
+
+	int ER_RenderGraphCompiler::GetCulledPassesCount() const
+	{
+		return static_cast<int>(std::count_if(mPasses.begin(), mPasses.end(), [](const ER_RenderGraphPass& aPass) { return aPass.IsCulled; }));
+	}
+
+	int ER_RenderGraphCompiler::GetAsyncComputePassesCount() const
+	{
+		int count = 0;
+		for (int passIndex : mExecutionOrder)
+			count += IsAsyncComputePass(passIndex) ? 1 : 0;
+		return count;
+	}
+
+	int ER_RenderGraphCompiler::GetTransitionsCount() const
+	{
+		int count = 0;
+		for (int passIndex : mExecutionOrder)
+			count += static_cast<int>(mPasses[passIndex].Transitions.size());
+		return count;
+	}
+
+	bool ER_RenderGraphCompiler::Compile()
+	{
+		mCompileMessages.clear();
+
+		std::vector<std::vector<int>> successors;
+		BuildDependencies(successors);
+		CullPasses();
+		if (!SortPasses(successors))
+		{
+			mCompileMessages.push_back("Could not compile the graph: cyclic dependency between passes!");
+			return false;
+		}
+
+		// every transient texture that is read has to be written first
+		for (int passIndex : mExecutionOrder)
+		{
+			for (auto& access : mPasses[passIndex].Accesses)
+			{
+				if (access.IsRead && mResources[access.Handle].Type == ER_RENDER_GRAPH_RESOURCE_TRANSIENT && !access.IsWrite &&
+					std::find_if(mPasses[passIndex].Producers.begin(), mPasses[passIndex].Producers.end(),
+						[&](int producer) { return !mPasses[producer].IsCulled; }) == mPasses[passIndex].Producers.end())
+				{
+					mCompileMessages.push_back("Transient texture is read before it is written: " + mResources[access.Handle].Name);
+				}
+			}
+		}
+
+		ComputeLifetimes();
+		AliasTransientTextures();
+		BatchTransitions();
+
+		mIsCompiled = true;
+		return true;
+	}
+
+	// Edges follow the declaration order of accesses:
+	// read-after-write (the only ones that carry data, used for culling), write-after-read and write-after-write (only for ordering)
+	void ER_RenderGraphCompiler::BuildDependencies(std::vector<std::vector<int>>& outSuccessors)
+	{
+		const int passesCount = GetPassesCount();
+		outSuccessors.assign(passesCount, {});
+
+		std::vector<int> lastWriters(mResources.size(), -1);
+		std::vector<std::vector<int>> readersSinceLastWrite(mResources.size());
+
+		auto addEdge = [&](int from, int to)
+		{
+			if (from != to && std::find(outSuccessors[from].begin(), outSuccessors[from].end(), to) == outSuccessors[from].end())
+			{
+				outSuccessors[from].push_back(to);
+				mPasses[to].Dependencies.push_back(from);
+			}
+		};
+
+		for (int passIndex = 0; passIndex < passesCount; passIndex++)
+		{
+			ER_RenderGraphPass& pass = mPasses[passIndex];
+			pass.Producers.clear();
+			pass.Dependencies.clear();
+
+			for (auto& access : pass.Accesses)
+			{
+				if (!access.IsRead)
+					continue;
+
+				const int writer = lastWriters[access.Handle];
+				if (writer >= 0)
+				{
+					addEdge(writer, passIndex);
+					if (std::find(pass.Producers.begin(), pass.Producers.end(), writer) == pass.Producers.end())
+						pass.Producers.push_back(writer);
+				}
+				readersSinceLastWrite[access.Handle].push_back(passIndex);
+			}
+
+			for (auto& access : pass.Accesses)
+			{
+				if (!access.IsWrite)
+					continue;
+
+				if (lastWriters[access.Handle] >= 0)
+					addEdge(lastWriters[access.Handle], passIndex);
+				for (int reader : readersSinceLastWrite[access.Handle])
+					addEdge(reader, passIndex);
+
+				lastWriters[access.Handle] = passIndex;
+				readersSinceLastWrite[access.Handle].clear();
+			}
+		}
+	}
+
+	// A pass is alive if it has side effects, writes to an output or produces data for another alive pass
+	void ER_RenderGraphCompiler::CullPasses()
+	{
+		const int passesCount = GetPassesCount();
+		std::vector<int> stack;
+		stack.reserve(passesCount);
+
+		for (int passIndex = 0; passIndex < passesCount; passIndex++)
+		{
+			ER_RenderGraphPass& pass = mPasses[passIndex];
+			pass.IsCulled = true;
+
+			bool isRoot = pass.HasSideEffects;
+			for (auto& access : pass.Accesses)
+				isRoot |= access.IsWrite && mResources[access.Handle].IsOutput;
+
+			if (isRoot)
+			{
+				pass.IsCulled = false;
+				stack.push_back(passIndex);
+			}
+		}
+
+		while (!stack.empty())
+		{
+			const int passIndex = stack.back();
+			stack.pop_back();
+
+			for (int producer : mPasses[passIndex].Producers)
+			{
+				if (mPasses[producer].IsCulled)
+				{
+					mPasses[producer].IsCulled = false;
+					stack.push_back(producer);
+				}
+			}
+		}
+	}
+
+	// Topological sort of the alive passes; between independent passes we keep the declaration order
+	bool ER_RenderGraphCompiler::SortPasses(const std::vector<std::vector<int>>& aSuccessors)
+	{
+		const int passesCount = GetPassesCount();
+		std::vector<int> inDegrees(passesCount, 0);
+		int alivePassesCount = 0;
+		for (int passIndex = 0; passIndex < passesCount; passIndex++)
+		{
+			if (mPasses[passIndex].IsCulled)
+				continue;
+
+			alivePassesCount++;
+			for (int successor : aSuccessors[passIndex])
+			{
+				if (!mPasses[successor].IsCulled)
+					inDegrees[successor]++;
+			}
+		}
+
+		// without async compute it is just the declaration order; with it - async compute passes go first (as early as possible),
+		// then graphics passes that do not wait for async compute (so they overlap with it), then the rest in the declaration order
+		std::vector<int> priorities(passesCount, 0);
+		if (mIsAsyncComputeEnabled)
+		{
+			for (int passIndex = 0; passIndex < passesCount; passIndex++)
+			{
+				if (IsAsyncComputePass(passIndex))
+					continue;
+
+				priorities[passIndex] = 1;
+				for (int dependency : mPasses[passIndex].Dependencies)
+				{
+					if (!mPasses[dependency].IsCulled && IsAsyncComputePass(dependency))
+					{
+						priorities[passIndex] = 2;
+						break;
+					}
+				}
+			}
+		}
+		auto isLowerPriority = [&priorities](int a, int b)
+		{
+			return priorities[a] != priorities[b] ? priorities[a] > priorities[b] : a > b;
+		};
+
+		std::priority_queue<int, std::vector<int>, decltype(isLowerPriority)> readyPasses(isLowerPriority);
+		for (int passIndex = 0; passIndex < passesCount; passIndex++)
+		{
+			if (!mPasses[passIndex].IsCulled && inDegrees[passIndex] == 0)
+				readyPasses.push(passIndex);
+		}
+
+		mExecutionOrder.clear();
+		while (!readyPasses.empty())
+		{
+			const int passIndex = readyPasses.top();
+			readyPasses.pop();
+			mExecutionOrder.push_back(passIndex);
+
+			for (int successor : aSuccessors[passIndex])
+			{
+				if (!mPasses[successor].IsCulled && --inDegrees[successor] == 0)
+					readyPasses.push(successor);
+			}
+		}
+
+		return static_cast<int>(mExecutionOrder.size()) == alivePassesCount;
+	}
+
+	void ER_RenderGraphCompiler::ComputeLifetimes()
+	{
+		for (auto& resource : mResources)
+		{
+			resource.FirstUse = -1;
+			resource.LastUse = -1;
+			resource.PhysicalIndex = -1;
+		}
+
+		for (int i = 0; i < static_cast<int>(mExecutionOrder.size()); i++)
+		{
+			for (auto& access : mPasses[mExecutionOrder[i]].Accesses)
+			{
+				ER_RenderGraphResource& resource = mResources[access.Handle];
+				if (resource.FirstUse == -1)
+					resource.FirstUse = i;
+				resource.LastUse = i;
+			}
+		}
+	}
+
+	// Greedy interval assignment: a transient texture reuses the physical texture of one that is already dead and has the same description
+	void ER_RenderGraphCompiler::AliasTransientTextures()
+	{
+		std::vector<ER_RenderGraphResourceHandle> transientTextures;
+		for (int i = 0; i < GetResourcesCount(); i++)
+		{
+			if (mResources[i].Type == ER_RENDER_GRAPH_RESOURCE_TRANSIENT && mResources[i].FirstUse >= 0)
+				transientTextures.push_back(i);
+		}
+		std::sort(transientTextures.begin(), transientTextures.end(),
+			[this](ER_RenderGraphResourceHandle a, ER_RenderGraphResourceHandle b) { return mResources[a].FirstUse < mResources[b].FirstUse; });
+
+		// textures of async compute passes are not aliased: their lifetimes on the GPU are not bound by the execution order
+		std::vector<bool> isUsedByAsyncCompute(mResources.size(), false);
+		for (int passIndex : mExecutionOrder)
+		{
+			if (IsAsyncComputePass(passIndex))
+			{
+				for (auto& access : mPasses[passIndex].Accesses)
+					isUsedByAsyncCompute[access.Handle] = true;
+			}
+		}
+
+		mPhysicalTexturesDescs.clear();
+		std::vector<int> physicalTexturesLastUses;
+		for (ER_RenderGraphResourceHandle handle : transientTextures)
+		{
+			ER_RenderGraphResource& resource = mResources[handle];
+			for (int i = 0; i < static_cast<int>(mPhysicalTexturesDescs.size()) && !isUsedByAsyncCompute[handle]; i++)
+			{
+				if (physicalTexturesLastUses[i] < resource.FirstUse && mPhysicalTexturesDescs[i] == resource.Desc)
+				{
+					resource.PhysicalIndex = i;
+					physicalTexturesLastUses[i] = resource.LastUse;
+					break;
+				}
+			}
+
+			if (resource.PhysicalIndex == -1)
+			{
+				resource.PhysicalIndex = static_cast<int>(mPhysicalTexturesDescs.size());
+				mPhysicalTexturesDescs.push_back(resource.Desc);
+				physicalTexturesLastUses.push_back(isUsedByAsyncCompute[handle] ? INT_MAX : resource.LastUse);
+			}
+		}
+	}
+
+	// We track the state every resource will be in after each pass, so that we only keep the transitions that change something.
+	// The state of a resource before its first use is unknown (imported resources are also used outside of the graph), so we always keep those:
+	// the RHI skips them if the resource is already in the right state.
+	void ER_RenderGraphCompiler::BatchTransitions()
+	{
+		const ER_RenderGraphResourceState unknownState = -1;
+		std::vector<ER_RenderGraphResourceState> currentStates(mResources.size(), unknownState);
+
+		for (auto& pass : mPasses)
+			pass.Transitions.clear();
+
+		for (int passIndex : mExecutionOrder)
+		{
+			ER_RenderGraphPass& pass = mPasses[passIndex];
+			for (auto& access : pass.Accesses)
+			{
+				if (mResources[access.Handle].Type == ER_RENDER_GRAPH_RESOURCE_VIRTUAL)
+					continue;
+
+				// async compute passes are transitioned by the RHI (on its queue), so we do not know the state after them
+				if (IsAsyncComputePass(passIndex))
+				{
+					currentStates[access.Handle] = unknownState;
+					continue;
+				}
+
+				if (currentStates[access.Handle] != access.State)
+				{
+					pass.Transitions.push_back(access);
+					currentStates[access.Handle] = access.State;
+				}
+			}
+		}
+	}
+}
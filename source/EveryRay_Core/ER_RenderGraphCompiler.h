@@ -0,0 +1,122 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#define ER_RENDER_GRAPH_INVALID_HANDLE -1
+
+namespace EveryRay_Core
+{
+	typedef int ER_RenderGraphResourceHandle;
+	typedef int ER_RenderGraphResourceState; // ER_RHI_RESOURCE_STATE in the engine (the compiler only compares states)
+
+	struct ER_RenderGraphTextureDesc
+	{
+		unsigned int Width = 0;
+		unsigned int Height = 0;
+		int Format = 0; // ER_RHI_FORMAT
+		int BindFlags = 0; // ER_RHI_BIND_FLAG
+		int Mips = 1;
+
+		bool operator==(const ER_RenderGraphTextureDesc& aDesc) const
+		{
+			return Width == aDesc.Width && Height == aDesc.Height && Format == aDesc.Format && BindFlags == aDesc.BindFlags && Mips == aDesc.Mips;
+		}
+	};
+
+	enum ER_RenderGraphResourceType
+	{
+		ER_RENDER_GRAPH_RESOURCE_IMPORTED = 0, // owned by some system (lives all the time)
+		ER_RENDER_GRAPH_RESOURCE_TRANSIENT, // owned by the graph (only lives between its first and last use, memory is shared with other transient textures)
+		ER_RENDER_GRAPH_RESOURCE_VIRTUAL // no GPU resource, only used for dependencies between passes (i.e., for the data that is hidden inside of systems)
+	};
+
+	struct ER_RenderGraphResource
+	{
+		std::string Name;
+		ER_RenderGraphResourceType Type = ER_RENDER_GRAPH_RESOURCE_IMPORTED;
+		ER_RenderGraphTextureDesc Desc; // transient only
+		bool IsOutput = false; // used after the graph, so the passes that write to it are never culled
+
+		// compiled
+		int FirstUse = -1; // position in the execution order
+		int LastUse = -1;
+		int PhysicalIndex = -1; // transient only: index of the physical texture (shared by transient textures with non-overlapping lifetimes)
+	};
+
+	struct ER_RenderGraphResourceAccess
+	{
+		ER_RenderGraphResourceHandle Handle = ER_RENDER_GRAPH_INVALID_HANDLE;
+		ER_RenderGraphResourceState State = 0; // the state the resource has to be in when the pass starts
+		bool IsRead = false;
+		bool IsWrite = false;
+	};
+
+	struct ER_RenderGraphPass
+	{
+		std::string Name;
+		std::vector<ER_RenderGraphResourceAccess> Accesses;
+		bool HasSideEffects = false; // never culled (i.e., writes to the swapchain, saves to disk, etc.)
+		bool IsAsyncCompute = false; // only compute work: recorded into the compute queue (if enabled), so it can overlap with the graphics passes that do not depend on it
+
+		// compiled
+		bool IsCulled = false;
+		std::vector<int> Producers; // passes that write the data this pass reads
+		std::vector<int> Dependencies; // all passes that have to be executed before this one (read-after-write, write-after-read, write-after-write)
+		std::vector<ER_RenderGraphResourceAccess> Transitions; // batched before the pass
+	};
+
+	// Compile step of the render graph (see ER_RenderGraph) over plain handles and states:
+	// derives the execution order from the dependencies, culls the passes whose results are never used,
+	// computes lifetimes of transient textures (and aliases the ones that do not overlap) and batches all transitions of a pass.
+	// Only depends on the standard library (no RHI, no Windows), so it can be built and tested on other platforms too.
+	class ER_RenderGraphCompiler
+	{
+	public:
+		ER_RenderGraphResourceHandle AddResource(const std::string& aName, ER_RenderGraphResourceType aType, bool isOutput = false);
+		ER_RenderGraphResourceHandle CreateVirtualResource(const std::string& aName, bool isOutput = false);
+		ER_RenderGraphResourceHandle CreateTexture(const std::string& aName, const ER_RenderGraphTextureDesc& aDesc);
+
+		int AddPass(const std::string& aName);
+		// one access per resource in a pass: flags of the repeated accesses are merged (the first declared state wins)
+		void AddPassAccess(int aPassIndex, ER_RenderGraphResourceHandle aHandle, ER_RenderGraphResourceState aState, bool isRead, bool isWrite);
+		void SetPassHasSideEffects(int aPassIndex) { mPasses[aPassIndex].HasSideEffects = true; mIsCompiled = false; }
+		void SetPassAsyncCompute(int aPassIndex) { mPasses[aPassIndex].IsAsyncCompute = true; mIsCompiled = false; }
+
+		// has to be set before "Compile()" (changes the execution order)
+		void SetAsyncComputeEnabled(bool aEnabled) { mIsAsyncComputeEnabled = aEnabled; mIsCompiled = false; }
+		bool IsAsyncComputeEnabled() const { return mIsAsyncComputeEnabled; }
+
+		bool Compile(); // warnings and errors are in "GetCompileMessages()"
+		void Clear(); // removes passes and resources
+
+		bool IsCompiled() const { return mIsCompiled; }
+		const std::vector<std::string>& GetCompileMessages() const { return mCompileMessages; }
+		const std::vector<int>& GetExecutionOrder() const { return mExecutionOrder; }
+		const ER_RenderGraphPass& GetPass(int aIndex) const { return mPasses[aIndex]; }
+		const ER_RenderGraphResource& GetResourceInfo(ER_RenderGraphResourceHandle aHandle) const { return mResources[aHandle]; }
+		int GetPassesCount() const { return static_cast<int>(mPasses.size()); }
+		int GetResourcesCount() const { return static_cast<int>(mResources.size()); }
+		int GetCulledPassesCount() const;
+		int GetPhysicalTexturesCount() const { return static_cast<int>(mPhysicalTexturesDescs.size()); }
+		int GetTransitionsCount() const;
+		int GetAsyncComputePassesCount() const;
+	protected:
+		bool IsAsyncComputePass(int aPassIndex) const { return mIsAsyncComputeEnabled && mPasses[aPassIndex].IsAsyncCompute; }
+
+		std::vector<ER_RenderGraphResource> mResources;
+		std::vector<ER_RenderGraphPass> mPasses;
+		std::vector<int> mExecutionOrder; // culled passes are not included
+		std::vector<ER_RenderGraphTextureDesc> mPhysicalTexturesDescs;
+		std::vector<std::string> mCompileMessages;
+
+		bool mIsCompiled = false;
+		bool mIsAsyncComputeEnabled = false;
+	private:
+		void BuildDependencies(std::vector<std::vector<int>>& outSuccessors);
+		void CullPasses();
+		bool SortPasses(const std::vector<std::vector<int>>& aSuccessors);
+		void ComputeLifetimes();
+		void AliasTransientTextures();
+		void BatchTransitions();
+	};
+}
@@ -15,8 +15,10 @@
 #include "ER_Camera.h"
 #include "ER_MatrixHelper.h"
 #include "ER_Terrain.h"
-#include "ER_Settings.h"
 #include "ER_Scene.h"
+#include "ER_TextureStreamer.h"
+#include "ER_TextureCooker.h"
+#include "ER_SoftwareOcclusionCuller.h"
 
 #define LOAD_OLD_INSTANCED_DATA_FOR_GPU_INDIRECT_OBJECTS 0 // uncommnet if you need to debug "direct" instancing code (old-way)
 
@@ -35,8 +37,7 @@ namespace EveryRay_Core
 		mIsAvailableInEditorMode(availableInEditor),
 		mTransformationMatrix(XMMatrixIdentity()),
 		mIsInstanced(isInstanced),
-		mIndexInScene(index),
-		mCurrentTextureQuality((RenderingObjectTextureQuality)ER_Settings::TexturesQuality)
+		mIndexInScene(index)
 	{
 		mModel = mCore->AddOrGet3DModelFromCache(pModelPath, nullptr, true);
 		if (!mModel)
@@ -46,13 +47,10 @@ namespace EveryRay_Core
 		}
 
 		mMeshesCount.push_back(0); // main LOD
-		mMeshVertices.push_back({}); // main LOD
-		mMeshAllVertices.push_back({}); // main LOD
 
 		mMeshesCount[0] = static_cast<int>(mModel->Meshes().size());
 		for (int i = 0; i < mMeshesCount[0]; i++)
 		{
-			mMeshVertices[0].push_back(mModel->GetMesh(i).Vertices());
 			mMeshesTextureBuffers.push_back(TextureData());
 			mMeshesReflectionFactors.push_back(0.0f);
 
@@ -64,14 +62,6 @@ namespace EveryRay_Core
 			mCustomReflectionMaskTextures.push_back("");
 		}
 
-		for (size_t i = 0; i < mMeshVertices[0].size(); i++)
-		{
-			for (size_t j = 0; j < mMeshVertices[0][i].size(); j++)
-			{
-				mMeshAllVertices[0].push_back(mMeshVertices[0][i][j]);
-			}
-		}
-
 		mLocalAABB = mModel->GenerateAABB();
 		mGlobalAABB = mLocalAABB;
 
@@ -114,9 +104,12 @@ namespace EveryRay_Core
 			}
 		}
 
-		for (auto& meshesInstanceBuffersLOD : mMeshesInstanceBuffers)
-			DeletePointerCollection(meshesInstanceBuffersLOD);
-		mMeshesInstanceBuffers.clear();
+		if (mScene && mScene->GetInstanceBufferPool())
+		{
+			for (auto& instanceBufferRange : mInstanceBufferRanges)
+				mScene->GetInstanceBufferPool()->Free(instanceBufferRange);
+		}
+		mInstanceBufferRanges.clear();
 
 		mMeshesTextureBuffers.clear();
 
@@ -128,26 +121,39 @@ namespace EveryRay_Core
 		mObjectConstantBuffer.Release();
 		mObjectFakeRootConstantBuffer.Release();
 
-		if (mIsIndirectlyRendered)
-		{
-#if !ER_PLATFORM_WIN64_DX11
-			mIndirectMeshConstants.Release();
-#endif
-			DeleteObject(mIndirectArgsBuffer);
-			DeleteObject(mIndirectNewInstanceDataBuffer);
-			DeleteObject(mIndirectOriginalInstanceDataBuffer);
-		}
-		else
+		if (!mIsIndirectlyRendered)
 		{
 			for (int i = 0; i < MAX_DIRECT_INSTANCE_COUNT; i++)
 				free(mEditorInstancedNamesUI[i]);
 		}
 	}
 
+	void ER_RenderingObject::Rename(const std::string& name)
+	{
+		if (name == mName)
+			return;
+
+		std::string oldName = mName;
+		mName = name;
+		if (mScene)
+			mScene->OnRenderingObjectRenamed(this, oldName);
+	}
+
 	void ER_RenderingObject::LoadMaterial(ER_Material* pMaterial, const std::string& materialName)
 	{
 		assert(pMaterial);
-		mMaterials.emplace(materialName, pMaterial);
+
+		const ER_MaterialID materialID = ER_MaterialHelper::GetMaterialID(materialName);
+		if (mMaterialsByID[materialID])
+		{
+			DeleteObject(pMaterial);
+			return;
+		}
+
+		mMaterials.emplace_back(materialName, pMaterial);
+		mMaterialIDs.push_back(materialID);
+		mMaterialsByID[materialID] = pMaterial;
+		mMaterialsListenerHandles[materialID] = ER_GenericEvent<Delegate_MeshMaterialVariablesUpdate>::GetListenerHandle(materialName);
 	}
 
 	//from mesh-built-in textures (something that was specified in 3D tool, like Blender or Maya)
@@ -312,7 +318,8 @@ namespace EveryRay_Core
 	}
 
 	// This is main method for loading textures before going to RHI
-	// It supports quality levels, format check and different types of textures
+	// It picks the best quality level on disk and sends textures with mips on disk to the streaming system (see ER_TextureStreamer),
+	// other textures are capped by the texture quality setting and get their mips generated
 	void ER_RenderingObject::LoadTexture(ER_RHI_GPUTexture** aTexture, bool* loadStat, const std::wstring& path, int meshIndex, bool isPlaceholder)
 	{
 		if (!mIsLoaded)
@@ -320,69 +327,77 @@ namespace EveryRay_Core
 
 		assert(loadStat);
 		ER_RHI* rhi = mCore->GetRHI();
+		ER_TextureStreamer* textureStreamer = mCore->GetServices().FindService<ER_TextureStreamer>();
 
 		const int extensionSymbolCount = 4; // .png, .dds, etc.
-		const int texQualityCount = RenderingObjectTextureQuality::OBJECT_TEXTURE_COUNT;
-		assert((int)mCurrentTextureQuality < texQualityCount);
-
-		const wchar_t* postfixQuality[RenderingObjectTextureQuality::OBJECT_TEXTURE_COUNT] =
+		const wchar_t* postfixQuality[] =
 		{
-			 L"_lq",
+			 L"_hq",
 			 L"_mq",
-			 L"_hq"
+			 L"_lq"
 		};
 
-		std::wstring possiblePaths[RenderingObjectTextureQuality::OBJECT_TEXTURE_COUNT];
-
-		for (int i = 0; i < (int)RenderingObjectTextureQuality::OBJECT_TEXTURE_COUNT; i++)
+		// we traverse through different texture quality levels on disk unless we hit the first one (maybe the texture does not have postfix at all)
+		std::wstring sourcePath = path;
+		for (const wchar_t* postfix : postfixQuality)
 		{
-			possiblePaths[i] = path;
-			possiblePaths[i].insert(path.length() - extensionSymbolCount, std::wstring(postfixQuality[i]));
+			std::wstring possiblePath = path;
+			possiblePath.insert(path.length() - extensionSymbolCount, std::wstring(postfix));
+			if (std::ifstream(possiblePath.c_str()).good())
+			{
+				sourcePath = possiblePath;
+				break;
+			}
 		}
 
-		const wchar_t* postfixDDS = L".dds";
-		const wchar_t* postfixDDS_Capital = L".DDS";
-		const wchar_t* postfixTGA = L".tga";
-		const wchar_t* postfixTGA_Capital = L".TGA";
-		bool ddsLoader = (path.substr(path.length() - extensionSymbolCount) == std::wstring(postfixDDS)) || (path.substr(path.length() - extensionSymbolCount) == std::wstring(postfixDDS_Capital));
-		bool tgaLoader = (path.substr(path.length() - extensionSymbolCount) == std::wstring(postfixTGA)) || (path.substr(path.length() - extensionSymbolCount) == std::wstring(postfixTGA_Capital));
-		std::string errorMessage = mModel->GetFileName() + " of mesh index: " + std::to_string(meshIndex);
+		// prefer the cooked version (full mip chain, maybe block compressed) from the offline cooking step (see ER_TextureCooker)
+		const std::wstring cookedPath = ER_TextureCooker::GetCookedPath(sourcePath);
+		const bool isCooked = ER_TextureCooker::IsCookedUpToDate(sourcePath, cookedPath);
+		if (isCooked)
+			sourcePath = cookedPath;
+
+		const bool isStreamed = !isPlaceholder && textureStreamer && textureStreamer->IsStreamable(sourcePath);
+		UINT maxSize = 0;
+		if (textureStreamer && !isPlaceholder)
+			maxSize = isStreamed ? textureStreamer->GetMinResidentSize() : textureStreamer->GetMaxTextureSize();
 
 		{
+			// the result of the load goes to loadStat: failed textures are not cached (only loaded ones are), the object gets the fallback texture instead
 			bool didExist = false;
-			//we start traversing through different texture quality levels unless we hit the first one
-			for (int i = static_cast<int>(mCurrentTextureQuality); i >= 0; i--)
+			*loadStat = false;
+			*aTexture = mCore->AddOrGetGPUTextureFromCache(sourcePath, &didExist, false, true, loadStat, false, maxSize);
+			if (didExist)
+				*loadStat = true;
+			if (!*loadStat)
 			{
-				*aTexture = mCore->AddOrGetGPUTextureFromCache(possiblePaths[i], &didExist, false, true, loadStat, true);
-				if (didExist)
-					break;
-
-				if (loadStat && !didExist)
-				{
-					if (*loadStat && *aTexture) // success
-						break;
-
-					if (!*loadStat && i <= 0) // after we traversed all possible levels, lets load the original path (maybe the texture does not have postfix)
-						*aTexture = mCore->AddOrGetGPUTextureFromCache(path, &didExist);
-				}
-
+				*aTexture = mCore->AddOrGetGPUTextureFromCache(ER_Utility::GetFilePath(L"content\\textures\\uvChecker.jpg"));
+				assert(*aTexture);
+				return;
 			}
 			assert(*aTexture);
 
-			if (!isPlaceholder/* && !didExist*/)
+			if (isStreamed)
+				textureStreamer->RegisterTexture(*aTexture, sourcePath, this);
+			else if (!isPlaceholder && !isCooked && !mIsStreamed && *aTexture && (*aTexture)->GetMips() <= 1)
 			{
-				rhi->GenerateMipsWithTextureReplacement(aTexture,
-					[this, aTexture](ER_RHI_GPUTexture** aNewTextureWithMips)
-					{
-						assert(*aNewTextureWithMips);
-						assert(!(*aNewTextureWithMips)->debugName.empty());
-
-						if (!mCore->IsGPUTextureInCache((*aNewTextureWithMips)->debugName))
-							mCore->AddGPUTextureToCache((*aNewTextureWithMips)->debugName, *aNewTextureWithMips);
-
-						*aTexture = mCore->AddOrGetGPUTextureFromCache((*aNewTextureWithMips)->debugName);
-					}
-				);
+				// fallback for the content that has not been cooked yet: runtime mip generation (allocates a second texture and runs a compute pass)
+				// not for streamed objects: it records GPU commands and the replacement only happens at level load (streamed content has to be cooked)
+				// (recorded on the main thread after the loading jobs)
+				rhi->EnqueueLoadingCommand([this, rhi, aTexture]()
+				{
+					rhi->GenerateMipsWithTextureReplacement(aTexture,
+						[this, aTexture](ER_RHI_GPUTexture** aNewTextureWithMips)
+						{
+							assert(*aNewTextureWithMips);
+							assert(!(*aNewTextureWithMips)->debugName.empty());
+
+							if (!mCore->IsGPUTextureInCache((*aNewTextureWithMips)->debugName))
+								mCore->AddGPUTextureToCache((*aNewTextureWithMips)->debugName, *aNewTextureWithMips);
+
+							*aTexture = mCore->AddOrGetGPUTextureFromCache((*aNewTextureWithMips)->debugName);
+						}
+					);
+				});
 			}
 		};
 	}
@@ -399,33 +414,39 @@ namespace EveryRay_Core
 		mMeshRenderBuffers.push_back({});
 		assert(mMeshRenderBuffers.size() - 1 == lod);
 
-		if (!mIndirectArgsBuffer && mIsIndirectlyRendered)
-		{
-			const int numArgs = 5; // number of args for DrawIndexedInstanced
-			int size = numArgs * MAX_MESH_COUNT * MAX_LOD; // we always assume that all lods have same mesh count...
-			mIndirectArgsBuffer = rhi->CreateGPUBuffer("ER_RHI_GPUBuffer: ER_RenderingObject - Indirect Args Buffer : " + mName);
-			mIndirectArgsBuffer->CreateGPUBufferResource(rhi, nullptr, size, sizeof(UINT), false,
-				ER_BIND_UNORDERED_ACCESS | ER_BIND_SHADER_RESOURCE, 0, ER_RESOURCE_MISC_DRAWINDIRECT_ARGS, ER_RHI_FORMAT::ER_FORMAT_R32_UINT);
-		}
-
 		auto createIndexBuffer = [this, rhi](const ER_Mesh& aMesh, int meshIndex, int lod) {
 			mMeshRenderBuffers[lod][meshIndex]->IndexBuffer = rhi->CreateGPUBuffer("ER_RHI_GPUBuffer: ER_RenderingObject - Index Buffer: " + mName + ", lod: " + std::to_string(lod) + ", mesh: " + std::to_string(meshIndex));
 			aMesh.CreateIndexBuffer(mMeshRenderBuffers[lod][meshIndex]->IndexBuffer);
 			mMeshRenderBuffers[lod][meshIndex]->IndicesCount = static_cast<UINT>(aMesh.Indices().size());
 		};
 
+		// position-only stream is only needed if some material (i.e., depth-only shadow map material) reads it
+		bool needsPositionStream = false;
+		for (auto& material : mMaterials)
+		{
+			if (material.second && material.second->IsPositionOnly())
+			{
+				needsPositionStream = true;
+				break;
+			}
+		}
+
 		{
 			for (int i = 0; i < mMeshesCount[lod]; i++)
 			{
+				const ER_Mesh& mesh = (lod == 0) ? mModel->GetMesh(i) : mModelLODs[lod - 1]->GetMesh(i);
+
 				mMeshRenderBuffers[lod].push_back(new RenderBufferData());
 				mMeshRenderBuffers[lod][i]->VertexBuffer = rhi->CreateGPUBuffer("ER_RHI_GPUBuffer: ER_RenderingObject - Vertex Buffer: " + mName + ", lod: " + std::to_string(lod) + ", mesh: " + std::to_string(i));
-				
-				if (lod == 0)
-					mModel->GetMesh(i).CreateVertexBuffer_PositionUvNormalTangent(mMeshRenderBuffers[lod][i]->VertexBuffer);
-				else
-					mModelLODs[lod - 1]->GetMesh(i).CreateVertexBuffer_PositionUvNormalTangent(mMeshRenderBuffers[lod][i]->VertexBuffer);
+				mesh.CreateVertexBuffer_PositionUvNormalTangent(mMeshRenderBuffers[lod][i]->VertexBuffer);
 
-				createIndexBuffer((lod == 0) ? mModel->GetMesh(i) : mModelLODs[lod - 1]->GetMesh(i), i, lod);
+				if (needsPositionStream)
+				{
+					mMeshRenderBuffers[lod][i]->PositionVertexBuffer = rhi->CreateGPUBuffer("ER_RHI_GPUBuffer: ER_RenderingObject - Position Vertex Buffer: " + mName + ", lod: " + std::to_string(lod) + ", mesh: " + std::to_string(i));
+					mesh.CreateVertexBuffer_Position(mMeshRenderBuffers[lod][i]->PositionVertexBuffer);
+				}
+
+				createIndexBuffer(mesh, i, lod);
 
 				mMeshRenderBuffers[lod][i]->Stride = sizeof(VertexPositionTextureNormalTangent);
 				mMeshRenderBuffers[lod][i]->Offset = 0;
@@ -433,7 +454,18 @@ namespace EveryRay_Core
 		}
 	}
 	
-	void ER_RenderingObject::Draw(const std::string& materialName, bool toDepth, int meshIndex) 
+	const UINT ER_RenderingObject::GetVertexCount(int lod) const
+	{
+		assert(lod < GetLODCount());
+		const ER_Model* model = (lod == 0) ? mModel : mModelLODs[lod - 1];
+		
+		UINT count = 0;
+		for (const ER_Mesh& mesh : model->Meshes())
+			count += static_cast<UINT>(mesh.Vertices().size());
+		return count;
+	}
+
+	void ER_RenderingObject::Draw(ER_MaterialID materialID, bool toDepth, int meshIndex, bool isShadowPass)
 	{
 		if (!mIsLoaded)
 			return;
@@ -442,13 +474,13 @@ namespace EveryRay_Core
 		if (mIsInstanced)
 		{
 			for (int lod = 0; lod < GetLODCount(); lod++)
-				DrawLOD(materialName, toDepth, meshIndex, lod);
+				DrawLOD(materialID, toDepth, meshIndex, lod, false, isShadowPass);
 		}
 		else
-			DrawLOD(materialName, toDepth, meshIndex, mCurrentLODIndex);
+			DrawLOD(materialID, toDepth, meshIndex, mCurrentLODIndex, false, isShadowPass);
 	}
 
-	void ER_RenderingObject::DrawLOD(const std::string& materialName, bool toDepth, int meshIndex, int lod, bool skipCulling)
+	void ER_RenderingObject::DrawLOD(ER_MaterialID materialID, bool toDepth, int meshIndex, int lod, bool skipCulling, bool isShadowPass)
 	{
 		if (!mIsLoaded)
 			return;
@@ -456,59 +488,61 @@ namespace EveryRay_Core
 		if (ER_Utility::StopDrawingRenderingObjects)
 			return;
 
-		bool isForwardPass = materialName == ER_MaterialHelper::forwardLightingNonMaterialName && mIsForwardShading;
+		bool isForwardPass = materialID == ER_MaterialHelper::forwardLightingNonMaterialID && mIsForwardShading;
 
 		ER_RHI* rhi = mCore->GetRHI();
 
-		if (mMaterials.find(materialName) == mMaterials.end() && !isForwardPass)
+		ER_Material* material = GetMaterial(materialID);
+		if (!material && !isForwardPass)
 			return;
 		
-		if (mIsRendered && (skipCulling || !mIsCulled) && mCurrentLODIndex != -1)
+		// occluded objects are not visible for the camera but still cast shadows
+		if (mIsRendered && (skipCulling || (!mIsCulled && (isShadowPass || !mIsOccluded))) && mCurrentLODIndex != -1)
 		{
 			if (!isForwardPass && (!mMaterials.size() || mMeshRenderBuffers[lod].size() == 0))
 				return;
+
+			// GPU culled instances of the shadow passes are in their own "LOD slots" (args and instances, see ER_GPUCuller)
+			const int indirectLOD = (mIsIndirectlyRendered && isShadowPass) ? lod + INDIRECT_SHADOW_LOD_OFFSET : lod;
 			
-			{
-				mObjectConstantBuffer.Data.World = XMMatrixTranspose(mTransformationMatrix);
-				mObjectConstantBuffer.Data.IndexOfRefraction = mIOR;
-				mObjectConstantBuffer.Data.CustomRoughness = mCustomRoughness;
-				mObjectConstantBuffer.Data.CustomMetalness = mCustomMetalness;
-				mObjectConstantBuffer.Data.CustomAlphaDiscard = mCustomAlphaDiscard;
-				mObjectConstantBuffer.Data.OriginalInstanceCount = mInstanceCount;
-				mObjectConstantBuffer.Data.RenderingObjectFlags = mObjectShaderBitmaskFlags;
-				mObjectConstantBuffer.ApplyChanges(rhi);
-
-				mObjectFakeRootConstantBuffer.Data.CurrentLOD = lod;
-				mObjectFakeRootConstantBuffer.ApplyChanges(rhi);
-			}
+			UpdateObjectConstantBuffers(indirectLOD);
 
 			if (isForwardPass && mCore->GetLevel()->mIllumination)
 				mCore->GetLevel()->mIllumination->PreparePipelineForForwardLighting(this);
 
+			const bool isPositionOnly = toDepth && !isForwardPass && material->IsPositionOnly();
+
+			// prepare callback for standard materials (specials, i.e., shadow mapping, are processed in their own systems), resolved once for all meshes
+			const Delegate_MeshMaterialVariablesUpdate* prepareMaterialBeforeRendering = nullptr;
+			if (!isForwardPass && material->IsStandard())
+				prepareMaterialBeforeRendering = MeshMaterialVariablesUpdateEvent->FindListener(mMaterialsListenerHandles[materialID]);
+
 			bool isSpecificMesh = (meshIndex != -1);
 			for (int meshI = (isSpecificMesh) ? meshIndex : 0; meshI < ((isSpecificMesh) ? meshIndex + 1 : mMeshesCount[lod]); meshI++)
 			{
+				ER_RHI_GPUBuffer* vertexBuffer = isPositionOnly ? mMeshRenderBuffers[lod][meshI]->PositionVertexBuffer : mMeshRenderBuffers[lod][meshI]->VertexBuffer;
+				assert(vertexBuffer);
+
 				if (mIsInstanced)
 				{
 					if (mIsIndirectlyRendered)
 					{
 						//instead of instance buffer, we set a read-only structured buffer with instance data in the system (i.e. GBuffer)
 						//WARNING: Make sure the system actually sets that buffer!
-						rhi->SetVertexBuffers({ mMeshRenderBuffers[lod][meshI]->VertexBuffer });
+						rhi->SetVertexBuffers({ vertexBuffer });
 					}
 					else
-						rhi->SetVertexBuffers({ mMeshRenderBuffers[lod][meshI]->VertexBuffer, mMeshesInstanceBuffers[lod][meshI]->InstanceBuffer });
+						rhi->SetVertexBuffers({ vertexBuffer, mScene->GetInstanceBufferPool()->GetBuffer() });
 				}
 				else
-					rhi->SetVertexBuffers({ mMeshRenderBuffers[lod][meshI]->VertexBuffer });
+					rhi->SetVertexBuffers({ vertexBuffer });
 				rhi->SetIndexBuffer(mMeshRenderBuffers[lod][meshI]->IndexBuffer);
 
-				// run prepare callbacks for standard materials (specials, i.e., shadow mapping, are processed in their own systems)
-				if (!isForwardPass && mMaterials[materialName]->IsStandard())
+				// run prepare callbacks for standard materials
+				if (prepareMaterialBeforeRendering)
 				{
-					auto prepareMaterialBeforeRendering = MeshMaterialVariablesUpdateEvent->GetListener(materialName);
-					if (prepareMaterialBeforeRendering)
-						prepareMaterialBeforeRendering(meshI, lod);
+					if (*prepareMaterialBeforeRendering)
+						(*prepareMaterialBeforeRendering)(meshI, lod);
 				}
 				else if (isForwardPass && mCore->GetLevel()->mIllumination)
 					mCore->GetLevel()->mIllumination->PrepareResourcesForForwardLighting(this, meshI, lod);
@@ -518,15 +552,17 @@ namespace EveryRay_Core
 					if (mIsIndirectlyRendered && mIndirectArgsBuffer)
 					{
 						if (!isForwardPass)
-							mMaterials[materialName]->SetRootConstantForMaterial(static_cast<UINT>(lod));
+							material->SetRootConstantForMaterial(static_cast<UINT>(indirectLOD));
 
-						const int offset = (MAX_MESH_COUNT * lod + meshI) * 5 * sizeof(UINT); //5 is args count of DrawIndexedInstanced()
+						const int offset = (mIndirectArgsOffset + (MAX_MESH_COUNT * indirectLOD + meshI) * INDIRECT_DRAW_ARGS_COUNT) * sizeof(UINT);
 						rhi->DrawIndexedInstancedIndirect(mIndirectArgsBuffer, offset);
 					}
 					else
 					{
-						if (mInstanceCountToRender[lod] > 0)
-							rhi->DrawIndexedInstanced(mMeshRenderBuffers[lod][meshI]->IndicesCount, mInstanceCountToRender[lod], 0, 0, 0);
+						// occluded instances are stored after the visible ones in the range of the lod
+						const UINT instanceCount = isShadowPass ? mInstanceCountToRenderInShadows[lod] : mInstanceCountToRender[lod];
+						if (instanceCount > 0)
+							rhi->DrawIndexedInstanced(mMeshRenderBuffers[lod][meshI]->IndicesCount, instanceCount, 0, 0, mInstanceBufferRanges[lod].Offset);
 						else
 							continue;
 					}
@@ -537,6 +573,67 @@ namespace EveryRay_Core
 		}
 	}
 
+	void ER_RenderingObject::DrawLODWithInstances(ER_MaterialID materialID, int meshIndex, int lod, ER_RHI_GPUBuffer* instanceBuffer, UINT instancesCount, UINT startInstance)
+	{
+		if (!mIsLoaded || !mIsRendered)
+			return;
+
+		if (ER_Utility::StopDrawingRenderingObjects)
+			return;
+
+		ER_Material* material = GetMaterial(materialID);
+		if (!material || lod >= static_cast<int>(mMeshRenderBuffers.size()) || meshIndex >= static_cast<int>(mMeshRenderBuffers[lod].size()))
+			return;
+
+		if (mIsInstanced && (!instanceBuffer || instancesCount == 0))
+			return;
+
+		ER_RHI* rhi = mCore->GetRHI();
+
+		UpdateObjectConstantBuffers(lod);
+
+		ER_RHI_GPUBuffer* vertexBuffer = material->IsPositionOnly() ? mMeshRenderBuffers[lod][meshIndex]->PositionVertexBuffer : mMeshRenderBuffers[lod][meshIndex]->VertexBuffer;
+		assert(vertexBuffer);
+
+		if (mIsInstanced)
+			rhi->SetVertexBuffers({ vertexBuffer, instanceBuffer });
+		else
+			rhi->SetVertexBuffers({ vertexBuffer });
+		rhi->SetIndexBuffer(mMeshRenderBuffers[lod][meshIndex]->IndexBuffer);
+
+		// run prepare callbacks for standard materials (specials are processed in their own systems)
+		if (material->IsStandard())
+		{
+			const Delegate_MeshMaterialVariablesUpdate* prepareMaterialBeforeRendering =
+				MeshMaterialVariablesUpdateEvent->FindListener(mMaterialsListenerHandles[materialID]);
+			if (prepareMaterialBeforeRendering && *prepareMaterialBeforeRendering)
+				(*prepareMaterialBeforeRendering)(meshIndex, lod);
+		}
+
+		if (mIsInstanced)
+			rhi->DrawIndexedInstanced(mMeshRenderBuffers[lod][meshIndex]->IndicesCount, instancesCount, 0, 0, startInstance);
+		else
+			rhi->DrawIndexed(mMeshRenderBuffers[lod][meshIndex]->IndicesCount);
+	}
+
+	void ER_RenderingObject::UpdateObjectConstantBuffers(int lod)
+	{
+		ER_RHI* rhi = mCore->GetRHI();
+
+		mObjectConstantBuffer.Data.World = XMMatrixTranspose(mTransformationMatrix);
+		mObjectConstantBuffer.Data.IndexOfRefraction = mIOR;
+		mObjectConstantBuffer.Data.CustomRoughness = mCustomRoughness;
+		mObjectConstantBuffer.Data.CustomMetalness = mCustomMetalness;
+		mObjectConstantBuffer.Data.CustomAlphaDiscard = mCustomAlphaDiscard;
+		mObjectConstantBuffer.Data.OriginalInstanceCount = mInstanceCount;
+		mObjectConstantBuffer.Data.RenderingObjectFlags = mObjectShaderBitmaskFlags;
+		mObjectConstantBuffer.Data.IndirectInstanceOffset = mIndirectNewInstancesOffset;
+		mObjectConstantBuffer.ApplyChanges(rhi);
+
+		mObjectFakeRootConstantBuffer.Data.CurrentLOD = lod;
+		mObjectFakeRootConstantBuffer.ApplyChanges(rhi);
+	}
+
 	void ER_RenderingObject::DrawAABB(ER_RHI_GPUTexture* aRenderTarget, ER_RHI_GPUTexture* aDepth, ER_RHI_GPURootSignature* rs)
 	{
 		if (!mIsLoaded)
@@ -576,70 +673,72 @@ namespace EveryRay_Core
 		if (!mIsLoaded)
 			return;
 
-		auto rhi = mCore->GetRHI();
 		assert(mModel != nullptr);
 		assert(mIsInstanced == true);
 
-		mInstanceData.push_back({});
-		assert(lod < mInstanceData.size());
+		mInstancesLODIndices.push_back({});
+		assert(lod == mInstancesLODIndices.size() - 1);
+		mInstancesOccludedLODIndices.push_back({});
 
 		mInstanceCountToRender.push_back(0);
 		assert(lod == mInstanceCountToRender.size() - 1);
+		mInstanceCountToRenderInShadows.push_back(0);
 
-		mMeshesInstanceBuffers.push_back({});
-		assert(lod == mMeshesInstanceBuffers.size() - 1);
+		// the range in the instance buffer pool of the scene is allocated on the first update (when we know the instance count)
+		mInstanceBufferRanges.push_back({});
+		assert(lod == mInstanceBufferRanges.size() - 1);
+	}
 
-		//adding extra instance data until we reach MAX_INSTANCE_COUNT 
-		for (int i = static_cast<int>(mInstanceData[lod].size()); i < MAX_DIRECT_INSTANCE_COUNT; i++)
-			AddInstanceData(XMMatrixIdentity(), lod);
+	// new instancing code
+	void ER_RenderingObject::UpdateInstanceBuffer(const std::vector<InstancedData>& instanceData, int lod, UINT occludedInstanceCount)
+	{
+		if (!mIsLoaded)
+			return;
 
 #if !LOAD_OLD_INSTANCED_DATA_FOR_GPU_INDIRECT_OBJECTS
 		if (mIsIndirectlyRendered)
 			return;
 #endif
 
-		//mMeshesInstanceBuffers.clear();
-		for (size_t i = 0; i < mMeshesCount[lod]; i++)
-		{
-			mMeshesInstanceBuffers[lod].push_back(new InstanceBufferData());
-			mMeshesInstanceBuffers[lod][i]->InstanceBuffer = rhi->CreateGPUBuffer("ER_RHI_GPUBuffer: ER_RenderingObject - Instance Buffer: " + mName + ", lod: " + std::to_string(lod) + ", mesh: " + std::to_string(i));
-			CreateInstanceBuffer(&mInstanceData[lod][0], MAX_DIRECT_INSTANCE_COUNT, mMeshesInstanceBuffers[lod][i]->InstanceBuffer);
-			mMeshesInstanceBuffers[lod][i]->Stride = sizeof(InstancedData);
-		}
-	}
-	// new instancing code
-	void ER_RenderingObject::CreateInstanceBuffer(InstancedData* instanceData, UINT instanceCount, ER_RHI_GPUBuffer* instanceBuffer)
-	{
-		if (!mIsLoaded)
-			return;
+		assert(lod < mInstanceBufferRanges.size());
+		assert(mScene && mScene->GetInstanceBufferPool());
+		ER_InstanceBufferPool* pool = mScene->GetInstanceBufferPool();
 
+		const UINT instanceCount = static_cast<UINT>(instanceData.size());
+		assert(occludedInstanceCount <= instanceCount);
 		if (instanceCount > MAX_DIRECT_INSTANCE_COUNT)
 			throw ER_CoreException("Instances count limit is exceeded!");
 
-		assert(instanceBuffer);
-		instanceBuffer->CreateGPUBufferResource(mCore->GetRHI(), instanceData, MAX_DIRECT_INSTANCE_COUNT, InstanceSize(), true, ER_BIND_VERTEX_BUFFER);
+		// the range fits all instances of the object (so it is not reallocated when instances move between LOD groups)
+		ER_InstanceBufferRange& range = mInstanceBufferRanges[lod];
+		if (range.Count < instanceCount)
+		{
+			pool->Free(range);
+			range = pool->Allocate(std::max(instanceCount, mInstanceCount));
+		}
+
+		// meshes of the lod share the range; uploaded to GPU in ER_InstanceBufferPool::Flush()
+		mInstanceCountToRender[lod] = instanceCount - occludedInstanceCount;
+		mInstanceCountToRenderInShadows[lod] = instanceCount;
+		if (instanceCount > 0)
+			pool->Update(range, &instanceData[0], instanceCount);
 	}
 
-	// new instancing code
-	void ER_RenderingObject::UpdateInstanceBuffer(std::vector<InstancedData>& instanceData, int lod)
+	// gathers the world matrices of the visible instances of every LOD group (by their indices) and uploads them
+	// occluded instances follow the visible ones, so the camera passes and the shadow passes draw the same range with different counts
+	void ER_RenderingObject::UpdateInstanceBuffers()
 	{
 		if (!mIsLoaded)
 			return;
 
-#if !LOAD_OLD_INSTANCED_DATA_FOR_GPU_INDIRECT_OBJECTS
-		if (mIsIndirectlyRendered)
-			return;
-#endif
-
-		assert(lod < mMeshesInstanceBuffers.size());
-
-		for (size_t i = 0; i < mMeshesCount[lod]; i++)
+		for (int lod = 0; lod < static_cast<int>(mInstancesLODIndices.size()); lod++)
 		{
-			//CreateInstanceBuffer(instanceData);
-			mInstanceCountToRender[lod] = static_cast<UINT>(instanceData.size());
-
-			// dynamically update instance buffer
-			mCore->GetRHI()->UpdateBuffer(mMeshesInstanceBuffers[lod][i]->InstanceBuffer, mInstanceCountToRender[lod] == 0 ? nullptr : &instanceData[0], InstanceSize() * mInstanceCountToRender[lod]);
+			mTempInstancesUploadData.clear();
+			for (UINT instanceIndex : mInstancesLODIndices[lod])
+				mTempInstancesUploadData.push_back(mInstancesWorlds[instanceIndex]);
+			for (UINT instanceIndex : mInstancesOccludedLODIndices[lod])
+				mTempInstancesUploadData.push_back(mInstancesWorlds[instanceIndex]);
+			UpdateInstanceBuffer(mTempInstancesUploadData, lod, static_cast<UINT>(mInstancesOccludedLODIndices[lod].size()));
 		}
 	}
 
@@ -648,9 +747,32 @@ namespace EveryRay_Core
 		return sizeof(InstancedData);
 	}
 
+	// Adds the triangles of the object (or of all its instances) to the occlusion buffer (between its BeginFrame() and Rasterize())
+	void ER_RenderingObject::AddToOcclusionCuller(ER_SoftwareOcclusionCuller* occlusionCuller)
+	{
+		assert(occlusionCuller);
+
+		// alpha tested geometry does not fully cover its triangles
+		if (!mIsOccluder || !mIsLoaded || IsAlphaTestedInDepth() || !mModel)
+			return;
+
+		for (const ER_Mesh& mesh : mModel->Meshes())
+		{
+			if (mIsInstanced)
+			{
+				for (const InstancedData& instance : mInstancesWorlds)
+					occlusionCuller->AddOccluder(mesh.Vertices(), mesh.Indices(), XMLoadFloat4x4(&instance.World));
+			}
+			else
+				occlusionCuller->AddOccluder(mesh.Vertices(), mesh.Indices(), mTransformationMatrix);
+		}
+	}
+
 	// This method culls the object (or its instances) on CPU 
 	// Note: for instanced objects consider using indirect rendering instead (culling will happen on GPU and not in this method)
-	void ER_RenderingObject::PerformCPUFrustumCull(ER_Camera* camera)
+	// Objects that pass the frustum test are also tested against the software occlusion buffer (if it is provided):
+	// occluded objects are hidden from the camera only, they are still rendered in shadow passes
+	void ER_RenderingObject::PerformCPUFrustumCull(ER_Camera* camera, const ER_SoftwareOcclusionCuller* occlusionCuller)
 	{
 		if (!mIsLoaded)
 			return;
@@ -694,35 +816,32 @@ namespace EveryRay_Core
 					break;
 				}
 			}
+
 			return culled;
 		};
 
-		assert(mInstanceCullingFlags.size() == mInstanceCount);
-
 		if (mIsInstanced)
 		{
-			XMMATRIX instanceWorldMatrix = XMMatrixIdentity();
-			const int currentLOD = 0; // no need to iterate through LODs (AABBs are shared between LODs, so culling results will be identical)
-
-			mTempPostCullingInstanceData.clear();
+			// AABBs are shared between LODs, so we only cull once (instances are distributed between LOD groups later in UpdateInstancesLODGroups())
+			assert(mInstancesVisibilityBits.size() == (mInstanceCount + 63) / 64);
+			std::fill(mInstancesVisibilityBits.begin(), mInstancesVisibilityBits.end(), 0);
+			std::fill(mInstancesOcclusionBits.begin(), mInstancesOcclusionBits.end(), 0);
+			for (UINT instanceIndex = 0; instanceIndex < mInstanceCount; instanceIndex++)
 			{
-				std::vector<InstancedData> newInstanceData;
-				for (int instanceIndex = 0; instanceIndex < static_cast<int>(mInstanceCount); instanceIndex++)
-				{
-					instanceWorldMatrix = XMLoadFloat4x4(&(mInstanceData[currentLOD][instanceIndex].World));
-					mInstanceCullingFlags[instanceIndex] = cullFunction(mInstanceAABBs[instanceIndex]);
-					if (!mInstanceCullingFlags[instanceIndex])
-						newInstanceData.push_back(instanceWorldMatrix);
-				}
-				mTempPostCullingInstanceData = newInstanceData; //we store a copy for future usages
+				if (cullFunction(mInstanceAABBs[instanceIndex]))
+					continue;
 
-				// if we have lods, we will update instance buffers later in UpdateLODs()
-				if (GetLODCount() <= 1)
-					UpdateInstanceBuffer(mTempPostCullingInstanceData, 0);
+				if (occlusionCuller && occlusionCuller->IsOccluded(mInstanceAABBs[instanceIndex]))
+					mInstancesOcclusionBits[instanceIndex >> 6] |= (1ull << (instanceIndex & 63));
+				else
+					mInstancesVisibilityBits[instanceIndex >> 6] |= (1ull << (instanceIndex & 63));
 			}
 		}
 		else
+		{
 			mIsCulled = cullFunction(mGlobalAABB);
+			mIsOccluded = !mIsCulled && occlusionCuller && occlusionCuller->IsOccluded(mGlobalAABB);
+		}
 	}
 
 	void ER_RenderingObject::StoreInstanceDataAfterTerrainPlacement()
@@ -731,23 +850,21 @@ namespace EveryRay_Core
 			return;
 
 		assert(mTempInstancesPositions);
-		XMMATRIX worldMatrix = XMMatrixIdentity();
-		for (int lod = 0; lod < GetLODCount(); lod++)
+		for (int instanceI = 0; instanceI < static_cast<int>(mInstanceCount); instanceI++)
 		{
-			for (int instanceI = 0; instanceI < static_cast<int>(mInstanceCount); instanceI++)
-			{
-				float scale = ER_Utility::RandomFloat(mTerrainProceduralObjectMinScale, mTerrainProceduralObjectMaxScale);
-				float roll = ER_Utility::RandomFloat(mTerrainProceduralObjectMinRoll, mTerrainProceduralObjectMaxRoll);
-				float pitch = ER_Utility::RandomFloat(mTerrainProceduralObjectMinPitch, mTerrainProceduralObjectMaxPitch);
-				float yaw = ER_Utility::RandomFloat(mTerrainProceduralObjectMinYaw, mTerrainProceduralObjectMaxYaw);
-
-				worldMatrix = XMMatrixScaling(scale, scale, scale) * XMMatrixRotationRollPitchYaw(pitch, yaw, roll);
-				ER_MatrixHelper::SetTranslation(worldMatrix, XMFLOAT3(mTempInstancesPositions[instanceI].x, mTempInstancesPositions[instanceI].y, mTempInstancesPositions[instanceI].z));
-				XMStoreFloat4x4(&(mInstanceData[lod][instanceI].World), worldMatrix);
-				worldMatrix = XMMatrixIdentity();
-			}
-			UpdateInstanceBuffer(mInstanceData[lod], lod);
+			float scale = ER_Utility::RandomFloat(mTerrainProceduralObjectMinScale, mTerrainProceduralObjectMaxScale);
+			float roll = ER_Utility::RandomFloat(mTerrainProceduralObjectMinRoll, mTerrainProceduralObjectMaxRoll);
+			float pitch = ER_Utility::RandomFloat(mTerrainProceduralObjectMinPitch, mTerrainProceduralObjectMaxPitch);
+			float yaw = ER_Utility::RandomFloat(mTerrainProceduralObjectMinYaw, mTerrainProceduralObjectMaxYaw);
+
+			XMFLOAT4 rotation;
+			XMStoreFloat4(&rotation, XMQuaternionRotationRollPitchYaw(pitch, yaw, roll));
+			SetInstanceTransform(instanceI, XMFLOAT3(mTempInstancesPositions[instanceI].x, mTempInstancesPositions[instanceI].y, mTempInstancesPositions[instanceI].z),
+				rotation, XMFLOAT3(scale, scale, scale));
 		}
+
+		for (int lod = 0; lod < GetLODCount(); lod++)
+			UpdateInstanceBuffer(mInstancesWorlds, lod);
 	}
 
 	XMFLOAT4 ER_RenderingObject::GetFurGravityStrength()
@@ -860,7 +977,7 @@ namespace EveryRay_Core
 
 		UpdateBitmaskFlags();
 
-		ER_Camera* camera = (ER_Camera*)(mCore->GetServices().FindService(ER_Camera::TypeIdClass()));
+		ER_Camera* camera = mCore->GetServices().FindService<ER_Camera>();
 		assert(camera);
 
 		bool isCurrentlyEditable = ER_Utility::IsEditorMode && mIsAvailableInEditorMode && mIsSelected;
@@ -869,7 +986,7 @@ namespace EveryRay_Core
 		{
 			mEditorSelectedInstancedObjectIndex = mEditorSelectedInstancedObjectIndexNextFrame;
 			// load current selected instance's transform to temp transform (for UI)
-			ER_MatrixHelper::SetFloatArray(mInstanceData[0][mEditorSelectedInstancedObjectIndex].World, mEditorCurrentObjectTransformMatrix);
+			ER_MatrixHelper::SetFloatArray(mInstancesWorlds[mEditorSelectedInstancedObjectIndex].World, mEditorCurrentObjectTransformMatrix);
 		}
 
 		// place procedurally on terrain (only executed once, on load)
@@ -881,38 +998,36 @@ namespace EveryRay_Core
 			mGlobalAABB = mLocalAABB;
 			UpdateAABB(mGlobalAABB, mTransformationMatrix);
 
-			if (mIsInstanced && (!mIsIndirectlyRendered || (mIsIndirectlyRendered && !mIndirectOriginalInstanceDataBuffer)))
+			if (mIsInstanced && (!mIsIndirectlyRendered || (mIsIndirectlyRendered && !IsIndirectInstanceDataReady())))
 			{
-				XMMATRIX instanceWorldMatrix = XMMatrixIdentity();
 				for (int instanceIndex = 0; instanceIndex < static_cast<int>(mInstanceCount); instanceIndex++)
 				{
-					instanceWorldMatrix = XMLoadFloat4x4(&(mInstanceData[0][instanceIndex].World));
 					mInstanceAABBs[instanceIndex] = mLocalAABB;
-					UpdateAABB(mInstanceAABBs[instanceIndex], instanceWorldMatrix);
+					UpdateAABB(mInstanceAABBs[instanceIndex], XMLoadFloat4x4(&(mInstancesWorlds[instanceIndex].World)));
 				}
 			}
 		}
 
 		if (mIsIndirectlyRendered)
-			CreateIndirectInstanceData(); // only happens once but we need to do it after the first update (i.e. after we placed the instances and calculated their AABBs)
+			CreateIndirectInstanceData(); // only happens once but we need to do it after the first update (i.e. after we placed the instances and calculated their AABBs), uploaded in ER_GPUCuller
 		else // fallback for old CPU frustum culling (i.e., makes sense for non-instanced objects)
 		{
 			if (ER_Utility::IsMainCameraCPUCulling && camera)
-				PerformCPUFrustumCull(camera);
-			else
 			{
-				// you can still use CPU culling of instances with buffer updates (for objects which do not use indirect rendering)
-				// however, this is left here mainly for legacy reason and potential debugging of indirect culling/rendering bugs
-				if (mIsInstanced)
-				{
-					//just updating transforms (that could be changed in a previous frame); this is not optimal (GPU buffer map() every frame...)
-					for (int lod = 0; lod < GetLODCount(); lod++)
-						UpdateInstanceBuffer(mInstanceData[lod], lod);
-				}
+				ER_SoftwareOcclusionCuller* occlusionCuller = mCore->GetLevel()->mSoftwareOcclusionCuller;
+				PerformCPUFrustumCull(camera, (occlusionCuller && occlusionCuller->IsReady()) ? occlusionCuller : nullptr);
 			}
+			else if (mIsInstanced)
+				SetAllInstancesVisible();
+
+			// you can still use CPU culling of instances with buffer updates (for objects which do not use indirect rendering)
+			// however, this is left here mainly for legacy reason and potential debugging of indirect culling/rendering bugs
+			// (transforms could be changed in a previous frame, so we upload every frame; this is not optimal (GPU buffer map() every frame...))
+			if (mIsInstanced)
+				UpdateInstancesLODGroups();
 		}
 
-		if (GetLODCount() > 1)
+		if (GetLODCount() > 1 && !mIsInstanced)
 			UpdateLODs();
 
 		if (isCurrentlyEditable)
@@ -977,8 +1092,7 @@ namespace EveryRay_Core
 		//update instance world transform (from editor's gizmo/UI)
 		if (mIsInstanced && ER_Utility::IsEditorMode)
 		{
-			for (int lod = 0; lod < GetLODCount(); lod++)
-				mInstanceData[lod][mEditorSelectedInstancedObjectIndex].World = XMFLOAT4X4(mEditorCurrentObjectTransformMatrix);
+			SetInstanceTransform(mEditorSelectedInstancedObjectIndex, mTransformationMatrix);
 		}
 	}
 	
@@ -1089,7 +1203,9 @@ namespace EveryRay_Core
 				if (mIsInstanced)
 				{
 					name = mEditorInstancedNamesUI[mEditorSelectedInstancedObjectIndex] ? mEditorInstancedNamesUI[mEditorSelectedInstancedObjectIndex] : "Unknown Name";
-					if (mInstanceCullingFlags[mEditorSelectedInstancedObjectIndex]) //showing info for main LOD only in editor
+					if (IsInstanceOccluded(mEditorSelectedInstancedObjectIndex))
+						name += " (Occluded)";
+					else if (!IsInstanceVisible(mEditorSelectedInstancedObjectIndex)) //showing info for main LOD only in editor
 						name += " (Culled)";
 				}
 				else
@@ -1097,6 +1213,8 @@ namespace EveryRay_Core
 					name += " LOD #" + std::to_string(mCurrentLODIndex);
 					if (mIsCulled)
 						name += " (Culled)";
+					else if (mIsOccluded)
+						name += " (Occluded)";
 				}
 			}
 
@@ -1107,7 +1225,7 @@ namespace EveryRay_Core
 			ImGui::Text(lodCountText.c_str());
 			for (int lodI = 0; lodI < GetLODCount(); lodI++)
 			{
-				std::string vertexCountText = "--> Vertex count LOD#" + std::to_string(lodI) + ": " + std::to_string(GetVertices(lodI).size());
+				std::string vertexCountText = "--> Vertex count LOD#" + std::to_string(lodI) + ": " + std::to_string(GetVertexCount(lodI));
 				ImGui::Text(vertexCountText.c_str());
 			}
 
@@ -1141,7 +1259,7 @@ namespace EveryRay_Core
 				XMFLOAT3 newCameraPos;
 				ER_MatrixHelper::GetTranslation(XMLoadFloat4x4(&(XMFLOAT4X4(mEditorCurrentObjectTransformMatrix))), newCameraPos);
 
-				ER_Camera* camera = (ER_Camera*)(mCore->GetServices().FindService(ER_Camera::TypeIdClass()));
+				ER_Camera* camera = mCore->GetServices().FindService<ER_Camera>();
 				if (camera)
 					camera->SetPosition(newCameraPos);
 			}
@@ -1155,7 +1273,7 @@ namespace EveryRay_Core
 
 				ImGui::Text("Instances (dynamic):");
 				ImGui::PushItemWidth(-1);
-				ImGui::ListBox("##empty", &mEditorSelectedInstancedObjectIndexNextFrame, mEditorInstancedNamesUI, static_cast<int>(mInstanceData[0].size()), maxInstancesHeightUI);
+				ImGui::ListBox("##empty", &mEditorSelectedInstancedObjectIndexNextFrame, mEditorInstancedNamesUI, static_cast<int>(mInstanceCount), maxInstancesHeightUI);
 			}
 
 			//terrain
@@ -1238,24 +1356,6 @@ namespace EveryRay_Core
 		}
 	}
 		
-	ER_RHI_GPUBuffer* ER_RenderingObject::GetIndirectMeshConstantBuffer()
-	{
-		if (!mIsIndirectlyRendered || !mIsLoaded)
-			return nullptr;
-
-		ER_RHI* rhi = mCore->GetRHI();
-
-		if (!mIndirectMeshConstants.IsInitialized() && mIsIndirectlyRendered)
-			mIndirectMeshConstants.Initialize(rhi, "ER_RHI_GPUBuffer: GPU Indirect Mesh CB: " + mName);
-
-		memcpy(mIndirectMeshConstants.Data.IndexCount_StartIndexLoc_BaseVtxLoc_StartInstLoc, mIndirectDrawArgsArray, sizeof(XMINT4) * MAX_LOD * MAX_MESH_COUNT);
-		mIndirectMeshConstants.Data.OriginalInstancesCount = GetInstanceCount();
-		mIndirectMeshConstants.Data.pad = XMINT3(0, 0, 0);
-		mIndirectMeshConstants.ApplyChanges(rhi);
-
-		return mIndirectMeshConstants.Buffer();
-	}
-
 	void ER_RenderingObject::UpdateLODs()
 	{
 		if (!mIsLoaded)
@@ -1268,42 +1368,7 @@ namespace EveryRay_Core
 		if (mIsInstanced) {
 			if (mIsIndirectlyRendered) // LODs are also updated in ER_GPUCuller, so no need to do that here
 				return;
-			if (!ER_Utility::IsMainCameraCPUCulling && mInstanceData.size() == 0)
-				return;
-			if (ER_Utility::IsMainCameraCPUCulling && mTempPostCullingInstanceData.size() == 0)
-				return;
-
-			mTempPostLoddingInstanceData.clear();
-			for (int lod = 0; lod < GetLODCount(); lod++)
-				mTempPostLoddingInstanceData.push_back({});
-
-			//traverse through original or culled instance data (sort of "read-only") to rebalance LOD's instance buffers
-			int length = (ER_Utility::IsMainCameraCPUCulling) ? static_cast<int>(mTempPostCullingInstanceData.size()) : static_cast<int>(mInstanceData[0].size());
-			for (int i = 0; i < length; i++)
-			{
-				XMFLOAT3 pos;
-				XMMATRIX mat = (ER_Utility::IsMainCameraCPUCulling) ? XMLoadFloat4x4(&mTempPostCullingInstanceData[i].World) : XMLoadFloat4x4(&mInstanceData[0][i].World);
-				ER_MatrixHelper::GetTranslation(mat, pos);
-
-				float distanceToCameraSqr =
-					(mCamera.Position().x - pos.x) * (mCamera.Position().x - pos.x) +
-					(mCamera.Position().y - pos.y) * (mCamera.Position().y - pos.y) +
-					(mCamera.Position().z - pos.z) * (mCamera.Position().z - pos.z);
-
-				//XMMATRIX newMat;
-				if (distanceToCameraSqr <= sqrDistLod0) {
-					mTempPostLoddingInstanceData[0].push_back((ER_Utility::IsMainCameraCPUCulling) ? mTempPostCullingInstanceData[i].World : mInstanceData[0][i].World);
-				}
-				else if (sqrDistLod0 < distanceToCameraSqr && distanceToCameraSqr <= sqrDistLod1) {
-					mTempPostLoddingInstanceData[1].push_back((ER_Utility::IsMainCameraCPUCulling) ? mTempPostCullingInstanceData[i].World : mInstanceData[0][i].World);
-				}
-				else if (sqrDistLod1 < distanceToCameraSqr && distanceToCameraSqr <= sqrDistLod2) {
-					mTempPostLoddingInstanceData[2].push_back((ER_Utility::IsMainCameraCPUCulling) ? mTempPostCullingInstanceData[i].World : mInstanceData[0][i].World);
-				}
-			}
-
-			for (int i = 0; i < GetLODCount(); i++)
-				UpdateInstanceBuffer(mTempPostLoddingInstanceData[i], i);
+			UpdateInstancesLODGroups();
 		}
 		else
 		{
@@ -1341,117 +1406,208 @@ namespace EveryRay_Core
 
 		mMeshesCount.push_back(static_cast<int>(pModel->Meshes().size()));
 		mModelLODs.push_back(pModel);
-		mMeshVertices.push_back({});
-		mMeshAllVertices.push_back({}); 
 
 		int lodIndex = static_cast<int>(mMeshesCount.size()) - 1;
+		LoadRenderBuffers(lodIndex);
+	}
 
-		for (int i = 0; i < mMeshesCount[lodIndex]; i++)
-			mMeshVertices[lodIndex].push_back(mModelLODs[lodIndex - 1]->GetMesh(i).Vertices());
+	// distributes the visible instances between LOD groups (by the distance to the camera) and uploads them to the instance buffers
+	void ER_RenderingObject::UpdateInstancesLODGroups()
+	{
+		assert(mIsInstanced && !mIsIndirectlyRendered);
+
+		const float sqrDistLod0 = ER_Utility::DistancesLOD[0] * ER_Utility::DistancesLOD[0];
+		const float sqrDistLod1 = ER_Utility::DistancesLOD[1] * ER_Utility::DistancesLOD[1];
+		const float sqrDistLod2 = ER_Utility::DistancesLOD[2] * ER_Utility::DistancesLOD[2];
+		const bool hasLODs = GetLODCount() > 1;
+		const XMFLOAT3 cameraPos = mCamera.Position();
+
+		for (auto& lodIndices : mInstancesLODIndices)
+			lodIndices.clear();
+		for (auto& lodIndices : mInstancesOccludedLODIndices)
+			lodIndices.clear();
 
-		for (size_t i = 0; i < mMeshVertices[lodIndex].size(); i++)
+		//traverse through the visible and occluded instances only (whole words of culled instances are skipped)
+		for (UINT wordIndex = 0; wordIndex < static_cast<UINT>(mInstancesVisibilityBits.size()); wordIndex++)
 		{
-			for (size_t j = 0; j < mMeshVertices[lodIndex][i].size(); j++)
+			const UINT64 occlusionBits = mInstancesOcclusionBits[wordIndex];
+			const UINT64 inFrustumBits = mInstancesVisibilityBits[wordIndex] | occlusionBits;
+			if (!inFrustumBits)
+				continue;
+
+			for (UINT bit = 0; bit < 64; bit++)
 			{
-				mMeshAllVertices[lodIndex].push_back(mMeshVertices[lodIndex][i][j]);
+				if (!(inFrustumBits & (1ull << bit)))
+					continue;
+
+				const UINT instanceIndex = wordIndex * 64 + bit;
+				auto& lodGroupsIndices = (occlusionBits & (1ull << bit)) ? mInstancesOccludedLODIndices : mInstancesLODIndices;
+				if (!hasLODs)
+				{
+					lodGroupsIndices[0].push_back(instanceIndex);
+					continue;
+				}
+
+				const XMFLOAT3& pos = mInstancesPositions[instanceIndex];
+				float distanceToCameraSqr =
+					(cameraPos.x - pos.x) * (cameraPos.x - pos.x) +
+					(cameraPos.y - pos.y) * (cameraPos.y - pos.y) +
+					(cameraPos.z - pos.z) * (cameraPos.z - pos.z);
+
+				int lod = -1;
+				if (distanceToCameraSqr <= sqrDistLod0)
+					lod = 0;
+				else if (distanceToCameraSqr <= sqrDistLod1)
+					lod = 1;
+				else if (distanceToCameraSqr <= sqrDistLod2)
+					lod = 2;
+
+				if (lod != -1 && lod < static_cast<int>(lodGroupsIndices.size()))
+					lodGroupsIndices[lod].push_back(instanceIndex);
 			}
 		}
 
-		LoadRenderBuffers(lodIndex);
+		UpdateInstanceBuffers();
 	}
 
-	void ER_RenderingObject::ResetInstanceData(int count, bool clear, int lod)
+	void ER_RenderingObject::SetAllInstancesVisible()
+	{
+		std::fill(mInstancesVisibilityBits.begin(), mInstancesVisibilityBits.end(), ~0ull);
+		std::fill(mInstancesOcclusionBits.begin(), mInstancesOcclusionBits.end(), 0);
+		// bits after the last instance stay empty
+		if (mInstanceCount & 63)
+			mInstancesVisibilityBits.back() = (1ull << (mInstanceCount & 63)) - 1;
+	}
+
+	void ER_RenderingObject::ResetInstanceData(int count)
 	{
 		if (!mIsLoaded)
 			return;
 
-		assert(lod < GetLODCount());
+		if (!mIsIndirectlyRendered && count > static_cast<int>(MAX_DIRECT_INSTANCE_COUNT))
+			throw ER_CoreException("Instances count limit is exceeded!");
 
-		mInstanceCountToRender[lod] = count;
+		// nothing is rendered until the new instances are uploaded
+		for (auto& instanceCountToRender : mInstanceCountToRender)
+			instanceCountToRender = 0;
+		for (auto& instanceCountToRender : mInstanceCountToRenderInShadows)
+			instanceCountToRender = 0;
+		for (auto& lodIndices : mInstancesLODIndices)
+			lodIndices.clear();
+		for (auto& lodIndices : mInstancesOccludedLODIndices)
+			lodIndices.clear();
+
+		mInstanceCount = 0;
+		mInstancesPositions.clear();
+		mInstancesRotations.clear();
+		mInstancesScales.clear();
+		mInstancesWorlds.clear();
+		mInstanceAABBs.clear();
+		mInstancesVisibilityBits.clear();
+		mInstancesOcclusionBits.clear();
+
+		mInstancesPositions.reserve(count);
+		mInstancesRotations.reserve(count);
+		mInstancesScales.reserve(count);
+		mInstancesWorlds.reserve(count);
+		mInstanceAABBs.reserve(count);
+		mInstancesVisibilityBits.reserve((count + 63) / 64);
+		mInstancesOcclusionBits.reserve((count + 63) / 64);
 
-		if (lod == 0)
+		if (!mIsIndirectlyRendered)
 		{
-			mInstanceCount = count;
-
-			mInstanceAABBs.clear();
-			mInstanceAABBs.resize(mInstanceCount, mLocalAABB);
-
-			mInstanceCullingFlags.clear();
-			mInstanceCullingFlags.resize(mInstanceCount, false);
-
-			if (!mIsIndirectlyRendered)
+			for (int i = 0; i < count; i++)
 			{
-				for (int i = 0; i < count; i++)
-				{
-					std::string instanceName = mName + " instance #" + std::to_string(i);
-					strcpy(mEditorInstancedNamesUI[i], instanceName.c_str());
-				}
+				std::string instanceName = mName + " instance #" + std::to_string(i);
+				strcpy(mEditorInstancedNamesUI[i], instanceName.c_str());
 			}
 		}
-
-		if (clear)
-			mInstanceData[lod].clear();
 	}
-	void ER_RenderingObject::AddInstanceData(const XMMATRIX& worldMatrix, int lod)
+	void ER_RenderingObject::AddInstanceData(const XMMATRIX& worldMatrix)
 	{
 		if (!mIsLoaded)
 			return;
 
-		if (lod == -1) {
-			for (int lod = 0; lod < GetLODCount(); lod++)
-				mInstanceData[lod].push_back(InstancedData(worldMatrix));
-			return;
+		if (mInstanceCount % 64 == 0)
+		{
+			mInstancesVisibilityBits.push_back(0);
+			mInstancesOcclusionBits.push_back(0);
 		}
+		mInstancesVisibilityBits.back() |= (1ull << (mInstanceCount % 64));
 
-		assert(lod < mInstanceData.size());
-		mInstanceData[lod].push_back(InstancedData(worldMatrix));
+		mInstancesPositions.push_back({});
+		mInstancesRotations.push_back({});
+		mInstancesScales.push_back({});
+		mInstancesWorlds.push_back({});
+		mInstanceAABBs.push_back(mLocalAABB);
+		mInstanceCount++;
+
+		SetInstanceTransform(mInstanceCount - 1, worldMatrix);
 	}
 
-	void ER_RenderingObject::CreateIndirectInstanceData()
+	// the matrix is stored as is (the streams get its decomposition)
+	void ER_RenderingObject::SetInstanceTransform(int index, const XMMATRIX& worldMatrix)
 	{
-		if (!mIsLoaded)
-			return;
+		assert(index < static_cast<int>(mInstanceCount));
 
-		ER_RHI* rhi = mCore->GetRHI();
+		XMStoreFloat4x4(&(mInstancesWorlds[index].World), worldMatrix);
+
+		XMVECTOR scale, rotation, translation;
+		if (!XMMatrixDecompose(&scale, &rotation, &translation, worldMatrix))
+		{
+			// i.e., zero scale
+			scale = XMVectorZero();
+			rotation = XMQuaternionIdentity();
+			translation = worldMatrix.r[3];
+		}
+		XMStoreFloat3(&mInstancesPositions[index], translation);
+		XMStoreFloat4(&mInstancesRotations[index], rotation);
+		XMStoreFloat3(&mInstancesScales[index], scale);
+	}
+
+	void ER_RenderingObject::SetInstanceTransform(int index, const XMFLOAT3& position, const XMFLOAT4& rotation, const XMFLOAT3& scale)
+	{
+		assert(index < static_cast<int>(mInstanceCount));
+
+		mInstancesPositions[index] = position;
+		mInstancesRotations[index] = rotation;
+		mInstancesScales[index] = scale;
+
+		XMMATRIX worldMatrix = XMMatrixScaling(scale.x, scale.y, scale.z) * XMMatrixRotationQuaternion(XMLoadFloat4(&rotation)) * XMMatrixTranslation(position.x, position.y, position.z);
+		XMStoreFloat4x4(&(mInstancesWorlds[index].World), worldMatrix);
+	}
 
-		if (mIndirectOriginalInstanceDataBuffer) // means we already created the buffers
+	void ER_RenderingObject::SetIndirectBatch(ER_RHI_GPUBuffer* aNewInstanceBuffer, ER_RHI_GPUBuffer* anArgsBuffer, UINT aNewInstancesOffset, UINT anArgsOffset)
+	{
+		assert(mIsIndirectlyRendered);
+
+		mIndirectNewInstanceDataBuffer = aNewInstanceBuffer;
+		mIndirectArgsBuffer = anArgsBuffer;
+		mIndirectNewInstancesOffset = aNewInstancesOffset;
+		mIndirectArgsOffset = anArgsOffset;
+	}
+
+	void ER_RenderingObject::CreateIndirectInstanceData()
+	{
+		if (!mIsLoaded)
 			return;
 
-		if (rhi->GetAPI() == DX12 && rhi->GetCurrentGraphicsCommandListIndex() == -1)
+		if (IsIndirectInstanceDataReady())
 			return;
 
 		assert(mIsIndirectlyRendered);
-		assert(!mIndirectNewInstanceDataBuffer);
-		assert(!mIndirectOriginalInstanceDataBuffer);
 		assert(mInstanceCount);
 		assert(mInstanceAABBs.size());
-		assert(mInstanceData[0].size());
-
-		mIndirectNewInstanceDataBuffer = rhi->CreateGPUBuffer("ER_RHI_GPUBuffer: ER_RenderingObject - Indirect New Instance Data Buffer : " + mName);
-		mIndirectOriginalInstanceDataBuffer = rhi->CreateGPUBuffer("ER_RHI_GPUBuffer: ER_RenderingObject - Indirect Original Instance Data Buffer : " + mName);
-
-		struct IndirectInstanceData 
-		{
-			XMFLOAT4X4 world;
-			XMFLOAT4 aabbMin;
-			XMFLOAT4 aabbMax;
-		};
-
-		std::vector<IndirectInstanceData> data;
-		data.resize(mInstanceCount);
+		assert(mInstancesWorlds.size());
 
+		mIndirectInstanceData.resize(mInstanceCount);
 		for (UINT i = 0; i < mInstanceCount; ++i)
 		{
-			data[i].world = mInstanceData[0][i].World;
-			data[i].aabbMin = XMFLOAT4(mInstanceAABBs[i].first.x, mInstanceAABBs[i].first.y, mInstanceAABBs[i].first.z, 1.0f);
-			data[i].aabbMax = XMFLOAT4(mInstanceAABBs[i].second.x, mInstanceAABBs[i].second.y, mInstanceAABBs[i].second.z, 1.0f);
+			mIndirectInstanceData[i].World = mInstancesWorlds[i].World;
+			mIndirectInstanceData[i].AABBMin = XMFLOAT4(mInstanceAABBs[i].first.x, mInstanceAABBs[i].first.y, mInstanceAABBs[i].first.z, 1.0f);
+			mIndirectInstanceData[i].AABBMax = XMFLOAT4(mInstanceAABBs[i].second.x, mInstanceAABBs[i].second.y, mInstanceAABBs[i].second.z, 1.0f);
 		}
 
-		mIndirectOriginalInstanceDataBuffer->CreateGPUBufferResource(rhi, &data[0], mInstanceCount, sizeof(IndirectInstanceData), false,
-			ER_BIND_SHADER_RESOURCE, 0, ER_RESOURCE_MISC_BUFFER_STRUCTURED);
-		mIndirectNewInstanceDataBuffer->CreateGPUBufferResource(rhi, nullptr, mInstanceCount * MAX_LOD, sizeof(IndirectInstanceData), false,
-			ER_BIND_UNORDERED_ACCESS | ER_BIND_SHADER_RESOURCE, 0, ER_RESOURCE_MISC_BUFFER_STRUCTURED, ER_FORMAT_UNKNOWN);
-
 		const int totalObjLodCount = GetLODCount();
 		// update draw args array
 		int offset, indexCount, lastAvailableLod = 0;
@@ -3,12 +3,14 @@
 #include "Common.h"
 #include "ER_GenericEvent.h"
 #include "ER_ModelMaterial.h"
+#include "ER_MaterialHelper.h"
+#include "ER_InstanceBufferPool.h"
 
 #include "RHI\ER_RHI.h"
 
 #define MAX_NAME_CHAR_LENGTH 100
 
-const UINT MAX_DIRECT_INSTANCE_COUNT = 20000; // max count for instances which are NOT GPU indirectly drawn
+const UINT MAX_DIRECT_INSTANCE_COUNT = 20000; // max count for instances which are NOT GPU indirectly drawn (instance buffers are only as big as the actual instance count)
 
 // Bitmasks for "RenderingObjectFlags" as decimal values
 // Keep in sync with content/shaders/Common.hlsli!
@@ -34,19 +36,13 @@ namespace EveryRay_Core
 	class ER_RenderableAABB;
 	class ER_Camera;
 	class ER_Model;
-
-	enum RenderingObjectTextureQuality
-	{
-		OBJECT_TEXTURE_LOW = 0,
-		OBJECT_TEXTURE_MEDIUM,
-		OBJECT_TEXTURE_HIGH,
-
-		OBJECT_TEXTURE_COUNT,
-	};
+	class ER_SoftwareOcclusionCuller;
+	class ER_Scene;
 
 	struct RenderBufferData
 	{
 		ER_RHI_GPUBuffer*		VertexBuffer;
+		ER_RHI_GPUBuffer*		PositionVertexBuffer; // optional position-only stream for depth passes (see ER_Material::IsPositionOnly())
 		ER_RHI_GPUBuffer*		IndexBuffer;
 		UINT					Stride;
 		UINT					Offset;
@@ -55,6 +51,7 @@ namespace EveryRay_Core
 		RenderBufferData()
 			:
 			VertexBuffer(nullptr),
+			PositionVertexBuffer(nullptr),
 			IndexBuffer(nullptr),
 			Stride(0),
 			Offset(0),
@@ -64,6 +61,7 @@ namespace EveryRay_Core
 		RenderBufferData(ER_RHI_GPUBuffer* vertexBuffer, ER_RHI_GPUBuffer* indexBuffer, UINT stride, UINT offset, UINT indicesCount)
 			:
 			VertexBuffer(vertexBuffer),
+			PositionVertexBuffer(nullptr),
 			IndexBuffer(indexBuffer),
 			Stride(stride),
 			Offset(offset),
@@ -73,6 +71,7 @@ namespace EveryRay_Core
 		~RenderBufferData()
 		{
 			DeleteObject(VertexBuffer);
+			DeleteObject(PositionVertexBuffer);
 			DeleteObject(IndexBuffer);
 		}
 	};
@@ -86,13 +85,15 @@ namespace EveryRay_Core
 		float CustomAlphaDiscard;
 		UINT OriginalInstanceCount;
 		UINT RenderingObjectFlags;
+		UINT IndirectInstanceOffset;
 	};
 
-	struct ER_ALIGN_GPU_BUFFER IndirectMeshCB
+	// should match "Instance" in IndirectCulling.hlsli
+	struct IndirectInstanceData
 	{
-		XMINT4 IndexCount_StartIndexLoc_BaseVtxLoc_StartInstLoc[MAX_LOD * MAX_MESH_COUNT];
-		UINT OriginalInstancesCount;
-		XMINT3 pad;
+		XMFLOAT4X4 World;
+		XMFLOAT4 AABBMin;
+		XMFLOAT4 AABBMax;
 	};
 
 	struct ER_ALIGN_GPU_BUFFER ObjectFakeRootCB
@@ -129,26 +130,6 @@ namespace EveryRay_Core
 		InstancedData(CXMMATRIX world) : World() { XMStoreFloat4x4(&World, world); }
 	};
 
-	struct InstanceBufferData
-	{
-		UINT				Stride = 0; 
-		UINT				Offset = 0;
-		ER_RHI_GPUBuffer*	InstanceBuffer = nullptr;
-
-		InstanceBufferData() : 
-			Stride(0),
-			Offset(0),
-			InstanceBuffer(nullptr)
-		{
-		}
-
-		~InstanceBufferData()
-		{
-			DeleteObject(InstanceBuffer);
-		}
-		
-	};
-
 	class ER_RenderingObject
 	{
 		using Delegate_MeshMaterialVariablesUpdate = std::function<void(int, int)>; // mesh index & lod index for input
@@ -157,26 +138,41 @@ namespace EveryRay_Core
 		ER_RenderingObject(const std::string& pName, int index, ER_Core& pCore, ER_Camera& pCamera, const std::string& pModelPath, bool availableInEditor = false, bool isInstanced = false);
 		~ER_RenderingObject();
 
-		void LoadMaterial(ER_Material* pMaterial, const std::string& materialName);
+		void LoadMaterial(ER_Material* pMaterial, const std::string& materialName); // the object owns the material (a second material with the same name is deleted)
 		void LoadRenderBuffers(int lod = 0);
 
 		void LoadCustomMeshTextures(int meshIndex);
 		void LoadCustomMaterialTextures();
 		void LoadAssignedMeshTextures(int meshIndex);
 
-		void Draw(const std::string& materialName, bool toDepth = false, int meshIndex = -1);
-		void DrawLOD(const std::string& materialName, bool toDepth, int meshIndex, int lod, bool skipCulling = false);
+		void Draw(ER_MaterialID materialID, bool toDepth = false, int meshIndex = -1, bool isShadowPass = false);
+		// shadow passes draw the instances that are not occlusion culled (they can still cast visible shadows)
+		void DrawLOD(ER_MaterialID materialID, bool toDepth, int meshIndex, int lod, bool skipCulling = false, bool isShadowPass = false);
+		// draws one mesh with the instances from an external instance buffer (i.e., culled by a system for its own pass, not by the camera);
+		// pass nullptr for non-instanced objects
+		void DrawLODWithInstances(ER_MaterialID materialID, int meshIndex, int lod, ER_RHI_GPUBuffer* instanceBuffer, UINT instancesCount, UINT startInstance);
 		void DrawAABB(ER_RHI_GPUTexture* aRenderTarget, ER_RHI_GPUTexture* aDepth, ER_RHI_GPURootSignature* rs);
 		void Update(const ER_CoreTime& time);
 
-		std::map<std::string, ER_Material*>& GetMaterials() { return mMaterials; }
+		// all materials (with their names) in the order they were loaded
+		const std::vector<std::pair<std::string, ER_Material*>>& GetMaterials() const { return mMaterials; }
+		const std::vector<ER_MaterialID>& GetMaterialIDs() const { return mMaterialIDs; } // in the same order as GetMaterials()
+		ER_Material* GetMaterial(ER_MaterialID materialID) const { return (materialID >= 0 && materialID < MAX_MATERIAL_IDS) ? mMaterialsByID[materialID] : nullptr; }
 		
 		TextureData& GetTextureData(int meshIndex) { return mMeshesTextureBuffers[meshIndex]; }
 		
+		const ER_Model* GetModel() const { return mModel; }
 		const int GetMeshCount(int lod = 0) const { return mMeshesCount[lod]; }
-		const std::vector<XMFLOAT3>& GetVertices(int lod = 0) { return mMeshAllVertices[lod]; }
-		const UINT GetInstanceCount(int lod = 0) const { return (mIsInstanced ? static_cast<UINT>(mInstanceData[lod].size()) : 0); }
-		std::vector<InstancedData>& GetInstancesData(int lod = 0) { return mInstanceData[lod]; }
+		const UINT GetVertexCount(int lod = 0) const;
+		const UINT GetInstanceCount() const { return (mIsInstanced ? mInstanceCount : 0); }
+		// world matrices of all instances (shared by all LODs, not culled)
+		const std::vector<InstancedData>& GetInstancesData() const { return mInstancesWorlds; }
+		const XMFLOAT3& GetInstancePosition(int index) const { return mInstancesPositions[index]; }
+		const XMFLOAT4& GetInstanceRotation(int index) const { return mInstancesRotations[index]; } // quaternion
+		const XMFLOAT3& GetInstanceScale(int index) const { return mInstancesScales[index]; }
+		// result of the last CPU culling of the instances (all instances are visible if CPU culling is disabled)
+		bool IsInstanceVisible(int index) const { return (mInstancesVisibilityBits[index >> 6] & (1ull << (index & 63))) != 0; }
+		bool IsInstanceOccluded(int index) const { return (mInstancesOcclusionBits[index >> 6] & (1ull << (index & 63))) != 0; } // only rendered in shadow passes
 		const int GetIndexCount(int lod, int mesh) const { return mMeshRenderBuffers[lod][mesh]->IndicesCount; }
 
 		XMFLOAT4X4 GetTransformationMatrix4X4() const { return XMFLOAT4X4(mEditorCurrentObjectTransformMatrix); }
@@ -192,23 +188,30 @@ namespace EveryRay_Core
 		void SetRotation(float x, float y, float z);
 
 		void LoadInstanceBuffers(int lod = 0);
-		void UpdateInstanceBuffer(std::vector<InstancedData>& instanceData, int lod = 0);
-		void ResetInstanceData(int count, bool clear = false, int lod = 0);
-		void AddInstanceData(const XMMATRIX& worldMatrix, int lod = -1);
+		// uploads the data as is (i.e., all instances) to the instance buffer of the lod; the last "occludedInstanceCount" instances are only drawn in shadow passes
+		void UpdateInstanceBuffer(const std::vector<InstancedData>& instanceData, int lod = 0, UINT occludedInstanceCount = 0);
+		void UpdateInstanceBuffers(); // uploads the visible (and then the occluded) instances of every LOD group (see UpdateInstancesLODGroups())
+		void ResetInstanceData(int count); // removes all instances, reserves memory for "count" instances
+		void AddInstanceData(const XMMATRIX& worldMatrix);
+		void SetInstanceTransform(int index, const XMMATRIX& worldMatrix);
+		void SetInstanceTransform(int index, const XMFLOAT3& position, const XMFLOAT4& rotation, const XMFLOAT3& scale);
 		void CreateIndirectInstanceData();
 		UINT InstanceSize() const;
 		
-		void PerformCPUFrustumCull(ER_Camera* camera);
+		void PerformCPUFrustumCull(ER_Camera* camera, const ER_SoftwareOcclusionCuller* occlusionCuller = nullptr);
+		void AddToOcclusionCuller(ER_SoftwareOcclusionCuller* occlusionCuller); // only if the object is marked as occluder
 
 		void SetGPUIndirectlyRendered(bool value) { mIsIndirectlyRendered = value; }
 		bool IsGPUIndirectlyRendered() { return mIsIndirectlyRendered; }
+		// buffers are shared by all indirectly rendered objects (ER_GPUCuller culls all of them in one dispatch), so the object only knows its offsets in them
+		void SetIndirectBatch(ER_RHI_GPUBuffer* aNewInstanceBuffer, ER_RHI_GPUBuffer* anArgsBuffer, UINT aNewInstancesOffset, UINT anArgsOffset);
 		ER_RHI_GPUBuffer* GetIndirectNewInstanceBuffer() { return mIndirectNewInstanceDataBuffer; }
-		ER_RHI_GPUBuffer* GetIndirectOriginalInstanceBuffer() { return mIndirectOriginalInstanceDataBuffer; }
 		ER_RHI_GPUBuffer* GetIndirectArgsBuffer() { return mIndirectArgsBuffer; }
-		ER_RHI_GPUBuffer* GetIndirectMeshConstantBuffer();
+		const std::vector<IndirectInstanceData>& GetIndirectInstanceData() const { return mIndirectInstanceData; }
+		bool IsIndirectInstanceDataReady() const { return !mIndirectInstanceData.empty(); }
 		const XMINT4* GetIndirectDrawArgsArray() const { return mIndirectDrawArgsArray; }
 
-		void Rename(const std::string& name) { mName = name; }
+		void Rename(const std::string& name); // also updates the name index of the scene (if the object is in one)
 		const std::string& GetName() { return mName; }
 
 		const int GetLODCount() const {	return 1 + static_cast<int>(mModelLODs.size());	}
@@ -230,8 +233,8 @@ namespace EveryRay_Core
 		bool IsRendered() { return mIsRendered; }
 		void SetRendered(bool val) { mIsRendered = val; }
 
-		// main camera view flag
-		bool IsCulled() { return mIsCulled; }
+		// main camera view flag (frustum culled or occluded, occluded objects still cast shadows)
+		bool IsCulled() { return mIsCulled || mIsOccluded; }
 		void SetCulled(bool val) { mIsCulled = val; }
 
 		float GetCustomAlphaDiscard() { return mCustomAlphaDiscard; }
@@ -242,18 +245,23 @@ namespace EveryRay_Core
 		void SetTerrainPlacement(bool flag) { mIsTerrainPlacement = flag; }
 		bool GetTerrainPlacement() { return mIsTerrainPlacement; }
 		void SetTerrainProceduralPlacementHeightDelta(float delta) { mTerrainProceduralPlacementHeightDelta = delta; }
+		float GetTerrainProceduralPlacementHeightDelta() { return mTerrainProceduralPlacementHeightDelta; }
 		void SetTerrainProceduralPlacementSplatChannel(int channel) { mTerrainProceduralPlacementSplatChannel = channel; }
 		int GetTerrainProceduralPlacementSplatChannel() { return mTerrainProceduralPlacementSplatChannel; }
 		void SetTerrainProceduralInstanceCount(int count) { mTerrainProceduralInstanceCount = count; }
 		int GetTerrainProceduralInstanceCount() { return mTerrainProceduralInstanceCount; }
 		void SetTerrainProceduralZoneCenterPos(const XMFLOAT3& pos) { mTerrainProceduralZoneCenterPos = pos; }
-		const XMFLOAT3& GetTerrainProceduralZoneCenterPos(const XMFLOAT3& pos) { return mTerrainProceduralZoneCenterPos; }
+		const XMFLOAT3& GetTerrainProceduralZoneCenterPos() { return mTerrainProceduralZoneCenterPos; }
 		void SetTerrainProceduralZoneRadius(float radius) { mTerrainProceduralZoneRadius = radius; }
 		float GetTerrainProceduralZoneRadius() { return mTerrainProceduralZoneRadius; }
 		void SetTerrainProceduralObjectsMinMaxScale(float minScale, float maxScale) { mTerrainProceduralObjectMinScale = minScale; mTerrainProceduralObjectMaxScale = maxScale; }
 		void SetTerrainProceduralObjectsMinMaxYaw(float minYaw, float maxYaw) { mTerrainProceduralObjectMinYaw = XMConvertToRadians(minYaw); mTerrainProceduralObjectMaxYaw = XMConvertToRadians(maxYaw); }
 		void SetTerrainProceduralObjectsMinMaxPitch(float minPitch, float maxPitch) { mTerrainProceduralObjectMinPitch = XMConvertToRadians(minPitch); mTerrainProceduralObjectMaxPitch = XMConvertToRadians(maxPitch); }
 		void SetTerrainProceduralObjectsMinMaxRoll(float minRoll, float maxRoll) { mTerrainProceduralObjectMinRoll = XMConvertToRadians(minRoll); mTerrainProceduralObjectMaxRoll = XMConvertToRadians(maxRoll); }
+		XMFLOAT2 GetTerrainProceduralObjectsMinMaxScale() { return XMFLOAT2(mTerrainProceduralObjectMinScale, mTerrainProceduralObjectMaxScale); }
+		XMFLOAT2 GetTerrainProceduralObjectsMinMaxYaw() { return XMFLOAT2(XMConvertToDegrees(mTerrainProceduralObjectMinYaw), XMConvertToDegrees(mTerrainProceduralObjectMaxYaw)); } // in degrees (as in the scene file)
+		XMFLOAT2 GetTerrainProceduralObjectsMinMaxPitch() { return XMFLOAT2(XMConvertToDegrees(mTerrainProceduralObjectMinPitch), XMConvertToDegrees(mTerrainProceduralObjectMaxPitch)); }
+		XMFLOAT2 GetTerrainProceduralObjectsMinMaxRoll() { return XMFLOAT2(XMConvertToDegrees(mTerrainProceduralObjectMinRoll), XMConvertToDegrees(mTerrainProceduralObjectMaxRoll)); }
 
 		void SetReflective(bool value) { mIsReflective = value; }
 		bool IsReflective() { return mIsReflective; }
@@ -282,6 +290,14 @@ namespace EveryRay_Core
 		bool IsTransparent() { return mIsTransparent; }
 		void SetTransparency(bool value) { mIsTransparent = value; }
 
+		// rasterized into the software occlusion buffer (see ER_SoftwareOcclusionCuller)
+		bool IsOccluder() { return mIsOccluder; }
+		void SetIsOccluder(bool value) { mIsOccluder = value; }
+
+		// alpha-tested objects need full vertices (UVs) in depth passes, others only use the position stream
+		bool IsAlphaTestedInDepth() { return mIsAlphaTestedInDepth || mIsTransparent || mIsMarkedAsFoliage; }
+		void SetAlphaTestedInDepth(bool value) { mIsAlphaTestedInDepth = value; }
+
 		float GetIOR() { return mIOR; }
 		void SetIOR(float value) { mIOR = value; }
 		
@@ -306,6 +322,14 @@ namespace EveryRay_Core
 		int GetIndexInScene() { return mIndexInScene; }
 		void SetIndexInScene(int index) { mIndexInScene = index; }
 
+		// stable ID (never reused in the scene), assigned in ER_Scene::AddRenderingObject(); -1 if the object is not in a scene
+		int GetSceneID() const { return mSceneID; }
+		void SetScene(ER_Scene* aScene, int aSceneID) { mScene = aScene; mSceneID = aSceneID; }
+
+		// streamed objects are loaded on worker threads while the level is rendered (see ER_Scene::UpdateStreaming())
+		bool IsStreamed() const { return mIsStreamed; }
+		void SetStreamed(bool value) { mIsStreamed = value; }
+
 		bool IsTriplanarMapped() { return mIsTriplanarMapped; }
 		void SetTriplanarMapping(bool value) { mIsTriplanarMapped = value; }
 		float GetTriplanarMappedSharpness() { return mTriplanarMappingSharpness; }
@@ -355,6 +379,7 @@ namespace EveryRay_Core
 		void SetFurUVScale(float val) { mFurUVScale = val; }
 		float GetFurUVScale() { return mFurUVScale; }
 		void SetFurWindFrequency(float v) { mFurWindFrequency = v; }
+		float GetFurWindFrequency() { return mFurWindFrequency; }
 		void SetFurGravityStrength(float v) { mFurGravityStrength = v; }
 		XMFLOAT4 GetFurGravityStrength(); 
 
@@ -362,7 +387,9 @@ namespace EveryRay_Core
 	private:
 		void UpdateAABB(ER_AABB& aabb, const XMMATRIX& transformMatrix);
 		void LoadTexture(ER_RHI_GPUTexture** aTexture, bool* loadStat, const std::wstring& path, int meshIndex, bool isPlaceholder = false);
-		void CreateInstanceBuffer(InstancedData* instanceData, UINT instanceCount, ER_RHI_GPUBuffer* instanceBuffer);
+		void SetAllInstancesVisible();
+		void UpdateInstancesLODGroups();
+		void UpdateObjectConstantBuffers(int lod);
 		
 		void UpdateGizmosAndUI();
 		void UpdateBitmaskFlags();
@@ -372,7 +399,10 @@ namespace EveryRay_Core
 		ER_Core* mCore = nullptr;
 		ER_Camera& mCamera;
 
-		std::map<std::string, ER_Material*>						mMaterials;
+		std::vector<std::pair<std::string, ER_Material*>>		mMaterials;
+		std::vector<ER_MaterialID>								mMaterialIDs;
+		ER_Material*											mMaterialsByID[MAX_MATERIAL_IDS] = { nullptr };
+		ER_GenericEvent<Delegate_MeshMaterialVariablesUpdate>::ListenerHandle mMaterialsListenerHandles[MAX_MATERIAL_IDS] = { 0 }; // for MeshMaterialVariablesUpdateEvent (listeners are named after materials)
 
 		ER_RHI_GPUConstantBuffer<ObjectCB>						mObjectConstantBuffer;
 		ER_RHI_GPUConstantBuffer<ObjectFakeRootCB>				mObjectFakeRootConstantBuffer; // for platforms where root constants aren't supported
@@ -380,10 +410,8 @@ namespace EveryRay_Core
 		///****************************************************************************************************************************
 		// *** mesh/model data (buffers, textures, etc.) ***
 		std::vector<TextureData>								mMeshesTextureBuffers;
-		std::vector<std::vector<std::vector<XMFLOAT3>>>			mMeshVertices; // vertices per mesh, per LOD group
 		std::vector<std::vector<RenderBufferData*>>				mMeshRenderBuffers; // vertex/index buffers per mesh, per LOD group
-		std::vector<std::vector<InstanceBufferData*>>			mMeshesInstanceBuffers; // instance buffers per mesh, per LOD group
-		std::vector<std::vector<XMFLOAT3>>						mMeshAllVertices; // vertices of all meshes combined, per LOD group
+		std::vector<ER_InstanceBufferRange>						mInstanceBufferRanges; // ranges in the instance buffer pool of the scene (per LOD group, shared by meshes)
 		std::vector<float>										mMeshesReflectionFactors; // mesh reflection factors, per LOD group
 		std::vector<int>										mMeshesCount; // mesh count, per LOD group
 		ER_Model*												mModel = nullptr; // just a pointer to the model cache
@@ -395,22 +423,30 @@ namespace EveryRay_Core
 		///****************************************************************************************************************************
 		// *** instancing data (counters, transforms etc.) ***
 		UINT													mInstanceCount = 0;
+		// instances are stored as a structure of arrays (shared for LODs), every stream is indexed by the instance index
+		std::vector<XMFLOAT3>									mInstancesPositions;
+		std::vector<XMFLOAT4>									mInstancesRotations; // quaternions
+		std::vector<XMFLOAT3>									mInstancesScales;
+		std::vector<InstancedData>								mInstancesWorlds; // world matrices (in the layout of the instance buffer), kept in sync with the streams above
 		std::vector<ER_AABB>									mInstanceAABBs; // collection of AABBs for every instance (shared for LODs)
-		std::vector<bool>										mInstanceCullingFlags; // collection of culling flags for every instance (vector is lame here btw...)
-		std::vector<InstancedData>								mTempPostCullingInstanceData; // temp instance data after CPU culling
-		std::vector<std::vector<InstancedData>>					mTempPostLoddingInstanceData; // temp instance data after lodding (per LOD group)
+		std::vector<UINT64>										mInstancesVisibilityBits; // packed culling results (1 - visible), 64 instances per word
+		std::vector<UINT64>										mInstancesOcclusionBits; // packed occlusion results (1 - inside the frustum but occluded, i.e., only casts shadows), 64 instances per word
+		std::vector<std::vector<UINT>>							mInstancesLODIndices; // indices of the visible instances (per LOD group)
+		std::vector<std::vector<UINT>>							mInstancesOccludedLODIndices; // indices of the occluded instances (per LOD group)
+		std::vector<InstancedData>								mTempInstancesUploadData; // world matrices of one LOD group gathered for the upload
 		std::vector<UINT>										mInstanceCountToRender; //instance render count  (per LOD group)
-		std::vector<std::vector<InstancedData>>					mInstanceData; //original instance data  (per LOD group)
+		std::vector<UINT>										mInstanceCountToRenderInShadows; //instance render count in shadow passes, visible + occluded (per LOD group)
 		XMFLOAT4*												mTempInstancesPositions = nullptr;
 
 		// GPU-driven way of culling and rendering instances without CPU readbacks (new and preferred)
 		// WARNING: Make sure to use this for objects with high instances counts to make this efficient
 		// WARNING: Has nothing to do with indirect lighting!
 		bool													mIsIndirectlyRendered = false; // parsed from the scene file
-		ER_RHI_GPUBuffer*										mIndirectOriginalInstanceDataBuffer = nullptr; //original instance transforms
-		ER_RHI_GPUBuffer*										mIndirectNewInstanceDataBuffer = nullptr; //new instance transforms of all LODs culled and processed in CS
-		ER_RHI_GPUBuffer*										mIndirectArgsBuffer = nullptr; // draw indexed instance indirect args for all meshes (instance count is calculated in CS)
-		ER_RHI_GPUConstantBuffer<IndirectMeshCB>				mIndirectMeshConstants; // not used on DX11-like APIs;
+		std::vector<IndirectInstanceData>						mIndirectInstanceData; //original instance transforms (uploaded by ER_GPUCuller)
+		ER_RHI_GPUBuffer*										mIndirectNewInstanceDataBuffer = nullptr; //new instance transforms of all LODs culled and processed in CS (owned by ER_GPUCuller)
+		ER_RHI_GPUBuffer*										mIndirectArgsBuffer = nullptr; // draw indexed instance indirect args for all meshes, instance count is calculated in CS (owned by ER_GPUCuller)
+		UINT													mIndirectNewInstancesOffset = 0; // in instances
+		UINT													mIndirectArgsOffset = 0; // in UINTs
 		XMINT4													mIndirectDrawArgsArray[MAX_LOD * MAX_MESH_COUNT];
 		
 		///****************************************************************************************************************************
@@ -463,7 +499,10 @@ namespace EveryRay_Core
 		ER_RenderableAABB*										mDebugGizmoAABB = nullptr;
 	
 		std::string												mName;
-		int														mIndexInScene = -1;
+		ER_Scene*												mScene = nullptr;
+		int														mIndexInScene = -1; //index in the scene file
+		int														mSceneID = -1;
+		bool													mIsStreamed = false;
 		int														mCurrentLODIndex = 0; //only used for non-instanced object
 		bool													mIsAABBDebugEnabled = true;
 		bool													mIsAvailableInEditorMode = false;
@@ -473,6 +512,7 @@ namespace EveryRay_Core
 		bool													mIsForwardShading = false;
 		bool													mIsPOM = false;
 		bool													mIsCulled = false; //only for non-instanced objects
+		bool													mIsOccluded = false; //only for non-instanced objects (still rendered in shadow passes)
 		bool													mIsMarkedAsFoliage = false;
 		bool													mIsInLightProbe = false;
 		bool													mIsSeparableSubsurfaceScattering = false;
@@ -484,6 +524,8 @@ namespace EveryRay_Core
 		bool													mIsSkippedIndirectDiffuse = false;
 		bool													mIsReflective = false; //appeared in SSR and such
 		bool													mIsTransparent = false;
+		bool													mIsAlphaTestedInDepth = false; //parsed from the scene file ("use_alpha_tested_depth")
+		bool													mIsOccluder = false; //parsed from the scene file ("use_as_occluder")
 		bool													mIsTriplanarMapped = false;
 		float													mTriplanarMappingSharpness = 1.0f;
 		float													mIOR = 1.52f; // glass IOR by default
@@ -508,7 +550,6 @@ namespace EveryRay_Core
 		int														mEditorSelectedInstancedObjectIndex = 0;							//only for direct instances and not GPU-driven/indirect
 		int														mEditorSelectedInstancedObjectIndexNextFrame = 0;					//only for direct instances and not GPU-driven/indirect
 
-		RenderingObjectTextureQuality							mCurrentTextureQuality = RenderingObjectTextureQuality::OBJECT_TEXTURE_LOW;
 		UINT													mObjectShaderBitmaskFlags = 0; // "RenderingObjectFlags" in shaders
 	};
 }
\ No newline at end of file
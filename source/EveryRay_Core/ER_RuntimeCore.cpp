@@ -11,15 +11,24 @@
 #include "ER_Sandbox.h"
 #include "ER_Editor.h"
 #include "ER_QuadRenderer.h"
+#include "ER_TextureStreamer.h"
 #include "ER_Model.h"
 
 #include "..\JsonCpp\include\json\json.h"
 
+#include <condition_variable>
+#include <set>
+
 namespace EveryRay_Core
 {
 	static int currentLevel = 0;
+	// Caches are filled from multiple loading threads: files are loaded outside of the locks, only the threads that need the same file wait for it
 	static std::mutex renderingObjectsTextureCacheMutex;
 	static std::mutex renderingObjects3DModelsCacheMutex;
+	static std::condition_variable renderingObjectsTextureCacheCondition;
+	static std::condition_variable renderingObjects3DModelsCacheCondition;
+	static std::set<std::wstring> renderingObjectsTexturesInLoading;
+	static std::set<std::string> renderingObjects3DModelsInLoading;
 
 	ER_RuntimeCore::ER_RuntimeCore(ER_RHI* aRHI, HINSTANCE instance, const std::wstring& windowClass, const std::wstring& windowTitle, int showCommand, bool isFullscreen)
 		: ER_Core(aRHI, instance, windowClass, windowTitle, showCommand, isFullscreen),
@@ -29,7 +38,8 @@ namespace EveryRay_Core
 		mGamepad(nullptr),
 		mShowProfiler(false),
 		mEditor(nullptr),
-		mQuadRenderer(nullptr)
+		mQuadRenderer(nullptr),
+		mTextureStreamer(nullptr)
 	{
 		LoadGraphicsConfig();
 
@@ -57,15 +67,15 @@ namespace EveryRay_Core
 
 			mKeyboard = new ER_Keyboard(*this, mDirectInput);
 			mCoreComponents.push_back(mKeyboard);
-			mCoreServices.AddService(ER_Keyboard::TypeIdClass(), mKeyboard);
+			mCoreServices.AddService<ER_Keyboard>(mKeyboard);
 
 			mMouse = new ER_Mouse(*this, mDirectInput);
 			mCoreComponents.push_back(mMouse);
-			mCoreServices.AddService(ER_Mouse::TypeIdClass(), mMouse);
+			mCoreServices.AddService<ER_Mouse>(mMouse);
 
 			mGamepad = new ER_Gamepad(*this);
 			mCoreComponents.push_back(mGamepad);
-			mCoreServices.AddService(ER_Gamepad::TypeIdClass(), mGamepad);
+			mCoreServices.AddService<ER_Gamepad>(mGamepad);
 		}
 
 		mCamera = new ER_CameraFPS(*this, 1.5708f, this->AspectRatio(), 0.5f, 100000.0f);
@@ -75,15 +85,19 @@ namespace EveryRay_Core
 		mCamera->SetNearPlaneDistance(0.5f);
 		mCamera->SetFarPlaneDistance(100000.0f);
 		mCoreComponents.push_back(mCamera);
-		mCoreServices.AddService(ER_Camera::TypeIdClass(), mCamera);
+		mCoreServices.AddService<ER_Camera>(mCamera);
 
 		mEditor = new ER_Editor(*this);
 		mCoreComponents.push_back(mEditor);
-		mCoreServices.AddService(ER_Editor::TypeIdClass(), mEditor);
+		mCoreServices.AddService<ER_Editor>(mEditor);
 
 		mQuadRenderer = new ER_QuadRenderer(*this);
 		mCoreComponents.push_back(mQuadRenderer);
-		mCoreServices.AddService(ER_QuadRenderer::TypeIdClass(), mQuadRenderer);
+		mCoreServices.AddService<ER_QuadRenderer>(mQuadRenderer);
+
+		mTextureStreamer = new ER_TextureStreamer(*this, *mCamera, (TextureStreamingQuality)ER_Settings::TexturesQuality);
+		mCoreComponents.push_back(mTextureStreamer);
+		mCoreServices.AddService<ER_TextureStreamer>(mTextureStreamer);
 
 		#pragma region INITIALIZE_IMGUI
 
@@ -198,6 +212,20 @@ namespace EveryRay_Core
 				ER_Settings::VolumetricFogQuality = root["presets"][currentPresetIndex]["volumetric_fog_quality"].asInt();
 				ER_Settings::VolumetricCloudsQuality = root["presets"][currentPresetIndex]["volumetric_clouds_quality"].asInt();
 			}
+			//set GI tier (of the selected gi_quality)
+			{
+				const int giTierIndex = ER_Settings::GlobalIlluminationQuality;
+				if (!root.isMember("gi_quality_tiers") || giTierIndex < 0 || giTierIndex >= (int)root["gi_quality_tiers"].size())
+					throw ER_CoreException("No tier for the current gi_quality defined in 'gi_quality_tiers' in graphics_config.json");
+
+				const Json::Value& giTier = root["gi_quality_tiers"][giTierIndex];
+				if (!giTier.isMember("voxel_cascade_resolution") || !giTier.isMember("diffuse_cones_count") || !giTier.isMember("specular_probes_limit"))
+					throw ER_CoreException("Current GI tier is missing some of its values in graphics_config.json");
+
+				ER_Settings::GIVoxelCascadeResolution = giTier["voxel_cascade_resolution"].asInt();
+				ER_Settings::GIDiffuseConesCount = giTier["diffuse_cones_count"].asInt();
+				ER_Settings::GISpecularProbesLimit = giTier["specular_probes_limit"].asInt();
+			}
 		}
 	}
 
@@ -212,6 +240,7 @@ namespace EveryRay_Core
 			DeleteObject(mCurrentSandbox);
 		}
 
+		mTextureStreamer->Reset();
 		for (auto& it : mRenderingObjectsTextureCache)
 			DeleteObject(it.second);
 		mRenderingObjectsTextureCache.erase(mRenderingObjectsTextureCache.begin(), mRenderingObjectsTextureCache.end());
@@ -299,6 +328,9 @@ namespace EveryRay_Core
 				ImGui::TextColored(ImVec4(0.95f, 0.5f, 0.0f, 1), "CPU Render: %f ms", mElapsedTimeRenderCPU.count() * 1000);
 				ImGui::TextColored(ImVec4(0.95f, 0.5f, 0.0f, 1), "CPU Update: %f ms", mElapsedTimeUpdateCPU.count() * 1000);
 			}
+
+			if (ImGui::Button("Texture Streaming") && mTextureStreamer)
+				mTextureStreamer->Config();
 			
 			if (ImGui::CollapsingHeader("Load level"))
 			{
@@ -320,6 +352,7 @@ namespace EveryRay_Core
 		DeleteObject(mKeyboard);
 		DeleteObject(mEditor);
 		DeleteObject(mQuadRenderer);
+		DeleteObject(mTextureStreamer);
 		DeleteObject(mMouse);
 		DeleteObject(mCamera);
 
@@ -350,6 +383,8 @@ namespace EveryRay_Core
 		mRHI->BeginGraphicsCommandList();
 		mRHI->SetGPUDescriptorHeap(ER_RHI_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, true);
 
+		mTextureStreamer->UploadStreamedTextures(mRHI);
+
 		mRHI->ClearMainRenderTarget(clearColorBlack);
 		mRHI->ClearMainDepthStencilTarget(1.0f, 0);
 
@@ -373,46 +408,63 @@ namespace EveryRay_Core
 
 	ER_Model* ER_RuntimeCore::AddOrGet3DModelFromCache(const std::string& aFullPath, bool* didExist /*= nullptr*/, bool isSilent /*= false*/)
 	{
-		const std::lock_guard<std::mutex> lock(renderingObjects3DModelsCacheMutex);
-		
+		std::unique_lock<std::mutex> lock(renderingObjects3DModelsCacheMutex);
+		renderingObjects3DModelsCacheCondition.wait(lock, [&aFullPath]() { return renderingObjects3DModelsInLoading.find(aFullPath) == renderingObjects3DModelsInLoading.end(); });
+
 		auto it = mRenderingObjects3DModelsCache.find(aFullPath);
 		if (it != mRenderingObjects3DModelsCache.end())
 		{
 			if (didExist)
 				*didExist = true;
-			return &(it->second);
+			return it->second.get();
 		}
-		else
-		{
-			if (didExist)
-				*didExist = false;
 
-			auto result = mRenderingObjects3DModelsCache.emplace(std::piecewise_construct,
-				std::forward_as_tuple(aFullPath), std::forward_as_tuple(*this, aFullPath, true, isSilent)); // this is ugly and we might consider updating to c++17 (try_emplace)
-			if (!result.first->second.IsLoaded())
-			{
-				std::string msg = "[ER Logger][ER_Core] Error! Could not load a new 3D model to models cache: " + aFullPath + '\n';
-				ER_OUTPUT_LOG(ER_Utility::ToWideString(msg).c_str());
+		if (didExist)
+			*didExist = false;
 
-				mRenderingObjects3DModelsCache.erase(aFullPath);
+		renderingObjects3DModelsInLoading.insert(aFullPath);
+		lock.unlock();
 
-				return nullptr;
-			}
-			else
-			{
-				std::string msg = "[ER Logger][ER_Core] Added new 3D model to models cache: " + aFullPath + '\n';
-				ER_OUTPUT_LOG(ER_Utility::ToWideString(msg).c_str());
+		std::unique_ptr<ER_Model> model;
+		try
+		{
+			model.reset(new ER_Model(*this, aFullPath, true, isSilent));
+		}
+		catch (...)
+		{
+			lock.lock();
+			renderingObjects3DModelsInLoading.erase(aFullPath);
+			lock.unlock();
+			renderingObjects3DModelsCacheCondition.notify_all();
+			throw;
+		}
 
-				return &(result.first->second);
-			}
+		ER_Model* result = nullptr;
+		lock.lock();
+		renderingObjects3DModelsInLoading.erase(aFullPath);
+		if (model->IsLoaded())
+			result = mRenderingObjects3DModelsCache.emplace(aFullPath, std::move(model)).first->second.get();
+		lock.unlock();
+		renderingObjects3DModelsCacheCondition.notify_all();
+
+		if (!result)
+		{
+			std::string msg = "[ER Logger][ER_Core] Error! Could not load a new 3D model to models cache: " + aFullPath + '\n';
+			ER_OUTPUT_LOG(ER_Utility::ToWideString(msg).c_str());
+		}
+		else
+		{
+			std::string msg = "[ER Logger][ER_Core] Added new 3D model to models cache: " + aFullPath + '\n';
+			ER_OUTPUT_LOG(ER_Utility::ToWideString(msg).c_str());
 		}
 
-		return nullptr;
+		return result;
 	}
 
-	ER_RHI_GPUTexture* ER_RuntimeCore::AddOrGetGPUTextureFromCache(const std::wstring& aFullPath, bool* didExist, bool is3D /*= false*/, bool skipFallback /*= false*/, bool* statusFlag /*= nullptr*/, bool isSilent /*= false*/)
+	ER_RHI_GPUTexture* ER_RuntimeCore::AddOrGetGPUTextureFromCache(const std::wstring& aFullPath, bool* didExist, bool is3D /*= false*/, bool skipFallback /*= false*/, bool* statusFlag /*= nullptr*/, bool isSilent /*= false*/, UINT maxSize /*= 0*/)
 	{
-		const std::lock_guard<std::mutex> lock(renderingObjectsTextureCacheMutex);
+		std::unique_lock<std::mutex> lock(renderingObjectsTextureCacheMutex);
+		renderingObjectsTextureCacheCondition.wait(lock, [&aFullPath]() { return renderingObjectsTexturesInLoading.find(aFullPath) == renderingObjectsTexturesInLoading.end(); });
 
 		auto it = mRenderingObjectsTextureCache.find(aFullPath);
 		if (it != mRenderingObjectsTextureCache.end())
@@ -421,29 +473,45 @@ namespace EveryRay_Core
 				*didExist = true;
 			return it->second;
 		}
-		else
+
+		if (didExist)
+			*didExist = false;
+
+		renderingObjectsTexturesInLoading.insert(aFullPath);
+		lock.unlock();
+
+		ER_RHI_GPUTexture* texture = mRHI->CreateGPUTexture(aFullPath);
+		try
 		{
-			if (didExist)
-				*didExist = false;
+			texture->CreateGPUTextureResource(mRHI, aFullPath, true, is3D, skipFallback, statusFlag, isSilent, maxSize);
+		}
+		catch (...)
+		{
+			DeleteObject(texture);
+			lock.lock();
+			renderingObjectsTexturesInLoading.erase(aFullPath);
+			lock.unlock();
+			renderingObjectsTextureCacheCondition.notify_all();
+			throw;
+		}
 
-			auto result = mRenderingObjectsTextureCache.emplace(aFullPath, mRHI->CreateGPUTexture(aFullPath));
-			result.first->second->CreateGPUTextureResource(mRHI, aFullPath, true, is3D, skipFallback, statusFlag, isSilent);
-			if (statusFlag && *statusFlag == false)
-			{
-				DeleteObject(result.first->second);
-				mRenderingObjectsTextureCache.erase(aFullPath);
-				return nullptr;
-			}
-			else
-			{
-				std::wstring msg = L"[ER Logger][ER_Core] Added new texture to rendering objects' texture cache: " + aFullPath + L'\n';
-				ER_OUTPUT_LOG(msg.c_str());
+		if (statusFlag && *statusFlag == false)
+			DeleteObject(texture);
 
-				return result.first->second;
-			}
+		lock.lock();
+		renderingObjectsTexturesInLoading.erase(aFullPath);
+		if (texture)
+			mRenderingObjectsTextureCache.emplace(aFullPath, texture);
+		lock.unlock();
+		renderingObjectsTextureCacheCondition.notify_all();
+
+		if (texture)
+		{
+			std::wstring msg = L"[ER Logger][ER_Core] Added new texture to rendering objects' texture cache: " + aFullPath + L'\n';
+			ER_OUTPUT_LOG(msg.c_str());
 		}
 
-		return nullptr;
+		return texture;
 	}
 
 	void ER_RuntimeCore::AddGPUTextureToCache(const std::wstring& aFullPath, ER_RHI_GPUTexture* aTexture)
@@ -12,6 +12,7 @@ namespace EveryRay_Core
 	class ER_CameraFPS;
 	class ER_Editor;
 	class ER_QuadRenderer;
+	class ER_TextureStreamer;
 	class ER_Model;
 	
 	enum GraphicsQualityPreset
@@ -38,7 +39,7 @@ namespace EveryRay_Core
 		virtual ER_Model* AddOrGet3DModelFromCache(const std::string& aFullPath, bool* didExist = nullptr, bool isSilent = false) override;
 
 		// methods for physical textures (on disk) cache from ER_RenderingObjects in the level
-		virtual ER_RHI_GPUTexture* AddOrGetGPUTextureFromCache(const std::wstring& aFullPath, bool* didExist = nullptr, bool is3D = false, bool skipFallback = false, bool* statusFlag = nullptr, bool isSilent = false) override;
+		virtual ER_RHI_GPUTexture* AddOrGetGPUTextureFromCache(const std::wstring& aFullPath, bool* didExist = nullptr, bool is3D = false, bool skipFallback = false, bool* statusFlag = nullptr, bool isSilent = false, UINT maxSize = 0) override;
 		virtual void AddGPUTextureToCache(const std::wstring& aFullPath, ER_RHI_GPUTexture* aTexture) override;
 		virtual bool RemoveGPUTextureFromCache(const std::wstring& aFullPath, bool removeKey = false) override;
 		virtual void ReplaceGPUTextureFromCache(const std::wstring& aFullPath, ER_RHI_GPUTexture* aTex) override; // WARNING: dangerous!
@@ -58,6 +59,7 @@ namespace EveryRay_Core
 		ER_CameraFPS* mCamera = nullptr;
 		ER_Editor* mEditor = nullptr;
 		ER_QuadRenderer* mQuadRenderer = nullptr;
+		ER_TextureStreamer* mTextureStreamer = nullptr;
 
 		ER_RHI_Viewport mMainViewport;
 
@@ -65,7 +67,7 @@ namespace EveryRay_Core
 		std::chrono::duration<double> mElapsedTimeRenderCPU;
 
 		std::map<std::wstring, ER_RHI_GPUTexture*> mRenderingObjectsTextureCache; // all physical textures (on disk) from ER_RenderingObjects in the level
-		std::map<std::string, ER_Model> mRenderingObjects3DModelsCache; // all 3D models from ER_RenderingObjects in the level (not wstring due to assimp)
+		std::map<std::string, std::unique_ptr<ER_Model>> mRenderingObjects3DModelsCache; // all 3D models from ER_RenderingObjects in the level (not wstring due to assimp)
 
 		std::map<std::string, std::string> mScenesPaths;
 		std::vector<std::string> mScenesNamesByIndices;
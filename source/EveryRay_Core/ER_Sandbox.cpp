@@ -18,12 +18,15 @@
 #include "ER_Terrain.h"
 #include "ER_FoliageManager.h"
 #include "ER_Scene.h"
+#include "ER_InstanceBufferPool.h"
 #include "ER_VolumetricClouds.h"
 #include "ER_VolumetricFog.h"
 #include "ER_Wind.h"
 #include "ER_Illumination.h"
 #include "ER_LightProbesManager.h"
 #include "ER_GPUCuller.h"
+#include "ER_SoftwareOcclusionCuller.h"
+#include "ER_RenderGraph.h"
 
 #include "RHI/ER_RHI.h"
 
@@ -57,6 +60,8 @@ namespace EveryRay_Core {
 		DeleteObject(mTerrain);
 		DeleteObject(mWind);
 		DeleteObject(mGPUCuller);
+		DeleteObject(mSoftwareOcclusionCuller);
+		DeleteObject(mRenderGraph);
 		DeletePointerCollection(mPointLights);
 
 		game.CPUProfiler()->EndCPUTime("Destroying scene: " + mName);
@@ -73,7 +78,7 @@ namespace EveryRay_Core {
 		rhi->SetGPUDescriptorHeap(ER_RHI_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, true);
 
 		#pragma region INIT_CONTROLS
-        mKeyboard = (ER_Keyboard*)game.GetServices().FindService(ER_Keyboard::TypeIdClass());
+        mKeyboard = game.GetServices().FindService<ER_Keyboard>();
         assert(mKeyboard);
 #pragma endregion
 
@@ -85,13 +90,13 @@ namespace EveryRay_Core {
 #pragma endregion
 
 		#pragma region INIT_EDITOR
-		mEditor = (ER_Editor*)game.GetServices().FindService(ER_Editor::TypeIdClass());
+		mEditor = game.GetServices().FindService<ER_Editor>();
 		assert(mEditor);
 		mEditor->Initialize(mScene);
 #pragma endregion
 
 		#pragma region INIT_QUAD_RENDERER
-		mQuadRenderer = (ER_QuadRenderer*)game.GetServices().FindService(ER_QuadRenderer::TypeIdClass());
+		mQuadRenderer = game.GetServices().FindService<ER_QuadRenderer>();
 		assert(mQuadRenderer);
 		mQuadRenderer->Init();
 #pragma endregion
@@ -221,6 +226,8 @@ namespace EveryRay_Core {
 		game.CPUProfiler()->BeginCPUTime("GPU Culler init");
 		mGPUCuller = new ER_GPUCuller(game, camera);
 		mGPUCuller->Initialize();
+
+		mSoftwareOcclusionCuller = new ER_SoftwareOcclusionCuller();
 		game.CPUProfiler()->EndCPUTime("GPU Culler init");
 #pragma endregion
 
@@ -233,21 +240,25 @@ namespace EveryRay_Core {
 		materialSystems.mProbesManager = mLightProbesManager;
 		materialSystems.mIllumination = mIllumination;
 
-		for (auto& object : mScene->objects) 
+		auto addMaterialCallbacks = [this, materialSystems](ER_RenderingObject* aObject)
 		{
-			for (auto& layeredMaterial : object.second->GetMaterials())
+			for (auto& layeredMaterial : aObject->GetMaterials())
 			{
 				// assign prepare callbacks to standard materials (non-standard ones are processed from their own systems)
 				if (layeredMaterial.second->IsStandard())
 				{
-					object.second->MeshMaterialVariablesUpdateEvent->AddListener(layeredMaterial.first,
-						[&, matSystems = materialSystems](int meshIndex, int lodIndex) { 
-							layeredMaterial.second->PrepareResourcesForStandardMaterial(matSystems, object.second, meshIndex, mScene->GetStandardMaterialRootSignature(layeredMaterial.first));
+					// materials are captured by value (the list of materials is not guaranteed to keep its elements in place)
+					aObject->MeshMaterialVariablesUpdateEvent->AddListener(layeredMaterial.first,
+						[this, matSystems = materialSystems, material = layeredMaterial.second, materialName = layeredMaterial.first, renderingObject = aObject](int meshIndex, int lodIndex) { 
+							material->PrepareResourcesForStandardMaterial(matSystems, renderingObject, meshIndex, mScene->GetStandardMaterialRootSignature(materialName));
 						}
 					);
 				}
 			}
-		}
+		};
+		for (auto& object : mScene->objects)
+			addMaterialCallbacks(object.second);
+		mScene->RenderingObjectStreamedInEvent->AddListener("Material callbacks", addMaterialCallbacks);
 		game.CPUProfiler()->EndCPUTime("Material callbacks init");
 #pragma endregion
 
@@ -260,14 +271,17 @@ namespace EveryRay_Core {
 
 		if (mTerrain)
 		{
-			for (auto listener : mTerrain->ReadbackPlacedPositionsOnInitEvent->GetListeners())
-				listener(mTerrain);
+			mTerrain->ReadbackPlacedPositionsOnInitEvent->Invoke(mTerrain);
 			mTerrain->ReadbackPlacedPositionsOnInitEvent->RemoveAllListeners();
 		}
+
+		SetupRenderGraph(game);
     }
 
 	void ER_Sandbox::Update(ER_Core& game, const ER_CoreTime& gameTime)
 	{
+		mScene->UpdateStreaming(game.GetServices().FindService<ER_Camera>()->Position());
+
 		mSkybox->Update(gameTime);
 		mSkybox->UpdateSun(gameTime);
 
@@ -294,19 +308,35 @@ namespace EveryRay_Core {
 
 		// TODO: consider moving all debug gizmos to a separate debug renderer system
 		mWind->UpdateProxyModel(gameTime,
-			((ER_Camera*)game.GetServices().FindService(ER_Camera::TypeIdClass()))->ViewMatrix4X4(),
-			((ER_Camera*)game.GetServices().FindService(ER_Camera::TypeIdClass()))->ProjectionMatrix4X4());
+			game.GetServices().FindService<ER_Camera>()->ViewMatrix4X4(),
+			game.GetServices().FindService<ER_Camera>()->ProjectionMatrix4X4());
 		// TODO: consider moving all debug gizmos to a separate debug renderer system
 		mDirectionalLight->UpdateProxyModel(gameTime, 
-			((ER_Camera*)game.GetServices().FindService(ER_Camera::TypeIdClass()))->ViewMatrix4X4(),
-			((ER_Camera*)game.GetServices().FindService(ER_Camera::TypeIdClass()))->ProjectionMatrix4X4());
+			game.GetServices().FindService<ER_Camera>()->ViewMatrix4X4(),
+			game.GetServices().FindService<ER_Camera>()->ProjectionMatrix4X4());
 		
 		for (auto& pointLight : mPointLights)
 			pointLight->Update(gameTime);
 
+		// occluders have to be rasterized before the objects are culled (in their updates)
+		if (ER_Utility::IsMainCameraCPUCulling && ER_Utility::IsMainCameraCPUOcclusionCulling)
+		{
+			mSoftwareOcclusionCuller->BeginFrame(game.GetServices().FindService<ER_Camera>()->ViewProjectionMatrix());
+			for (auto& object : mScene->objects)
+				object.second->AddToOcclusionCuller(mSoftwareOcclusionCuller);
+			mSoftwareOcclusionCuller->Rasterize();
+		}
+		else
+			mSoftwareOcclusionCuller->Invalidate();
+
 		for (auto& object : mScene->objects)
 			object.second->Update(gameTime);
 
+		mGPUCuller->UpdateBatch(mScene);
+
+		// instances of all objects (updated above) are uploaded at once
+		mScene->GetInstanceBufferPool()->Flush();
+
         UpdateImGui();
 	}
 
@@ -342,56 +372,119 @@ namespace EveryRay_Core {
 	{
 		ER_RHI* rhi = game.GetRHI();
 		rhi->SetTopologyType(ER_RHI_PRIMITIVE_TYPE::ER_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-		
-		#pragma region GPU_CULLING
-		rhi->BeginEventTag("EveryRay: GPU Culling");
-		mGPUCuller->PerformCull(mScene);
-		rhi->EndEventTag();
-#pragma endregion
 
-		#pragma region DRAW_GBUFFER
-		rhi->BeginEventTag("EveryRay: GBuffer");
-		{
-			mGBuffer->Start();
+		mFrameTime = &gameTime;
+		mRenderGraph->Execute(rhi);
+		mFrameTime = nullptr;
+	}
 
-			rhi->BeginEventTag("EveryRay: GBuffer (objects)");
-			mGBuffer->Draw(mScene);
-			rhi->EndEventTag();
+	// Order, culling and transitions of the passes are derived by the graph from the declared reads/writes.
+	// Data that lives inside of the systems (culled instance buffers, voxel cascades, etc.) is declared with virtual resources.
+	void ER_Sandbox::SetupRenderGraph(ER_Core& game)
+	{
+		mRenderGraph = new ER_RenderGraph();
+		ER_RenderGraph& graph = *mRenderGraph;
+		graph.SetAsyncComputeEnabled(game.GetRHI()->IsAsyncComputeSupported());
 
-			rhi->BeginEventTag("EveryRay: GBuffer (terrain)");
-			if (mTerrain)
+		const ER_RenderGraphResourceHandle gbufferRTs[] =
+		{
+			graph.ImportResource("GBuffer Albedo", mGBuffer->GetAlbedo()),
+			graph.ImportResource("GBuffer Normals", mGBuffer->GetNormals()),
+			graph.ImportResource("GBuffer Positions", mGBuffer->GetPositions()),
+			graph.ImportResource("GBuffer Extra", mGBuffer->GetExtraBuffer()),
+			graph.ImportResource("GBuffer Extra2", mGBuffer->GetExtra2Buffer())
+		};
+		const ER_RenderGraphResourceHandle gbufferDepth = graph.ImportResource("GBuffer Depth", mGBuffer->GetDepth());
+		ER_RenderGraphResourceHandle shadowMaps[NUM_SHADOW_CASCADES];
+		for (int i = 0; i < NUM_SHADOW_CASCADES; i++)
+			shadowMaps[i] = graph.ImportResource("Shadow Map #" + std::to_string(i), mShadowMapper->GetShadowTexture(i));
+		const ER_RenderGraphResourceHandle localIlluminationRT = graph.ImportResource("Local Illumination RT", mIllumination->GetLocalIlluminationRT());
+		const ER_RenderGraphResourceHandle finalIlluminationRT = graph.ImportResource("Final Illumination RT", mIllumination->GetFinalIlluminationRT());
+
+		const ER_RenderGraphResourceHandle culledInstances = graph.CreateVirtualResource("Culled Instances");
+		const ER_RenderGraphResourceHandle lightProbes = graph.CreateVirtualResource("Light Probes");
+		const ER_RenderGraphResourceHandle voxelCascades = graph.CreateVirtualResource("Voxel Cascades");
+		const ER_RenderGraphResourceHandle dynamicGI = graph.CreateVirtualResource("Dynamic GI");
+		const ER_RenderGraphResourceHandle volumetricFog = graph.CreateVirtualResource("Volumetric Fog");
+		const ER_RenderGraphResourceHandle volumetricCloudsSky = graph.CreateVirtualResource("Volumetric Clouds Sky");
+		const ER_RenderGraphResourceHandle volumetricClouds = graph.CreateVirtualResource("Volumetric Clouds");
+		const ER_RenderGraphResourceHandle backBuffer = graph.CreateVirtualResource("Back Buffer", true);
+
+		ER_RenderGraphTextureDesc coneTracingDesc;
+		coneTracingDesc.Width = static_cast<UINT>(static_cast<float>(game.ScreenWidth()) * mIllumination->GetVCTDownscaleFactor());
+		coneTracingDesc.Height = static_cast<UINT>(static_cast<float>(game.ScreenHeight()) * mIllumination->GetVCTDownscaleFactor());
+		coneTracingDesc.Format = ER_FORMAT_R8G8B8A8_UNORM;
+		coneTracingDesc.BindFlags = ER_BIND_SHADER_RESOURCE | ER_BIND_UNORDERED_ACCESS;
+		const ER_RenderGraphResourceHandle coneTracingRT = graph.CreateTexture("VCT Cone Tracing RT", coneTracingDesc);
+
+		graph.AddPass("GPU Culling",
+			[&](ER_RenderGraphPassBuilder& builder)
 			{
-				mTerrain->Draw(TerrainRenderPass::TERRAIN_GBUFFER,
-					{ mGBuffer->GetAlbedo(), mGBuffer->GetNormals(), mGBuffer->GetPositions(), mGBuffer->GetExtraBuffer(), mGBuffer->GetExtra2Buffer() }, mGBuffer->GetDepth());
-			}
-			rhi->EndEventTag();
+				builder.Read(gbufferDepth, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE); // previous frame's (for Hi-Z)
+				builder.Write(culledInstances);
+				builder.SetAsyncCompute();
+			},
+			[this](ER_RHI* rhi, ER_RenderGraph&)
+			{
+				mGPUCuller->PerformCull(mScene, mGBuffer->GetDepth());
+			});
 
-			rhi->BeginEventTag("EveryRay: GBuffer (foliage)");
-			if (mFoliageSystem)
+		graph.AddPass("GBuffer",
+			[&](ER_RenderGraphPassBuilder& builder)
 			{
-				mFoliageSystem->Draw(gameTime, nullptr, FoliageRenderingPass::FOLIAGE_GBUFFER,
-					{ mGBuffer->GetAlbedo(), mGBuffer->GetNormals(), mGBuffer->GetPositions(), mGBuffer->GetExtraBuffer(), mGBuffer->GetExtra2Buffer() }, mGBuffer->GetDepth());
-			}
-			rhi->EndEventTag();
+				builder.Read(culledInstances);
+				for (ER_RenderGraphResourceHandle rt : gbufferRTs)
+					builder.Write(rt, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_RENDER_TARGET);
+				builder.Write(gbufferDepth, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_DEPTH_WRITE);
+			},
+			[this](ER_RHI* rhi, ER_RenderGraph&)
+			{
+				mGBuffer->Start();
 
-			mGBuffer->End();
-		}
-		rhi->EndEventTag();
-#pragma endregion
-		
-		#pragma region DRAW_SHADOWS
-		rhi->BeginEventTag("EveryRay: Shadow Maps");
-		{
-			mShadowMapper->Draw(mScene, mTerrain);
-		}
-		rhi->EndEventTag();
-#pragma endregion
-		
-		#pragma region DRAW_GLOBAL_ILLUMINATION
-		rhi->BeginEventTag("EveryRay: Compute/load light probes");
-		{
-			// compute static GI (load probes if they exist on disk, otherwise - compute and save them)
+				rhi->BeginEventTag("EveryRay: GBuffer (objects)");
+				mGBuffer->Draw(mScene);
+				rhi->EndEventTag();
+
+				rhi->BeginEventTag("EveryRay: GBuffer (terrain)");
+				if (mTerrain)
+				{
+					mTerrain->Draw(TerrainRenderPass::TERRAIN_GBUFFER,
+						{ mGBuffer->GetAlbedo(), mGBuffer->GetNormals(), mGBuffer->GetPositions(), mGBuffer->GetExtraBuffer(), mGBuffer->GetExtra2Buffer() }, mGBuffer->GetDepth());
+				}
+				rhi->EndEventTag();
+
+				rhi->BeginEventTag("EveryRay: GBuffer (foliage)");
+				if (mFoliageSystem)
+				{
+					mFoliageSystem->Draw(*mFrameTime, nullptr, FoliageRenderingPass::FOLIAGE_GBUFFER,
+						{ mGBuffer->GetAlbedo(), mGBuffer->GetNormals(), mGBuffer->GetPositions(), mGBuffer->GetExtraBuffer(), mGBuffer->GetExtra2Buffer() }, mGBuffer->GetDepth());
+				}
+				rhi->EndEventTag();
+
+				mGBuffer->End();
+			});
+
+		graph.AddPass("Shadow Maps",
+			[&](ER_RenderGraphPassBuilder& builder)
 			{
+				builder.Read(culledInstances);
+				for (ER_RenderGraphResourceHandle shadowMap : shadowMaps)
+					builder.Write(shadowMap, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_DEPTH_WRITE);
+			},
+			[this](ER_RHI* rhi, ER_RenderGraph&)
+			{
+				mShadowMapper->Draw(mScene, mTerrain);
+			});
+
+		graph.AddPass("Compute/load light probes",
+			[&](ER_RenderGraphPassBuilder& builder)
+			{
+				builder.Write(lightProbes);
+				builder.SetHasSideEffects(); // probes are saved to disk
+			},
+			[this, &game](ER_RHI* rhi, ER_RenderGraph&)
+			{
+				// compute static GI (load probes if they exist on disk, otherwise - compute and save them)
 				if (mLightProbesManager->IsEnabled() && !mLightProbesManager->AreProbesReady())
 				{
 					game.CPUProfiler()->BeginCPUTime("Compute or load light probes");
@@ -401,42 +494,84 @@ namespace EveryRay_Core {
 				}
 				else if (!mLightProbesManager->IsEnabled() && !mLightProbesManager->AreGlobalProbesReady())
 					mLightProbesManager->ComputeOrLoadGlobalProbes(game, mScene->objects, mSkybox);
-			}
-		}
-		rhi->EndEventTag();
+			});
 
-		// compute dynamic GI
-		rhi->BeginEventTag("EveryRay: Dynamic Global Illumination");
-		{
-			mIllumination->DrawDynamicGlobalIllumination(mGBuffer, gameTime);
-		}
-		rhi->EndEventTag();
-#pragma endregion
+		graph.AddPass("Dynamic Global Illumination (voxelization)",
+			[&](ER_RenderGraphPassBuilder& builder)
+			{
+				for (ER_RenderGraphResourceHandle shadowMap : shadowMaps)
+					builder.Read(shadowMap, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+				builder.Read(culledInstances);
+				builder.Write(voxelCascades);
+			},
+			[this](ER_RHI* rhi, ER_RenderGraph&)
+			{
+				mIllumination->DrawDynamicGlobalIlluminationVoxelization(*mFrameTime);
+			});
 
-		#pragma region DRAW_LOCAL_ILLUMINATION
-		rhi->BeginEventTag("EveryRay: Local Illumination");
-		{
-			mIllumination->DrawLocalIllumination(mGBuffer, mSkybox);
-			ER_RHI_GPUTexture* localRT = mIllumination->GetLocalIlluminationRT();
-
-			//Terrain rendering is now in deferred; uncomment code below if you want to render in forward
-			// rhi->BeginEventTag("EveryRay: Forward Lighting (terrain)");
-			// 
-			//#pragma region DRAW_TERRAIN_FORWARD
-			//if (mTerrain)
-			//	mTerrain->Draw(TerrainRenderPass::FORWARD, localRT, mShadowMapper, mLightProbesManager);
-			// rhi->EndEventTag();
-			//#pragma endregion
-		}
-		rhi->EndEventTag();
-#pragma endregion
+		graph.AddPass("Dynamic Global Illumination (cone tracing)",
+			[&](ER_RenderGraphPassBuilder& builder)
+			{
+				for (ER_RenderGraphResourceHandle rt : gbufferRTs)
+					builder.Read(rt, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+				builder.Read(voxelCascades);
+				builder.Write(coneTracingRT, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_UNORDERED_ACCESS);
+				builder.SetAsyncCompute();
+			},
+			[this, coneTracingRT](ER_RHI* rhi, ER_RenderGraph& aGraph)
+			{
+				mIllumination->DrawDynamicGlobalIlluminationConeTracing(mGBuffer, aGraph.GetTexture(coneTracingRT));
+			});
+
+		graph.AddPass("Dynamic Global Illumination (upsample and blur)",
+			[&](ER_RenderGraphPassBuilder& builder)
+			{
+				builder.Read(coneTracingRT, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+				builder.Write(dynamicGI);
+				builder.SetAsyncCompute();
+			},
+			[this, coneTracingRT](ER_RHI* rhi, ER_RenderGraph& aGraph)
+			{
+				mIllumination->UpsampleDynamicGlobalIllumination(aGraph.GetTexture(coneTracingRT));
+			});
+
+		graph.AddPass("Local Illumination",
+			[&](ER_RenderGraphPassBuilder& builder)
+			{
+				for (ER_RenderGraphResourceHandle rt : gbufferRTs)
+					builder.Read(rt, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+				builder.Read(gbufferDepth, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+				for (ER_RenderGraphResourceHandle shadowMap : shadowMaps)
+					builder.Read(shadowMap, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+				builder.Read(lightProbes);
+				builder.Write(localIlluminationRT, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_UNORDERED_ACCESS);
+			},
+			[this](ER_RHI* rhi, ER_RenderGraph&)
+			{
+				mIllumination->DrawLocalIllumination(mGBuffer, mSkybox);
+
+				//Terrain rendering is now in deferred; uncomment code below if you want to render in forward
+				// rhi->BeginEventTag("EveryRay: Forward Lighting (terrain)");
+				// 
+				//#pragma region DRAW_TERRAIN_FORWARD
+				//if (mTerrain)
+				//	mTerrain->Draw(TerrainRenderPass::FORWARD, mIllumination->GetLocalIlluminationRT(), mShadowMapper, mLightProbesManager);
+				// rhi->EndEventTag();
+				//#pragma endregion
+			});
 
-		#pragma region DRAW_DEBUG_GIZMOS
 		// TODO: consider moving all debug gizmos to a separate debug renderer system
-		if (ER_Utility::IsEditorMode)
-		{
-			rhi->BeginEventTag("EveryRay: Debug gizmos");
+		graph.AddPass("Debug gizmos",
+			[&](ER_RenderGraphPassBuilder& builder)
+			{
+				builder.ReadWrite(localIlluminationRT, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_RENDER_TARGET);
+				builder.Read(gbufferDepth, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_DEPTH_WRITE);
+			},
+			[this](ER_RHI* rhi, ER_RenderGraph&)
 			{
+				if (!ER_Utility::IsEditorMode)
+					return;
+
 				ER_RHI_GPUTexture* localRT = mIllumination->GetLocalIlluminationRT();
 
 				mIllumination->DrawDebugProbes(localRT, mGBuffer->GetDepth());
@@ -446,8 +581,8 @@ namespace EveryRay_Core {
 				rhi->SetRootSignature(debugGizmoRootSignature);
 				{
 					mIllumination->DrawDebugGizmos(localRT, mGBuffer->GetDepth(), debugGizmoRootSignature);
-					mDirectionalLight->DrawProxyModel(localRT, mGBuffer->GetDepth(), gameTime, debugGizmoRootSignature);
-					mWind->DrawProxyModel(localRT, mGBuffer->GetDepth(), gameTime, debugGizmoRootSignature);
+					mDirectionalLight->DrawProxyModel(localRT, mGBuffer->GetDepth(), *mFrameTime, debugGizmoRootSignature);
+					mWind->DrawProxyModel(localRT, mGBuffer->GetDepth(), *mFrameTime, debugGizmoRootSignature);
 					if (mTerrain)
 						mTerrain->DrawDebugGizmos(localRT, mGBuffer->GetDepth(), debugGizmoRootSignature);
 					if (mFoliageSystem)
@@ -458,59 +593,101 @@ namespace EveryRay_Core {
 						it->second->DrawAABB(localRT, mGBuffer->GetDepth(), debugGizmoRootSignature);
 				}
 				rhi->SetTopologyType(ER_RHI_PRIMITIVE_TYPE::ER_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-			}
-			rhi->EndEventTag();
-		}
-#pragma endregion
-		
-		#pragma region DRAW_COMPOSITE
+			});
+
 		// combine the results of local and global illumination
-		rhi->BeginEventTag("EveryRay: Composite Illumination");
-		{
-			mIllumination->CompositeTotalIllumination(mGBuffer);
-		}
-		rhi->EndEventTag();
-#pragma endregion
-		
-		#pragma region DRAW_VOLUMETRIC_FOG
-		rhi->BeginEventTag("EveryRay: Volumetric Fog");
-		{
-			mVolumetricFog->Draw();
-		}
-		rhi->EndEventTag();
-#pragma endregion
+		graph.AddPass("Composite Illumination",
+			[&](ER_RenderGraphPassBuilder& builder)
+			{
+				builder.Read(localIlluminationRT, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+				builder.Read(dynamicGI);
+				builder.Write(finalIlluminationRT, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_UNORDERED_ACCESS);
+			},
+			[this](ER_RHI* rhi, ER_RenderGraph&)
+			{
+				mIllumination->CompositeTotalIllumination(mGBuffer);
+			});
 
-		#pragma region DRAW_VOLUMETRIC_CLOUDS
-		rhi->BeginEventTag("EveryRay: Volumetric Clouds");
-		{
-			mVolumetricClouds->Draw(gameTime);
-		}
-		rhi->EndEventTag();
-#pragma endregion	
+		graph.AddPass("Volumetric Fog",
+			[&](ER_RenderGraphPassBuilder& builder)
+			{
+				builder.Read(gbufferDepth, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+				for (ER_RenderGraphResourceHandle shadowMap : shadowMaps)
+					builder.Read(shadowMap, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+				builder.Write(volumetricFog);
+				builder.SetAsyncCompute();
+			},
+			[this](ER_RHI* rhi, ER_RenderGraph&)
+			{
+				mVolumetricFog->Draw();
+			});
 
-		#pragma region DRAW_POSTPROCESSING
-		rhi->BeginEventTag("EveryRay: Post Processing");
-		{
-			auto quad = (ER_QuadRenderer*)game.GetServices().FindService(ER_QuadRenderer::TypeIdClass());
-			mPostProcessingStack->Begin(mIllumination->GetFinalIlluminationRT(), mGBuffer->GetDepth());
-			mPostProcessingStack->DrawEffects(gameTime, quad, mGBuffer, mVolumetricClouds, mVolumetricFog);
-			mPostProcessingStack->End();
-		}
-		rhi->EndEventTag();
-#pragma endregion
+		graph.AddPass("Volumetric Clouds (sky)",
+			[&](ER_RenderGraphPassBuilder& builder)
+			{
+				builder.Read(gbufferDepth, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+				builder.Write(volumetricCloudsSky);
+			},
+			[this](ER_RHI* rhi, ER_RenderGraph&)
+			{
+				mVolumetricClouds->DrawSky(*mFrameTime);
+			});
 
-		// reset back to main RT before UI rendering
-		rhi->SetMainRenderTargets();
+		graph.AddPass("Volumetric Clouds",
+			[&](ER_RenderGraphPassBuilder& builder)
+			{
+				builder.Read(gbufferDepth, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+				builder.Read(volumetricCloudsSky);
+				builder.Write(volumetricClouds);
+				builder.SetAsyncCompute();
+			},
+			[this](ER_RHI* rhi, ER_RenderGraph&)
+			{
+				mVolumetricClouds->DrawClouds(*mFrameTime);
+			});
 
-		#pragma region DRAW_IMGUI
-		rhi->BeginEventTag("EveryRay: ImGui");
-		{
-			rhi->SetGPUDescriptorHeapImGui(rhi->GetCurrentGraphicsCommandListIndex());
+		graph.AddPass("Post Processing",
+			[&](ER_RenderGraphPassBuilder& builder)
+			{
+				builder.Read(finalIlluminationRT, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+				for (ER_RenderGraphResourceHandle rt : gbufferRTs)
+					builder.Read(rt, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+				builder.Read(gbufferDepth, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+				builder.Read(volumetricFog);
+				builder.Read(volumetricClouds);
+				builder.Write(backBuffer);
+			},
+			[this, &game](ER_RHI* rhi, ER_RenderGraph&)
+			{
+				auto quad = game.GetServices().FindService<ER_QuadRenderer>();
+				mPostProcessingStack->Begin(mIllumination->GetFinalIlluminationRT(), mGBuffer->GetDepth());
+				mPostProcessingStack->DrawEffects(*mFrameTime, quad, mGBuffer, mVolumetricClouds, mVolumetricFog);
+				mPostProcessingStack->End();
+			});
+
+		graph.AddPass("ImGui",
+			[&](ER_RenderGraphPassBuilder& builder)
+			{
+				builder.ReadWrite(backBuffer);
+				builder.SetHasSideEffects();
+			},
+			[](ER_RHI* rhi, ER_RenderGraph&)
+			{
+				// reset back to main RT before UI rendering
+				rhi->SetMainRenderTargets();
 
-			ImGui::Render();
-			rhi->RenderDrawDataImGui();
-		}
-		rhi->EndEventTag();
-#pragma endregion
+				rhi->SetGPUDescriptorHeapImGui(rhi->GetCurrentGraphicsCommandListIndex());
+
+				ImGui::Render();
+				rhi->RenderDrawDataImGui();
+			});
+
+		if (!graph.Compile())
+			throw ER_CoreException("ER_Sandbox: Failed to compile the render graph!");
+
+		std::string message = "[ER Logger][ER_Sandbox] Render graph compiled: " + std::to_string(graph.GetPassesCount() - graph.GetCulledPassesCount()) + " passes (" +
+			std::to_string(graph.GetCulledPassesCount()) + " culled, " + std::to_string(graph.GetAsyncComputePassesCount()) + " async compute), " +
+			std::to_string(graph.GetTransitionsCount()) + " batched transitions\n";
+		ER_OUTPUT_LOG(ER_Utility::ToWideString(message).c_str());
 	}
 }
@@ -24,6 +24,8 @@ namespace EveryRay_Core
     class ER_PostProcessingStack;
     class ER_QuadRenderer;
     class ER_GPUCuller;
+    class ER_SoftwareOcclusionCuller;
+    class ER_RenderGraph;
 
 	class ER_Sandbox
 	{
@@ -53,12 +55,16 @@ namespace EveryRay_Core
         ER_PostProcessingStack* mPostProcessingStack = nullptr;
         ER_QuadRenderer* mQuadRenderer = nullptr;
         ER_GPUCuller* mGPUCuller = nullptr;
+        ER_SoftwareOcclusionCuller* mSoftwareOcclusionCuller = nullptr;
+        ER_RenderGraph* mRenderGraph = nullptr;
 
         std::vector<ER_PointLight*> mPointLights;
     private:
         void UpdateImGui();
+        void SetupRenderGraph(ER_Core& game);
 
         std::string mName;
+        const ER_CoreTime* mFrameTime = nullptr; // only valid while the render graph is executed
 	};
 
 }
@@ -11,6 +11,7 @@
 #include "ER_Model.h"
 #include "ER_Materials.inl"
 #include "ER_RenderingObject.h"
+#include "ER_InstanceBufferPool.h"
 #include "ER_MaterialHelper.h"
 #include "ER_Illumination.h"
 #include "ER_LightProbesManager.h"
@@ -19,12 +20,15 @@
 #include "ER_PointLight.h"
 #include "ER_Terrain.h"
 #include "ER_PostProcessingStack.h"
+#include "ER_TextureStreamer.h"
+#include "ER_VertexDeclarations.h"
 
-#if defined(DEBUG) || defined(_DEBUG)  
-	#define MULTITHREADED_SCENE_LOAD 0
-#else
-	#define MULTITHREADED_SCENE_LOAD 1
-#endif
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <map>
+
+#define MULTITHREADED_SCENE_LOAD 1 // on all backends and builds (set to 0 to debug the loading on the main thread)
 
 namespace EveryRay_Core 
 {
@@ -32,8 +36,8 @@ namespace EveryRay_Core
 	int ER_Scene::GetValueFromSceneRoot(const std::string& aName)
 	{
 		int value = 0;
-		if (mSceneJsonRoot.isMember(aName.c_str()))
-			value = mSceneJsonRoot[aName.c_str()].asInt();
+		if (mSceneDescription.Root.isMember(aName.c_str()))
+			value = mSceneDescription.Root[aName.c_str()].asInt();
 		else
 			ShowNoValueFoundMessage(aName);
 
@@ -44,8 +48,8 @@ namespace EveryRay_Core
 	UINT ER_Scene::GetValueFromSceneRoot(const std::string& aName)
 	{
 		UINT value = 0;
-		if (mSceneJsonRoot.isMember(aName.c_str()))
-			value = mSceneJsonRoot[aName.c_str()].asUInt();
+		if (mSceneDescription.Root.isMember(aName.c_str()))
+			value = mSceneDescription.Root[aName.c_str()].asUInt();
 		else
 			ShowNoValueFoundMessage(aName);
 
@@ -56,8 +60,8 @@ namespace EveryRay_Core
 	bool ER_Scene::GetValueFromSceneRoot(const std::string& aName)
 	{
 		bool value = false;
-		if (mSceneJsonRoot.isMember(aName.c_str()))
-			value = mSceneJsonRoot[aName.c_str()].asBool();
+		if (mSceneDescription.Root.isMember(aName.c_str()))
+			value = mSceneDescription.Root[aName.c_str()].asBool();
 		else
 			ShowNoValueFoundMessage(aName);
 
@@ -68,8 +72,8 @@ namespace EveryRay_Core
 	float ER_Scene::GetValueFromSceneRoot(const std::string& aName)
 	{
 		float value = 0.0f;
-		if (mSceneJsonRoot.isMember(aName.c_str()))
-			value = mSceneJsonRoot[aName.c_str()].asFloat();
+		if (mSceneDescription.Root.isMember(aName.c_str()))
+			value = mSceneDescription.Root[aName.c_str()].asFloat();
 		else
 			ShowNoValueFoundMessage(aName);
 
@@ -80,11 +84,11 @@ namespace EveryRay_Core
 	XMFLOAT3 ER_Scene::GetValueFromSceneRoot(const std::string& aName)
 	{
 		XMFLOAT3 value = XMFLOAT3(0.0f, 0.0f, 0.0f);
-		if (mSceneJsonRoot.isMember(aName.c_str()))
+		if (mSceneDescription.Root.isMember(aName.c_str()))
 		{
 			float vec3[3] = { 0.0, 0.0, 0.0 };
-			for (Json::Value::ArrayIndex i = 0; i != mSceneJsonRoot[aName.c_str()].size(); i++)
-				vec3[i] = mSceneJsonRoot[aName.c_str()][i].asFloat();
+			for (Json::Value::ArrayIndex i = 0; i != mSceneDescription.Root[aName.c_str()].size(); i++)
+				vec3[i] = mSceneDescription.Root[aName.c_str()][i].asFloat();
 
 			value = XMFLOAT3(vec3[0], vec3[1], vec3[2]);
 		}
@@ -98,11 +102,11 @@ namespace EveryRay_Core
 	XMFLOAT4 ER_Scene::GetValueFromSceneRoot(const std::string& aName)
 	{
 		XMFLOAT4 value = XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f);
-		if (mSceneJsonRoot.isMember(aName.c_str()))
+		if (mSceneDescription.Root.isMember(aName.c_str()))
 		{
 			float vec4[4] = { 0.0, 0.0, 0.0, 0.0 };
-			for (Json::Value::ArrayIndex i = 0; i != mSceneJsonRoot[aName.c_str()].size(); i++)
-				vec4[i] = mSceneJsonRoot[aName.c_str()][i].asFloat();
+			for (Json::Value::ArrayIndex i = 0; i != mSceneDescription.Root[aName.c_str()].size(); i++)
+				vec4[i] = mSceneDescription.Root[aName.c_str()][i].asFloat();
 
 			value = XMFLOAT4(vec4[0], vec4[1], vec4[2], vec4[3]);
 		}
@@ -116,8 +120,8 @@ namespace EveryRay_Core
 	std::string ER_Scene::GetValueFromSceneRoot(const std::string& aName)
 	{
 		std::string value = "";
-		if (mSceneJsonRoot.isMember(aName.c_str()))
-			value = mSceneJsonRoot[aName.c_str()].asString();
+		if (mSceneDescription.Root.isMember(aName.c_str()))
+			value = mSceneDescription.Root[aName.c_str()].asString();
 		else
 			ShowNoValueFoundMessage(aName);
 
@@ -126,7 +130,192 @@ namespace EveryRay_Core
 
 	bool ER_Scene::IsValueInSceneRoot(const std::string& aName)
 	{
-		return mSceneJsonRoot.isMember(aName.c_str());
+		return mSceneDescription.Root.isMember(aName.c_str());
+	}
+
+	static Json::Value ToJsonArray(const XMFLOAT3& aValue)
+	{
+		Json::Value content(Json::arrayValue);
+		content.append(aValue.x);
+		content.append(aValue.y);
+		content.append(aValue.z);
+		return content;
+	}
+
+	// matrices are stored transposed in the scene file
+	static Json::Value ToJsonMatrix(const XMFLOAT4X4& aMatrix)
+	{
+		XMFLOAT4X4 mat;
+		XMStoreFloat4x4(&mat, XMMatrixTranspose(XMLoadFloat4x4(&aMatrix)));
+		float matF[16];
+		ER_MatrixHelper::SetFloatArray(mat, matF);
+
+		Json::Value content(Json::arrayValue);
+		for (int i = 0; i < 16; i++)
+			content.append(matF[i]);
+		return content;
+	}
+
+	// Every editable property of the object with the same names as the loader expects them (see LoadRenderingObjectData())
+	static void SerializeRenderingObjectProperties(ER_RenderingObject* aObject, Json::Value& outProperties)
+	{
+		outProperties = Json::Value(Json::objectValue);
+
+		outProperties["name"] = aObject->GetName();
+		outProperties["transform"] = ToJsonMatrix(aObject->GetTransformationMatrix4X4());
+
+		// flags
+		outProperties["foliageMask"] = aObject->GetIsMarkedAsFoliage();
+		outProperties["use_indirect_global_lightprobe"] = aObject->GetUseIndirectGlobalLightProbe();
+		outProperties["use_in_global_lightprobe_rendering"] = aObject->IsUsedForGlobalLightProbeRendering();
+		outProperties["use_parallax_occlusion_mapping"] = aObject->IsParallaxOcclusionMapping();
+		outProperties["use_forward_shading"] = aObject->IsForwardShading();
+		outProperties["use_reflection"] = aObject->IsReflective();
+		outProperties["use_sss"] = aObject->IsSeparableSubsurfaceScattering();
+		outProperties["use_custom_alpha_discard"] = aObject->GetCustomAlphaDiscard();
+		outProperties["use_transparency"] = aObject->IsTransparent();
+		outProperties["use_as_occluder"] = aObject->IsOccluder();
+		outProperties["use_gpu_indirect_rendering"] = aObject->IsGPUIndirectlyRendered();
+		outProperties["skip_indirect_specular"] = aObject->IsSkippedIndirectSpecular();
+		outProperties["index_of_refraction"] = aObject->GetIOR();
+		outProperties["custom_roughness"] = aObject->GetCustomRoughness();
+		outProperties["custom_metalness"] = aObject->GetCustomMetalness();
+		outProperties["use_triplanar_mapping"] = aObject->IsTriplanarMapped();
+
+		Json::Value reflectionFactors(Json::arrayValue);
+		for (int meshIndex = 0; meshIndex < aObject->GetMeshCount(); meshIndex++)
+			reflectionFactors.append(aObject->GetMeshReflectionFactor(meshIndex));
+		outProperties["reflection_factors"] = reflectionFactors;
+
+		outProperties["fresnel_outline_color"] = ToJsonArray(aObject->GetFresnelOutlineColor());
+
+		//fur
+		outProperties["fur_layers_count"] = aObject->GetFurLayersCount();
+		outProperties["fur_color"] = ToJsonArray(aObject->GetFurColor());
+		outProperties["fur_color_interpolation"] = aObject->GetFurColorInterpolation();
+		outProperties["fur_length"] = aObject->GetFurLength();
+		outProperties["fur_cutoff"] = aObject->GetFurCutoff();
+		outProperties["fur_cutoff_end"] = aObject->GetFurCutoffEnd();
+		outProperties["fur_wind_frequency"] = aObject->GetFurWindFrequency();
+		outProperties["fur_gravity_strength"] = aObject->GetFurGravityStrength().w;
+		outProperties["fur_uv_scale"] = aObject->GetFurUVScale();
+
+		//terrain (the loader only reads the placement settings of objects placed on terrain)
+		outProperties["terrain_placement"] = aObject->GetTerrainPlacement();
+		if (aObject->GetTerrainPlacement())
+		{
+			outProperties["terrain_splat_channel"] = aObject->GetTerrainProceduralPlacementSplatChannel();
+			outProperties["terrain_height_delta"] = aObject->GetTerrainProceduralPlacementHeightDelta();
+
+			const XMFLOAT2 scale = aObject->GetTerrainProceduralObjectsMinMaxScale();
+			outProperties["terrain_procedural_instance_scale_min"] = scale.x;
+			outProperties["terrain_procedural_instance_scale_max"] = scale.y;
+			const XMFLOAT2 pitch = aObject->GetTerrainProceduralObjectsMinMaxPitch();
+			outProperties["terrain_procedural_instance_pitch_min"] = pitch.x;
+			outProperties["terrain_procedural_instance_pitch_max"] = pitch.y;
+			const XMFLOAT2 roll = aObject->GetTerrainProceduralObjectsMinMaxRoll();
+			outProperties["terrain_procedural_instance_roll_min"] = roll.x;
+			outProperties["terrain_procedural_instance_roll_max"] = roll.y;
+			const XMFLOAT2 yaw = aObject->GetTerrainProceduralObjectsMinMaxYaw();
+			outProperties["terrain_procedural_instance_yaw_min"] = yaw.x;
+			outProperties["terrain_procedural_instance_yaw_max"] = yaw.y;
+
+			outProperties["terrain_procedural_zone_center_pos"] = ToJsonArray(aObject->GetTerrainProceduralZoneCenterPos());
+			if (aObject->IsInstanced())
+			{
+				outProperties["terrain_procedural_instance_count"] = aObject->GetTerrainProceduralInstanceCount();
+				outProperties["terrain_procedural_zone_radius"] = aObject->GetTerrainProceduralZoneRadius();
+			}
+		}
+
+		outProperties["min_scale"] = aObject->GetMinScale();
+		outProperties["max_scale"] = aObject->GetMaxScale();
+	}
+
+	// Every editable property of the zone with the same names as the loader expects them (see LoadFoliageZonesData())
+	static void SerializeFoliageZoneProperties(ER_Foliage* aZone, Json::Value& outProperties)
+	{
+		outProperties = Json::Value(Json::objectValue);
+
+		outProperties["position"] = ToJsonArray(aZone->GetDistributionCenter());
+		outProperties["patch_count"] = aZone->GetPatchesCount();
+		outProperties["average_scale"] = aZone->GetScale();
+		outProperties["distribution_radius"] = aZone->GetDistributionRadius();
+		outProperties["type"] = static_cast<int>(aZone->GetType());
+		outProperties["placed_on_terrain"] = aZone->IsPlacedOnTerrain();
+		outProperties["placed_splat_channel"] = aZone->GetTerrainSplatChannel();
+		outProperties["placed_height_delta"] = aZone->GetPlacementHeightDelta();
+	}
+
+	// Writes the properties which differ from the saved ones into the json node (and updates the saved ones). Returns the number of written properties.
+	// Unchanged properties are never written: values and formatting of the scene file stay as they were (i.e., properties not in the file are not added).
+	static int WriteChangedProperties(const Json::Value& aProperties, Json::Value& aSavedProperties, Json::Value& aNode)
+	{
+		int changedCount = 0;
+		for (const std::string& name : aProperties.getMemberNames())
+		{
+			const Json::Value& value = aProperties[name];
+			if (aSavedProperties.isMember(name) && aSavedProperties[name] == value)
+				continue;
+
+			aNode[name] = value;
+			aSavedProperties[name] = value;
+			changedCount++;
+		}
+		return changedCount;
+	}
+
+	// Position of the object (or the center of its instances) from its json node, so it can be put into a streaming cell before it is loaded
+	static XMFLOAT3 GetObjectNodePosition(const Json::Value& aObjectRoot)
+	{
+		const Json::Value& instancesRoot = aObjectRoot["instances_transforms"];
+		if (aObjectRoot["instanced"].asBool() && instancesRoot.isArray() && instancesRoot.size() > 0)
+		{
+			XMFLOAT3 center = XMFLOAT3(0.0f, 0.0f, 0.0f);
+			int count = 0;
+			for (Json::Value::ArrayIndex instance = 0; instance != instancesRoot.size(); instance++)
+			{
+				// matrices are stored transposed: translation is in the last column
+				const Json::Value& transformRoot = instancesRoot[instance]["transform"];
+				if (transformRoot.size() != 16)
+					continue;
+
+				center.x += transformRoot[3].asFloat();
+				center.y += transformRoot[7].asFloat();
+				center.z += transformRoot[11].asFloat();
+				count++;
+			}
+
+			if (count > 0)
+				return XMFLOAT3(center.x / count, center.y / count, center.z / count);
+		}
+
+		const Json::Value& transformRoot = aObjectRoot["transform"];
+		if (transformRoot.size() == 16)
+			return XMFLOAT3(transformRoot[3].asFloat(), transformRoot[7].asFloat(), transformRoot[11].asFloat());
+
+		return XMFLOAT3(0.0f, 0.0f, 0.0f);
+	}
+
+	static float GetDistanceToStreamingCell(const XMFLOAT2& aMin, const XMFLOAT2& aMax, const XMFLOAT3& aPosition)
+	{
+		const float dx = std::max(std::max(aMin.x - aPosition.x, 0.0f), aPosition.x - aMax.x);
+		const float dz = std::max(std::max(aMin.y - aPosition.z, 0.0f), aPosition.z - aMax.y);
+		return sqrt(dx * dx + dz * dz);
+	}
+
+	// Geometry and instance data of the object (textures are budgeted by ER_TextureStreamer)
+	static UINT64 GetEstimatedStreamingSize(ER_RenderingObject* aObject)
+	{
+		UINT64 size = 0;
+		for (int lod = 0; lod < aObject->GetLODCount(); lod++)
+		{
+			size += static_cast<UINT64>(aObject->GetVertexCount(lod)) * (sizeof(VertexPositionTextureNormalTangent) + sizeof(VertexPosition));
+			for (int mesh = 0; mesh < aObject->GetMeshCount(lod); mesh++)
+				size += static_cast<UINT64>(aObject->GetIndexCount(lod, mesh)) * sizeof(UINT);
+		}
+		size += static_cast<UINT64>(aObject->GetInstanceCount()) * aObject->GetLODCount() * sizeof(InstancedData);
+		return size;
 	}
 
 	ER_Scene::ER_Scene(ER_Core& pCore, ER_Camera& pCamera, const std::string& path) :
@@ -139,11 +328,11 @@ namespace EveryRay_Core
 
 		CreateStandardMaterialsRootSignatures();
 
-		Json::Reader reader;
-		std::ifstream scene(path.c_str(), std::ifstream::binary);
+		mInstanceBufferPool = new ER_InstanceBufferPool(pCore, sizeof(InstancedData));
 
-		if (!reader.parse(scene, mSceneJsonRoot)) {
-			throw ER_CoreException(reader.getFormattedErrorMessages().c_str());
+		std::string parseErrors;
+		if (!mSceneDescription.LoadFromFile(path, parseErrors)) {
+			throw ER_CoreException(parseErrors.c_str());
 		}
 		else {
 
@@ -161,52 +350,78 @@ namespace EveryRay_Core
 					mCamera.SetNearPlaneDistance(GetValueFromSceneRoot<float>("camera_plane_near"));
 			}
 
-			// add rendering objects to scene
-			unsigned int numRenderingObjects = mSceneJsonRoot["rendering_objects"].size();
-			for (Json::Value::ArrayIndex i = 0; i != numRenderingObjects; i++) {
-				objects.emplace_back(
-					mSceneJsonRoot["rendering_objects"][i]["name"].asString(), 
-					new ER_RenderingObject(mSceneJsonRoot["rendering_objects"][i]["name"].asString(), i, *mCore, mCamera, 
-						ER_Utility::GetFilePath(mSceneJsonRoot["rendering_objects"][i]["model_path"].asString()),
-						true, mSceneJsonRoot["rendering_objects"][i]["instanced"].asBool())
-				);
-			}
-			std::partition(objects.begin(), objects.end(), [](const ER_SceneObject& obj) {	return obj.second->IsInstanced(); });
-			assert(numRenderingObjects == objects.size());
+			unsigned int numRenderingObjects = static_cast<unsigned int>(mSceneDescription.RenderingObjects.size());
 
-#if MULTITHREADED_SCENE_LOAD && !ER_PLATFORM_WIN64_DX12
-			int numThreads = std::thread::hardware_concurrency();
-#else
-			int numThreads = 1;
-#endif
-			int objectsPerThread = numRenderingObjects / numThreads;
-			if (objectsPerThread == 0)
+			// with level streaming, only the objects of the cells around the camera (and the objects that are not streamed) are loaded with the scene
+			std::vector<int> streamingCellsIndices(numRenderingObjects, -1);
+			InitStreamingCells(streamingCellsIndices);
+			auto isLoadedLater = [this, &streamingCellsIndices](Json::Value::ArrayIndex aIndex)
 			{
-				numThreads = 1;
-				objectsPerThread = numRenderingObjects;
-			}
+				return streamingCellsIndices[aIndex] >= 0 && mStreamingCells[streamingCellsIndices[aIndex]].State == STREAMING_CELL_UNLOADED;
+			};
 
-			std::vector<std::thread> threads;
-			threads.reserve(numThreads);
-
-			for (int i = 0; i < numThreads; i++)
+			// import the models (and their LODs) of all objects first, so objects (which are created on the main thread) only get them from the cache
 			{
-				threads.push_back(std::thread([&, numThreads, numRenderingObjects, objectsPerThread, i]
+				std::vector<std::string> modelPaths;
+				for (Json::Value::ArrayIndex i = 0; i != numRenderingObjects; i++)
 				{
-					int endRange = (i < numThreads - 1) ? (i + 1) * objectsPerThread : numRenderingObjects;
+					if (isLoadedLater(i))
+						continue;
 
-					for (int j = i * objectsPerThread; j < endRange; j++)
+					const Json::Value& objectRoot = mSceneDescription.GetRenderingObject(i);
+					modelPaths.push_back(ER_Utility::GetFilePath(objectRoot["model_path"].asString()));
+					if (objectRoot.isMember("model_lods"))
 					{
-						auto objectI = objects.begin();
-						std::advance(objectI, j);
-						LoadRenderingObjectData(objectI->second);
+						for (Json::Value::ArrayIndex lod = 1 /* 0 is the main model */; lod < objectRoot["model_lods"].size(); lod++)
+							modelPaths.push_back(ER_Utility::GetFilePath(objectRoot["model_lods"][lod]["path"].asString()));
 					}
-				}));
+				}
+				std::sort(modelPaths.begin(), modelPaths.end());
+				modelPaths.erase(std::unique(modelPaths.begin(), modelPaths.end()), modelPaths.end());
+
+				RunLoadingJobs(static_cast<int>(modelPaths.size()), [this, &modelPaths](int aJobIndex)
+				{
+					GetCore()->AddOrGet3DModelFromCache(modelPaths[aJobIndex], nullptr, true);
+				});
 			}
-			for (auto& t : threads) t.join();
 
-			for (auto& obj : objects)
-				LoadRenderingObjectInstancedData(obj.second);
+			// add rendering objects to scene
+			int numLoadedRenderingObjects = 0;
+			for (Json::Value::ArrayIndex i = 0; i != numRenderingObjects; i++) {
+				if (isLoadedLater(i))
+					continue;
+
+				const Json::Value& objectRoot = mSceneDescription.GetRenderingObject(i);
+				const std::string name = objectRoot["name"].asString();
+				ER_RenderingObject* object = AddRenderingObject(name,
+					new ER_RenderingObject(name, i, *mCore, mCamera, ER_Utility::GetFilePath(objectRoot["model_path"].asString()), true, objectRoot["instanced"].asBool())
+				);
+				if (streamingCellsIndices[i] >= 0)
+				{
+					object->SetStreamed(true);
+					mStreamingCells[streamingCellsIndices[i]].Objects.push_back(object);
+				}
+				numLoadedRenderingObjects++;
+			}
+			std::partition(objects.begin(), objects.end(), [](const ER_SceneObject& obj) {	return obj.second->IsInstanced(); });
+			assert(numLoadedRenderingObjects == objects.size());
+
+			// every object is one job (instanced objects go first as they are usually the heaviest): materials, textures and buffers and then its instance data
+			mSavedRenderingObjects.resize(numRenderingObjects);
+			RunLoadingJobs(static_cast<int>(objects.size()), [this](int aJobIndex)
+			{
+				ER_RenderingObject* object = objects[aJobIndex].second;
+				LoadRenderingObjectData(object);
+				LoadRenderingObjectInstancedData(object);
+				StoreSavedRenderingObjectState(object);
+			});
+
+			for (StreamingCell& cell : mStreamingCells)
+			{
+				for (ER_RenderingObject* object : cell.Objects)
+					cell.SizeInBytes += GetEstimatedStreamingSize(object);
+				mStreamingResidentBytes += cell.SizeInBytes;
+			}
 		}
 
 		{
@@ -217,12 +432,42 @@ namespace EveryRay_Core
 
 	ER_Scene::~ER_Scene()
 	{
+		// cells that are still loading: their objects were never added to the scene (the commands they queued are recorded before their resources are gone)
+		std::vector<ER_RenderingObject*> pendingObjects;
+		for (StreamingCell& cell : mStreamingCells)
+		{
+			if (cell.State != STREAMING_CELL_LOADING)
+				continue;
+
+			try
+			{
+				const std::vector<ER_RenderingObject*> cellObjects = cell.PendingLoad.get();
+				pendingObjects.insert(pendingObjects.end(), cellObjects.begin(), cellObjects.end());
+			}
+			catch (...) {}
+		}
+		GetCore()->GetRHI()->ExecuteLoadingCommands();
+		ER_TextureStreamer* textureStreamer = GetCore()->GetServices().FindService<ER_TextureStreamer>();
+		for (ER_RenderingObject* object : pendingObjects)
+		{
+			if (textureStreamer)
+				textureStreamer->UnregisterOwner(object);
+			DeleteObject(object);
+		}
+		mStreamingCells.clear();
+		DeleteObject(RenderingObjectStreamedInEvent);
+
 		for (auto& object : objects)
 		{
 			object.second->MeshMaterialVariablesUpdateEvent->RemoveAllListeners();
 			DeleteObject(object.second);
 		}
 		objects.clear();
+		mRenderingObjectsByName.clear();
+		mRenderingObjectsByID.clear();
+
+		// objects free their ranges of the pool in their destructors
+		DeleteObject(mInstanceBufferPool);
 
 		for (auto& rs : mStandardMaterialsRootSignatures)
 		{
@@ -231,6 +476,57 @@ namespace EveryRay_Core
 		mStandardMaterialsRootSignatures.clear();
 	}
 
+	// Runs the jobs on worker threads: every worker takes the next job until none are left (so one heavy job does not hold back a whole range of jobs).
+	// GPU resources can be created from the jobs (DX11 device is free-threaded, DX12 uploads and descriptor allocations are synchronized in the RHI),
+	// but the DX11 immediate context and the DX12 main command list are not: their work (i.e., mips generation) is queued by the RHI and recorded here after the workers have finished.
+	// The first exception of the jobs is rethrown on the calling thread after all workers have finished.
+	void ER_Scene::RunLoadingJobs(int aJobsCount, const std::function<void(int)>& aJob)
+	{
+		if (aJobsCount <= 0)
+			return;
+
+#if MULTITHREADED_SCENE_LOAD
+		const int numThreads = std::max(1, std::min(static_cast<int>(std::thread::hardware_concurrency()), aJobsCount));
+#else
+		const int numThreads = 1;
+#endif
+		std::atomic<int> nextJobIndex { 0 };
+		std::exception_ptr jobException;
+		std::mutex jobExceptionMutex;
+
+		auto runJobs = [&]()
+		{
+			ER_RHI::SetIsLoadingThread(true);
+			for (int jobIndex = nextJobIndex++; jobIndex < aJobsCount; jobIndex = nextJobIndex++)
+			{
+				try
+				{
+					aJob(jobIndex);
+				}
+				catch (...)
+				{
+					const std::lock_guard<std::mutex> lock(jobExceptionMutex);
+					if (!jobException)
+						jobException = std::current_exception();
+					nextJobIndex = aJobsCount; // skip the rest
+				}
+			}
+			ER_RHI::SetIsLoadingThread(false);
+		};
+
+		std::vector<std::thread> threads;
+		threads.reserve(numThreads - 1);
+		for (int i = 0; i < numThreads - 1; i++)
+			threads.push_back(std::thread(runJobs));
+		runJobs(); // on the calling thread too
+		for (auto& t : threads) t.join();
+
+		GetCore()->GetRHI()->ExecuteLoadingCommands();
+
+		if (jobException)
+			std::rethrow_exception(jobException);
+	}
+
 	void ER_Scene::CreateStandardMaterialsRootSignatures()
 	{
 		ER_Core* core = GetCore();
@@ -291,161 +587,169 @@ namespace EveryRay_Core
 		if (!aObject || !aObject->IsLoaded())
 			return;
 
-		int i = aObject->GetIndexInScene();
+		// resolved once after parsing, never modified here (so objects can be loaded in parallel)
+		const Json::Value& objectRoot = mSceneDescription.GetRenderingObject(aObject->GetIndexInScene());
 		bool isInstanced = aObject->IsInstanced();
 		bool hasLODs = false;
 
 		// load flags
 		{
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("foliageMask"))
-				aObject->SetIsMarkedAsFoliage(mSceneJsonRoot["rendering_objects"][i]["foliageMask"].asBool());
+			if (objectRoot.isMember("foliageMask"))
+				aObject->SetIsMarkedAsFoliage(objectRoot["foliageMask"].asBool());
 			
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("use_indirect_global_lightprobe"))
-				aObject->SetUseIndirectGlobalLightProbe(mSceneJsonRoot["rendering_objects"][i]["use_indirect_global_lightprobe"].asBool());
+			if (objectRoot.isMember("use_indirect_global_lightprobe"))
+				aObject->SetUseIndirectGlobalLightProbe(objectRoot["use_indirect_global_lightprobe"].asBool());
 			
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("use_in_global_lightprobe_rendering"))
-				aObject->SetIsUsedForGlobalLightProbeRendering(mSceneJsonRoot["rendering_objects"][i]["use_in_global_lightprobe_rendering"].asBool());
+			if (objectRoot.isMember("use_in_global_lightprobe_rendering"))
+				aObject->SetIsUsedForGlobalLightProbeRendering(objectRoot["use_in_global_lightprobe_rendering"].asBool());
 			
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("use_parallax_occlusion_mapping"))
-				aObject->SetParallaxOcclusionMapping(mSceneJsonRoot["rendering_objects"][i]["use_parallax_occlusion_mapping"].asBool());
+			if (objectRoot.isMember("use_parallax_occlusion_mapping"))
+				aObject->SetParallaxOcclusionMapping(objectRoot["use_parallax_occlusion_mapping"].asBool());
 			
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("use_forward_shading"))
-				aObject->SetForwardShading(mSceneJsonRoot["rendering_objects"][i]["use_forward_shading"].asBool());
+			if (objectRoot.isMember("use_forward_shading"))
+				aObject->SetForwardShading(objectRoot["use_forward_shading"].asBool());
 
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("use_reflection"))
-				aObject->SetReflective(mSceneJsonRoot["rendering_objects"][i]["use_reflection"].asBool());
+			if (objectRoot.isMember("use_reflection"))
+				aObject->SetReflective(objectRoot["use_reflection"].asBool());
 
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("use_sss"))
-				aObject->SetSeparableSubsurfaceScattering(mSceneJsonRoot["rendering_objects"][i]["use_sss"].asBool());
+			if (objectRoot.isMember("use_sss"))
+				aObject->SetSeparableSubsurfaceScattering(objectRoot["use_sss"].asBool());
 			
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("use_custom_alpha_discard"))
-				aObject->SetCustomAlphaDiscard(mSceneJsonRoot["rendering_objects"][i]["use_custom_alpha_discard"].asFloat());
+			if (objectRoot.isMember("use_custom_alpha_discard"))
+				aObject->SetCustomAlphaDiscard(objectRoot["use_custom_alpha_discard"].asFloat());
+
+			if (objectRoot.isMember("use_transparency"))
+				aObject->SetTransparency(objectRoot["use_transparency"].asBool());
 
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("use_transparency"))
-				aObject->SetTransparency(mSceneJsonRoot["rendering_objects"][i]["use_transparency"].asBool());
+			if (objectRoot.isMember("use_alpha_tested_depth"))
+				aObject->SetAlphaTestedInDepth(objectRoot["use_alpha_tested_depth"].asBool());
 
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("use_gpu_indirect_rendering"))
-				aObject->SetGPUIndirectlyRendered(mSceneJsonRoot["rendering_objects"][i]["use_gpu_indirect_rendering"].asBool());
+			if (objectRoot.isMember("use_as_occluder"))
+				aObject->SetIsOccluder(objectRoot["use_as_occluder"].asBool());
 
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("skip_indirect_specular"))
-				aObject->SetSkipIndirectSpecular(mSceneJsonRoot["rendering_objects"][i]["skip_indirect_specular"].asBool());
+			if (objectRoot.isMember("use_gpu_indirect_rendering"))
+				aObject->SetGPUIndirectlyRendered(objectRoot["use_gpu_indirect_rendering"].asBool());
 
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("index_of_refraction"))
-				aObject->SetIOR(mSceneJsonRoot["rendering_objects"][i]["index_of_refraction"].asFloat());
+			if (objectRoot.isMember("skip_indirect_specular"))
+				aObject->SetSkipIndirectSpecular(objectRoot["skip_indirect_specular"].asBool());
 
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("custom_roughness"))
-				aObject->SetCustomRoughness(mSceneJsonRoot["rendering_objects"][i]["custom_roughness"].asFloat());
+			if (objectRoot.isMember("index_of_refraction"))
+				aObject->SetIOR(objectRoot["index_of_refraction"].asFloat());
 
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("custom_metalness"))
-				aObject->SetCustomMetalness(mSceneJsonRoot["rendering_objects"][i]["custom_metalness"].asFloat());
+			if (objectRoot.isMember("custom_roughness"))
+				aObject->SetCustomRoughness(objectRoot["custom_roughness"].asFloat());
 
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("use_triplanar_mapping"))
-				aObject->SetTriplanarMapping(mSceneJsonRoot["rendering_objects"][i]["use_triplanar_mapping"].asBool());
-			//if (mSceneJsonRoot["rendering_objects"][i].isMember("triplanar_mapping_sharpness"))
-			//	aObject->SetTriplanarMappedSharpness(mSceneJsonRoot["rendering_objects"][i]["triplanar_mapping_sharpness"].asFloat());
+			if (objectRoot.isMember("custom_metalness"))
+				aObject->SetCustomMetalness(objectRoot["custom_metalness"].asFloat());
+
+			if (objectRoot.isMember("use_triplanar_mapping"))
+				aObject->SetTriplanarMapping(objectRoot["use_triplanar_mapping"].asBool());
+			//if (objectRoot.isMember("triplanar_mapping_sharpness"))
+			//	aObject->SetTriplanarMappedSharpness(objectRoot["triplanar_mapping_sharpness"].asFloat());
 
 			//fur
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("fur_layers_count"))
-				aObject->SetFurLayersCount(mSceneJsonRoot["rendering_objects"][i]["fur_layers_count"].asInt());
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("fur_color"))
+			if (objectRoot.isMember("fur_layers_count"))
+				aObject->SetFurLayersCount(objectRoot["fur_layers_count"].asInt());
+			if (objectRoot.isMember("fur_color"))
 			{
 				float vec3[3];
-				for (Json::Value::ArrayIndex vecI = 0; vecI != mSceneJsonRoot["rendering_objects"][i]["fur_color"].size(); vecI++)
-					vec3[vecI] = mSceneJsonRoot["rendering_objects"][i]["fur_color"][vecI].asFloat();
+				for (Json::Value::ArrayIndex vecI = 0; vecI != objectRoot["fur_color"].size(); vecI++)
+					vec3[vecI] = objectRoot["fur_color"][vecI].asFloat();
 
 				aObject->SetFurColor(vec3[0], vec3[1], vec3[2]);
 			}
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("fur_color_interpolation"))
-				aObject->SetFurColorInterpolation(mSceneJsonRoot["rendering_objects"][i]["fur_color_interpolation"].asFloat());
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("fur_length"))
-				aObject->SetFurLength(mSceneJsonRoot["rendering_objects"][i]["fur_length"].asFloat());
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("fur_cutoff"))
-				aObject->SetFurCutoff(mSceneJsonRoot["rendering_objects"][i]["fur_cutoff"].asFloat());
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("fur_cutoff_end"))
-				aObject->SetFurCutoffEnd(mSceneJsonRoot["rendering_objects"][i]["fur_cutoff_end"].asFloat());
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("fur_wind_frequency"))
-				aObject->SetFurWindFrequency(mSceneJsonRoot["rendering_objects"][i]["fur_wind_frequency"].asFloat());
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("fur_gravity_strength"))
-				aObject->SetFurGravityStrength(mSceneJsonRoot["rendering_objects"][i]["fur_gravity_strength"].asFloat());
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("fur_uv_scale"))
-				aObject->SetFurUVScale(mSceneJsonRoot["rendering_objects"][i]["fur_uv_scale"].asFloat());
+			if (objectRoot.isMember("fur_color_interpolation"))
+				aObject->SetFurColorInterpolation(objectRoot["fur_color_interpolation"].asFloat());
+			if (objectRoot.isMember("fur_length"))
+				aObject->SetFurLength(objectRoot["fur_length"].asFloat());
+			if (objectRoot.isMember("fur_cutoff"))
+				aObject->SetFurCutoff(objectRoot["fur_cutoff"].asFloat());
+			if (objectRoot.isMember("fur_cutoff_end"))
+				aObject->SetFurCutoffEnd(objectRoot["fur_cutoff_end"].asFloat());
+			if (objectRoot.isMember("fur_wind_frequency"))
+				aObject->SetFurWindFrequency(objectRoot["fur_wind_frequency"].asFloat());
+			if (objectRoot.isMember("fur_gravity_strength"))
+				aObject->SetFurGravityStrength(objectRoot["fur_gravity_strength"].asFloat());
+			if (objectRoot.isMember("fur_uv_scale"))
+				aObject->SetFurUVScale(objectRoot["fur_uv_scale"].asFloat());
 
 			//terrain
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("terrain_placement"))
+			if (objectRoot.isMember("terrain_placement"))
 			{
-				aObject->SetTerrainPlacement(mSceneJsonRoot["rendering_objects"][i]["terrain_placement"].asBool());
+				aObject->SetTerrainPlacement(objectRoot["terrain_placement"].asBool());
 
-				if (mSceneJsonRoot["rendering_objects"][i].isMember("terrain_splat_channel"))
-					aObject->SetTerrainProceduralPlacementSplatChannel(mSceneJsonRoot["rendering_objects"][i]["terrain_splat_channel"].asInt());
+				if (objectRoot.isMember("terrain_splat_channel"))
+					aObject->SetTerrainProceduralPlacementSplatChannel(objectRoot["terrain_splat_channel"].asInt());
 
-				if (mSceneJsonRoot["rendering_objects"][i].isMember("terrain_height_delta"))
-					aObject->SetTerrainProceduralPlacementHeightDelta(mSceneJsonRoot["rendering_objects"][i]["terrain_height_delta"].asFloat());
+				if (objectRoot.isMember("terrain_height_delta"))
+					aObject->SetTerrainProceduralPlacementHeightDelta(objectRoot["terrain_height_delta"].asFloat());
 
 				//procedural flags
 				{
-					if (mSceneJsonRoot["rendering_objects"][i].isMember("terrain_procedural_instance_scale_min") && mSceneJsonRoot["rendering_objects"][i].isMember("terrain_procedural_instance_scale_max"))
+					if (objectRoot.isMember("terrain_procedural_instance_scale_min") && objectRoot.isMember("terrain_procedural_instance_scale_max"))
 						aObject->SetTerrainProceduralObjectsMinMaxScale(
-							mSceneJsonRoot["rendering_objects"][i]["terrain_procedural_instance_scale_min"].asFloat(),
-							mSceneJsonRoot["rendering_objects"][i]["terrain_procedural_instance_scale_max"].asFloat());
+							objectRoot["terrain_procedural_instance_scale_min"].asFloat(),
+							objectRoot["terrain_procedural_instance_scale_max"].asFloat());
 
-					if (mSceneJsonRoot["rendering_objects"][i].isMember("terrain_procedural_instance_pitch_min") && mSceneJsonRoot["rendering_objects"][i].isMember("terrain_procedural_instance_pitch_max"))
+					if (objectRoot.isMember("terrain_procedural_instance_pitch_min") && objectRoot.isMember("terrain_procedural_instance_pitch_max"))
 						aObject->SetTerrainProceduralObjectsMinMaxPitch(
-							mSceneJsonRoot["rendering_objects"][i]["terrain_procedural_instance_pitch_min"].asFloat(),
-							mSceneJsonRoot["rendering_objects"][i]["terrain_procedural_instance_pitch_max"].asFloat());
+							objectRoot["terrain_procedural_instance_pitch_min"].asFloat(),
+							objectRoot["terrain_procedural_instance_pitch_max"].asFloat());
 
-					if (mSceneJsonRoot["rendering_objects"][i].isMember("terrain_procedural_instance_roll_min") && mSceneJsonRoot["rendering_objects"][i].isMember("terrain_procedural_instance_roll_max"))
+					if (objectRoot.isMember("terrain_procedural_instance_roll_min") && objectRoot.isMember("terrain_procedural_instance_roll_max"))
 						aObject->SetTerrainProceduralObjectsMinMaxRoll(
-							mSceneJsonRoot["rendering_objects"][i]["terrain_procedural_instance_roll_min"].asFloat(),
-							mSceneJsonRoot["rendering_objects"][i]["terrain_procedural_instance_roll_max"].asFloat());
+							objectRoot["terrain_procedural_instance_roll_min"].asFloat(),
+							objectRoot["terrain_procedural_instance_roll_max"].asFloat());
 
-					if (mSceneJsonRoot["rendering_objects"][i].isMember("terrain_procedural_instance_yaw_min") && mSceneJsonRoot["rendering_objects"][i].isMember("terrain_procedural_instance_yaw_max"))
+					if (objectRoot.isMember("terrain_procedural_instance_yaw_min") && objectRoot.isMember("terrain_procedural_instance_yaw_max"))
 						aObject->SetTerrainProceduralObjectsMinMaxYaw(
-							mSceneJsonRoot["rendering_objects"][i]["terrain_procedural_instance_yaw_min"].asFloat(),
-							mSceneJsonRoot["rendering_objects"][i]["terrain_procedural_instance_yaw_max"].asFloat());
+							objectRoot["terrain_procedural_instance_yaw_min"].asFloat(),
+							objectRoot["terrain_procedural_instance_yaw_max"].asFloat());
 
-					if (isInstanced && mSceneJsonRoot["rendering_objects"][i].isMember("terrain_procedural_instance_count"))
-						aObject->SetTerrainProceduralInstanceCount(mSceneJsonRoot["rendering_objects"][i]["terrain_procedural_instance_count"].asInt());
+					if (isInstanced && objectRoot.isMember("terrain_procedural_instance_count"))
+						aObject->SetTerrainProceduralInstanceCount(objectRoot["terrain_procedural_instance_count"].asInt());
 
-					if (mSceneJsonRoot["rendering_objects"][i].isMember("terrain_procedural_zone_center_pos"))
+					if (objectRoot.isMember("terrain_procedural_zone_center_pos"))
 					{
 						float vec3[3];
-						for (Json::Value::ArrayIndex vecI = 0; vecI != mSceneJsonRoot["rendering_objects"][i]["terrain_procedural_zone_center_pos"].size(); vecI++)
-							vec3[vecI] = mSceneJsonRoot["rendering_objects"][i]["terrain_procedural_zone_center_pos"][vecI].asFloat();
+						for (Json::Value::ArrayIndex vecI = 0; vecI != objectRoot["terrain_procedural_zone_center_pos"].size(); vecI++)
+							vec3[vecI] = objectRoot["terrain_procedural_zone_center_pos"][vecI].asFloat();
 
 						XMFLOAT3 centerPos = XMFLOAT3(vec3[0], vec3[1], vec3[2]);
 						aObject->SetTerrainProceduralZoneCenterPos(centerPos);
 					}
 
-					if (isInstanced && mSceneJsonRoot["rendering_objects"][i].isMember("terrain_procedural_zone_radius"))
-						aObject->SetTerrainProceduralZoneRadius(mSceneJsonRoot["rendering_objects"][i]["terrain_procedural_zone_radius"].asFloat());
+					if (isInstanced && objectRoot.isMember("terrain_procedural_zone_radius"))
+						aObject->SetTerrainProceduralZoneRadius(objectRoot["terrain_procedural_zone_radius"].asFloat());
 				}
 			}
 			
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("min_scale"))
-				aObject->SetMinScale(mSceneJsonRoot["rendering_objects"][i]["min_scale"].asFloat());
+			if (objectRoot.isMember("min_scale"))
+				aObject->SetMinScale(objectRoot["min_scale"].asFloat());
 			
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("max_scale"))
-				aObject->SetMaxScale(mSceneJsonRoot["rendering_objects"][i]["max_scale"].asFloat());
+			if (objectRoot.isMember("max_scale"))
+				aObject->SetMaxScale(objectRoot["max_scale"].asFloat());
 		}
 
 		// load materials
 		{
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("new_materials")) {
-				unsigned int numMaterials = mSceneJsonRoot["rendering_objects"][i]["new_materials"].size();
+			if (objectRoot.isMember("new_materials")) {
+				unsigned int numMaterials = objectRoot["new_materials"].size();
 				for (Json::Value::ArrayIndex matIndex = 0; matIndex != numMaterials; matIndex++) {
-					std::string name = mSceneJsonRoot["rendering_objects"][i]["new_materials"][matIndex]["name"].asString();
+					const Json::Value& materialRoot = objectRoot["new_materials"][matIndex];
+					std::string name = materialRoot["name"].asString();
 
 					MaterialShaderEntries shaderEntries;
-					if (mSceneJsonRoot["rendering_objects"][i]["new_materials"][matIndex].isMember("vertexEntry"))
-						shaderEntries.vertexEntry = mSceneJsonRoot["rendering_objects"][i]["new_materials"][matIndex]["vertexEntry"].asString();
-					if (mSceneJsonRoot["rendering_objects"][i]["new_materials"][matIndex].isMember("geometryEntry"))
-						shaderEntries.geometryEntry = mSceneJsonRoot["rendering_objects"][i]["new_materials"][matIndex]["geometryEntry"].asString();
-					if (mSceneJsonRoot["rendering_objects"][i]["new_materials"][matIndex].isMember("hullEntry"))
-						shaderEntries.hullEntry = mSceneJsonRoot["rendering_objects"][i]["new_materials"][matIndex]["hullEntry"].asString();	
-					if (mSceneJsonRoot["rendering_objects"][i]["new_materials"][matIndex].isMember("domainEntry"))
-						shaderEntries.domainEntry = mSceneJsonRoot["rendering_objects"][i]["new_materials"][matIndex]["domainEntry"].asString();	
-					if (mSceneJsonRoot["rendering_objects"][i]["new_materials"][matIndex].isMember("pixelEntry"))
-						shaderEntries.pixelEntry = mSceneJsonRoot["rendering_objects"][i]["new_materials"][matIndex]["pixelEntry"].asString();
+					if (materialRoot.isMember("vertexEntry"))
+						shaderEntries.vertexEntry = materialRoot["vertexEntry"].asString();
+					if (materialRoot.isMember("geometryEntry"))
+						shaderEntries.geometryEntry = materialRoot["geometryEntry"].asString();
+					if (materialRoot.isMember("hullEntry"))
+						shaderEntries.hullEntry = materialRoot["hullEntry"].asString();	
+					if (materialRoot.isMember("domainEntry"))
+						shaderEntries.domainEntry = materialRoot["domainEntry"].asString();	
+					if (materialRoot.isMember("pixelEntry"))
+						shaderEntries.pixelEntry = materialRoot["pixelEntry"].asString();
 
 					if (isInstanced) //be careful with the instancing support in shaders of the materials! (i.e., maybe the material does not have instancing entry point/support)
 						shaderEntries.vertexEntry = shaderEntries.vertexEntry + "_instancing";
@@ -457,10 +761,18 @@ namespace EveryRay_Core
 
 					if (name == ER_MaterialHelper::shadowMapMaterialName)
 					{
+						// objects without alpha testing only need positions for depth (no UVs and no pixel shader)
+						const bool isPositionOnly = !aObject->IsAlphaTestedInDepth();
+						if (isPositionOnly)
+							shaderEntries.vertexEntry = isInstanced ? "VSMain_PositionOnly_instancing" : "VSMain_PositionOnly";
+
 						for (int cascade = 0; cascade < NUM_SHADOW_CASCADES; cascade++)
 						{
 							std::string cascadedname = ER_MaterialHelper::shadowMapMaterialName + " " + std::to_string(cascade);
-							aObject->LoadMaterial(GetMaterialByName(name, shaderEntries, isInstanced), cascadedname);
+							if (isPositionOnly)
+								aObject->LoadMaterial(new ER_ShadowMapMaterial(*GetCore(), shaderEntries, HAS_VERTEX_SHADER, isInstanced, true), cascadedname);
+							else
+								aObject->LoadMaterial(GetMaterialByName(name, shaderEntries, isInstanced), cascadedname);
 						}
 					}
 					else if (name == ER_MaterialHelper::voxelizationMaterialName)
@@ -474,7 +786,7 @@ namespace EveryRay_Core
 					}
 					else if (name == ER_MaterialHelper::furShellMaterialName)
 					{
-						ER_RHI_GPURootSignature* rs = mStandardMaterialsRootSignatures.at(name);
+						ER_RHI_GPURootSignature* rs = GetStandardMaterialRootSignature(name);
 						int layerCount = aObject->GetFurLayersCount();
 						if (layerCount > 0)
 						{
@@ -483,7 +795,10 @@ namespace EveryRay_Core
 								const std::string fullname = ER_MaterialHelper::furShellMaterialName + "_" + std::to_string(layer);
 								aObject->LoadMaterial(GetMaterialByName(name, shaderEntries, isInstanced, layer), fullname);
 								if (rs)
+								{
+									const std::lock_guard<std::mutex> lock(mStandardMaterialsRootSignaturesMutex);
 									mStandardMaterialsRootSignatures.emplace(fullname, rs);
+								}
 							}
 						}
 
@@ -517,49 +832,58 @@ namespace EveryRay_Core
 		}
 
 		// load extra materials data
-		if (mSceneJsonRoot["rendering_objects"][i].isMember("snow_albedo"))
-			aObject->mSnowAlbedoTexturePath = mSceneJsonRoot["rendering_objects"][i]["snow_albedo"].asString();
-		if (mSceneJsonRoot["rendering_objects"][i].isMember("snow_normal"))
-			aObject->mSnowNormalTexturePath = mSceneJsonRoot["rendering_objects"][i]["snow_normal"].asString();
-		if (mSceneJsonRoot["rendering_objects"][i].isMember("snow_roughness"))
-			aObject->mSnowRoughnessTexturePath = mSceneJsonRoot["rendering_objects"][i]["snow_roughness"].asString();
+		if (objectRoot.isMember("snow_albedo"))
+			aObject->mSnowAlbedoTexturePath = objectRoot["snow_albedo"].asString();
+		if (objectRoot.isMember("snow_normal"))
+			aObject->mSnowNormalTexturePath = objectRoot["snow_normal"].asString();
+		if (objectRoot.isMember("snow_roughness"))
+			aObject->mSnowRoughnessTexturePath = objectRoot["snow_roughness"].asString();
 		
-		if (mSceneJsonRoot["rendering_objects"][i].isMember("fresnel_outline_color"))
+		if (objectRoot.isMember("fresnel_outline_color"))
 		{
 			float vec3[3];
-			for (Json::Value::ArrayIndex vecI = 0; vecI != mSceneJsonRoot["rendering_objects"][i]["fresnel_outline_color"].size(); vecI++)
-				vec3[vecI] = mSceneJsonRoot["rendering_objects"][i]["fresnel_outline_color"][vecI].asFloat();
+			for (Json::Value::ArrayIndex vecI = 0; vecI != objectRoot["fresnel_outline_color"].size(); vecI++)
+				vec3[vecI] = objectRoot["fresnel_outline_color"][vecI].asFloat();
 
 			XMFLOAT3 color = XMFLOAT3(vec3[0], vec3[1], vec3[2]);
 			aObject->SetFresnelOutlineColor(color);
 		}
 
-		if (mSceneJsonRoot["rendering_objects"][i].isMember("fur_height"))
-			aObject->mFurHeightTexturePath = mSceneJsonRoot["rendering_objects"][i]["fur_height"].asString();
+		if (objectRoot.isMember("fur_height"))
+			aObject->mFurHeightTexturePath = objectRoot["fur_height"].asString();
+
+		if (objectRoot.isMember("reflection_factors"))
+		{
+			const Json::Value& factorsRoot = objectRoot["reflection_factors"];
+			const int factorsCount = std::min(static_cast<int>(factorsRoot.size()), aObject->GetMeshCount());
+			for (int meshIndex = 0; meshIndex < factorsCount; meshIndex++)
+				aObject->SetMeshReflectionFactor(meshIndex, factorsRoot[meshIndex].asFloat());
+		}
 
 		// load textures
 		{
 			const int meshCount = aObject->GetMeshCount();
 
-			const bool containsCustomTextures = mSceneJsonRoot["rendering_objects"][i].isMember("textures");
-			const int maxCustomTextures = mSceneJsonRoot["rendering_objects"][i]["textures"].size();
+			const bool containsCustomTextures = objectRoot.isMember("textures");
+			const int maxCustomTextures = objectRoot["textures"].size();
 
 			for (int meshIndex = 0; meshIndex < meshCount; meshIndex++)
 			{
 				if (containsCustomTextures && meshIndex < maxCustomTextures)
 				{
-					if (mSceneJsonRoot["rendering_objects"][i]["textures"][meshIndex].isMember("albedo"))
-						aObject->mCustomAlbedoTextures[meshIndex] = mSceneJsonRoot["rendering_objects"][i]["textures"][meshIndex]["albedo"].asString();
-					if (mSceneJsonRoot["rendering_objects"][i]["textures"][meshIndex].isMember("normal"))
-						aObject->mCustomNormalTextures[meshIndex] = mSceneJsonRoot["rendering_objects"][i]["textures"][meshIndex]["normal"].asString();
-					if (mSceneJsonRoot["rendering_objects"][i]["textures"][meshIndex].isMember("roughness"))
-						aObject->mCustomRoughnessTextures[meshIndex] = mSceneJsonRoot["rendering_objects"][i]["textures"][meshIndex]["roughness"].asString();
-					if (mSceneJsonRoot["rendering_objects"][i]["textures"][meshIndex].isMember("metalness"))
-						aObject->mCustomMetalnessTextures[meshIndex] = mSceneJsonRoot["rendering_objects"][i]["textures"][meshIndex]["metalness"].asString();
-					if (mSceneJsonRoot["rendering_objects"][i]["textures"][meshIndex].isMember("height"))
-						aObject->mCustomHeightTextures[meshIndex] = mSceneJsonRoot["rendering_objects"][i]["textures"][meshIndex]["height"].asString();
-					if (mSceneJsonRoot["rendering_objects"][i]["textures"][meshIndex].isMember("reflection_mask"))
-						aObject->mCustomReflectionMaskTextures[meshIndex] = mSceneJsonRoot["rendering_objects"][i]["textures"][meshIndex]["reflection_mask"].asString();
+					const Json::Value& meshTexturesRoot = objectRoot["textures"][meshIndex];
+					if (meshTexturesRoot.isMember("albedo"))
+						aObject->mCustomAlbedoTextures[meshIndex] = meshTexturesRoot["albedo"].asString();
+					if (meshTexturesRoot.isMember("normal"))
+						aObject->mCustomNormalTextures[meshIndex] = meshTexturesRoot["normal"].asString();
+					if (meshTexturesRoot.isMember("roughness"))
+						aObject->mCustomRoughnessTextures[meshIndex] = meshTexturesRoot["roughness"].asString();
+					if (meshTexturesRoot.isMember("metalness"))
+						aObject->mCustomMetalnessTextures[meshIndex] = meshTexturesRoot["metalness"].asString();
+					if (meshTexturesRoot.isMember("height"))
+						aObject->mCustomHeightTextures[meshIndex] = meshTexturesRoot["height"].asString();
+					if (meshTexturesRoot.isMember("reflection_mask"))
+						aObject->mCustomReflectionMaskTextures[meshIndex] = meshTexturesRoot["reflection_mask"].asString();
 
 					aObject->LoadCustomMeshTextures(meshIndex);
 				}
@@ -570,15 +894,15 @@ namespace EveryRay_Core
 
 		// load world transform
 		{
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("transform")) {
-				if (mSceneJsonRoot["rendering_objects"][i]["transform"].size() != 16)
+			if (objectRoot.isMember("transform")) {
+				if (objectRoot["transform"].size() != 16)
 				{
 					aObject->SetTransformationMatrix(XMMatrixIdentity());
 				}
 				else {
 					float matrix[16];
-					for (Json::Value::ArrayIndex matC = 0; matC != mSceneJsonRoot["rendering_objects"][i]["transform"].size(); matC++) {
-						matrix[matC] = mSceneJsonRoot["rendering_objects"][i]["transform"][matC].asFloat();
+					for (Json::Value::ArrayIndex matC = 0; matC != objectRoot["transform"].size(); matC++) {
+						matrix[matC] = objectRoot["transform"][matC].asFloat();
 					}
 					XMFLOAT4X4 worldTransform(matrix);
 					aObject->SetTransformationMatrix(XMMatrixTranspose(XMLoadFloat4x4(&worldTransform)));
@@ -590,10 +914,10 @@ namespace EveryRay_Core
 
 		// load lods
 		{
-			hasLODs = mSceneJsonRoot["rendering_objects"][i].isMember("model_lods");
+			hasLODs = objectRoot.isMember("model_lods");
 			if (hasLODs) {
-				for (Json::Value::ArrayIndex lod = 1 /* 0 is main model loaded before */; lod != mSceneJsonRoot["rendering_objects"][i]["model_lods"].size(); lod++) {
-					std::string path = mSceneJsonRoot["rendering_objects"][i]["model_lods"][lod]["path"].asString();
+				for (Json::Value::ArrayIndex lod = 1 /* 0 is main model loaded before */; lod != objectRoot["model_lods"].size(); lod++) {
+					std::string path = objectRoot["model_lods"][lod]["path"].asString();
 					aObject->AddLOD(ER_Utility::GetFilePath(path));
 				}
 			}
@@ -602,232 +926,574 @@ namespace EveryRay_Core
 		std::wstring msg = L"[ER Logger][ER_Scene] Loaded rendering object into scene: " + ER_Utility::ToWideString(aObject->GetName()) + L'\n';
 		ER_OUTPUT_LOG(msg.c_str());
 	}
-	// [WARNING] NOT THREAD-SAFE!
+	// Can be called for different objects in parallel: only reads the object's json node (never adds members to it) and the instance buffer pool is synchronized
 	void ER_Scene::LoadRenderingObjectInstancedData(ER_RenderingObject* aObject)
 	{
-		int i = aObject->GetIndexInScene();
 		bool isInstanced = aObject->IsInstanced();
 		if (!isInstanced)
 			return;
 
-		bool hasLODs = mSceneJsonRoot["rendering_objects"][i].isMember("model_lods");
-		if (hasLODs)
+		const Json::Value& objectRoot = mSceneDescription.GetRenderingObject(aObject->GetIndexInScene());
+
+		// instances are shared by all LODs, every LOD only has its own instance buffers
+		const int lodCount = objectRoot.isMember("model_lods") ? static_cast<int>(objectRoot["model_lods"].size()) : 1;
+		for (int lod = 0; lod < lodCount; lod++)
+			aObject->LoadInstanceBuffers(lod);
+
+		if (aObject->GetTerrainPlacement() && aObject->GetTerrainProceduralInstanceCount() > 0)
 		{
-			for (int lod = 0; lod < static_cast<int>(mSceneJsonRoot["rendering_objects"][i]["model_lods"].size()); lod++)
-			{
-				aObject->LoadInstanceBuffers(lod);
-				if (aObject->GetTerrainPlacement() && aObject->GetTerrainProceduralInstanceCount() > 0)
-				{
-					int instanceCount = aObject->GetTerrainProceduralInstanceCount();
-					aObject->ResetInstanceData(instanceCount, true, lod);
-					for (int i = 0; i < instanceCount; i++)
-						aObject->AddInstanceData(XMMatrixIdentity(), lod);
-				}
-				else
-				{
-					if (mSceneJsonRoot["rendering_objects"][i].isMember("instances_transforms")) {
-						aObject->ResetInstanceData(mSceneJsonRoot["rendering_objects"][i]["instances_transforms"].size(), true, lod);
-						for (Json::Value::ArrayIndex instance = 0; instance != mSceneJsonRoot["rendering_objects"][i]["instances_transforms"].size(); instance++) {
-							float matrix[16];
-							for (Json::Value::ArrayIndex matC = 0; matC != mSceneJsonRoot["rendering_objects"][i]["instances_transforms"][instance]["transform"].size(); matC++) {
-								matrix[matC] = mSceneJsonRoot["rendering_objects"][i]["instances_transforms"][instance]["transform"][matC].asFloat();
-							}
-							XMFLOAT4X4 worldTransform(matrix);
-							aObject->AddInstanceData(XMMatrixTranspose(XMLoadFloat4x4(&worldTransform)), lod);
-						}
-					}
-					else {
-						aObject->ResetInstanceData(1, true, lod);
-						aObject->AddInstanceData(aObject->GetTransformationMatrix(), lod);
+			int instanceCount = aObject->GetTerrainProceduralInstanceCount();
+			aObject->ResetInstanceData(instanceCount);
+			for (int i = 0; i < instanceCount; i++)
+				aObject->AddInstanceData(XMMatrixIdentity());
+		}
+		else
+		{
+			if (objectRoot.isMember("instances_transforms")) {
+				const Json::Value& instancesRoot = objectRoot["instances_transforms"];
+				aObject->ResetInstanceData(instancesRoot.size());
+				for (Json::Value::ArrayIndex instance = 0; instance != instancesRoot.size(); instance++) {
+					const Json::Value& transformRoot = instancesRoot[instance]["transform"];
+					float matrix[16];
+					for (Json::Value::ArrayIndex matC = 0; matC != transformRoot.size(); matC++) {
+						matrix[matC] = transformRoot[matC].asFloat();
 					}
+					XMFLOAT4X4 worldTransform(matrix);
+					aObject->AddInstanceData(XMMatrixTranspose(XMLoadFloat4x4(&worldTransform)));
 				}
-				aObject->UpdateInstanceBuffer(aObject->GetInstancesData(), lod);
+			}
+			else {
+				aObject->ResetInstanceData(1);
+				aObject->AddInstanceData(aObject->GetTransformationMatrix());
 			}
 		}
-		else {
-			aObject->LoadInstanceBuffers();
 
-			if (aObject->GetTerrainPlacement() && aObject->GetTerrainProceduralInstanceCount() > 0)
-			{
-				int instanceCount = aObject->GetTerrainProceduralInstanceCount();
-				aObject->ResetInstanceData(instanceCount, true);
-				for (int i = 0; i < instanceCount; i++)
-					aObject->AddInstanceData(XMMatrixIdentity());
-			}
-			else
-			{
-				if (mSceneJsonRoot["rendering_objects"][i].isMember("instances_transforms")) {
-					aObject->ResetInstanceData(mSceneJsonRoot["rendering_objects"][i]["instances_transforms"].size(), true);
-					for (Json::Value::ArrayIndex instance = 0; instance != mSceneJsonRoot["rendering_objects"][i]["instances_transforms"].size(); instance++) {
-						float matrix[16];
-						for (Json::Value::ArrayIndex matC = 0; matC != mSceneJsonRoot["rendering_objects"][i]["instances_transforms"][instance]["transform"].size(); matC++) {
-							matrix[matC] = mSceneJsonRoot["rendering_objects"][i]["instances_transforms"][instance]["transform"][matC].asFloat();
-						}
-						XMFLOAT4X4 worldTransform(matrix);
-						aObject->AddInstanceData(XMMatrixTranspose(XMLoadFloat4x4(&worldTransform)));
-					}
-				}
-				else {
-					aObject->ResetInstanceData(1, true);
-					aObject->AddInstanceData(aObject->GetTransformationMatrix());
-				}
-			}
-			aObject->UpdateInstanceBuffer(aObject->GetInstancesData());
+		for (int lod = 0; lod < lodCount; lod++)
+			aObject->UpdateInstanceBuffer(aObject->GetInstancesData(), lod);
+	}
+
+	// Called after the object has been loaded (can be called for different objects in parallel: every object has its own entry)
+	void ER_Scene::StoreSavedRenderingObjectState(ER_RenderingObject* aObject)
+	{
+		const int indexInScene = aObject->GetIndexInScene();
+		assert(indexInScene >= 0 && indexInScene < static_cast<int>(mSavedRenderingObjects.size()));
+
+		SavedRenderingObjectState& state = mSavedRenderingObjects[indexInScene];
+		state.SceneID = aObject->GetSceneID();
+		SerializeRenderingObjectProperties(aObject, state.Properties);
+
+		state.InstancesTransforms.clear();
+		if (aObject->IsInstanced() && mSceneDescription.GetRenderingObject(indexInScene).isMember("instances_transforms"))
+		{
+			state.InstancesTransforms.reserve(aObject->GetInstanceCount());
+			for (UINT instance = 0; instance < aObject->GetInstanceCount(); instance++)
+				state.InstancesTransforms.push_back(aObject->GetInstancesData()[instance].World);
 		}
 	}
-	// TODO: add functionality for storing flags, etc. (currently only transforms can be saved to json)
+
+	// Only writes what has been changed since the scene was loaded/last saved: the properties of every object and its instances transforms.
+	// Objects which were not loaded from the scene file (or were removed from the scene) are not saved, streamed out objects keep their changes in their json nodes.
 	void ER_Scene::SaveRenderingObjectsData()
 	{
 		if (mScenePath.empty())
 			throw ER_CoreException("Can't save to scene json file! Empty scene name...");
 
-		// store world transform
-		for (Json::Value::ArrayIndex i = 0; i != mSceneJsonRoot["rendering_objects"].size(); i++) {
-			Json::Value content(Json::arrayValue);
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("transform")) {
-				ER_RenderingObject* rObj = FindRenderingObjectByName(mSceneJsonRoot["rendering_objects"][i]["name"].asString());
-				if (rObj)
-				{
-					XMFLOAT4X4 mat = rObj->GetTransformationMatrix4X4();
-					XMMATRIX matXM = XMMatrixTranspose(XMLoadFloat4x4(&mat));
-					XMStoreFloat4x4(&mat, matXM);
-					float matF[16];
-					ER_MatrixHelper::SetFloatArray(mat, matF);
-					for (int i = 0; i < 16; i++)
-						content.append(matF[i]);
-					mSceneJsonRoot["rendering_objects"][i]["transform"] = content;
-				}
-			}
-			else
+		int changesCount = 0;
+		for (SavedRenderingObjectState& state : mSavedRenderingObjects)
+		{
+			ER_RenderingObject* rObj = FindRenderingObjectByID(state.SceneID);
+			if (rObj)
+				changesCount += WriteRenderingObjectChanges(rObj);
+
+			if (state.HasUnsavedChanges)
 			{
-				float matF[16];
-				XMFLOAT4X4 mat;
-				XMStoreFloat4x4(&mat, XMMatrixTranspose(XMMatrixIdentity()));
-				ER_MatrixHelper::SetFloatArray(mat, matF);
-
-				for (int i = 0; i < 16; i++)
-					content.append(matF[i]);
-				mSceneJsonRoot["rendering_objects"][i]["transform"] = content;
+				changesCount++;
+				state.HasUnsavedChanges = false;
 			}
+		}
 
-			if (mSceneJsonRoot["rendering_objects"][i].isMember("instanced")) 
-			{
-				bool isInstanced = mSceneJsonRoot["rendering_objects"][i]["instanced"].asBool();
-				if (isInstanced)
-				{
-					if (mSceneJsonRoot["rendering_objects"][i].isMember("instances_transforms")) {
+		if (changesCount == 0)
+		{
+			ER_OUTPUT_LOG(L"[ER Logger][ER_Scene] Rendering objects have not been changed since the last save, nothing to save.\n");
+			return;
+		}
+
+		WriteSceneFile();
+
+		std::wstring msg = L"[ER Logger][ER_Scene] Saved rendering objects: " + std::to_wstring(changesCount) + L" changes.\n";
+		ER_OUTPUT_LOG(msg.c_str());
+	}
 
-						ER_RenderingObject* rObj = FindRenderingObjectByName(mSceneJsonRoot["rendering_objects"][i]["name"].asString());
-						if (!rObj || mSceneJsonRoot["rendering_objects"][i]["instances_transforms"].size() != rObj->GetInstanceCount())
-							throw ER_CoreException("Can't save instances transforms to scene json file! RenderObject's instance count is not equal to the number of instance transforms in scene file.");
+	// Writes the properties and the instances transforms which differ from the saved state of the object into its json node
+	int ER_Scene::WriteRenderingObjectChanges(ER_RenderingObject* aObject)
+	{
+		const int indexInScene = aObject->GetIndexInScene();
+		assert(indexInScene >= 0 && indexInScene < static_cast<int>(mSavedRenderingObjects.size()));
 
-						for (Json::Value::ArrayIndex instance = 0; instance != mSceneJsonRoot["rendering_objects"][i]["instances_transforms"].size(); instance++) {
-							Json::Value contentInstanceTransform(Json::arrayValue);
+		SavedRenderingObjectState& state = mSavedRenderingObjects[indexInScene];
+		Json::Value& objectRoot = mSceneDescription.Root["rendering_objects"][indexInScene];
 
-							XMFLOAT4X4 mat = rObj->GetInstancesData()[instance].World;
-							XMMATRIX matXM = XMMatrixTranspose(XMLoadFloat4x4(&mat));
-							XMStoreFloat4x4(&mat, matXM);
-							float matF[16];
-							ER_MatrixHelper::SetFloatArray(mat, matF);
-							for (int i = 0; i < 16; i++)
-								contentInstanceTransform.append(matF[i]);
+		Json::Value currentProperties;
+		SerializeRenderingObjectProperties(aObject, currentProperties);
+		int changesCount = WriteChangedProperties(currentProperties, state.Properties, objectRoot);
 
-							mSceneJsonRoot["rendering_objects"][i]["instances_transforms"][instance]["transform"] = contentInstanceTransform;
-						}
-					}
-				}
+		// instances transforms: only the changed ones are rewritten (instances can also be added/removed in the editor)
+		if (aObject->IsInstanced() && objectRoot.isMember("instances_transforms"))
+		{
+			Json::Value& instancesRoot = objectRoot["instances_transforms"];
+			const UINT instanceCount = aObject->GetInstanceCount();
+			if (instancesRoot.size() != instanceCount)
+			{
+				instancesRoot.resize(instanceCount);
+				state.InstancesTransforms.resize(instanceCount);
+				changesCount++; // so that removed instances are saved too (added ones are written below)
+			}
+
+			const std::vector<InstancedData>& instancesData = aObject->GetInstancesData();
+			for (UINT instance = 0; instance < instanceCount; instance++)
+			{
+				const XMFLOAT4X4& world = instancesData[instance].World;
+				if (memcmp(&world, &state.InstancesTransforms[instance], sizeof(XMFLOAT4X4)) == 0 && instancesRoot[instance].isMember("transform"))
+					continue;
+
+				instancesRoot[instance]["transform"] = ToJsonMatrix(world);
+				state.InstancesTransforms[instance] = world;
+				changesCount++;
 			}
 		}
 
+		return changesCount;
+	}
+
+	// Writes the whole scene (the parsed root with all the saved changes) to the scene file
+	void ER_Scene::WriteSceneFile()
+	{
 		Json::StreamWriterBuilder builder;
 		std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
 
 		std::ofstream file_id;
 		file_id.open(mScenePath.c_str());
-		writer->write(mSceneJsonRoot, &file_id);
+		writer->write(mSceneDescription.Root, &file_id);
 	}
-	ER_RenderingObject* ER_Scene::FindRenderingObjectByName(const std::string& aName)
+
+	ER_RenderingObject* ER_Scene::AddRenderingObject(const std::string& aName, ER_RenderingObject* aObject)
 	{
+		assert(aObject);
+
+		aObject->SetScene(this, static_cast<int>(mRenderingObjectsByID.size()));
+		mRenderingObjectsByID.push_back(aObject);
+		InsertRenderingObject(aName, aObject);
+
+		return aObject;
+	}
+
+	// Adds the object (which already has its scene ID) to 'objects' and to the lookups
+	void ER_Scene::InsertRenderingObject(const std::string& aName, ER_RenderingObject* aObject)
+	{
+		assert(mRenderingObjectsByID[aObject->GetSceneID()] == aObject);
+
+		// keeps 'objects' partitioned (instanced objects first), so the objects can also be added after loading
+		if (aObject->IsInstanced())
+			objects.emplace(std::find_if(objects.begin(), objects.end(), [](const ER_SceneObject& obj) { return !obj.second->IsInstanced(); }), aName, aObject);
+		else
+			objects.emplace_back(aName, aObject);
+
+		if (!mRenderingObjectsByName.emplace(aName, aObject).second)
+		{
+			std::wstring msg = L"[ER Logger][ER_Scene] Rendering object with this name already exists in the scene (lookups by name will return the first one): " + ER_Utility::ToWideString(aName) + L"\n";
+			ER_OUTPUT_LOG(msg.c_str());
+		}
+	}
+
+	bool ER_Scene::RemoveRenderingObject(ER_RenderingObject* aObject)
+	{
+		auto it = std::find_if(objects.begin(), objects.end(), [aObject](const ER_SceneObject& obj) { return obj.second == aObject; });
+		if (it == objects.end())
+			return false;
+
+		std::string name = it->first;
+		objects.erase(it); // keeps the order (instanced objects first)
+		mRenderingObjectsByID[aObject->GetSceneID()] = nullptr;
+
+		auto nameIt = mRenderingObjectsByName.find(name);
+		if (nameIt != mRenderingObjectsByName.end() && nameIt->second == aObject)
+			IndexRenderingObjectName(name);
+
+		ER_TextureStreamer* textureStreamer = GetCore()->GetServices().FindService<ER_TextureStreamer>();
+		if (textureStreamer)
+			textureStreamer->UnregisterOwner(aObject);
+
+		aObject->MeshMaterialVariablesUpdateEvent->RemoveAllListeners();
+		DeleteObject(aObject);
+		return true;
+	}
+
+	void ER_Scene::OnRenderingObjectRenamed(ER_RenderingObject* aObject, const std::string& aOldName)
+	{
+		auto it = std::find_if(objects.begin(), objects.end(), [aObject](const ER_SceneObject& obj) { return obj.second == aObject; });
+		if (it == objects.end())
+			return;
+
+		it->first = aObject->GetName();
+
+		// keep the scene file entry in sync, so the object is still found by its name when the scene is saved
+		int indexInScene = aObject->GetIndexInScene();
+		if (indexInScene >= 0 && indexInScene < static_cast<int>(mSceneDescription.Root["rendering_objects"].size()) &&
+			mSceneDescription.Root["rendering_objects"][indexInScene]["name"].asString() == aOldName)
+			mSceneDescription.Root["rendering_objects"][indexInScene]["name"] = it->first;
+
+		auto oldNameIt = mRenderingObjectsByName.find(aOldName);
+		if (oldNameIt != mRenderingObjectsByName.end() && oldNameIt->second == aObject)
+			IndexRenderingObjectName(aOldName);
+		IndexRenderingObjectName(it->first);
+	}
+
+	void ER_Scene::IndexRenderingObjectName(const std::string& aName)
+	{
+		mRenderingObjectsByName.erase(aName);
+
+		// 'objects' is partitioned after loading, so we look for the object with the smallest ID (the first added one)
+		ER_RenderingObject* firstObject = nullptr;
 		for (auto& sceneObj : objects)
 		{
-			if (sceneObj.first == aName)
-				return sceneObj.second;
-			else
+			if (sceneObj.first == aName && (!firstObject || sceneObj.second->GetSceneID() < firstObject->GetSceneID()))
+				firstObject = sceneObj.second;
+		}
+
+		if (firstObject)
+			mRenderingObjectsByName.emplace(aName, firstObject);
+	}
+
+	ER_RenderingObject* ER_Scene::FindRenderingObjectByName(const std::string& aName) const
+	{
+		auto it = mRenderingObjectsByName.find(aName);
+		return it != mRenderingObjectsByName.end() ? it->second : nullptr;
+	}
+
+	ER_RenderingObject* ER_Scene::FindRenderingObjectByID(int aID) const
+	{
+		if (aID < 0 || aID >= static_cast<int>(mRenderingObjectsByID.size()))
+			return nullptr;
+
+		return mRenderingObjectsByID[aID];
+	}
+
+	// Cells are only created for the objects that can be streamed: objects placed on terrain (they are placed once at level load)
+	// and objects with "streamed": false are always loaded. Cells within the load distance of the camera are loaded with the scene.
+	void ER_Scene::InitStreamingCells(std::vector<int>& outCellsIndices)
+	{
+		if (!IsValueInSceneRoot("streaming_cell_size"))
+			return;
+
+		mStreamingCellSize = GetValueFromSceneRoot<float>("streaming_cell_size");
+		if (mStreamingCellSize <= 0.0f)
+		{
+			mStreamingCellSize = 0.0f;
+			return;
+		}
+
+		mStreamingLoadDistance = IsValueInSceneRoot("streaming_load_distance") ? GetValueFromSceneRoot<float>("streaming_load_distance") : 2.0f * mStreamingCellSize;
+		mStreamingUnloadDistance = mStreamingLoadDistance + 0.5f * mStreamingCellSize;
+		const UINT64 budgetInMB = IsValueInSceneRoot("streaming_memory_budget_mb") ? GetValueFromSceneRoot<UINT>("streaming_memory_budget_mb") : LEVEL_STREAMING_DEFAULT_BUDGET_MB;
+		mStreamingBudgetInBytes = budgetInMB * 1024 * 1024;
+
+		std::map<std::pair<int, int>, int> cellsByCoordinates;
+		int streamedObjectsCount = 0;
+		for (int i = 0; i < static_cast<int>(mSceneDescription.RenderingObjects.size()); i++)
+		{
+			const Json::Value& objectRoot = mSceneDescription.GetRenderingObject(i);
+			if (objectRoot.isMember("streamed") && !objectRoot["streamed"].asBool())
+				continue;
+			if (objectRoot.isMember("terrain_placement") && objectRoot["terrain_placement"].asBool())
 				continue;
+
+			const XMFLOAT3 position = GetObjectNodePosition(objectRoot);
+			const std::pair<int, int> coordinates(static_cast<int>(floor(position.x / mStreamingCellSize)), static_cast<int>(floor(position.z / mStreamingCellSize)));
+
+			auto cellIt = cellsByCoordinates.find(coordinates);
+			if (cellIt == cellsByCoordinates.end())
+			{
+				cellIt = cellsByCoordinates.emplace(coordinates, static_cast<int>(mStreamingCells.size())).first;
+				mStreamingCells.emplace_back();
+
+				StreamingCell& cell = mStreamingCells.back();
+				cell.Min = XMFLOAT2(coordinates.first * mStreamingCellSize, coordinates.second * mStreamingCellSize);
+				cell.Max = XMFLOAT2(cell.Min.x + mStreamingCellSize, cell.Min.y + mStreamingCellSize);
+			}
+
+			mStreamingCells[cellIt->second].ObjectsIndices.push_back(i);
+			outCellsIndices[i] = cellIt->second;
+			streamedObjectsCount++;
+		}
+
+		int loadedCellsCount = 0;
+		for (StreamingCell& cell : mStreamingCells)
+		{
+			cell.Distance = GetDistanceToStreamingCell(cell.Min, cell.Max, mCamera.Position());
+			if (cell.Distance <= mStreamingLoadDistance)
+			{
+				cell.State = STREAMING_CELL_LOADED;
+				loadedCellsCount++;
+			}
 		}
 
-		return nullptr;
+		std::wstring msg = L"[ER Logger][ER_Scene] Level streaming: " + std::to_wstring(streamedObjectsCount) + L" streamed objects in " + std::to_wstring(mStreamingCells.size()) +
+			L" cells, " + std::to_wstring(loadedCellsCount) + L" cells are loaded with the scene\n";
+		ER_OUTPUT_LOG(msg.c_str());
 	}
 
-	void ER_Scene::LoadFoliageZonesData(std::vector<ER_Foliage*>& foliageZones, ER_DirectionalLight& light)
+	void ER_Scene::UpdateStreaming(const XMFLOAT3& aCameraPosition)
 	{
-		Json::Reader reader;
-		std::ifstream scene(mScenePath.c_str(), std::ifstream::binary);
-		ER_Core* core = GetCore();
-		assert(core);
+		if (!IsStreamingEnabled())
+			return;
 
-		if (!reader.parse(scene, mSceneJsonRoot)) {
-			throw ER_CoreException(reader.getFormattedErrorMessages().c_str());
+		// finished cells are added to the scene on the main thread
+		for (StreamingCell& cell : mStreamingCells)
+		{
+			if (cell.State == STREAMING_CELL_LOADING && cell.PendingLoad.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+				FinishStreamingCellLoad(cell);
 		}
-		else {
-			if (mSceneJsonRoot.isMember("foliage_zones")) 
+
+		if (mStreamingFrameIndex++ % LEVEL_STREAMING_UPDATE_FREQUENCY != 0)
+			return;
+
+		std::vector<StreamingCell*> cellsByDistance;
+		cellsByDistance.reserve(mStreamingCells.size());
+		for (StreamingCell& cell : mStreamingCells)
+		{
+			cell.Distance = GetDistanceToStreamingCell(cell.Min, cell.Max, aCameraPosition);
+			cellsByDistance.push_back(&cell);
+		}
+		std::sort(cellsByDistance.begin(), cellsByDistance.end(), [](const StreamingCell* a, const StreamingCell* b) { return a->Distance < b->Distance; });
+
+		std::vector<StreamingCell*> cellsToUnload;
+		UINT64 plannedBytes = mStreamingResidentBytes;
+		auto requestUnload = [&cellsToUnload, &plannedBytes](StreamingCell* aCell)
+		{
+			aCell->State = STREAMING_CELL_UNLOADING;
+			plannedBytes -= aCell->SizeInBytes;
+			cellsToUnload.push_back(aCell);
+		};
+
+		// far cells and then (if we are over the budget) the farthest cells, except the one with the camera
+		for (auto it = cellsByDistance.rbegin(); it != cellsByDistance.rend(); ++it)
+		{
+			StreamingCell* cell = *it;
+			if (cell->State == STREAMING_CELL_LOADED && (cell->Distance > mStreamingUnloadDistance || (plannedBytes > mStreamingBudgetInBytes && cell->Distance > 0.0f)))
+				requestUnload(cell);
+		}
+
+		// the nearest cells are loaded first: loaded cells that are farther than the cell go out if it does not fit into the budget
+		// (the size of a cell is not known until it has been loaded once, so it only needs some space left in the budget)
+		std::vector<StreamingCell*> cellsToLoad;
+		int pendingCellsCount = mStreamingPendingCellsCount;
+		for (StreamingCell* cell : cellsByDistance)
+		{
+			if (pendingCellsCount >= LEVEL_STREAMING_MAX_PENDING_CELLS || cell->Distance > mStreamingLoadDistance)
+				break;
+			if (cell->State != STREAMING_CELL_UNLOADED)
+				continue;
+
+			const UINT64 neededBytes = std::max(cell->SizeInBytes, static_cast<UINT64>(1));
+			for (auto it = cellsByDistance.rbegin(); it != cellsByDistance.rend() && *it != cell && plannedBytes + neededBytes > mStreamingBudgetInBytes; ++it)
 			{
-				for (Json::Value::ArrayIndex i = 0; i != mSceneJsonRoot["foliage_zones"].size(); i++)
-				{
-					float vec3[3];
-					for (Json::Value::ArrayIndex ia = 0; ia != mSceneJsonRoot["foliage_zones"][i]["position"].size(); ia++)
-						vec3[ia] = mSceneJsonRoot["foliage_zones"][i]["position"][ia].asFloat();
+				if ((*it)->State == STREAMING_CELL_LOADED)
+					requestUnload(*it);
+			}
+			if (plannedBytes + neededBytes > mStreamingBudgetInBytes)
+				continue;
 
-					bool placedOnTerrain = false;
-					if (mSceneJsonRoot["foliage_zones"][i].isMember("placed_on_terrain"))
-						placedOnTerrain = mSceneJsonRoot["foliage_zones"][i]["placed_on_terrain"].asBool();
-					
-					TerrainSplatChannels terrainChannel = TerrainSplatChannels::NONE;
-					if (mSceneJsonRoot["foliage_zones"][i].isMember("placed_splat_channel"))
-						terrainChannel = (TerrainSplatChannels)(mSceneJsonRoot["foliage_zones"][i]["placed_splat_channel"].asInt());
-
-					float placedHeightDelta = 0.0f;
-					if (mSceneJsonRoot["foliage_zones"][i].isMember("placed_height_delta"))
-						placedHeightDelta = mSceneJsonRoot["foliage_zones"][i]["placed_height_delta"].asFloat();
-
-					foliageZones.push_back(new ER_Foliage(*core, mCamera, light,
-						mSceneJsonRoot["foliage_zones"][i]["patch_count"].asInt(),
-						ER_Utility::GetFilePath(mSceneJsonRoot["foliage_zones"][i]["texture_path"].asString()),
-						mSceneJsonRoot["foliage_zones"][i]["average_scale"].asFloat(),
-						mSceneJsonRoot["foliage_zones"][i]["distribution_radius"].asFloat(),
-						XMFLOAT3(vec3[0], vec3[1], vec3[2]),
-						(FoliageBillboardType)mSceneJsonRoot["foliage_zones"][i]["type"].asInt(), placedOnTerrain, terrainChannel, placedHeightDelta));
-				}
+			plannedBytes += cell->SizeInBytes;
+			cellsToLoad.push_back(cell);
+			pendingCellsCount++;
+		}
+
+		if (!cellsToUnload.empty())
+			UnloadStreamingCells(cellsToUnload);
+
+		for (StreamingCell* cell : cellsToLoad)
+			StartStreamingCellLoad(*cell);
+	}
+
+	// Objects get their scene IDs on the main thread (IDs are not reused, so the reserved ones stay empty until the cell is finished)
+	void ER_Scene::StartStreamingCellLoad(StreamingCell& aCell)
+	{
+		assert(aCell.State == STREAMING_CELL_UNLOADED);
+
+		std::vector<std::pair<int, int>> objectsToLoad; // index in the scene file, scene ID
+		objectsToLoad.reserve(aCell.ObjectsIndices.size());
+		for (int indexInScene : aCell.ObjectsIndices)
+		{
+			objectsToLoad.emplace_back(indexInScene, static_cast<int>(mRenderingObjectsByID.size()));
+			mRenderingObjectsByID.push_back(nullptr);
+		}
+
+		aCell.PendingLoad = std::async(std::launch::async, [this, objectsToLoad]() { return LoadStreamingCellObjects(objectsToLoad); });
+		aCell.State = STREAMING_CELL_LOADING;
+		mStreamingPendingCellsCount++;
+	}
+
+	// Runs on a worker thread while the level is rendered: objects are not added to the scene here and their json nodes are only read
+	std::vector<ER_RenderingObject*> ER_Scene::LoadStreamingCellObjects(const std::vector<std::pair<int, int>>& aObjects)
+	{
+		std::vector<ER_RenderingObject*> loadedObjects;
+		loadedObjects.reserve(aObjects.size());
+		ER_RHI::SetIsLoadingThread(true); // the work for the main context/command list is recorded in FinishStreamingCellLoad()
+		try
+		{
+			for (const std::pair<int, int>& objectToLoad : aObjects)
+			{
+				const Json::Value& objectRoot = mSceneDescription.GetRenderingObject(objectToLoad.first);
+				const std::string name = objectRoot["name"].asString();
+
+				ER_RenderingObject* object = new ER_RenderingObject(name, objectToLoad.first, *mCore, mCamera, ER_Utility::GetFilePath(objectRoot["model_path"].asString()), true, objectRoot["instanced"].asBool());
+				loadedObjects.push_back(object);
+
+				object->SetScene(this, objectToLoad.second);
+				object->SetStreamed(true);
+				LoadRenderingObjectData(object);
+				LoadRenderingObjectInstancedData(object);
+			}
+		}
+		catch (...)
+		{
+			// the objects are deleted on the main thread after their queued commands (that still use them) are recorded
+			ER_TextureStreamer* textureStreamer = GetCore()->GetServices().FindService<ER_TextureStreamer>();
+			for (ER_RenderingObject* object : loadedObjects)
+			{
+				if (textureStreamer)
+					textureStreamer->UnregisterOwner(object);
+			}
+			GetCore()->GetRHI()->EnqueueLoadingCommand([loadedObjects]()
+			{
+				for (ER_RenderingObject* object : loadedObjects)
+					DeleteObject(object);
+			});
+
+			ER_RHI::SetIsLoadingThread(false);
+			throw;
+		}
+
+		ER_RHI::SetIsLoadingThread(false);
+		return loadedObjects;
+	}
+
+	void ER_Scene::FinishStreamingCellLoad(StreamingCell& aCell)
+	{
+		assert(aCell.State == STREAMING_CELL_LOADING);
+
+		mStreamingPendingCellsCount--;
+		aCell.PendingLoad.wait();
+		GetCore()->GetRHI()->ExecuteLoadingCommands(); // before the exception of the loading thread is rethrown (its objects are deleted by the commands)
+		aCell.Objects = aCell.PendingLoad.get();
+		aCell.SizeInBytes = 0;
+
+		for (ER_RenderingObject* object : aCell.Objects)
+		{
+			mRenderingObjectsByID[object->GetSceneID()] = object;
+			InsertRenderingObject(object->GetName(), object);
+			StoreSavedRenderingObjectState(object);
+			RenderingObjectStreamedInEvent->Invoke(object);
+
+			aCell.SizeInBytes += GetEstimatedStreamingSize(object);
+		}
+
+		aCell.State = STREAMING_CELL_LOADED;
+		mStreamingResidentBytes += aCell.SizeInBytes;
+	}
+
+	// Changes of the objects (i.e., from the editor) are kept in their json nodes, so they are loaded back with the cell and saved with the scene
+	void ER_Scene::UnloadStreamingCells(const std::vector<StreamingCell*>& aCells)
+	{
+		// objects might still be used by the frames in flight
+		ER_RHI* rhi = GetCore()->GetRHI();
+		rhi->WaitForGpuOnGraphicsFence();
+		rhi->WaitForGpuOnComputeFence();
+
+		for (StreamingCell* cell : aCells)
+		{
+			assert(cell->State == STREAMING_CELL_UNLOADING);
+
+			for (ER_RenderingObject* object : cell->Objects)
+			{
+				SavedRenderingObjectState& state = mSavedRenderingObjects[object->GetIndexInScene()];
+				if (WriteRenderingObjectChanges(object) > 0)
+					state.HasUnsavedChanges = true;
+				state.SceneID = -1;
+
+				RemoveRenderingObject(object);
 			}
+			cell->Objects.clear();
+
+			mStreamingResidentBytes -= cell->SizeInBytes;
+			cell->State = STREAMING_CELL_UNLOADED;
+		}
+	}
+
+	void ER_Scene::LoadFoliageZonesData(std::vector<ER_Foliage*>& foliageZones, ER_DirectionalLight& light)
+	{
+		ER_Core* core = GetCore();
+		assert(core);
+
+		mSavedFoliageZonesProperties.clear();
+		for (const Json::Value* zoneNode : mSceneDescription.FoliageZones)
+		{
+			const Json::Value& zoneRoot = *zoneNode;
+
+			float vec3[3];
+			for (Json::Value::ArrayIndex ia = 0; ia != zoneRoot["position"].size(); ia++)
+				vec3[ia] = zoneRoot["position"][ia].asFloat();
+
+			bool placedOnTerrain = false;
+			if (zoneRoot.isMember("placed_on_terrain"))
+				placedOnTerrain = zoneRoot["placed_on_terrain"].asBool();
+			
+			TerrainSplatChannels terrainChannel = TerrainSplatChannels::NONE;
+			if (zoneRoot.isMember("placed_splat_channel"))
+				terrainChannel = (TerrainSplatChannels)(zoneRoot["placed_splat_channel"].asInt());
+
+			float placedHeightDelta = 0.0f;
+			if (zoneRoot.isMember("placed_height_delta"))
+				placedHeightDelta = zoneRoot["placed_height_delta"].asFloat();
+
+			foliageZones.push_back(new ER_Foliage(*core, mCamera, light,
+				zoneRoot["patch_count"].asInt(),
+				ER_Utility::GetFilePath(zoneRoot["texture_path"].asString()),
+				zoneRoot["average_scale"].asFloat(),
+				zoneRoot["distribution_radius"].asFloat(),
+				XMFLOAT3(vec3[0], vec3[1], vec3[2]),
+				(FoliageBillboardType)zoneRoot["type"].asInt(), placedOnTerrain, terrainChannel, placedHeightDelta));
+
+			mSavedFoliageZonesProperties.emplace_back();
+			SerializeFoliageZoneProperties(foliageZones.back(), mSavedFoliageZonesProperties.back());
 		}
 	}
-	// TODO: add functionality for storing flags, etc. (currently only transforms can be saved to json)
+	// Only writes the properties of the zones which have been changed since the scene was loaded/last saved
 	void ER_Scene::SaveFoliageZonesData(const std::vector<ER_Foliage*>& foliageZones)
 	{
 		if (mScenePath.empty())
 			throw ER_CoreException("Can't save to scene json file! Empty scene name...");
 
-		if (mSceneJsonRoot.isMember("foliage_zones")) {
-			assert(foliageZones.size() == mSceneJsonRoot["foliage_zones"].size());
-			float vec3[3];
-			for (Json::Value::ArrayIndex iz = 0; iz != mSceneJsonRoot["foliage_zones"].size(); iz++)
+		int changedPropertiesCount = 0;
+		if (mSceneDescription.Root.isMember("foliage_zones")) {
+			assert(foliageZones.size() == mSceneDescription.Root["foliage_zones"].size());
+			assert(foliageZones.size() == mSavedFoliageZonesProperties.size());
+
+			Json::Value currentProperties;
+			for (Json::Value::ArrayIndex iz = 0; iz != mSceneDescription.Root["foliage_zones"].size(); iz++)
 			{
-				Json::Value content(Json::arrayValue);
-				vec3[0] = foliageZones[iz]->GetDistributionCenter().x;
-				vec3[1] = foliageZones[iz]->GetDistributionCenter().y;
-				vec3[2] = foliageZones[iz]->GetDistributionCenter().z;
-				for (Json::Value::ArrayIndex i = 0; i < 3; i++)
-					content.append(vec3[i]);
-				mSceneJsonRoot["foliage_zones"][iz]["position"] = content;
+				SerializeFoliageZoneProperties(foliageZones[iz], currentProperties);
+				changedPropertiesCount += WriteChangedProperties(currentProperties, mSavedFoliageZonesProperties[iz], mSceneDescription.Root["foliage_zones"][iz]);
 			}
 		}
 
-		Json::StreamWriterBuilder builder;
-		std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
+		if (changedPropertiesCount == 0)
+		{
+			ER_OUTPUT_LOG(L"[ER Logger][ER_Scene] Foliage zones have not been changed since the last save, nothing to save.\n");
+			return;
+		}
 
-		std::ofstream file_id;
-		file_id.open(mScenePath.c_str());
-		writer->write(mSceneJsonRoot, &file_id);
+		WriteSceneFile();
 	}
 
 	void ER_Scene::LoadPostProcessingVolumesData()
@@ -837,115 +1503,113 @@ namespace EveryRay_Core
 
 		ER_PostProcessingStack* pp = core->GetLevel()->mPostProcessingStack;
 
-		Json::Reader reader;
-		std::ifstream scene(mScenePath.c_str(), std::ifstream::binary);
-
-		if (!reader.parse(scene, mSceneJsonRoot)) {
-			throw ER_CoreException(reader.getFormattedErrorMessages().c_str());
-		}
-		else
+		if (!mSceneDescription.PostEffectsVolumes.empty())
 		{
-			if (mSceneJsonRoot.isMember("posteffects_volumes")) 
+			XMFLOAT4X4 transform = 
 			{
-				XMFLOAT4X4 transform = 
-				{
-					1.f, 0.f, 0.f, 0.f,
-					0.f, 1.f, 0.f, 0.f,
-					0.f, 0.f, 1.f, 0.f,
-					0.f, 0.f, 0.f, 1.f
-				};
-				int size = mSceneJsonRoot["posteffects_volumes"].size();
-				pp->ReservePostEffectsVolumes(size);
-				for (Json::Value::ArrayIndex i = 0; i != size; i++)
+				1.f, 0.f, 0.f, 0.f,
+				0.f, 1.f, 0.f, 0.f,
+				0.f, 0.f, 1.f, 0.f,
+				0.f, 0.f, 0.f, 1.f
+			};
+			pp->ReservePostEffectsVolumes(static_cast<int>(mSceneDescription.PostEffectsVolumes.size()));
+			for (const Json::Value* volumeNode : mSceneDescription.PostEffectsVolumes)
+			{
+				const Json::Value& volumeRoot = *volumeNode;
+				if (volumeRoot.isMember("volume_transform"))
 				{
-					if (mSceneJsonRoot["posteffects_volumes"][i].isMember("volume_transform"))
+					if (volumeRoot["volume_transform"].size() == 16)
 					{
-						if (mSceneJsonRoot["posteffects_volumes"][i]["volume_transform"].size() == 16)
-						{
-							float matrix[16];
-							for (Json::Value::ArrayIndex matC = 0; matC != mSceneJsonRoot["posteffects_volumes"][i]["volume_transform"].size(); matC++)
-								matrix[matC] = mSceneJsonRoot["posteffects_volumes"][i]["volume_transform"][matC].asFloat();
-
-							XMFLOAT4X4 worldTransform(matrix);
-							XMMATRIX transformM = XMMatrixTranspose(XMLoadFloat4x4(&worldTransform));
-
-							XMStoreFloat4x4(&transform, transformM);
-						}
-					}
-
-					PostEffectsVolumeValues values = {};
+						float matrix[16];
+						for (Json::Value::ArrayIndex matC = 0; matC != volumeRoot["volume_transform"].size(); matC++)
+							matrix[matC] = volumeRoot["volume_transform"][matC].asFloat();
 
-					if (mSceneJsonRoot["posteffects_volumes"][i].isMember("posteffects_linearfog_enabled"))
-						values.linearFogEnable = mSceneJsonRoot["posteffects_volumes"][i]["posteffects_linearfog_enabled"].asBool();
-					if (mSceneJsonRoot["posteffects_volumes"][i].isMember("posteffects_linearfog_density"))
-						values.linearFogDensity = mSceneJsonRoot["posteffects_volumes"][i]["posteffects_linearfog_density"].asFloat();
-					if (mSceneJsonRoot["posteffects_volumes"][i].isMember("posteffects_linearfog_color"))
-					{
-						float vec3[3];
-						for (Json::Value::ArrayIndex j = 0; j != mSceneJsonRoot["posteffects_volumes"][i]["posteffects_linearfog_color"].size(); j++)
-							vec3[j] = mSceneJsonRoot["posteffects_volumes"][i]["posteffects_linearfog_color"][j].asFloat();
+						XMFLOAT4X4 worldTransform(matrix);
+						XMMATRIX transformM = XMMatrixTranspose(XMLoadFloat4x4(&worldTransform));
 
-						values.linearFogColor[0] = vec3[0];
-						values.linearFogColor[1] = vec3[1];
-						values.linearFogColor[2] = vec3[2];
+						XMStoreFloat4x4(&transform, transformM);
 					}
+				}
 
-					if (mSceneJsonRoot["posteffects_volumes"][i].isMember("posteffects_tonemapping_enabled"))
-						values.tonemappingEnable = mSceneJsonRoot["posteffects_volumes"][i]["posteffects_tonemapping_enabled"].asBool();
-
-					if (mSceneJsonRoot["posteffects_volumes"][i].isMember("posteffects_sss_enabled"))
-						values.sssEnable = mSceneJsonRoot["posteffects_volumes"][i]["posteffects_sss_enabled"].asBool();
-
-					if (mSceneJsonRoot["posteffects_volumes"][i].isMember("posteffects_ssr_enabled"))
-						values.ssrEnable = mSceneJsonRoot["posteffects_volumes"][i]["posteffects_ssr_enabled"].asBool();
-					if (mSceneJsonRoot["posteffects_volumes"][i].isMember("posteffects_ssr_maxthickness"))
-						values.ssrMaxThickness = mSceneJsonRoot["posteffects_volumes"][i]["posteffects_ssr_maxthickness"].asFloat();
-					if (mSceneJsonRoot["posteffects_volumes"][i].isMember("posteffects_ssr_stepsize"))
-						values.ssrStepSize = mSceneJsonRoot["posteffects_volumes"][i]["posteffects_ssr_stepsize"].asFloat();
-
-					if (mSceneJsonRoot["posteffects_volumes"][i].isMember("posteffects_vignette_enabled"))
-						values.vignetteEnable = mSceneJsonRoot["posteffects_volumes"][i]["posteffects_vignette_enabled"].asBool();
-					if (mSceneJsonRoot["posteffects_volumes"][i].isMember("posteffects_vignette_softness"))
-						values.vignetteSoftness = mSceneJsonRoot["posteffects_volumes"][i]["posteffects_vignette_softness"].asFloat();
-					if (mSceneJsonRoot["posteffects_volumes"][i].isMember("posteffects_vignette_radius"))
-						values.vignetteRadius = mSceneJsonRoot["posteffects_volumes"][i]["posteffects_vignette_radius"].asFloat();
-
-					if (mSceneJsonRoot["posteffects_volumes"][i].isMember("posteffects_colorgrading_enabled"))
-						values.colorGradingEnable = mSceneJsonRoot["posteffects_volumes"][i]["posteffects_colorgrading_enabled"].asBool();
-					if (mSceneJsonRoot["posteffects_volumes"][i].isMember("posteffects_colorgrading_lut_name"))
-						values.colorGradingLUTName = mSceneJsonRoot["posteffects_volumes"][i]["posteffects_colorgrading_lut_name"].asString();
+				PostEffectsVolumeValues values = {};
 
-					std::string name = "";
-					if (mSceneJsonRoot["posteffects_volumes"][i].isMember("volume_name"))
-						name = mSceneJsonRoot["posteffects_volumes"][i]["volume_name"].asString();
+				if (volumeRoot.isMember("posteffects_linearfog_enabled"))
+					values.linearFogEnable = volumeRoot["posteffects_linearfog_enabled"].asBool();
+				if (volumeRoot.isMember("posteffects_linearfog_density"))
+					values.linearFogDensity = volumeRoot["posteffects_linearfog_density"].asFloat();
+				if (volumeRoot.isMember("posteffects_linearfog_color"))
+				{
+					float vec3[3];
+					for (Json::Value::ArrayIndex j = 0; j != volumeRoot["posteffects_linearfog_color"].size(); j++)
+						vec3[j] = volumeRoot["posteffects_linearfog_color"][j].asFloat();
 
-					pp->AddPostEffectsVolume(transform, values, name);
+					values.linearFogColor[0] = vec3[0];
+					values.linearFogColor[1] = vec3[1];
+					values.linearFogColor[2] = vec3[2];
 				}
+
+				if (volumeRoot.isMember("posteffects_tonemapping_enabled"))
+					values.tonemappingEnable = volumeRoot["posteffects_tonemapping_enabled"].asBool();
+
+				if (volumeRoot.isMember("posteffects_sss_enabled"))
+					values.sssEnable = volumeRoot["posteffects_sss_enabled"].asBool();
+
+				if (volumeRoot.isMember("posteffects_ssr_enabled"))
+					values.ssrEnable = volumeRoot["posteffects_ssr_enabled"].asBool();
+				if (volumeRoot.isMember("posteffects_ssr_maxthickness"))
+					values.ssrMaxThickness = volumeRoot["posteffects_ssr_maxthickness"].asFloat();
+				if (volumeRoot.isMember("posteffects_ssr_stepsize"))
+					values.ssrStepSize = volumeRoot["posteffects_ssr_stepsize"].asFloat();
+
+				if (volumeRoot.isMember("posteffects_vignette_enabled"))
+					values.vignetteEnable = volumeRoot["posteffects_vignette_enabled"].asBool();
+				if (volumeRoot.isMember("posteffects_vignette_softness"))
+					values.vignetteSoftness = volumeRoot["posteffects_vignette_softness"].asFloat();
+				if (volumeRoot.isMember("posteffects_vignette_radius"))
+					values.vignetteRadius = volumeRoot["posteffects_vignette_radius"].asFloat();
+
+				if (volumeRoot.isMember("posteffects_colorgrading_enabled"))
+					values.colorGradingEnable = volumeRoot["posteffects_colorgrading_enabled"].asBool();
+				if (volumeRoot.isMember("posteffects_colorgrading_lut_name"))
+					values.colorGradingLUTName = volumeRoot["posteffects_colorgrading_lut_name"].asString();
+
+				if (volumeRoot.isMember("volume_priority"))
+					values.priority = volumeRoot["volume_priority"].asInt();
+				if (volumeRoot.isMember("volume_blend_distance"))
+					values.blendDistance = volumeRoot["volume_blend_distance"].asFloat();
+				if (volumeRoot.isMember("volume_weight"))
+					values.weight = volumeRoot["volume_weight"].asFloat();
+
+				std::string name = "";
+				if (volumeRoot.isMember("volume_name"))
+					name = volumeRoot["volume_name"].asString();
+
+				pp->AddPostEffectsVolume(transform, values, name);
 			}
 		}
 
 		// set default flags
 
-		if (mSceneJsonRoot.isMember("posteffects_aa_enabled"))
-			pp->SetUseAntiAliasing(mSceneJsonRoot["posteffects_aa_enabled"].asBool());
+		if (mSceneDescription.Root.isMember("posteffects_aa_enabled"))
+			pp->SetUseAntiAliasing(mSceneDescription.Root["posteffects_aa_enabled"].asBool());
 
-		if (mSceneJsonRoot.isMember("posteffects_ssr_default"))
-			pp->SetUseSSR(mSceneJsonRoot["posteffects_ssr_default"].asBool(), true);
+		if (mSceneDescription.Root.isMember("posteffects_ssr_default"))
+			pp->SetUseSSR(mSceneDescription.Root["posteffects_ssr_default"].asBool(), true);
 
-		if (mSceneJsonRoot.isMember("posteffects_sss_default"))
-			pp->SetUseSSS(mSceneJsonRoot["posteffects_sss_default"].asBool(), true);
+		if (mSceneDescription.Root.isMember("posteffects_sss_default"))
+			pp->SetUseSSS(mSceneDescription.Root["posteffects_sss_default"].asBool(), true);
 
-		if (mSceneJsonRoot.isMember("posteffects_vignette_default"))
-			pp->SetUseVignette(mSceneJsonRoot["posteffects_vignette_default"].asBool(), true);
+		if (mSceneDescription.Root.isMember("posteffects_vignette_default"))
+			pp->SetUseVignette(mSceneDescription.Root["posteffects_vignette_default"].asBool(), true);
 
-		if (mSceneJsonRoot.isMember("posteffects_tonmapping_default"))
-			pp->SetUseTonemapping(mSceneJsonRoot["posteffects_tonmapping_default"].asBool(), true);
+		if (mSceneDescription.Root.isMember("posteffects_tonmapping_default"))
+			pp->SetUseTonemapping(mSceneDescription.Root["posteffects_tonmapping_default"].asBool(), true);
 
-		if (mSceneJsonRoot.isMember("posteffects_linearfog_default"))
-			pp->SetUseLinearFog(mSceneJsonRoot["posteffects_linearfog_default"].asBool(), true);
+		if (mSceneDescription.Root.isMember("posteffects_linearfog_default"))
+			pp->SetUseLinearFog(mSceneDescription.Root["posteffects_linearfog_default"].asBool(), true);
 
-		if (mSceneJsonRoot.isMember("posteffects_colorgrading_default"))
-			pp->SetUseColorGrading(mSceneJsonRoot["posteffects_colorgrading_default"].asBool(), true);
+		if (mSceneDescription.Root.isMember("posteffects_colorgrading_default"))
+			pp->SetUseColorGrading(mSceneDescription.Root["posteffects_colorgrading_default"].asBool(), true);
 	}
 	void ER_Scene::SavePostProcessingVolumesData()
 	{
@@ -957,13 +1621,13 @@ namespace EveryRay_Core
 
 		ER_PostProcessingStack* pp = core->GetLevel()->mPostProcessingStack;
 
-		if (mSceneJsonRoot.isMember("posteffects_volumes"))
+		if (mSceneDescription.Root.isMember("posteffects_volumes"))
 		{
-			assert(pp->GetPostEffectsVolumesCount() == mSceneJsonRoot["posteffects_volumes"].size());
-			for (Json::Value::ArrayIndex i = 0; i != mSceneJsonRoot["posteffects_volumes"].size(); i++)
+			assert(pp->GetPostEffectsVolumesCount() == mSceneDescription.Root["posteffects_volumes"].size());
+			for (Json::Value::ArrayIndex i = 0; i != mSceneDescription.Root["posteffects_volumes"].size(); i++)
 			{
 				Json::Value content(Json::arrayValue);
-				if (mSceneJsonRoot["posteffects_volumes"][i].isMember("volume_transform"))
+				if (mSceneDescription.Root["posteffects_volumes"][i].isMember("volume_transform"))
 				{
 					const PostEffectsVolume& volume = pp->GetPostEffectsVolume(i);
 					
@@ -974,7 +1638,7 @@ namespace EveryRay_Core
 					ER_MatrixHelper::SetFloatArray(mat, matF);
 					for (int i = 0; i < 16; i++)
 						content.append(matF[i]);
-					mSceneJsonRoot["posteffects_volumes"][i]["volume_transform"] = content;
+					mSceneDescription.Root["posteffects_volumes"][i]["volume_transform"] = content;
 				}
 				else
 				{
@@ -985,50 +1649,51 @@ namespace EveryRay_Core
 
 					for (int i = 0; i < 16; i++)
 						content.append(matF[i]);
-					mSceneJsonRoot["posteffects_volumes"][i]["volume_transform"] = content;
+					mSceneDescription.Root["posteffects_volumes"][i]["volume_transform"] = content;
 				}
+
+				const PostEffectsVolumeValues& values = pp->GetPostEffectsVolume(i).values;
+				mSceneDescription.Root["posteffects_volumes"][i]["volume_priority"] = values.priority;
+				mSceneDescription.Root["posteffects_volumes"][i]["volume_blend_distance"] = values.blendDistance;
+				mSceneDescription.Root["posteffects_volumes"][i]["volume_weight"] = values.weight;
 			}
 		}
 
-		Json::StreamWriterBuilder builder;
-		std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
-
-		std::ofstream file_id;
-		file_id.open(mScenePath.c_str());
-		writer->write(mSceneJsonRoot, &file_id);
+		WriteSceneFile();
 	}
 
 	void ER_Scene::LoadPointLightsData()
 	{
 		std::vector<ER_PointLight*>& lights = GetCore()->GetLevel()->mPointLights;
 
-		unsigned int numLights = mSceneJsonRoot["point_lights"].size();
-		for (Json::Value::ArrayIndex i = 0; i != numLights; i++)
+		for (const Json::Value* lightNode : mSceneDescription.PointLights)
 		{
+			const Json::Value& lightRoot = *lightNode;
+
 			float position[3] = { 0.0, 0.0, 0.0 };
-			if (mSceneJsonRoot["point_lights"][i].isMember("position"))
+			if (lightRoot.isMember("position"))
 			{
-				for (Json::Value::ArrayIndex j = 0; j != mSceneJsonRoot["point_lights"][i]["position"].size(); j++)
-					position[j] = mSceneJsonRoot["point_lights"][i]["position"][j].asFloat();
+				for (Json::Value::ArrayIndex j = 0; j != lightRoot["position"].size(); j++)
+					position[j] = lightRoot["position"][j].asFloat();
 
 				//light.SetPosition(XMFLOAT3(position[0], position[1], position[2]));
 			}
 
 			float radius = 0.0;
-			if (mSceneJsonRoot["point_lights"][i].isMember("radius"))
-				radius = mSceneJsonRoot["point_lights"][i]["radius"].asFloat();
-			//light.SetRadius(mSceneJsonRoot["point_lights"][i]["radius"].asFloat());
+			if (lightRoot.isMember("radius"))
+				radius = lightRoot["radius"].asFloat();
+			//light.SetRadius(lightRoot["radius"].asFloat());
 
 			if (static_cast<int>(lights.size()) < MAX_NUM_POINT_LIGHTS)
 				lights.push_back(new ER_PointLight(*GetCore(), XMFLOAT3(position[0], position[1], position[2]), radius));
 			else
 				throw ER_CoreException("Exceeded the max number of point lights when loading the scene!");
 
-			if (mSceneJsonRoot["point_lights"][i].isMember("color"))
+			if (lightRoot.isMember("color"))
 			{
 				float vec4[4];
-				for (Json::Value::ArrayIndex j = 0; j != mSceneJsonRoot["point_lights"][i]["color"].size(); j++)
-					vec4[j] = mSceneJsonRoot["point_lights"][i]["color"][j].asFloat();
+				for (Json::Value::ArrayIndex j = 0; j != lightRoot["color"].size(); j++)
+					vec4[j] = lightRoot["color"][j].asFloat();
 
 				lights.back()->SetColor(XMFLOAT4(vec4[0], vec4[1], vec4[2], vec4[3]));
 			}
@@ -1043,11 +1708,11 @@ namespace EveryRay_Core
 		std::vector<ER_PointLight*>& lights = GetCore()->GetLevel()->mPointLights;
 		
 		// store world transform
-		for (Json::Value::ArrayIndex i = 0; i != mSceneJsonRoot["point_lights"].size(); i++) 
+		for (Json::Value::ArrayIndex i = 0; i != mSceneDescription.Root["point_lights"].size(); i++) 
 		{
 			ER_PointLight* light = lights[i];
 
-			if (mSceneJsonRoot["point_lights"][i].isMember("position")) 
+			if (mSceneDescription.Root["point_lights"][i].isMember("position")) 
 			{
 				Json::Value content(Json::arrayValue);
 				if (light)
@@ -1056,11 +1721,11 @@ namespace EveryRay_Core
 					content.append(light->GetPosition().y);
 					content.append(light->GetPosition().z);
 
-					mSceneJsonRoot["point_lights"][i]["position"] = content;
+					mSceneDescription.Root["point_lights"][i]["position"] = content;
 				}
 			}
 
-			if (mSceneJsonRoot["point_lights"][i].isMember("color"))
+			if (mSceneDescription.Root["point_lights"][i].isMember("color"))
 			{
 				Json::Value content(Json::arrayValue);
 				if (light)
@@ -1070,23 +1735,18 @@ namespace EveryRay_Core
 					content.append(light->GetColor().z);
 					content.append(light->GetColor().w);
 
-					mSceneJsonRoot["point_lights"][i]["color"] = content;
+					mSceneDescription.Root["point_lights"][i]["color"] = content;
 				}
 			}
 
-			if (mSceneJsonRoot["point_lights"][i].isMember("radius"))
+			if (mSceneDescription.Root["point_lights"][i].isMember("radius"))
 			{
 				if (light)
-					mSceneJsonRoot["point_lights"][i]["radius"] = light->mRadius;
+					mSceneDescription.Root["point_lights"][i]["radius"] = light->mRadius;
 			}
 		}
 
-		Json::StreamWriterBuilder builder;
-		std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
-
-		std::ofstream file_id;
-		file_id.open(mScenePath.c_str());
-		writer->write(mSceneJsonRoot, &file_id);
+		WriteSceneFile();
 	}
 	
 	// We cant do reflection in C++, that is why we check every materials name and create a material out of it (and root-signature if needed)
@@ -1123,6 +1783,7 @@ namespace EveryRay_Core
 
 	ER_RHI_GPURootSignature* ER_Scene::GetStandardMaterialRootSignature(const std::string& materialName)
 	{
+		std::lock_guard<std::mutex> lock(mStandardMaterialsRootSignaturesMutex); // cells can be streamed in while the scene is rendered
 		auto it = mStandardMaterialsRootSignatures.find(materialName);
 		if (it != mStandardMaterialsRootSignatures.end())
 		{
@@ -5,13 +5,22 @@
 #include "ER_ModelMaterial.h"
 #include "ER_Material.h"
 
-#include "..\JsonCpp\include\json\json.h"
+#include "ER_SceneDescription.h"
+#include "ER_GenericEvent.h"
+
+#include <functional>
+#include <future>
+
+#define LEVEL_STREAMING_UPDATE_FREQUENCY 10 // in frames
+#define LEVEL_STREAMING_MAX_PENDING_CELLS 2 // max # of cells that are loaded in the background at the same time
+#define LEVEL_STREAMING_DEFAULT_BUDGET_MB 1024 // if "streaming_memory_budget_mb" is not in the scene file
 
 namespace EveryRay_Core
 {
 	class ER_RenderingObject;
 	class ER_DirectionalLight;
 	class ER_Foliage;
+	class ER_InstanceBufferPool;
 	using ER_SceneObject = std::pair<std::string, ER_RenderingObject*>;
 
 	class ER_Scene : public ER_CoreComponent
@@ -22,9 +31,30 @@ namespace EveryRay_Core
 
 		void LoadRenderingObjectData(ER_RenderingObject* aObject);
 		void SaveRenderingObjectsData();
-		ER_RenderingObject* FindRenderingObjectByName(const std::string& aName);
+
+		// Objects are owned by the scene. Always add/remove them with these methods (not directly in 'objects'), so the lookups below stay valid.
+		// Names are not required to be unique: lookups by name return the first added object with that name.
+		ER_RenderingObject* AddRenderingObject(const std::string& aName, ER_RenderingObject* aObject);
+		bool RemoveRenderingObject(ER_RenderingObject* aObject); // also deletes the object
+		void OnRenderingObjectRenamed(ER_RenderingObject* aObject, const std::string& aOldName); // called from ER_RenderingObject::Rename()
+
+		ER_RenderingObject* FindRenderingObjectByName(const std::string& aName) const;
+		ER_RenderingObject* FindRenderingObjectByID(int aID) const;
+
 		std::vector<ER_SceneObject> objects;
 
+		// Level streaming (only if the scene file has "streaming_cell_size"): rendering objects are grouped into cells on the XZ plane,
+		// cells around the camera are loaded on worker threads and far cells are unloaded, so that their geometry fits into the memory budget.
+		// Must be called at the beginning of the frame's update (before any system gathers the objects of the scene for the frame).
+		void UpdateStreaming(const XMFLOAT3& aCameraPosition);
+		bool IsStreamingEnabled() const { return mStreamingCellSize > 0.0f; }
+
+		using Delegate_RenderingObjectStreamedIn = std::function<void(ER_RenderingObject*)>;
+		ER_GenericEvent<Delegate_RenderingObjectStreamedIn>* RenderingObjectStreamedInEvent = new ER_GenericEvent<Delegate_RenderingObjectStreamedIn>(); // after the object is added to the scene
+
+		// instance buffer ranges of the objects (which are not GPU indirectly rendered) are suballocated from this pool
+		ER_InstanceBufferPool* GetInstanceBufferPool() const { return mInstanceBufferPool; }
+
 		ER_Material* GetMaterialByName(const std::string& matName, const MaterialShaderEntries& entries, bool instanced, int layerIndex = -1);
 		ER_RHI_GPURootSignature* GetStandardMaterialRootSignature(const std::string& materialName);
 		
@@ -42,17 +72,77 @@ namespace EveryRay_Core
 		bool IsValueInSceneRoot(const std::string& aName);
 
 	private:
+		// Editable state of a scene file's object as it was last loaded/saved, so saving only touches what has changed since then.
+		// Read-only data of the object (model and LOD paths, materials, textures) is never re-serialized: it stays in the object's json node.
+		struct SavedRenderingObjectState
+		{
+			int SceneID = -1;
+			Json::Value Properties;
+			std::vector<XMFLOAT4X4> InstancesTransforms; // only for objects with "instances_transforms" in the scene file
+			bool HasUnsavedChanges = false; // changes of streamed out objects are kept in their json nodes until the scene is saved
+		};
+
+		enum StreamingCellState
+		{
+			STREAMING_CELL_UNLOADED = 0,
+			STREAMING_CELL_LOADING,
+			STREAMING_CELL_LOADED,
+			STREAMING_CELL_UNLOADING
+		};
+
+		struct StreamingCell
+		{
+			XMFLOAT2 Min = XMFLOAT2(0.0f, 0.0f); // on XZ plane
+			XMFLOAT2 Max = XMFLOAT2(0.0f, 0.0f);
+			std::vector<int> ObjectsIndices; // in the scene file
+			std::vector<ER_RenderingObject*> Objects; // only when loaded
+			std::future<std::vector<ER_RenderingObject*>> PendingLoad;
+			StreamingCellState State = STREAMING_CELL_UNLOADED;
+			UINT64 SizeInBytes = 0; // estimated, 0 until the cell has been loaded once
+			float Distance = 0.0f; // to the camera (on XZ plane)
+		};
+
 		void LoadRenderingObjectInstancedData(ER_RenderingObject* aObject);
-		
+		void StoreSavedRenderingObjectState(ER_RenderingObject* aObject);
+		int WriteRenderingObjectChanges(ER_RenderingObject* aObject); // into its json node, returns the number of changes
+		void RunLoadingJobs(int aJobsCount, const std::function<void(int)>& aJob);
+		void WriteSceneFile();
+
+		void InitStreamingCells(std::vector<int>& outCellsIndices); // -1 for objects that are not streamed
+		void StartStreamingCellLoad(StreamingCell& aCell);
+		std::vector<ER_RenderingObject*> LoadStreamingCellObjects(const std::vector<std::pair<int, int>>& aObjects); // on a worker thread
+		void FinishStreamingCellLoad(StreamingCell& aCell);
+		void UnloadStreamingCells(const std::vector<StreamingCell*>& aCells);
+		void InsertRenderingObject(const std::string& aName, ER_RenderingObject* aObject);
+
 		void CreateStandardMaterialsRootSignatures();
 
 		void ShowNoValueFoundMessage(const std::string& aName);
+		void IndexRenderingObjectName(const std::string& aName); // (re)indexes the first object with that name
 
 		std::map<std::string, ER_RHI_GPURootSignature*> mStandardMaterialsRootSignatures;
+		std::mutex mStandardMaterialsRootSignaturesMutex; // fur layers add their entries while objects are loaded in parallel
 
-		Json::Value mSceneJsonRoot;
+		std::unordered_map<std::string, ER_RenderingObject*> mRenderingObjectsByName;
+		std::vector<ER_RenderingObject*> mRenderingObjectsByID; // nullptr for removed objects (IDs are not reused)
+
+		ER_InstanceBufferPool* mInstanceBufferPool = nullptr;
+
+		ER_SceneDescription mSceneDescription;
 		std::string mScenePath;
 
+		std::vector<SavedRenderingObjectState> mSavedRenderingObjects; // by index in the scene file
+		std::vector<Json::Value> mSavedFoliageZonesProperties; // by index in the scene file
+
+		std::vector<StreamingCell> mStreamingCells;
+		float mStreamingCellSize = 0.0f;
+		float mStreamingLoadDistance = 0.0f;
+		float mStreamingUnloadDistance = 0.0f; // a bit more than the load distance, so cells on the border do not stream back and forth
+		UINT64 mStreamingBudgetInBytes = 0;
+		UINT64 mStreamingResidentBytes = 0;
+		UINT mStreamingFrameIndex = 0;
+		int mStreamingPendingCellsCount = 0;
+
 		ER_Camera& mCamera;
 	};
 }
\ No newline at end of file
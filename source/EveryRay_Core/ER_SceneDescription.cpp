@@ -0,0 +1,61 @@
+#include "ER_SceneDescription.h"
+
+#include <fstream>
+#include <iterator>
+#include <memory>
+
+namespace EveryRay_Core
+{
+	static void ResolveSectionNodes(const Json::Value& aRoot, const char* aSectionName, std::vector<const Json::Value*>& outNodes)
+	{
+		outNodes.clear();
+
+		const Json::Value& section = aRoot[aSectionName];
+		if (!section.isArray())
+			return;
+
+		outNodes.reserve(section.size());
+		for (Json::Value::ArrayIndex i = 0; i != section.size(); i++)
+			outNodes.push_back(&section[i]);
+	}
+
+	bool ER_SceneDescription::LoadFromFile(const std::string& aPath, std::string& outErrors)
+	{
+		std::ifstream file(aPath.c_str(), std::ifstream::binary);
+		if (!file.is_open())
+		{
+			outErrors = "Could not open the scene file: " + aPath;
+			return false;
+		}
+
+		// read the whole file at once and parse it from memory
+		const std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		return Parse(content.data(), content.data() + content.size(), outErrors);
+	}
+
+	bool ER_SceneDescription::Parse(const char* aBegin, const char* aEnd, std::string& outErrors)
+	{
+		Json::CharReaderBuilder builder;
+		std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+
+		Root = Json::Value();
+		if (!reader->parse(aBegin, aEnd, &Root, &outErrors))
+		{
+			Root = Json::Value();
+			ResolveNodes();
+			return false;
+		}
+
+		ResolveNodes();
+		return true;
+	}
+
+	void ER_SceneDescription::ResolveNodes()
+	{
+		const Json::Value& root = Root;
+		ResolveSectionNodes(root, "rendering_objects", RenderingObjects);
+		ResolveSectionNodes(root, "point_lights", PointLights);
+		ResolveSectionNodes(root, "foliage_zones", FoliageZones);
+		ResolveSectionNodes(root, "posteffects_volumes", PostEffectsVolumes);
+	}
+}
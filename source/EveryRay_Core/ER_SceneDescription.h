@@ -0,0 +1,29 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "json/json.h"
+
+namespace EveryRay_Core
+{
+	// Parsed scene file: the file is read and parsed once per scene load, the nodes of the sections are resolved once after parsing
+	// (i.e., every "rendering_objects" node can be taken by the object's index in the scene without looking it up again).
+	// Only depends on JsonCpp and the standard library (no RHI, no Windows), so it can be used by tools and tests on other platforms too.
+	// Nodes are not copied: they stay valid until the section they belong to gets elements added/removed (then call ResolveNodes()).
+	struct ER_SceneDescription
+	{
+		Json::Value Root;
+
+		// cached section nodes (in order of the file)
+		std::vector<const Json::Value*> RenderingObjects;
+		std::vector<const Json::Value*> PointLights;
+		std::vector<const Json::Value*> FoliageZones;
+		std::vector<const Json::Value*> PostEffectsVolumes;
+
+		bool LoadFromFile(const std::string& aPath, std::string& outErrors);
+		bool Parse(const char* aBegin, const char* aEnd, std::string& outErrors);
+		void ResolveNodes();
+
+		const Json::Value& GetRenderingObject(int aIndex) const { return *RenderingObjects[aIndex]; }
+	};
+}
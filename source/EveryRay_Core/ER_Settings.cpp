@@ -10,4 +10,8 @@ namespace EveryRay_Core
 	int ER_Settings::FoliageQuality = 0;
 	int ER_Settings::AntiAliasingQuality = 0;
 	int ER_Settings::SubsurfaceScatteringQuality = 0;
+
+	int ER_Settings::GIVoxelCascadeResolution = 128;
+	int ER_Settings::GIDiffuseConesCount = 6;
+	int ER_Settings::GISpecularProbesLimit = 216;
 }
\ No newline at end of file
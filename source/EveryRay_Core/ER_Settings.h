@@ -13,5 +13,10 @@ namespace EveryRay_Core
 		static int FoliageQuality;
 		static int AntiAliasingQuality;
 		static int SubsurfaceScatteringQuality;
+
+		// from the tier of the current GlobalIlluminationQuality
+		static int GIVoxelCascadeResolution;
+		static int GIDiffuseConesCount;
+		static int GISpecularProbesLimit;
 	};
 }
\ No newline at end of file
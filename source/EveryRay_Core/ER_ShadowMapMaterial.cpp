@@ -10,14 +10,39 @@
 
 namespace EveryRay_Core
 {
-	ER_ShadowMapMaterial::ER_ShadowMapMaterial(ER_Core& game, const MaterialShaderEntries& entries, unsigned int shaderFlags, bool instanced)
+	ER_ShadowMapMaterial::ER_ShadowMapMaterial(ER_Core& game, const MaterialShaderEntries& entries, unsigned int shaderFlags, bool instanced, bool positionOnly)
 		: ER_Material(game, entries, shaderFlags)
 	{
 		mIsStandard = false;
+		mIsPositionOnly = positionOnly;
+		assert(!positionOnly || !(shaderFlags & HAS_PIXEL_SHADER));
 
 		if (shaderFlags & HAS_VERTEX_SHADER)
 		{
-			if (!instanced)
+			if (positionOnly)
+			{
+				if (!instanced)
+				{
+					ER_RHI_INPUT_ELEMENT_DESC inputElementDescriptions[] =
+					{
+						{ "POSITION", 0, ER_FORMAT_R32G32B32A32_FLOAT, 0, 0, true, 0 }
+					};
+					ER_Material::CreateVertexShader("content\\shaders\\ShadowMap.hlsl", inputElementDescriptions, ARRAYSIZE(inputElementDescriptions));
+				}
+				else
+				{
+					ER_RHI_INPUT_ELEMENT_DESC inputElementDescriptionsInstanced[] =
+					{
+						{ "POSITION", 0, ER_FORMAT_R32G32B32A32_FLOAT, 0, 0, true, 0 },
+						{ "WORLD", 0, ER_FORMAT_R32G32B32A32_FLOAT, 1, 0, false, 1 },
+						{ "WORLD", 1, ER_FORMAT_R32G32B32A32_FLOAT, 1, 16,false, 1 },
+						{ "WORLD", 2, ER_FORMAT_R32G32B32A32_FLOAT, 1, 32,false, 1 },
+						{ "WORLD", 3, ER_FORMAT_R32G32B32A32_FLOAT, 1, 48,false, 1 }
+					};
+					ER_Material::CreateVertexShader("content\\shaders\\ShadowMap.hlsl", inputElementDescriptionsInstanced, ARRAYSIZE(inputElementDescriptionsInstanced));
+				}
+			}
+			else if (!instanced)
 			{
 				ER_RHI_INPUT_ELEMENT_DESC inputElementDescriptions[] =
 				{
@@ -60,7 +85,7 @@ namespace EveryRay_Core
 	void ER_ShadowMapMaterial::PrepareForRendering(ER_MaterialSystems neededSystems, ER_RenderingObject* aObj, int meshIndex, int cascadeIndex, ER_RHI_GPURootSignature* rs)
 	{
 		auto rhi = ER_Material::GetCore()->GetRHI();
-		ER_Camera* camera = (ER_Camera*)(ER_Material::GetCore()->GetServices().FindService(ER_Camera::TypeIdClass()));
+		ER_Camera* camera = ER_Material::GetCore()->GetServices().FindService<ER_Camera>();
 
 		assert(aObj);
 		assert(camera);
@@ -79,13 +104,16 @@ namespace EveryRay_Core
 		}
 		else
 			rhi->SetConstantBuffers(ER_VERTEX, { mConstantBuffer.Buffer(), aObj->GetObjectsConstantBuffer().Buffer() }, 0, rs, SHADOWMAP_MAT_ROOT_DESCRIPTOR_TABLE_CBV_INDEX);
-		rhi->SetConstantBuffers(ER_PIXEL, { mConstantBuffer.Buffer(), aObj->GetObjectsConstantBuffer().Buffer() }, 0, rs, SHADOWMAP_MAT_ROOT_DESCRIPTOR_TABLE_CBV_INDEX);
-
-		if (aObj->GetTextureData(meshIndex).AlbedoMap)
-			rhi->SetShaderResources(ER_PIXEL, { aObj->GetTextureData(meshIndex).AlbedoMap }, 0, rs, SHADOWMAP_MAT_ROOT_DESCRIPTOR_TABLE_PIXEL_SRV_INDEX);
+		if (!mIsPositionOnly)
+		{
+			rhi->SetConstantBuffers(ER_PIXEL, { mConstantBuffer.Buffer(), aObj->GetObjectsConstantBuffer().Buffer() }, 0, rs, SHADOWMAP_MAT_ROOT_DESCRIPTOR_TABLE_CBV_INDEX);
+			if (aObj->GetTextureData(meshIndex).AlbedoMap)
+				rhi->SetShaderResources(ER_PIXEL, { aObj->GetTextureData(meshIndex).AlbedoMap }, 0, rs, SHADOWMAP_MAT_ROOT_DESCRIPTOR_TABLE_PIXEL_SRV_INDEX);
+		}
 		if (aObj->IsGPUIndirectlyRendered())
 			rhi->SetShaderResources(ER_VERTEX, { aObj->GetIndirectNewInstanceBuffer() }, 1, rs, SHADOWMAP_MAT_ROOT_DESCRIPTOR_TABLE_VERTEX_SRV_INDEX);
-		rhi->SetSamplers(ER_PIXEL, { ER_RHI_SAMPLER_STATE::ER_TRILINEAR_WRAP });
+		if (!mIsPositionOnly)
+			rhi->SetSamplers(ER_PIXEL, { ER_RHI_SAMPLER_STATE::ER_TRILINEAR_WRAP });
 	}
 
 	void ER_ShadowMapMaterial::PrepareResourcesForStandardMaterial(ER_MaterialSystems neededSystems, ER_RenderingObject* aObj, int meshIndex, ER_RHI_GPURootSignature* rs)
@@ -101,12 +129,15 @@ namespace EveryRay_Core
 
 	void ER_ShadowMapMaterial::CreateVertexBuffer(const ER_Mesh& mesh, ER_RHI_GPUBuffer* vertexBuffer)
 	{
-		mesh.CreateVertexBuffer_PositionUvNormalTangent(vertexBuffer);
+		if (mIsPositionOnly)
+			mesh.CreateVertexBuffer_Position(vertexBuffer);
+		else
+			mesh.CreateVertexBuffer_PositionUvNormalTangent(vertexBuffer);
 	}
 
 	int ER_ShadowMapMaterial::VertexSize()
 	{
-		return sizeof(VertexPositionTextureNormalTangent);
+		return mIsPositionOnly ? sizeof(VertexPosition) : sizeof(VertexPositionTextureNormalTangent);
 	}
 
 }
\ No newline at end of file
@@ -21,7 +21,8 @@ namespace EveryRay_Core
 	class ER_ShadowMapMaterial : public ER_Material
 	{
 	public:
-		ER_ShadowMapMaterial(ER_Core& game, const MaterialShaderEntries& entries, unsigned int shaderFlags, bool instanced = false);
+		// "positionOnly" variant has no pixel shader (no alpha testing) and reads the position-only vertex stream of the mesh
+		ER_ShadowMapMaterial(ER_Core& game, const MaterialShaderEntries& entries, unsigned int shaderFlags, bool instanced = false, bool positionOnly = false);
 		~ER_ShadowMapMaterial();
 
 		void PrepareForRendering(ER_MaterialSystems neededSystems, ER_RenderingObject* aObj, int meshIndex, int cascadeIndex, ER_RHI_GPURootSignature* rs);
@@ -23,6 +23,8 @@
 
 static const std::string psoNameNonInstanced = "ER_RHI_GPUPipelineStateObject: ShadowMapMaterial";
 static const std::string psoNameInstanced = "ER_RHI_GPUPipelineStateObject: ShadowMapMaterial w/ Instancing";
+static const std::string psoNamePositionOnlyNonInstanced = "ER_RHI_GPUPipelineStateObject: ShadowMapMaterial (position only)";
+static const std::string psoNamePositionOnlyInstanced = "ER_RHI_GPUPipelineStateObject: ShadowMapMaterial (position only) w/ Instancing";
 
 namespace EveryRay_Core
 {
@@ -155,6 +157,15 @@ namespace EveryRay_Core
 		mOriginalViewport = rhi->GetCurrentViewport();
 		mOriginalRect = rhi->GetCurrentRect();
 
+		rhi->ClearDepthStencilTarget(mShadowMaps[cascadeIndex], 1.0f);
+		SetShadowMapTarget(cascadeIndex);
+	}
+
+	// sets the target without clearing and without storing the original states (can be called from the recording threads)
+	void ER_ShadowMapper::SetShadowMapTarget(int cascadeIndex)
+	{
+		auto rhi = GetCore()->GetRHI();
+
 		ER_RHI_Viewport newViewport;
 		newViewport.TopLeftX = 0.0f;
 		newViewport.TopLeftY = 0.0f;
@@ -166,7 +177,6 @@ namespace EveryRay_Core
 		ER_RHI_Rect newRect = { 0, 0, static_cast<LONG>(mShadowMaps[cascadeIndex]->GetWidth()), static_cast<LONG>(mShadowMaps[cascadeIndex]->GetHeight()) };
 
 		rhi->SetDepthTarget(mShadowMaps[cascadeIndex]);
-		rhi->ClearDepthStencilTarget(mShadowMaps[cascadeIndex], 1.0f);
 		rhi->SetViewport(newViewport);
 		rhi->SetRect(newRect);
 	}
@@ -320,12 +330,41 @@ namespace EveryRay_Core
 	{
 		auto rhi = GetCore()->GetRHI();
 
-		ER_MaterialSystems materialSystems;
-		materialSystems.mShadowMapper = this;
+		std::vector<ER_RenderingObject*> objects;
+		objects.reserve(scene->objects.size());
+		for (auto& renderingObjectInfo : scene->objects)
+			objects.push_back(renderingObjectInfo.second);
+
+		const int threadsCount = static_cast<int>(std::min<size_t>({
+			static_cast<size_t>(ER_RHI_MAX_PARALLEL_GRAPHICS_COMMAND_LISTS),
+			static_cast<size_t>(std::max(std::thread::hardware_concurrency(), 1u)),
+			objects.size() / SHADOWS_MIN_OBJECTS_PER_RECORDING_THREAD }));
+
+		if (!rhi->IsParallelRecordingSupported() || threadsCount < 2)
+		{
+			for (int i = 0; i < NUM_SHADOW_CASCADES; i++)
+			{
+				BeginRenderingToShadowMap(i);
 
+				rhi->BeginEventTag("EveryRay: Shadow Maps (terrain), cascade " + std::to_string(i));
+				if (terrain)
+					terrain->Draw(TerrainRenderPass::TERRAIN_SHADOW, { mShadowMaps[i] }, nullptr, this, nullptr, i);
+				rhi->EndEventTag();
+
+				rhi->BeginEventTag("EveryRay: Shadow Maps (objects), cascade " + std::to_string(i));
+				DrawObjects(objects, 0, static_cast<int>(objects.size()), i);
+				rhi->EndEventTag();
+
+				StopRenderingToShadowMap(i);
+			}
+			return;
+		}
+
+		// Parallel recording: clears and terrain go into the main command list, objects are split between the recording threads.
+		// Every thread draws its own objects into all cascades, so the constant buffers of an object are only updated by one thread.
+		// The shadow maps are already in the depth-write state after the main list, so the threads do not transition anything.
 		for (int i = 0; i < NUM_SHADOW_CASCADES; i++)
 		{
-			std::string materialName = ER_MaterialHelper::shadowMapMaterialName + " " + std::to_string(i);
 			BeginRenderingToShadowMap(i);
 
 			rhi->BeginEventTag("EveryRay: Shadow Maps (terrain), cascade " + std::to_string(i));
@@ -333,49 +372,109 @@ namespace EveryRay_Core
 				terrain->Draw(TerrainRenderPass::TERRAIN_SHADOW, { mShadowMaps[i] }, nullptr, this, nullptr, i);
 			rhi->EndEventTag();
 
-			rhi->BeginEventTag("EveryRay: Shadow Maps (objects), cascade " + std::to_string(i));
+			StopRenderingToShadowMap(i);
+		}
 
-			rhi->SetRootSignature(mRootSignature);
-			rhi->SetTopologyType(ER_RHI_PRIMITIVE_TYPE::ER_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		// PSOs can only be created on the main thread
+		const ER_MaterialID materialID = ER_MaterialHelper::GetMaterialID(ER_MaterialHelper::shadowMapMaterialName + " " + std::to_string(0));
+		for (auto renderingObject : objects)
+		{
+			ER_Material* material = renderingObject->GetMaterial(materialID);
+			if (material)
+				PreparePSO(renderingObject, material);
+		}
+
+		std::vector<int> commandLists;
+		std::vector<std::thread> threads;
+		threads.reserve(threadsCount);
+		const int objectsPerThread = static_cast<int>(objects.size()) / threadsCount;
+		for (int threadIndex = 0; threadIndex < threadsCount; threadIndex++)
+		{
+			const int commandListIndex = threadIndex + 1;
+			const int objectsStart = threadIndex * objectsPerThread;
+			const int objectsEnd = (threadIndex == threadsCount - 1) ? static_cast<int>(objects.size()) : objectsStart + objectsPerThread;
+			commandLists.push_back(commandListIndex);
 
-			int objectIndex = 0;
-			std::string psoName;
-			for (auto renderingObjectInfo = scene->objects.begin(); renderingObjectInfo != scene->objects.end(); renderingObjectInfo++, objectIndex++)
+			threads.push_back(std::thread([this, rhi, &objects, commandListIndex, objectsStart, objectsEnd]()
 			{
-				ER_RenderingObject* renderingObject = renderingObjectInfo->second;
-				psoName = renderingObject->IsInstanced() ? psoNameInstanced : psoNameNonInstanced;
-				auto materialInfo = renderingObject->GetMaterials().find(materialName);
-				if (materialInfo != renderingObject->GetMaterials().end())
+				rhi->BeginParallelGraphicsCommandList(commandListIndex);
+				for (int i = 0; i < NUM_SHADOW_CASCADES; i++)
 				{
-					ER_Material* material = materialInfo->second;
-					if (!rhi->IsPSOReady(psoName))
-					{
-						rhi->InitializePSO(psoName);
-						rhi->SetRasterizerState(ER_SHADOW_RS);
-						rhi->SetBlendState(ER_NO_BLEND);
-						rhi->SetDepthStencilState(ER_RHI_DEPTH_STENCIL_STATE::ER_DEPTH_ONLY_WRITE_COMPARISON_LESS_EQUAL);
-						material->PrepareShaders();
-						rhi->SetRenderTargetFormats({}, mShadowMaps[i]);
-						rhi->SetRootSignatureToPSO(psoName, mRootSignature);
-						rhi->SetTopologyTypeToPSO(psoName, ER_RHI_PRIMITIVE_TYPE::ER_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-						rhi->FinalizePSO(psoName);
-					}
-					rhi->SetPSO(psoName);
-					for (int meshIndex = 0; meshIndex < renderingObject->GetMeshCount(); meshIndex++)
-					{
-						static_cast<ER_ShadowMapMaterial*>(material)->PrepareForRendering(materialSystems, renderingObject, meshIndex, i, mRootSignature);
-						if (!renderingObject->IsInstanced())
-							renderingObject->DrawLOD(materialName, true, meshIndex, renderingObject->GetLODCount() - 1); //drawing highest LOD
-						else
-							renderingObject->Draw(materialName, true, meshIndex);
-					}
+					rhi->BeginEventTag("EveryRay: Shadow Maps (objects), cascade " + std::to_string(i) + ", command list " + std::to_string(commandListIndex));
+					SetShadowMapTarget(i);
+					DrawObjects(objects, objectsStart, objectsEnd, i);
+					rhi->EndEventTag();
+				}
+				rhi->UnbindRenderTargets();
+				rhi->EndParallelGraphicsCommandList(commandListIndex);
+			}));
+		}
+
+		for (auto& thread : threads)
+			thread.join();
+
+		rhi->ExecuteParallelGraphicsCommandLists(commandLists);
+	}
+
+	void ER_ShadowMapper::DrawObjects(const std::vector<ER_RenderingObject*>& aObjects, int aStart, int aEnd, int cascadeIndex)
+	{
+		auto rhi = GetCore()->GetRHI();
+
+		ER_MaterialSystems materialSystems;
+		materialSystems.mShadowMapper = this;
+
+		const ER_MaterialID materialID = ER_MaterialHelper::GetMaterialID(ER_MaterialHelper::shadowMapMaterialName + " " + std::to_string(cascadeIndex));
+
+		rhi->SetRootSignature(mRootSignature);
+		rhi->SetTopologyType(ER_RHI_PRIMITIVE_TYPE::ER_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+		for (int objectIndex = aStart; objectIndex < aEnd; objectIndex++)
+		{
+			ER_RenderingObject* renderingObject = aObjects[objectIndex];
+			ER_Material* material = renderingObject->GetMaterial(materialID);
+			if (material)
+			{
+				rhi->SetPSO(PreparePSO(renderingObject, material));
+				for (int meshIndex = 0; meshIndex < renderingObject->GetMeshCount(); meshIndex++)
+				{
+					static_cast<ER_ShadowMapMaterial*>(material)->PrepareForRendering(materialSystems, renderingObject, meshIndex, cascadeIndex, mRootSignature);
+					if (!renderingObject->IsInstanced())
+						renderingObject->DrawLOD(materialID, true, meshIndex, renderingObject->GetLODCount() - 1, false, true); //drawing highest LOD
+					else
+						renderingObject->Draw(materialID, true, meshIndex, true);
 				}
 			}
-			rhi->EndEventTag();
+		}
 
-			rhi->UnsetPSO();
-			StopRenderingToShadowMap(i);
+		rhi->UnsetPSO();
+	}
+
+	// returns the name of the object's PSO (initializes it if it is not ready yet)
+	const std::string& ER_ShadowMapper::PreparePSO(ER_RenderingObject* aObj, ER_Material* aMaterial)
+	{
+		auto rhi = GetCore()->GetRHI();
+
+		const std::string* psoName;
+		if (aMaterial->IsPositionOnly())
+			psoName = aObj->IsInstanced() ? &psoNamePositionOnlyInstanced : &psoNamePositionOnlyNonInstanced;
+		else
+			psoName = aObj->IsInstanced() ? &psoNameInstanced : &psoNameNonInstanced;
+
+		if (!rhi->IsPSOReady(*psoName))
+		{
+			rhi->InitializePSO(*psoName);
+			rhi->SetRasterizerState(ER_SHADOW_RS);
+			rhi->SetBlendState(ER_NO_BLEND);
+			rhi->SetDepthStencilState(ER_RHI_DEPTH_STENCIL_STATE::ER_DEPTH_ONLY_WRITE_COMPARISON_LESS_EQUAL);
+			if (aMaterial->IsPositionOnly())
+				rhi->UnbindResourcesFromShader(ER_PIXEL); // depth only (on PSO-based APIs the shader is simply not set)
+			aMaterial->PrepareShaders();
+			rhi->SetRenderTargetFormats({}, mShadowMaps[0]); // all cascades have the same format
+			rhi->SetRootSignatureToPSO(*psoName, mRootSignature);
+			rhi->SetTopologyTypeToPSO(*psoName, ER_RHI_PRIMITIVE_TYPE::ER_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+			rhi->FinalizePSO(*psoName);
 		}
+		return *psoName;
 	}
 
 	float ER_ShadowMapper::GetCameraFarShadowCascadeDistance(int index) const
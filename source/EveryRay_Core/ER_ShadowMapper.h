@@ -3,6 +3,8 @@
 #include "ER_CoreComponent.h"
 #include "RHI/ER_RHI.h"
 
+#define SHADOWS_MIN_OBJECTS_PER_RECORDING_THREAD 16
+
 namespace EveryRay_Core
 {
 	class ER_Frustum;
@@ -11,6 +13,8 @@ namespace EveryRay_Core
 	class ER_DirectionalLight;
 	class ER_Scene;
 	class ER_Terrain;
+	class ER_RenderingObject;
+	class ER_Material;
 
 	enum ShadowQuality
 	{
@@ -43,6 +47,9 @@ namespace EveryRay_Core
 	private:
 		XMMATRIX GetLightProjectionMatrixInFrustum(int index, ER_Frustum& cameraFrustum, ER_DirectionalLight& light);
 		XMMATRIX GetProjectionBoundingSphere(int index, float& sphereRadius);
+		void SetShadowMapTarget(int cascadeIndex);
+		void DrawObjects(const std::vector<ER_RenderingObject*>& aObjects, int aStart, int aEnd, int cascadeIndex);
+		const std::string& PreparePSO(ER_RenderingObject* aObj, ER_Material* aMaterial);
 
 		ER_Camera& mCamera;
 		ER_DirectionalLight& mDirectionalLight;
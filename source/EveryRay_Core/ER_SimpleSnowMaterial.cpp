@@ -69,7 +69,7 @@ namespace EveryRay_Core
 		//ImGui::End();
 
 		auto rhi = ER_Material::GetCore()->GetRHI();
-		ER_Camera* camera = (ER_Camera*)(ER_Material::GetCore()->GetServices().FindService(ER_Camera::TypeIdClass()));
+		ER_Camera* camera = ER_Material::GetCore()->GetServices().FindService<ER_Camera>();
 
 		assert(aObj);
 		assert(camera);
@@ -0,0 +1,326 @@
+#include "ER_SoftwareOcclusionCuller.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <thread>
+
+namespace EveryRay_Core
+{
+	ER_SoftwareOcclusionCuller::ER_SoftwareOcclusionCuller()
+	{
+		mTilesCountX = (SOFTWARE_OCCLUSION_WIDTH + SOFTWARE_OCCLUSION_TILE_SIZE - 1) / SOFTWARE_OCCLUSION_TILE_SIZE;
+		mTilesCountY = (SOFTWARE_OCCLUSION_HEIGHT + SOFTWARE_OCCLUSION_TILE_SIZE - 1) / SOFTWARE_OCCLUSION_TILE_SIZE;
+
+		mDepth.resize(SOFTWARE_OCCLUSION_WIDTH * SOFTWARE_OCCLUSION_HEIGHT, 1.0f);
+		mTilesMaxDepth.resize(mTilesCountX * mTilesCountY, 1.0f);
+		mTilesBins.resize(mTilesCountX * mTilesCountY);
+		XMStoreFloat4x4(&mViewProjection, XMMatrixIdentity());
+	}
+
+	ER_SoftwareOcclusionCuller::~ER_SoftwareOcclusionCuller()
+	{
+	}
+
+	void ER_SoftwareOcclusionCuller::BeginFrame(const XMMATRIX& aViewProjection)
+	{
+		XMStoreFloat4x4(&mViewProjection, aViewProjection);
+		std::fill(mDepth.begin(), mDepth.end(), 1.0f);
+		std::fill(mTilesMaxDepth.begin(), mTilesMaxDepth.end(), 1.0f);
+		for (auto& bin : mTilesBins)
+			bin.clear();
+		mTriangles.clear();
+		mOccludersCount = 0;
+		mIsReady = false;
+	}
+
+	void ER_SoftwareOcclusionCuller::AddOccluder(const std::vector<XMFLOAT3>& aVertices, const std::vector<unsigned int>& aIndices, const XMMATRIX& aWorld)
+	{
+		mOccludersCount++;
+
+		const XMMATRIX worldViewProjection = aWorld * XMLoadFloat4x4(&mViewProjection);
+		const size_t trianglesCount = aIndices.size() / 3;
+
+		XMFLOAT4 clipPos[3];
+		for (size_t triangleI = 0; triangleI < trianglesCount; triangleI++)
+		{
+			if (mTriangles.size() >= SOFTWARE_OCCLUSION_MAX_TRIANGLES)
+				return;
+
+			for (int i = 0; i < 3; i++)
+				XMStoreFloat4(&clipPos[i], XMVector3Transform(XMLoadFloat3(&aVertices[aIndices[triangleI * 3 + i]]), worldViewProjection));
+
+			AddClippedTriangle(clipPos[0], clipPos[1], clipPos[2]);
+		}
+	}
+
+	// clips the triangle against the near plane (z >= 0 in clip space), the rest of the clipping is done by the screen bounds during setup
+	void ER_SoftwareOcclusionCuller::AddClippedTriangle(const XMFLOAT4& aV0, const XMFLOAT4& aV1, const XMFLOAT4& aV2)
+	{
+		const XMFLOAT4 input[3] = { aV0, aV1, aV2 };
+		XMFLOAT4 clipped[4];
+		int clippedCount = 0;
+
+		for (int i = 0; i < 3; i++)
+		{
+			const XMFLOAT4& current = input[i];
+			const XMFLOAT4& next = input[(i + 1) % 3];
+			const bool isCurrentInside = current.z >= 0.0f;
+			const bool isNextInside = next.z >= 0.0f;
+
+			if (isCurrentInside)
+				clipped[clippedCount++] = current;
+			if (isCurrentInside != isNextInside)
+			{
+				const float t = current.z / (current.z - next.z);
+				XMStoreFloat4(&clipped[clippedCount++], XMVectorLerp(XMLoadFloat4(&current), XMLoadFloat4(&next), t));
+			}
+		}
+
+		if (clippedCount < 3)
+			return;
+
+		XMFLOAT3 screenPos[4];
+		for (int i = 0; i < clippedCount; i++)
+		{
+			const float invW = 1.0f / clipped[i].w;
+			screenPos[i] = XMFLOAT3(
+				(clipped[i].x * invW * 0.5f + 0.5f) * SOFTWARE_OCCLUSION_WIDTH,
+				(0.5f - clipped[i].y * invW * 0.5f) * SOFTWARE_OCCLUSION_HEIGHT,
+				clipped[i].z * invW);
+		}
+
+		SetupTriangle(screenPos[0], screenPos[1], screenPos[2]);
+		if (clippedCount == 4)
+			SetupTriangle(screenPos[0], screenPos[2], screenPos[3]);
+	}
+
+	void ER_SoftwareOcclusionCuller::SetupTriangle(const XMFLOAT3& aV0, const XMFLOAT3& aV1, const XMFLOAT3& aV2)
+	{
+		const float minX = std::min({ aV0.x, aV1.x, aV2.x });
+		const float minY = std::min({ aV0.y, aV1.y, aV2.y });
+		const float maxX = std::max({ aV0.x, aV1.x, aV2.x });
+		const float maxY = std::max({ aV0.y, aV1.y, aV2.y });
+
+		Triangle triangle;
+		// pixels with the centers inside of the bounds
+		triangle.MinX = std::max(static_cast<int>(ceilf(minX - 0.5f)), 0);
+		triangle.MinY = std::max(static_cast<int>(ceilf(minY - 0.5f)), 0);
+		triangle.MaxX = std::min(static_cast<int>(floorf(maxX - 0.5f)), SOFTWARE_OCCLUSION_WIDTH - 1);
+		triangle.MaxY = std::min(static_cast<int>(floorf(maxY - 0.5f)), SOFTWARE_OCCLUSION_HEIGHT - 1);
+		if (triangle.MinX > triangle.MaxX || triangle.MinY > triangle.MaxY)
+			return;
+
+		float area = (aV1.x - aV0.x) * (aV2.y - aV0.y) - (aV2.x - aV0.x) * (aV1.y - aV0.y);
+		if (fabsf(area) < 1e-6f)
+			return;
+
+		// both faces are rasterized (GBuffer does not cull back faces), so we just make the winding positive
+		const XMFLOAT3* v[3] = { &aV0, &aV1, &aV2 };
+		if (area < 0.0f)
+		{
+			std::swap(v[1], v[2]);
+			area = -area;
+		}
+
+		// edge "i" is opposite of vertex "i": E(p) = A * p.x + B * p.y + C (>= 0 inside)
+		float depthA = 0.0f, depthB = 0.0f, depthC = 0.0f;
+		for (int i = 0; i < 3; i++)
+		{
+			const XMFLOAT3& a = *v[(i + 1) % 3];
+			const XMFLOAT3& b = *v[(i + 2) % 3];
+			const float edgeA = a.y - b.y;
+			const float edgeB = b.x - a.x;
+			const float edgeC = a.x * b.y - a.y * b.x;
+
+			// depth is the barycentric interpolation of the vertices (i.e., a plane in screen space)
+			depthA += v[i]->z * edgeA;
+			depthB += v[i]->z * edgeB;
+			depthC += v[i]->z * edgeC;
+
+			triangle.EdgeA[i] = edgeA;
+			triangle.EdgeB[i] = edgeB;
+			triangle.EdgeC[i] = edgeC;
+		}
+		triangle.DepthA = depthA / area;
+		triangle.DepthB = depthB / area;
+		triangle.DepthC = depthC / area + 0.5f * (fabsf(triangle.DepthA) + fabsf(triangle.DepthB)); // farthest depth in the pixel
+
+		const int triangleIndex = static_cast<int>(mTriangles.size());
+		mTriangles.push_back(triangle);
+
+		for (int tileY = triangle.MinY / SOFTWARE_OCCLUSION_TILE_SIZE; tileY <= triangle.MaxY / SOFTWARE_OCCLUSION_TILE_SIZE; tileY++)
+		{
+			for (int tileX = triangle.MinX / SOFTWARE_OCCLUSION_TILE_SIZE; tileX <= triangle.MaxX / SOFTWARE_OCCLUSION_TILE_SIZE; tileX++)
+				mTilesBins[tileY * mTilesCountX + tileX].push_back(triangleIndex);
+		}
+	}
+
+	void ER_SoftwareOcclusionCuller::Rasterize(int aThreadsCount)
+	{
+		const int tilesCount = mTilesCountX * mTilesCountY;
+
+		int numThreads = aThreadsCount;
+		if (numThreads < 0)
+		{
+			numThreads = std::min({ static_cast<int>(std::thread::hardware_concurrency()), tilesCount,
+				static_cast<int>(mTriangles.size()) / SOFTWARE_OCCLUSION_MIN_TRIANGLES_PER_THREAD });
+		}
+
+		if (numThreads <= 1)
+		{
+			for (int tileIndex = 0; tileIndex < tilesCount; tileIndex++)
+				RasterizeTile(tileIndex);
+		}
+		else
+		{
+			// tiles are picked dynamically, as the amount of triangles per tile varies a lot
+			std::atomic<int> nextTile{ 0 };
+			auto rasterizeTiles = [&]()
+			{
+				int tileIndex;
+				while ((tileIndex = nextTile++) < tilesCount)
+					RasterizeTile(tileIndex);
+			};
+
+			std::vector<std::thread> threads;
+			threads.reserve(numThreads - 1);
+			for (int i = 0; i < numThreads - 1; i++)
+				threads.push_back(std::thread(rasterizeTiles));
+			rasterizeTiles();
+
+			for (auto& t : threads)
+				t.join();
+		}
+
+		mIsReady = true;
+	}
+
+	void ER_SoftwareOcclusionCuller::RasterizeTile(int aTileIndex)
+	{
+		const int tileMinX = (aTileIndex % mTilesCountX) * SOFTWARE_OCCLUSION_TILE_SIZE;
+		const int tileMinY = (aTileIndex / mTilesCountX) * SOFTWARE_OCCLUSION_TILE_SIZE;
+		const int tileMaxX = std::min(tileMinX + SOFTWARE_OCCLUSION_TILE_SIZE, SOFTWARE_OCCLUSION_WIDTH) - 1;
+		const int tileMaxY = std::min(tileMinY + SOFTWARE_OCCLUSION_TILE_SIZE, SOFTWARE_OCCLUSION_HEIGHT) - 1;
+
+		const XMVECTOR zero = XMVectorZero();
+		const XMVECTOR one = XMVectorSplatOne();
+		const XMVECTOR pixelOffsets = XMVectorSet(0.5f, 1.5f, 2.5f, 3.5f);
+
+		for (int triangleIndex : mTilesBins[aTileIndex])
+		{
+			const Triangle& triangle = mTriangles[triangleIndex];
+			const int minX = std::max(triangle.MinX, tileMinX) & ~3; // tiles are aligned to 4 pixels, so we never leave the tile
+			const int maxX = std::min(triangle.MaxX, tileMaxX);
+			const int minY = std::max(triangle.MinY, tileMinY);
+			const int maxY = std::min(triangle.MaxY, tileMaxY);
+
+			const XMVECTOR edgeA0 = XMVectorReplicate(triangle.EdgeA[0]);
+			const XMVECTOR edgeA1 = XMVectorReplicate(triangle.EdgeA[1]);
+			const XMVECTOR edgeA2 = XMVectorReplicate(triangle.EdgeA[2]);
+			const XMVECTOR depthA = XMVectorReplicate(triangle.DepthA);
+
+			for (int y = minY; y <= maxY; y++)
+			{
+				const float pixelY = static_cast<float>(y) + 0.5f;
+				const XMVECTOR rowEdge0 = XMVectorReplicate(triangle.EdgeB[0] * pixelY + triangle.EdgeC[0]);
+				const XMVECTOR rowEdge1 = XMVectorReplicate(triangle.EdgeB[1] * pixelY + triangle.EdgeC[1]);
+				const XMVECTOR rowEdge2 = XMVectorReplicate(triangle.EdgeB[2] * pixelY + triangle.EdgeC[2]);
+				const XMVECTOR rowDepth = XMVectorReplicate(triangle.DepthB * pixelY + triangle.DepthC);
+				float* row = &mDepth[y * SOFTWARE_OCCLUSION_WIDTH];
+
+				for (int x = minX; x <= maxX; x += 4)
+				{
+					const XMVECTOR pixelX = XMVectorAdd(XMVectorReplicate(static_cast<float>(x)), pixelOffsets);
+					const XMVECTOR isInside = XMVectorAndInt(
+						XMVectorAndInt(
+							XMVectorGreaterOrEqual(XMVectorMultiplyAdd(pixelX, edgeA0, rowEdge0), zero),
+							XMVectorGreaterOrEqual(XMVectorMultiplyAdd(pixelX, edgeA1, rowEdge1), zero)),
+						XMVectorGreaterOrEqual(XMVectorMultiplyAdd(pixelX, edgeA2, rowEdge2), zero));
+					const XMVECTOR depth = XMVectorClamp(XMVectorMultiplyAdd(pixelX, depthA, rowDepth), zero, one);
+
+					XMFLOAT4* pixels = reinterpret_cast<XMFLOAT4*>(&row[x]);
+					const XMVECTOR currentDepth = XMLoadFloat4(pixels);
+					XMStoreFloat4(pixels, XMVectorSelect(currentDepth, XMVectorMin(currentDepth, depth), isInside));
+				}
+			}
+		}
+
+		float tileMaxDepth = 0.0f;
+		for (int y = tileMinY; y <= tileMaxY; y++)
+		{
+			for (int x = tileMinX; x <= tileMaxX; x++)
+				tileMaxDepth = std::max(tileMaxDepth, mDepth[y * SOFTWARE_OCCLUSION_WIDTH + x]);
+		}
+		mTilesMaxDepth[aTileIndex] = tileMaxDepth;
+	}
+
+	bool ER_SoftwareOcclusionCuller::IsOccluded(const ER_AABB& aAABB) const
+	{
+		if (!mIsReady)
+			return false;
+
+		const XMMATRIX viewProjection = XMLoadFloat4x4(&mViewProjection);
+		float minX = FLT_MAX, minY = FLT_MAX, minDepth = FLT_MAX;
+		float maxX = -FLT_MAX, maxY = -FLT_MAX;
+		for (int i = 0; i < 8; i++)
+		{
+			const XMVECTOR corner = XMVectorSet(
+				(i & 1) ? aAABB.second.x : aAABB.first.x,
+				(i & 2) ? aAABB.second.y : aAABB.first.y,
+				(i & 4) ? aAABB.second.z : aAABB.first.z, 1.0f);
+			XMFLOAT4 clipPos;
+			XMStoreFloat4(&clipPos, XMVector4Transform(corner, viewProjection));
+
+			// crosses the near plane (i.e., the camera is inside or very close to the box)
+			if (clipPos.w <= 1e-6f || clipPos.z < 0.0f)
+				return false;
+
+			const float invW = 1.0f / clipPos.w;
+			const float x = (clipPos.x * invW * 0.5f + 0.5f) * SOFTWARE_OCCLUSION_WIDTH;
+			const float y = (0.5f - clipPos.y * invW * 0.5f) * SOFTWARE_OCCLUSION_HEIGHT;
+			minX = std::min(minX, x);
+			maxX = std::max(maxX, x);
+			minY = std::min(minY, y);
+			maxY = std::max(maxY, y);
+			minDepth = std::min(minDepth, clipPos.z * invW);
+		}
+
+		// expanded by a pixel: occluders' pixels at the silhouettes might be covered only partially
+		const int pixelMinX = std::max(static_cast<int>(floorf(minX)) - 1, 0);
+		const int pixelMinY = std::max(static_cast<int>(floorf(minY)) - 1, 0);
+		const int pixelMaxX = std::min(static_cast<int>(floorf(maxX)) + 1, SOFTWARE_OCCLUSION_WIDTH - 1);
+		const int pixelMaxY = std::min(static_cast<int>(floorf(maxY)) + 1, SOFTWARE_OCCLUSION_HEIGHT - 1);
+		if (pixelMinX > pixelMaxX || pixelMinY > pixelMaxY)
+			return false; // outside of the screen (frustum culling is responsible for that)
+
+		// quick path: all covered tiles are closer than the box
+		bool isOccludedByTiles = true;
+		for (int tileY = pixelMinY / SOFTWARE_OCCLUSION_TILE_SIZE; tileY <= pixelMaxY / SOFTWARE_OCCLUSION_TILE_SIZE && isOccludedByTiles; tileY++)
+		{
+			for (int tileX = pixelMinX / SOFTWARE_OCCLUSION_TILE_SIZE; tileX <= pixelMaxX / SOFTWARE_OCCLUSION_TILE_SIZE; tileX++)
+			{
+				if (mTilesMaxDepth[tileY * mTilesCountX + tileX] >= minDepth)
+				{
+					isOccludedByTiles = false;
+					break;
+				}
+			}
+		}
+		if (isOccludedByTiles)
+			return true;
+
+		for (int y = pixelMinY; y <= pixelMaxY; y++)
+		{
+			const float* row = &mDepth[y * SOFTWARE_OCCLUSION_WIDTH];
+			for (int x = pixelMinX; x <= pixelMaxX; x++)
+			{
+				if (row[x] >= minDepth)
+					return false;
+			}
+		}
+		return true;
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+#include <utility>
+
+using namespace DirectX;
+using ER_AABB = std::pair<XMFLOAT3, XMFLOAT3>; // same as in Common.h (which is not included here)
+
+#define SOFTWARE_OCCLUSION_WIDTH 320
+#define SOFTWARE_OCCLUSION_HEIGHT 192
+#define SOFTWARE_OCCLUSION_TILE_SIZE 32 // has to be a multiple of 4 (pixels are rasterized in groups of 4)
+#define SOFTWARE_OCCLUSION_MAX_TRIANGLES 131072 // occluders above the budget are skipped (which is always conservative)
+#define SOFTWARE_OCCLUSION_MIN_TRIANGLES_PER_THREAD 2048
+
+namespace EveryRay_Core
+{
+	// CPU occlusion culling for the objects that are not rendered indirectly (i.e., culled on CPU):
+	// triangles of the objects marked as occluders ("use_as_occluder") are rasterized into a small depth buffer
+	// and AABBs of the other objects (or their instances) are tested against it after the frustum culling.
+	// - triangles are transformed, clipped against the near plane and binned into screen tiles on the calling thread,
+	//   tiles are rasterized in parallel (every thread owns its tiles, so no synchronization is needed)
+	// - 4 pixels of a row are rasterized at once (DirectXMath SIMD)
+	// - pixels are covered at their centers (like on GPU, so there are no cracks between triangles), but with the farthest depth of the triangle inside of them,
+	//   so an object is never culled by its own depth; tested rectangles are expanded by a pixel to compensate for partially covered pixels at the silhouettes
+	// Only depends on DirectXMath and the standard library (no RHI, no Windows), so it can be tested and benchmarked without a GPU on other platforms too.
+	class ER_SoftwareOcclusionCuller
+	{
+	public:
+		ER_SoftwareOcclusionCuller();
+		~ER_SoftwareOcclusionCuller();
+
+		// every frame (before the objects are culled): BeginFrame(), AddOccluder() for every occluder mesh (see ER_RenderingObject::AddToOcclusionCuller()), Rasterize()
+		void BeginFrame(const XMMATRIX& aViewProjection);
+		void AddOccluder(const std::vector<XMFLOAT3>& aVertices, const std::vector<unsigned int>& aIndices, const XMMATRIX& aWorld);
+		void Rasterize(int aThreadsCount = -1); // -1: all hardware threads (if there are enough triangles)
+
+		// world space AABB; only valid after Rasterize()
+		bool IsOccluded(const ER_AABB& aAABB) const;
+		bool IsReady() const { return mIsReady; }
+		void Invalidate() { mIsReady = false; } // objects are not occlusion culled until the next Rasterize()
+
+		const std::vector<float>& GetDepth() const { return mDepth; } // SOFTWARE_OCCLUSION_WIDTH x SOFTWARE_OCCLUSION_HEIGHT, 1.0 - empty
+		int GetTrianglesCount() const { return static_cast<int>(mTriangles.size()); }
+		int GetOccludersCount() const { return mOccludersCount; } // meshes (every instance is counted)
+	private:
+		// edge functions and depth plane in screen space (pixel centers are at +0.5)
+		struct Triangle
+		{
+			float EdgeA[3];
+			float EdgeB[3];
+			float EdgeC[3];
+			float DepthA, DepthB, DepthC; // already biased for the farthest depth in the pixel
+			int MinX, MinY, MaxX, MaxY; // in pixels, inclusive
+		};
+
+		void AddClippedTriangle(const XMFLOAT4& aV0, const XMFLOAT4& aV1, const XMFLOAT4& aV2);
+		void SetupTriangle(const XMFLOAT3& aV0, const XMFLOAT3& aV1, const XMFLOAT3& aV2);
+		void RasterizeTile(int aTileIndex);
+
+		std::vector<float> mDepth;
+		std::vector<float> mTilesMaxDepth; // for quick rejection in IsOccluded()
+		std::vector<Triangle> mTriangles;
+		std::vector<std::vector<int>> mTilesBins; // indices of the triangles that overlap the tile
+		XMFLOAT4X4 mViewProjection;
+		int mTilesCountX = 0;
+		int mTilesCountY = 0;
+		int mOccludersCount = 0;
+		bool mIsReady = false;
+	};
+}
@@ -546,7 +546,7 @@ namespace EveryRay_Core
 			return;
 
 		ER_RHI* rhi = mCore->GetRHI();
-		ER_Camera* camera = (ER_Camera*)(mCore->GetServices().FindService(ER_Camera::TypeIdClass()));
+		ER_Camera* camera = mCore->GetServices().FindService<ER_Camera>();
 
 		if (worldShadowMapper && aPass != TerrainRenderPass::TERRAIN_GBUFFER)
 		{
@@ -601,7 +601,7 @@ namespace EveryRay_Core
 		if (!mEnabled && !mLoaded)
 			return;
 
-		ER_Camera* camera = (ER_Camera*)(mCore->GetServices().FindService(ER_Camera::TypeIdClass()));
+		ER_Camera* camera = mCore->GetServices().FindService<ER_Camera>();
 
 		int visibleTiles = 0;
 		for (int i = 0; i < mHeightMaps.size(); i++)
@@ -639,7 +639,7 @@ namespace EveryRay_Core
 
 		ER_RHI* rhi = mCore->GetRHI();
 
-		ER_Camera* camera = (ER_Camera*)(mCore->GetServices().FindService(ER_Camera::TypeIdClass()));
+		ER_Camera* camera = mCore->GetServices().FindService<ER_Camera>();
 		assert(camera);
 
 		ER_RHI_PRIMITIVE_TYPE originalPrimitiveTopology = rhi->GetCurrentTopologyType();
@@ -1071,7 +1071,7 @@ namespace EveryRay_Core
 		rhi->SetUnorderedAccessResources(ER_COMPUTE, { inputBuffer }, 0,
 			mTerrainPlacementPassRS, PLACEMENT_PASS_ROOT_DESCRIPTOR_TABLE_UAV_INDEX, true);
 		rhi->SetSamplers(ER_COMPUTE, { ER_RHI_SAMPLER_STATE::ER_BILINEAR_CLAMP, ER_RHI_SAMPLER_STATE::ER_TRILINEAR_WRAP });
-		rhi->Dispatch(512, 1, 1);
+		rhi->Dispatch(ER_DivideByMultiple(static_cast<UINT>(positionsCount), 512u), 1u, 1u);
 		rhi->UnsetPSO();
 		rhi->UnbindResourcesFromShader(ER_COMPUTE);
 
@@ -0,0 +1,185 @@
+#include "ER_TextureCooker.h"
+#include "ER_Utility.h"
+
+#include <algorithm>
+
+namespace EveryRay_Core
+{
+	static bool GetFileWriteTime(const std::wstring& aPath, FILETIME& outTime)
+	{
+		WIN32_FILE_ATTRIBUTE_DATA data;
+		if (!GetFileAttributesExW(aPath.c_str(), GetFileExInfoStandard, &data))
+			return false;
+
+		outTime = data.ftLastWriteTime;
+		return true;
+	}
+
+	static std::wstring GetLowerCaseExtension(const std::wstring& aPath)
+	{
+		std::wstring extension;
+		ER_Utility::GetPathExtension(aPath, extension);
+		std::transform(extension.begin(), extension.end(), extension.begin(), ::towlower);
+		return extension;
+	}
+
+	static bool EndsWith(const std::wstring& aString, const std::wstring& aEnding)
+	{
+		return aString.length() >= aEnding.length() && aString.compare(aString.length() - aEnding.length(), aEnding.length(), aEnding) == 0;
+	}
+
+	bool ER_TextureCooker::IsCookable(const std::wstring& aPath)
+	{
+		if (EndsWith(aPath, TEXTURE_COOKING_COOKED_POSTFIX))
+			return false;
+
+		const std::wstring extension = GetLowerCaseExtension(aPath);
+		return extension == L".png" || extension == L".jpg" || extension == L".jpeg" || extension == L".bmp" || extension == L".tga" || extension == L".dds";
+	}
+
+	bool ER_TextureCooker::IsCookedUpToDate(const std::wstring& aSourcePath, const std::wstring& aCookedPath)
+	{
+		FILETIME sourceTime, cookedTime;
+		if (!GetFileWriteTime(aCookedPath, cookedTime))
+			return false;
+		if (!GetFileWriteTime(aSourcePath, sourceTime))
+			return true; // only the cooked file was shipped
+
+		return CompareFileTime(&sourceTime, &cookedTime) <= 0;
+	}
+
+	bool ER_TextureCooker::CookTexture(const std::wstring& aSourcePath, const std::wstring& aCookedPath, TextureCookingCompression aCompression)
+	{
+		using namespace DirectX;
+
+		const std::wstring extension = GetLowerCaseExtension(aSourcePath);
+
+		TexMetadata metadata;
+		ScratchImage image;
+		HRESULT res;
+		if (extension == L".dds")
+			res = LoadFromDDSFile(aSourcePath.c_str(), DDS_FLAGS_NONE, &metadata, image);
+		else if (extension == L".tga")
+			res = LoadFromTGAFile(aSourcePath.c_str(), TGA_FLAGS_NONE, &metadata, image);
+		else
+			res = LoadFromWICFile(aSourcePath.c_str(), WIC_FLAGS_NONE, &metadata, image);
+
+		if (FAILED(res))
+		{
+			ER_OUTPUT_LOG((L"[ER Logger][ER_TextureCooker] Could not load a texture for cooking: " + aSourcePath + L"\n").c_str());
+			return false;
+		}
+
+		// 3D textures and textures that are ready to use (i.e., already have a mip chain and are already compressed if needed) are left as they are
+		const bool isCompressed = IsCompressed(metadata.format);
+		if (metadata.dimension == TEX_DIMENSION_TEXTURE3D || (metadata.mipLevels > 1 && (isCompressed || aCompression == TEXTURE_COOKING_COMPRESSION_NONE)))
+			return false;
+
+		// we can not filter block compressed data, so we decompress it first and compress it back into the same format
+		DXGI_FORMAT compressedFormat = isCompressed ? metadata.format : DXGI_FORMAT_UNKNOWN;
+		if (isCompressed)
+		{
+			ScratchImage decompressed;
+			res = Decompress(image.GetImages(), image.GetImageCount(), metadata, DXGI_FORMAT_UNKNOWN, decompressed);
+			if (FAILED(res))
+			{
+				ER_OUTPUT_LOG((L"[ER Logger][ER_TextureCooker] Could not decompress a texture for cooking: " + aSourcePath + L"\n").c_str());
+				return false;
+			}
+			image = std::move(decompressed);
+			metadata = image.GetMetadata();
+		}
+
+		ScratchImage mipChain;
+		if (metadata.mipLevels > 1)
+			mipChain = std::move(image);
+		else
+		{
+			res = GenerateMipMaps(image.GetImages(), image.GetImageCount(), metadata, TEX_FILTER_DEFAULT, 0, mipChain);
+			if (FAILED(res))
+			{
+				ER_OUTPUT_LOG((L"[ER Logger][ER_TextureCooker] Could not generate mips for: " + aSourcePath + L"\n").c_str());
+				return false;
+			}
+		}
+
+		// BC formats need the top mip to be a multiple of 4 in both dimensions
+		const bool canBeCompressed = (metadata.width % 4 == 0) && (metadata.height % 4 == 0);
+		if (compressedFormat == DXGI_FORMAT_UNKNOWN && canBeCompressed && aCompression != TEXTURE_COOKING_COMPRESSION_NONE)
+		{
+			if (aCompression == TEXTURE_COOKING_COMPRESSION_BC7)
+				compressedFormat = DXGI_FORMAT_BC7_UNORM;
+			else
+				compressedFormat = mipChain.IsAlphaAllOpaque() ? DXGI_FORMAT_BC1_UNORM : DXGI_FORMAT_BC3_UNORM;
+
+			if (IsSRGB(metadata.format))
+				compressedFormat = MakeSRGB(compressedFormat);
+		}
+
+		const ScratchImage* result = &mipChain;
+		ScratchImage compressed;
+		if (compressedFormat != DXGI_FORMAT_UNKNOWN)
+		{
+			res = Compress(mipChain.GetImages(), mipChain.GetImageCount(), mipChain.GetMetadata(), compressedFormat, TEX_COMPRESS_PARALLEL, TEX_THRESHOLD_DEFAULT, compressed);
+			if (FAILED(res))
+			{
+				ER_OUTPUT_LOG((L"[ER Logger][ER_TextureCooker] Could not compress a texture, saving it uncompressed: " + aSourcePath + L"\n").c_str());
+			}
+			else
+				result = &compressed;
+		}
+
+		res = SaveToDDSFile(result->GetImages(), result->GetImageCount(), result->GetMetadata(), DDS_FLAGS_NONE, aCookedPath.c_str());
+		if (FAILED(res))
+		{
+			ER_OUTPUT_LOG((L"[ER Logger][ER_TextureCooker] Could not save a cooked texture: " + aCookedPath + L"\n").c_str());
+			return false;
+		}
+
+		return true;
+	}
+
+	int ER_TextureCooker::CookDirectory(const std::wstring& aDirectory, TextureCookingCompression aCompression)
+	{
+		int cookedCount = 0;
+		std::vector<std::wstring> directories = { aDirectory };
+		while (!directories.empty())
+		{
+			const std::wstring directory = directories.back();
+			directories.pop_back();
+
+			std::wstring searchPattern;
+			ER_Utility::PathJoin(searchPattern, directory, L"*");
+
+			WIN32_FIND_DATAW findData;
+			HANDLE findHandle = FindFirstFileW(searchPattern.c_str(), &findData);
+			if (findHandle == INVALID_HANDLE_VALUE)
+				continue;
+
+			do
+			{
+				const std::wstring name = findData.cFileName;
+				if (name == L"." || name == L"..")
+					continue;
+
+				std::wstring path;
+				ER_Utility::PathJoin(path, directory, name);
+				if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+					directories.push_back(path);
+				else if (IsCookable(path))
+				{
+					const std::wstring cookedPath = GetCookedPath(path);
+					if (!IsCookedUpToDate(path, cookedPath) && CookTexture(path, cookedPath, aCompression))
+					{
+						ER_OUTPUT_LOG((L"[ER Logger][ER_TextureCooker] Cooked: " + cookedPath + L"\n").c_str());
+						cookedCount++;
+					}
+				}
+			} while (FindNextFileW(findHandle, &findData));
+
+			FindClose(findHandle);
+		}
+
+		return cookedCount;
+	}
+}
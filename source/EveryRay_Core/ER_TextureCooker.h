@@ -0,0 +1,35 @@
+#pragma once
+#include "Common.h"
+
+#define TEXTURE_COOKING_COOKED_POSTFIX L".cooked.dds"
+
+namespace EveryRay_Core
+{
+	enum TextureCookingCompression
+	{
+		TEXTURE_COOKING_COMPRESSION_NONE = 0, // uncompressed, only the mip chain is generated
+		TEXTURE_COOKING_COMPRESSION_BC1_BC3, // BC1 for opaque textures, BC3 for textures with alpha (fast)
+		TEXTURE_COOKING_COMPRESSION_BC7 // slow, better quality
+	};
+
+	// Offline texture cooking step (run the executable with "-cooktextures [-bc1bc3|-bc7]"):
+	// every source texture in the content folder that does not have a full mip chain on disk is converted into "<source>.cooked.dds"
+	// with the full mip chain (and, optionally, block compression). Cooked files are preferred by the loading code,
+	// so we do not have to generate mips (allocate a second texture and run a compute pass) for every texture at level load.
+	// Sources that are newer than their cooked files are re-cooked; stale cooked files are ignored when loading.
+	class ER_TextureCooker
+	{
+	public:
+		// returns the number of cooked textures (up-to-date ones are skipped)
+		static int CookDirectory(const std::wstring& aDirectory, TextureCookingCompression aCompression = TEXTURE_COOKING_COMPRESSION_NONE);
+		static bool CookTexture(const std::wstring& aSourcePath, const std::wstring& aCookedPath, TextureCookingCompression aCompression = TEXTURE_COOKING_COMPRESSION_NONE);
+
+		static std::wstring GetCookedPath(const std::wstring& aSourcePath) { return aSourcePath + TEXTURE_COOKING_COOKED_POSTFIX; }
+		static bool IsCookedUpToDate(const std::wstring& aSourcePath, const std::wstring& aCookedPath);
+		static bool IsCookable(const std::wstring& aPath);
+	private:
+		ER_TextureCooker();
+		ER_TextureCooker(const ER_TextureCooker& rhs);
+		ER_TextureCooker& operator=(const ER_TextureCooker& rhs);
+	};
+}
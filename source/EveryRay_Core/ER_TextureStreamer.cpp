@@ -0,0 +1,364 @@
+#include "ER_TextureStreamer.h"
+#include "ER_Core.h"
+#include "ER_CoreTime.h"
+#include "ER_Camera.h"
+#include "ER_RenderingObject.h"
+#include "ER_Utility.h"
+
+#define DDS_MAGIC 0x20534444 // "DDS "
+#define DDS_HEADER_SIZE 128 // magic + DDS_HEADER
+#define DDS_HEADER_DX10_SIZE 20
+#define DDS_FOURCC_DX10 0x30315844 // "DX10"
+#define DDS_FLAGS_MIPMAPCOUNT 0x20000
+#define DDS_CAPS2_CUBEMAP 0x200
+#define DDS_CAPS2_VOLUME 0x200000
+
+namespace EveryRay_Core
+{
+	RTTI_DEFINITIONS(ER_TextureStreamer)
+
+	static std::vector<char> ReadTextureFile(const std::wstring& aPath)
+	{
+		std::vector<char> data;
+		std::ifstream file(aPath.c_str(), std::ios::binary | std::ios::ate);
+		if (!file.good())
+			return data;
+
+		data.resize(static_cast<size_t>(file.tellg()));
+		file.seekg(0, std::ios::beg);
+		if (!file.read(data.data(), data.size()))
+			data.clear();
+
+		return data;
+	}
+
+	static UINT NextPowerOfTwo(float aValue)
+	{
+		UINT result = 1;
+		while (static_cast<float>(result) < aValue && result < (1u << 15))
+			result <<= 1;
+		return result;
+	}
+
+	ER_TextureStreamer::ER_TextureStreamer(ER_Core& game, ER_Camera& camera, TextureStreamingQuality quality)
+		: ER_CoreComponent(game), mCamera(camera)
+	{
+		switch (quality)
+		{
+		case TextureStreamingQuality::TEXTURE_STREAMING_LOW:
+			mBudgetInBytes = 256ull * 1024 * 1024;
+			mMinResidentSize = 128;
+			mMaxTextureSize = 1024;
+			break;
+		case TextureStreamingQuality::TEXTURE_STREAMING_MEDIUM:
+			mBudgetInBytes = 512ull * 1024 * 1024;
+			mMinResidentSize = 256;
+			mMaxTextureSize = 2048;
+			break;
+		case TextureStreamingQuality::TEXTURE_STREAMING_HIGH:
+			mBudgetInBytes = 1024ull * 1024 * 1024;
+			mMinResidentSize = 256;
+			mMaxTextureSize = 8192;
+			break;
+		}
+	}
+
+	ER_TextureStreamer::~ER_TextureStreamer()
+	{
+		Reset();
+	}
+
+	void ER_TextureStreamer::Reset()
+	{
+		const std::lock_guard<std::mutex> lock(mTexturesMutex);
+
+		for (auto& it : mTextures)
+		{
+			if (it.second.PendingRead.valid())
+				it.second.PendingRead.wait();
+		}
+		mTextures.clear();
+
+		mResidentBytes = 0;
+		mRequestedBytes = 0;
+		mPendingReadsCount = 0;
+		mFrameIndex = 0;
+	}
+
+	bool ER_TextureStreamer::ReadHeader(const std::wstring& aPath, UINT& outFullSize, UINT& outMipCount, UINT64& outSizeInBytes)
+	{
+		std::ifstream file(aPath.c_str(), std::ios::binary | std::ios::ate);
+		if (!file.good())
+			return false;
+
+		const UINT64 fileSize = static_cast<UINT64>(file.tellg());
+		if (fileSize <= DDS_HEADER_SIZE)
+			return false;
+
+		// magic, size, flags, height, width, pitchOrLinearSize, depth, mipMapCount, reserved1[11], ddspf[8], caps, caps2, caps3, caps4, reserved2
+		uint32_t header[DDS_HEADER_SIZE / sizeof(uint32_t)] = {};
+		file.seekg(0, std::ios::beg);
+		if (!file.read(reinterpret_cast<char*>(header), DDS_HEADER_SIZE) || header[0] != DDS_MAGIC)
+			return false;
+
+		if (header[28] & (DDS_CAPS2_CUBEMAP | DDS_CAPS2_VOLUME))
+			return false;
+
+		outFullSize = std::max(header[3], header[4]);
+		outMipCount = (header[2] & DDS_FLAGS_MIPMAPCOUNT) ? std::max(header[7], 1u) : 1;
+		outSizeInBytes = fileSize - DDS_HEADER_SIZE - ((header[21] == DDS_FOURCC_DX10) ? DDS_HEADER_DX10_SIZE : 0);
+		return true;
+	}
+
+	bool ER_TextureStreamer::IsStreamable(const std::wstring& aPath)
+	{
+		if (!mEnabled)
+			return false;
+
+		UINT fullSize = 0;
+		UINT mipCount = 0;
+		UINT64 sizeInBytes = 0;
+		if (!ReadHeader(aPath, fullSize, mipCount, sizeInBytes))
+			return false;
+
+		return mipCount > 1 && fullSize > mMinResidentSize;
+	}
+
+	// Textures are shared between objects via the texture cache, so we just add a new owner if the texture is already registered
+	void ER_TextureStreamer::RegisterTexture(ER_RHI_GPUTexture* aTexture, const std::wstring& aPath, ER_RenderingObject* aOwner)
+	{
+		assert(aTexture);
+		assert(aOwner);
+
+		const std::lock_guard<std::mutex> lock(mTexturesMutex);
+
+		auto it = mTextures.find(aTexture);
+		if (it != mTextures.end())
+		{
+			if (std::find(it->second.Owners.begin(), it->second.Owners.end(), aOwner) == it->second.Owners.end())
+				it->second.Owners.push_back(aOwner);
+			return;
+		}
+
+		ER_StreamedTexture& streamedTexture = mTextures[aTexture];
+		streamedTexture.Texture = aTexture;
+		streamedTexture.Path = aPath;
+		streamedTexture.Owners.push_back(aOwner);
+		if (!ReadHeader(aPath, streamedTexture.FullSize, streamedTexture.MipCount, streamedTexture.FullSizeInBytes))
+			streamedTexture.IsFailed = true;
+
+		streamedTexture.ResidentSize = GetResidentDimension(streamedTexture, mMinResidentSize);
+		streamedTexture.RequestedSize = streamedTexture.ResidentSize;
+		mResidentBytes += GetSizeInBytes(streamedTexture, streamedTexture.ResidentSize);
+	}
+
+	// Called before the object is deleted (i.e., streamed out): textures without owners are not visible, so they go down to their lowest mips
+	void ER_TextureStreamer::UnregisterOwner(ER_RenderingObject* aOwner)
+	{
+		const std::lock_guard<std::mutex> lock(mTexturesMutex);
+
+		for (auto& it : mTextures)
+		{
+			std::vector<ER_RenderingObject*>& owners = it.second.Owners;
+			owners.erase(std::remove(owners.begin(), owners.end(), aOwner), owners.end());
+		}
+	}
+
+	// Same logic as in DirectXTK loaders when they skip the top mips that do not fit into "maxsize"
+	UINT ER_TextureStreamer::GetSkippedMipsCount(const ER_StreamedTexture& aTexture, UINT aMaxSize) const
+	{
+		UINT dimension = aTexture.FullSize;
+		UINT skippedMips = 0;
+		while (dimension > aMaxSize && skippedMips + 1 < aTexture.MipCount)
+		{
+			dimension >>= 1;
+			skippedMips++;
+		}
+		return skippedMips;
+	}
+
+	UINT ER_TextureStreamer::GetResidentDimension(const ER_StreamedTexture& aTexture, UINT aMaxSize) const
+	{
+		return aTexture.FullSize >> GetSkippedMipsCount(aTexture, aMaxSize);
+	}
+
+	UINT64 ER_TextureStreamer::GetSizeInBytes(const ER_StreamedTexture& aTexture, UINT aMaxSize) const
+	{
+		return aTexture.FullSizeInBytes >> (2 * GetSkippedMipsCount(aTexture, aMaxSize)); // every skipped mip is ~3/4 of the remaining chain
+	}
+
+	// Approximate size of the bounding sphere of the AABB on the screen (in pixels)
+	float ER_TextureStreamer::GetScreenSize(const ER_AABB& aAABB, const XMFLOAT3& aCameraPos, float aProjectionScale) const
+	{
+		XMVECTOR minV = XMLoadFloat3(&aAABB.first);
+		XMVECTOR maxV = XMLoadFloat3(&aAABB.second);
+		XMVECTOR center = XMVectorScale(XMVectorAdd(minV, maxV), 0.5f);
+		float radius = 0.5f * XMVectorGetX(XMVector3Length(XMVectorSubtract(maxV, minV)));
+		float distance = XMVectorGetX(XMVector3Length(XMVectorSubtract(center, XMLoadFloat3(&aCameraPos))));
+
+		if (distance <= radius)
+			return static_cast<float>(mMaxTextureSize);
+
+		return radius * aProjectionScale / distance;
+	}
+
+	// Distance-based for all owners (instanced owners are sized by their nearest instance): culling results are not used,
+	// so the textures do not drop to the lowest mip when the camera turns away and pop when it turns back
+	float ER_TextureStreamer::GetOwnerScreenSize(ER_RenderingObject* aOwner, const XMFLOAT3& aCameraPos, float aProjectionScale) const
+	{
+		if (!aOwner->IsInstanced())
+			return GetScreenSize(aOwner->GetGlobalAABB(), aCameraPos, aProjectionScale);
+
+		float screenSize = 0.0f;
+		for (int instance = 0; instance < static_cast<int>(aOwner->GetInstanceCount()); instance++)
+			screenSize = std::max(screenSize, GetScreenSize(aOwner->GetInstanceAABB(instance), aCameraPos, aProjectionScale));
+		return screenSize;
+	}
+
+	void ER_TextureStreamer::Update(const ER_CoreTime& gameTime)
+	{
+		const std::lock_guard<std::mutex> lock(mTexturesMutex); // streamed objects register their textures on worker threads
+
+		UpdateImGui();
+
+		if (mIsPaused || mTextures.empty())
+			return;
+
+		if (mFrameIndex++ % TEXTURE_STREAMING_UPDATE_FREQUENCY != 0)
+			return;
+
+		const XMFLOAT3& cameraPos = mCamera.Position();
+		const float projectionScale = static_cast<float>(mCore->ScreenHeight()) / tan(mCamera.FieldOfView() * 0.5f);
+
+		std::vector<ER_StreamedTexture*> texturesByPriority;
+		texturesByPriority.reserve(mTextures.size());
+
+		// objects usually own several textures (and textures are shared between objects), so every owner is only projected once
+		mOwnersScreenSizes.clear();
+		for (auto& it : mTextures)
+		{
+			for (ER_RenderingObject* owner : it.second.Owners)
+			{
+				if (mOwnersScreenSizes.find(owner) == mOwnersScreenSizes.end())
+					mOwnersScreenSizes.emplace(owner, GetOwnerScreenSize(owner, cameraPos, projectionScale));
+			}
+		}
+
+		mRequestedBytes = 0;
+		for (auto& it : mTextures)
+		{
+			ER_StreamedTexture& streamedTexture = it.second;
+			if (streamedTexture.IsFailed)
+				continue;
+
+			streamedTexture.ScreenSize = 0.0f;
+			for (ER_RenderingObject* owner : streamedTexture.Owners)
+				streamedTexture.ScreenSize = std::max(streamedTexture.ScreenSize, mOwnersScreenSizes[owner]);
+
+			UINT desiredSize = std::min(std::max(NextPowerOfTwo(streamedTexture.ScreenSize), mMinResidentSize), mMaxTextureSize);
+			streamedTexture.RequestedSize = GetResidentDimension(streamedTexture, desiredSize);
+			mRequestedBytes += GetSizeInBytes(streamedTexture, streamedTexture.RequestedSize);
+
+			texturesByPriority.push_back(&streamedTexture);
+		}
+
+		std::sort(texturesByPriority.begin(), texturesByPriority.end(),
+			[](const ER_StreamedTexture* a, const ER_StreamedTexture* b) { return a->ScreenSize > b->ScreenSize; });
+
+		// not enough memory: drop mips from the textures that are the smallest on screen first
+		const bool isOverBudget = mRequestedBytes > mBudgetInBytes || mResidentBytes > mBudgetInBytes;
+		for (auto it = texturesByPriority.rbegin(); it != texturesByPriority.rend() && mRequestedBytes > mBudgetInBytes; ++it)
+		{
+			ER_StreamedTexture* streamedTexture = *it;
+			const UINT minSize = GetResidentDimension(*streamedTexture, mMinResidentSize);
+			while (mRequestedBytes > mBudgetInBytes && streamedTexture->RequestedSize > minSize)
+			{
+				UINT64 currentBytes = GetSizeInBytes(*streamedTexture, streamedTexture->RequestedSize);
+				streamedTexture->RequestedSize = GetResidentDimension(*streamedTexture, streamedTexture->RequestedSize >> 1);
+				mRequestedBytes -= currentBytes - GetSizeInBytes(*streamedTexture, streamedTexture->RequestedSize);
+			}
+		}
+
+		UINT64 plannedBytes = mResidentBytes;
+		auto requestRead = [this, &plannedBytes](ER_StreamedTexture* aStreamedTexture)
+		{
+			plannedBytes += GetSizeInBytes(*aStreamedTexture, aStreamedTexture->RequestedSize);
+			plannedBytes -= GetSizeInBytes(*aStreamedTexture, aStreamedTexture->ResidentSize);
+
+			aStreamedTexture->PendingSize = aStreamedTexture->RequestedSize;
+			aStreamedTexture->PendingRead = std::async(std::launch::async, ReadTextureFile, aStreamedTexture->Path);
+			mPendingReadsCount++;
+		};
+
+		// evictions go first as they free memory (if we are within the budget, we keep the extra mip to avoid streaming back and forth)
+		for (ER_StreamedTexture* streamedTexture : texturesByPriority)
+		{
+			if (mPendingReadsCount >= TEXTURE_STREAMING_MAX_PENDING_READS)
+				return;
+			if (streamedTexture->PendingRead.valid() || streamedTexture->RequestedSize >= streamedTexture->ResidentSize)
+				continue;
+			if (isOverBudget || streamedTexture->RequestedSize < (streamedTexture->ResidentSize >> 1))
+				requestRead(streamedTexture);
+		}
+
+		// then the most visible textures get their mips (only if they fit after the evictions above)
+		for (ER_StreamedTexture* streamedTexture : texturesByPriority)
+		{
+			if (mPendingReadsCount >= TEXTURE_STREAMING_MAX_PENDING_READS)
+				return;
+			if (streamedTexture->PendingRead.valid() || streamedTexture->RequestedSize <= streamedTexture->ResidentSize)
+				continue;
+			if (plannedBytes + GetSizeInBytes(*streamedTexture, streamedTexture->RequestedSize) - GetSizeInBytes(*streamedTexture, streamedTexture->ResidentSize) > mBudgetInBytes)
+				continue;
+			requestRead(streamedTexture);
+		}
+	}
+
+	void ER_TextureStreamer::UploadStreamedTextures(ER_RHI* rhi)
+	{
+		assert(rhi);
+		const std::lock_guard<std::mutex> lock(mTexturesMutex);
+		if (mPendingReadsCount == 0)
+			return;
+
+		int uploadsCount = 0;
+		for (auto& it : mTextures)
+		{
+			if (uploadsCount >= TEXTURE_STREAMING_MAX_UPLOADS_PER_FRAME)
+				break;
+
+			ER_StreamedTexture& streamedTexture = it.second;
+			if (!streamedTexture.PendingRead.valid() || streamedTexture.PendingRead.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+				continue;
+
+			std::vector<char> fileData = streamedTexture.PendingRead.get();
+			mPendingReadsCount--;
+			uploadsCount++;
+
+			if (fileData.empty() || !streamedTexture.Texture->StreamGPUTextureResource(rhi, fileData, streamedTexture.PendingSize))
+			{
+				streamedTexture.IsFailed = true;
+				continue;
+			}
+
+			mResidentBytes -= GetSizeInBytes(streamedTexture, streamedTexture.ResidentSize);
+			streamedTexture.ResidentSize = streamedTexture.PendingSize;
+			mResidentBytes += GetSizeInBytes(streamedTexture, streamedTexture.ResidentSize);
+		}
+	}
+
+	void ER_TextureStreamer::UpdateImGui()
+	{
+		if (!mShowDebug)
+			return;
+
+		ImGui::Begin("Texture Streaming");
+		ImGui::Checkbox("Pause streaming", &mIsPaused);
+		ImGui::Text("Streamed textures: %d", static_cast<int>(mTextures.size()));
+		ImGui::Text("Pending reads: %d", mPendingReadsCount);
+		ImGui::Text("Resident: %.1f MB", static_cast<double>(mResidentBytes) / (1024.0 * 1024.0));
+		ImGui::Text("Requested: %.1f MB", static_cast<double>(mRequestedBytes) / (1024.0 * 1024.0));
+		ImGui::Text("Budget: %.1f MB", static_cast<double>(mBudgetInBytes) / (1024.0 * 1024.0));
+		ImGui::End();
+	}
+}
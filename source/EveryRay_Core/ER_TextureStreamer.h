@@ -0,0 +1,93 @@
+#pragma once
+#include "Common.h"
+#include "ER_CoreComponent.h"
+#include "RHI/ER_RHI.h"
+
+#include <future>
+
+#define TEXTURE_STREAMING_MAX_PENDING_READS 8 // max # of files that are being read in the background at the same time
+#define TEXTURE_STREAMING_MAX_UPLOADS_PER_FRAME 4 // max # of textures that are re-created on the GPU per frame
+#define TEXTURE_STREAMING_UPDATE_FREQUENCY 10 // in frames
+
+namespace EveryRay_Core
+{
+	class ER_Camera;
+	class ER_CoreTime;
+	class ER_RenderingObject;
+
+	enum TextureStreamingQuality
+	{
+		TEXTURE_STREAMING_LOW = 0,
+		TEXTURE_STREAMING_MEDIUM,
+		TEXTURE_STREAMING_HIGH
+	};
+
+	struct ER_StreamedTexture
+	{
+		ER_RHI_GPUTexture* Texture = nullptr;
+		std::wstring Path;
+		std::vector<ER_RenderingObject*> Owners;
+
+		UINT FullSize = 0; // max dimension of the top mip on disk
+		UINT MipCount = 0; // on disk
+		UINT64 FullSizeInBytes = 0; // whole mip chain on disk
+		UINT ResidentSize = 0; // max dimension of the resident top mip
+		UINT RequestedSize = 0;
+		UINT PendingSize = 0;
+		float ScreenSize = 0.0f; // max projected size (in pixels) of all owners
+		bool IsFailed = false;
+
+		std::future<std::vector<char>> PendingRead;
+	};
+
+	// Mip streaming for the textures of rendering objects that come with a full mip chain on disk (.dds):
+	// - at level load we only create the lowest mips (up to "mMinResidentSize"), so loading is fast and cheap
+	// - we estimate the needed resolution for every texture from the screen-space size of its owners (objects or their instances)
+	// - if the requested resolutions do not fit into the memory budget, we drop mips from the textures that are the smallest on screen
+	// - files are read on worker threads, GPU resources are re-created in-place (users keep their pointers) and capped per frame
+	// Lives in the core (next to the texture cache) and is reset on every level change.
+	class ER_TextureStreamer : public ER_CoreComponent
+	{
+		RTTI_DECLARATIONS(ER_TextureStreamer, ER_CoreComponent)
+	public:
+		ER_TextureStreamer(ER_Core& game, ER_Camera& camera, TextureStreamingQuality quality);
+		~ER_TextureStreamer();
+
+		bool IsStreamable(const std::wstring& aPath); // only reads the header of the file
+		void RegisterTexture(ER_RHI_GPUTexture* aTexture, const std::wstring& aPath, ER_RenderingObject* aOwner);
+		void UnregisterOwner(ER_RenderingObject* aOwner);
+
+		virtual void Update(const ER_CoreTime& gameTime) override;
+		void UploadStreamedTextures(ER_RHI* rhi); // must be called when the graphics command list is open (before the textures are used in the frame)
+		void Reset(); // before the textures of the level are released
+		void Config() { mShowDebug = !mShowDebug; }
+
+		UINT GetMinResidentSize() const { return mMinResidentSize; }
+		UINT GetMaxTextureSize() const { return mMaxTextureSize; }
+	private:
+		bool ReadHeader(const std::wstring& aPath, UINT& outFullSize, UINT& outMipCount, UINT64& outSizeInBytes);
+		UINT GetSkippedMipsCount(const ER_StreamedTexture& aTexture, UINT aMaxSize) const;
+		UINT GetResidentDimension(const ER_StreamedTexture& aTexture, UINT aMaxSize) const;
+		UINT64 GetSizeInBytes(const ER_StreamedTexture& aTexture, UINT aMaxSize) const;
+		float GetScreenSize(const ER_AABB& aAABB, const XMFLOAT3& aCameraPos, float aProjectionScale) const;
+		float GetOwnerScreenSize(ER_RenderingObject* aOwner, const XMFLOAT3& aCameraPos, float aProjectionScale) const;
+		void UpdateImGui();
+
+		ER_Camera& mCamera;
+
+		std::map<ER_RHI_GPUTexture*, ER_StreamedTexture> mTextures;
+		std::mutex mTexturesMutex; // objects can be loaded from multiple threads
+		std::unordered_map<ER_RenderingObject*, float> mOwnersScreenSizes; // computed once per update and shared by all textures of the owner
+
+		UINT64 mBudgetInBytes = 0;
+		UINT64 mResidentBytes = 0;
+		UINT64 mRequestedBytes = 0;
+		UINT mMinResidentSize = 256;
+		UINT mMaxTextureSize = 2048;
+		UINT mFrameIndex = 0;
+		int mPendingReadsCount = 0;
+
+		bool mIsPaused = false;
+		bool mShowDebug = false;
+	};
+}
@@ -15,7 +15,9 @@ namespace EveryRay_Core
 	bool ER_Utility::IsFoliageEditor = false;
 	bool ER_Utility::IsPostEffectsVolumeEditor = false;
 	bool ER_Utility::IsMainCameraCPUCulling = true;
+	bool ER_Utility::IsMainCameraCPUOcclusionCulling = true;
 	bool ER_Utility::IsMainCameraGPUCulling = true;
+	bool ER_Utility::IsMainCameraGPUOcclusionCulling = true;
 
 	bool ER_Utility::StopDrawingRenderingObjects = false;
 	bool ER_Utility::IsWireframe = false;
@@ -40,7 +40,9 @@ namespace EveryRay_Core
 		static bool IsPostEffectsVolumeEditor;
 
 		static bool IsMainCameraCPUCulling;
+		static bool IsMainCameraCPUOcclusionCulling;
 		static bool IsMainCameraGPUCulling;
+		static bool IsMainCameraGPUOcclusionCulling;
 		static bool StopDrawingRenderingObjects;
 		static bool IsWireframe;
 		static float DistancesLOD[MAX_LOD];
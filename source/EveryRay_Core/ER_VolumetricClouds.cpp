@@ -216,6 +216,15 @@ namespace EveryRay_Core {
 	}
 
 	void ER_VolumetricClouds::Draw(const ER_CoreTime& gametime)
+	{
+		DrawSky(gametime);
+		DrawClouds(gametime);
+
+		//composite pass (happens in PostProcessing)
+	}
+
+	// Graphics part of the clouds: sky and sun that the clouds are raymarched against
+	void ER_VolumetricClouds::DrawSky(const ER_CoreTime& gametime)
 	{
 		if (!mEnabled || mCurrentQuality == VolumetricCloudsQuality::VC_DISABLED)
 			return;
@@ -238,11 +247,18 @@ namespace EveryRay_Core {
 			rhi->UnbindRenderTargets();
 		}
 		rhi->EndEventTag();
+	}
 
-		ER_QuadRenderer* quadRenderer = (ER_QuadRenderer*)mCore->GetServices().FindService(ER_QuadRenderer::TypeIdClass());
-		assert(quadRenderer);
+	// Compute part of the clouds: main pass and upsampling/blurring (can be recorded into the async compute queue)
+	void ER_VolumetricClouds::DrawClouds(const ER_CoreTime& gametime)
+	{
+		if (!mEnabled || mCurrentQuality == VolumetricCloudsQuality::VC_DISABLED)
+			return;
+
+		assert(mIlluminationResultDepthTarget);
+		auto rhi = mCore->GetRHI();
 
-		rhi->BeginEventTag("EveryRay: Volumetric Clouds (main pass)");
+		rhi->BeginEventTag("EveryRay: Volumetric Clouds (main pass)", rhi->IsRecordingAsyncComputePass());
 		// main pass
 		{
 			rhi->SetRootSignature(mMainPassRS, true);
@@ -264,9 +280,9 @@ namespace EveryRay_Core {
 			
 			rhi->UnbindResourcesFromShader(ER_COMPUTE);
 		}
-		rhi->EndEventTag();
+		rhi->EndEventTag(rhi->IsRecordingAsyncComputePass());
 
-		rhi->BeginEventTag("EveryRay: Volumetric Clouds (upsample+blur)");
+		rhi->BeginEventTag("EveryRay: Volumetric Clouds (upsample+blur)", rhi->IsRecordingAsyncComputePass());
 		//upsample and blur
 		{
 			mUpsampleBlurConstantBuffer.Data.Upsample = true;
@@ -290,9 +306,7 @@ namespace EveryRay_Core {
 			
 			rhi->UnbindResourcesFromShader(ER_COMPUTE);
 		}
-		rhi->EndEventTag();
-
-		//composite pass (happens in PostProcessing)
+		rhi->EndEventTag(rhi->IsRecordingAsyncComputePass());
 	}
 
 	void ER_VolumetricClouds::Composite(ER_RHI_GPUTexture* aRenderTarget)
@@ -300,7 +314,7 @@ namespace EveryRay_Core {
 		if (mCurrentQuality == VolumetricCloudsQuality::VC_DISABLED)
 			return;
 
-		ER_QuadRenderer* quadRenderer = (ER_QuadRenderer*)mCore->GetServices().FindService(ER_QuadRenderer::TypeIdClass());
+		ER_QuadRenderer* quadRenderer = mCore->GetServices().FindService<ER_QuadRenderer>();
 		assert(quadRenderer);
 
 		auto rhi = mCore->GetRHI();
@@ -61,6 +61,8 @@ namespace EveryRay_Core
 		void Initialize(ER_RHI_GPUTexture* aIlluminationDepth);
 
 		void Draw(const ER_CoreTime& gametime);
+		void DrawSky(const ER_CoreTime& gametime);
+		void DrawClouds(const ER_CoreTime& gametime);
 		void Update(const ER_CoreTime& gameTime);
 		void Config() { mShowDebug = !mShowDebug; }
 		void Composite(ER_RHI_GPUTexture* aRenderTarget);
@@ -63,7 +63,7 @@ namespace EveryRay_Core {
 
 		auto rhi = GetCore()->GetRHI();
 
-		ER_Camera* cameraScene = (ER_Camera*)GetCore()->GetServices().FindService(ER_Camera::TypeIdClass());
+		ER_Camera* cameraScene = GetCore()->GetServices().FindService<ER_Camera>();
 		mCameraFog = new ER_Camera(*GetCore(), cameraScene->FieldOfView(), cameraScene->AspectRatio(), mCustomNearPlane, mCustomFarPlane);
 		mCameraFog->Initialize();
 
@@ -122,13 +122,13 @@ namespace EveryRay_Core {
 		auto rhi = GetCore()->GetRHI();
 		rhi->SetRootSignature(mInjectionAccumulationPassesRootSignature, true);
 
-		rhi->BeginEventTag("EveryRay: Volumetric Fog (injection)");
+		rhi->BeginEventTag("EveryRay: Volumetric Fog (injection)", rhi->IsRecordingAsyncComputePass());
 		ComputeInjection();
-		rhi->EndEventTag();
+		rhi->EndEventTag(rhi->IsRecordingAsyncComputePass());
 
-		rhi->BeginEventTag("EveryRay: Volumetric Fog (accumulation)");
+		rhi->BeginEventTag("EveryRay: Volumetric Fog (accumulation)", rhi->IsRecordingAsyncComputePass());
 		ComputeAccumulation();
-		rhi->EndEventTag();
+		rhi->EndEventTag(rhi->IsRecordingAsyncComputePass());
 	}
 
 	void ER_VolumetricFog::Update(const ER_CoreTime& gameTime)
@@ -141,7 +141,7 @@ namespace EveryRay_Core {
 		if (!mEnabled)
 			return;
 
-		ER_Camera* cameraScene = (ER_Camera*)GetCore()->GetServices().FindService(ER_Camera::TypeIdClass());
+		ER_Camera* cameraScene = GetCore()->GetServices().FindService<ER_Camera>();
 		ER_Camera* camera = mCameraFog;
 		camera->SetPosition(cameraScene->Position());
 		camera->SetDirection(cameraScene->Direction());
@@ -253,7 +253,7 @@ namespace EveryRay_Core {
 	{
 		assert(aGbufferWorldPos && aInputColorTexture && aRT);
 
-		ER_QuadRenderer* quadRenderer = (ER_QuadRenderer*)mCore->GetServices().FindService(ER_QuadRenderer::TypeIdClass());
+		ER_QuadRenderer* quadRenderer = mCore->GetServices().FindService<ER_QuadRenderer>();
 		assert(quadRenderer);
 
 		auto rhi = GetCore()->GetRHI();
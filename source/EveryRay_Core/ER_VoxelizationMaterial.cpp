@@ -63,10 +63,11 @@ namespace EveryRay_Core
 	}
 
 	void ER_VoxelizationMaterial::PrepareForRendering(ER_MaterialSystems neededSystems, ER_RenderingObject* aObj, int meshIndex, 
-		float voxelScale, float voxelTexSize, const XMFLOAT4& voxelCameraPos, ER_RHI_GPURootSignature* rs)
+		float voxelScale, float voxelTexSize, const XMFLOAT4& voxelCameraPos, const XMFLOAT4& voxelWindowOrigin,
+		const XMFLOAT4* updateBoxesMin, const XMFLOAT4* updateBoxesMax, ER_RHI_GPURootSignature* rs)
 	{
 		auto rhi = ER_Material::GetCore()->GetRHI();
-		ER_Camera* camera = (ER_Camera*)(ER_Material::GetCore()->GetServices().FindService(ER_Camera::TypeIdClass()));
+		ER_Camera* camera = ER_Material::GetCore()->GetServices().FindService<ER_Camera>();
 
 		assert(aObj);
 		assert(camera);
@@ -83,6 +84,13 @@ namespace EveryRay_Core
 			neededSystems.mShadowMapper->GetCameraFarShadowCascadeDistance(1),
 			neededSystems.mShadowMapper->GetCameraFarShadowCascadeDistance(2), 1.0f };
 		mConstantBuffer.Data.VoxelCameraPos = voxelCameraPos;
+		mConstantBuffer.Data.VoxelWindowOrigin = voxelWindowOrigin;
+		assert(static_cast<int>(voxelWindowOrigin.w) <= VCT_MAX_UPDATE_BOXES);
+		for (int i = 0; i < static_cast<int>(voxelWindowOrigin.w); i++)
+		{
+			mConstantBuffer.Data.UpdateBoxesMin[i] = updateBoxesMin[i];
+			mConstantBuffer.Data.UpdateBoxesMax[i] = updateBoxesMax[i];
+		}
 		mConstantBuffer.Data.VoxelTextureDimension = voxelTexSize;
 		mConstantBuffer.Data.WorldVoxelScale = voxelScale;
 		mConstantBuffer.ApplyChanges(rhi);
@@ -20,6 +20,9 @@ namespace EveryRay_Core
 			XMFLOAT4 ShadowTexelSize;
 			XMFLOAT4 ShadowCascadeDistances;
 			XMFLOAT4 VoxelCameraPos;
+			XMFLOAT4 VoxelWindowOrigin; // xyz - first voxel of the cascade in world voxel coordinates (for toroidal addressing), w - update boxes count
+			XMFLOAT4 UpdateBoxesMin[VCT_MAX_UPDATE_BOXES]; // only these regions (in voxels, relative to the cascade) are voxelized
+			XMFLOAT4 UpdateBoxesMax[VCT_MAX_UPDATE_BOXES];
 			float VoxelTextureDimension;
 			float WorldVoxelScale;
 		};
@@ -31,7 +34,8 @@ namespace EveryRay_Core
 		~ER_VoxelizationMaterial();
 
 		void PrepareForRendering(ER_MaterialSystems neededSystems, ER_RenderingObject* aObj, int meshIndex, 
-			float voxelScale, float voxelTexSize, const XMFLOAT4& voxelCameraPos, ER_RHI_GPURootSignature* rs);
+			float voxelScale, float voxelTexSize, const XMFLOAT4& voxelCameraPos, const XMFLOAT4& voxelWindowOrigin,
+			const XMFLOAT4* updateBoxesMin, const XMFLOAT4* updateBoxesMax, ER_RHI_GPURootSignature* rs);
 		virtual void PrepareResourcesForStandardMaterial(ER_MaterialSystems neededSystems, ER_RenderingObject* aObj, int meshIndex, ER_RHI_GPURootSignature* rs) override;
 		virtual void CreateVertexBuffer(const ER_Mesh& mesh, ER_RHI_GPUBuffer* vertexBuffer) override;
 		virtual int VertexSize() override;
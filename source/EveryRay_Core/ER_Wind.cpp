@@ -132,7 +132,7 @@ namespace EveryRay_Core
 
 	void ER_Wind::UpdateProxyModel(const ER_CoreTime& time, const XMFLOAT4X4& viewMatrix, const XMFLOAT4X4& projectionMatrix)
 	{
-		ER_Camera* camera = (ER_Camera*)(GetCore()->GetServices().FindService(ER_Camera::TypeIdClass()));
+		ER_Camera* camera = GetCore()->GetServices().FindService<ER_Camera>();
 		assert(camera);
 
 		XMFLOAT3 gizmoPos = XMFLOAT3(
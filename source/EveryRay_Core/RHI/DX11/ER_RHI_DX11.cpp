@@ -437,6 +437,14 @@ namespace EveryRay_Core
 		mDirect3DDeviceContext->Dispatch(ThreadGroupCountX, ThreadGroupCountY, ThreadGroupCountZ);
 	}
 
+	void ER_RHI_DX11::DispatchIndirect(ER_RHI_GPUBuffer* anArgsBuffer, UINT alignedByteOffset)
+	{
+		assert(anArgsBuffer);
+
+		ER_RHI_DX11_GPUBuffer* dx11Buffer = static_cast<ER_RHI_DX11_GPUBuffer*>(anArgsBuffer);
+		mDirect3DDeviceContext->DispatchIndirect(static_cast<ID3D11Buffer*>(dx11Buffer->GetBuffer()), alignedByteOffset);
+	}
+
 	void ER_RHI_DX11::GenerateMips(ER_RHI_GPUTexture* aTexture, ER_RHI_GPUTexture* aSRGBTexture)
 	{
 		assert(aTexture);
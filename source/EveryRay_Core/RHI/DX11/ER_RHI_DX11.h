@@ -69,7 +69,7 @@ namespace EveryRay_Core
 		virtual void DrawIndexedInstancedIndirect(ER_RHI_GPUBuffer* anArgsBuffer, UINT alignedByteOffset) override;
 
 		virtual void Dispatch(UINT ThreadGroupCountX, UINT ThreadGroupCountY, UINT ThreadGroupCountZ) override;
-		//TODO DispatchIndirect
+		virtual void DispatchIndirect(ER_RHI_GPUBuffer* anArgsBuffer, UINT alignedByteOffset) override;
 
 		virtual void ExecuteCommandLists(int commandListIndex = 0, bool isCompute = false) override {}; //not supported on DX11
 		virtual void ExecuteCopyCommandList() override {}; //not supported on DX11
@@ -159,6 +159,16 @@ namespace EveryRay_Core
 		virtual void BeginEventTag(const std::string& aName, bool isComputeQueue = false) override;
 		virtual void EndEventTag(bool isComputeQueue = false) override;
 
+		virtual bool IsAsyncComputeSupported() override { return false; } //not supported on DX11
+		virtual void FlushGraphicsCommandList() override {}; //not supported on DX11
+		virtual void WaitForComputeOnGraphicsQueue() override {}; //not supported on DX11
+		virtual void WaitForGraphicsOnComputeQueue() override {}; //not supported on DX11
+
+		virtual bool IsParallelRecordingSupported() override { return false; } //not supported on DX11
+		virtual void BeginParallelGraphicsCommandList(int index) override {}; //not supported on DX11
+		virtual void EndParallelGraphicsCommandList(int index) override {}; //not supported on DX11
+		virtual void ExecuteParallelGraphicsCommandLists(const std::vector<int>& aIndices) override {}; //not supported on DX11
+
 		ID3D11Device1* GetDevice() { return mDirect3DDevice; }
 		ID3D11DeviceContext1* GetContext() { return mDirect3DDeviceContext; }
 		DXGI_FORMAT GetFormat(ER_RHI_FORMAT aFormat);
@@ -326,18 +326,20 @@ namespace EveryRay_Core
 		mTexture2D = tex2D;
 		mTexture3D = tex3D;
 	}
-	void ER_RHI_DX11_GPUTexture::CreateGPUTextureResource(ER_RHI* aRHI, const std::string& aPath, bool isFullPath /*= false*/, bool is3D, bool skipFallback, bool* statusFlag, bool isSilent)
+	void ER_RHI_DX11_GPUTexture::CreateGPUTextureResource(ER_RHI* aRHI, const std::string& aPath, bool isFullPath /*= false*/, bool is3D, bool skipFallback, bool* statusFlag, bool isSilent, UINT maxSize)
 	{
-		CreateGPUTextureResource(aRHI, EveryRay_Core::ER_Utility::ToWideString(aPath), isFullPath, is3D, skipFallback, statusFlag, isSilent);
+		CreateGPUTextureResource(aRHI, EveryRay_Core::ER_Utility::ToWideString(aPath), isFullPath, is3D, skipFallback, statusFlag, isSilent, maxSize);
 	}
-	void ER_RHI_DX11_GPUTexture::CreateGPUTextureResource(ER_RHI* aRHI, const std::wstring& aPath, bool isFullPath /*= false*/, bool is3D, bool skipFallback, bool* statusFlag, bool isSilent)
+	void ER_RHI_DX11_GPUTexture::CreateGPUTextureResource(ER_RHI* aRHI, const std::wstring& aPath, bool isFullPath /*= false*/, bool is3D, bool skipFallback, bool* statusFlag, bool isSilent, UINT maxSize)
 	{
 		assert(aRHI);
 		ER_RHI_DX11* aRHIDX11 = static_cast<ER_RHI_DX11*>(aRHI);
 		ID3D11Device* device = aRHIDX11->GetDevice();
 		assert(device);
-		ID3D11DeviceContext1* context = aRHIDX11->GetContext();
-		assert(context);
+		// the immediate context is not thread-safe: loading threads create the textures with the device only (loaders do not generate the mips then),
+		// the mips are generated later on the main thread
+		ID3D11DeviceContext1* context = ER_RHI::IsLoadingThread() ? nullptr : aRHIDX11->GetContext();
+		assert(context || ER_RHI::IsLoadingThread());
 
 		mIsLoadedFromFile = true;
 
@@ -356,7 +358,7 @@ namespace EveryRay_Core
 
 		if (isDDS)
 		{
-			if (FAILED(DirectX::CreateDDSTextureFromFile(device, context, isFullPath ? aPath.c_str() : EveryRay_Core::ER_Utility::GetFilePath(aPath).c_str(), &resourceTex, &mSRV)))
+			if (FAILED(DirectX::CreateDDSTextureFromFile(device, context, isFullPath ? aPath.c_str() : EveryRay_Core::ER_Utility::GetFilePath(aPath).c_str(), &resourceTex, &mSRV, maxSize)))
 			{
 				outputLog(isFullPath ? aPath.c_str() : EveryRay_Core::ER_Utility::GetFilePath(aPath).c_str());
 				if (!skipFallback)
@@ -368,7 +370,7 @@ namespace EveryRay_Core
 		}
 		else
 		{
-			if (FAILED(DirectX::CreateWICTextureFromFile(device, context, isFullPath ? aPath.c_str() : EveryRay_Core::ER_Utility::GetFilePath(aPath).c_str(), &resourceTex, &mSRV)))
+			if (FAILED(DirectX::CreateWICTextureFromFile(device, context, isFullPath ? aPath.c_str() : EveryRay_Core::ER_Utility::GetFilePath(aPath).c_str(), &resourceTex, &mSRV, maxSize)))
 			{
 				outputLog(isFullPath ? aPath.c_str() : EveryRay_Core::ER_Utility::GetFilePath(aPath).c_str());
 				if (!skipFallback)
@@ -390,8 +392,18 @@ namespace EveryRay_Core
 			}
 			else
 			{
+				D3D11_TEXTURE2D_DESC desc;
+				mTexture2D->GetDesc(&desc);
+				mFormat = desc.Format;
+				mMipLevels = desc.MipLevels;
+				mWidth = desc.Width;
+				mHeight = desc.Height;
+
 				if (statusFlag)
 					*statusFlag = true;
+
+				if (!context && mMipLevels <= 1)
+					aRHI->EnqueueLoadingCommand([this, aRHIDX11]() { GenerateMipChain(aRHIDX11); });
 			}
 		}
 		else
@@ -411,7 +423,7 @@ namespace EveryRay_Core
 		resourceTex->Release();
 	}
 
-	void ER_RHI_DX11_GPUTexture::LoadFallbackTexture(ER_RHI* aRHI, ID3D11Resource** texture, ID3D11ShaderResourceView** textureView)
+	bool ER_RHI_DX11_GPUTexture::StreamGPUTextureResource(ER_RHI* aRHI, const std::vector<char>& aFileData, UINT maxSize)
 	{
 		assert(aRHI);
 		ER_RHI_DX11* aRHIDX11 = static_cast<ER_RHI_DX11*>(aRHI);
@@ -420,6 +432,104 @@ namespace EveryRay_Core
 		ID3D11DeviceContext1* context = aRHIDX11->GetContext();
 		assert(context);
 
+		assert(mIsLoadedFromFile);
+		if (aFileData.size() < sizeof(uint32_t) || mTexture3D)
+			return false;
+
+		const uint8_t* data = reinterpret_cast<const uint8_t*>(aFileData.data());
+		const bool isDDS = *reinterpret_cast<const uint32_t*>(data) == 0x20534444; // "DDS "
+
+		ID3D11Resource* resourceTex = NULL;
+		ID3D11ShaderResourceView* srv = NULL;
+		HRESULT hr = isDDS ?
+			DirectX::CreateDDSTextureFromMemory(device, context, data, aFileData.size(), &resourceTex, &srv, maxSize) :
+			DirectX::CreateWICTextureFromMemory(device, context, data, aFileData.size(), &resourceTex, &srv, maxSize);
+		if (FAILED(hr))
+		{
+			std::wstring msg = L"[ER Logger][ER_RHI_DX11_GPUTexture] Failed to stream texture: " + debugName + L". Keeping the resident mips. \n";
+			ER_OUTPUT_LOG(msg.c_str());
+			return false;
+		}
+
+		ID3D11Texture2D* tex2D = NULL;
+		if (FAILED(resourceTex->QueryInterface(IID_ID3D11Texture2D, (void**)&tex2D)))
+		{
+			ReleaseObject(srv);
+			resourceTex->Release();
+			return false;
+		}
+		resourceTex->Release();
+
+		// the context holds its own references to the bound views, so it is safe to release the old ones mid-frame
+		ReleaseObject(mSRV);
+		ReleaseObject(mTexture2D);
+		mSRV = srv;
+		mTexture2D = tex2D;
+
+		D3D11_TEXTURE2D_DESC desc;
+		mTexture2D->GetDesc(&desc);
+		mFormat = desc.Format;
+		mMipLevels = desc.MipLevels;
+		mWidth = desc.Width;
+		mHeight = desc.Height;
+
+		return true;
+	}
+
+	// Recreates the texture with the full mip chain generated from its top mip (same as the texture loaders do when they get the immediate context).
+	// Runs on the main thread: the views of the old texture that are still bound are kept alive by the context.
+	void ER_RHI_DX11_GPUTexture::GenerateMipChain(ER_RHI_DX11* aRHIDX11)
+	{
+		assert(aRHIDX11);
+		ID3D11Device* device = aRHIDX11->GetDevice();
+		ID3D11DeviceContext1* context = aRHIDX11->GetContext();
+		assert(device && context);
+
+		if (!mTexture2D)
+			return;
+
+		D3D11_TEXTURE2D_DESC desc;
+		mTexture2D->GetDesc(&desc);
+		UINT formatSupport = 0;
+		if (desc.MipLevels > 1 || desc.ArraySize > 1 || FAILED(device->CheckFormatSupport(desc.Format, &formatSupport)) || !(formatSupport & D3D11_FORMAT_SUPPORT_MIP_AUTOGEN))
+			return;
+
+		desc.MipLevels = 0; // full mip chain
+		desc.Usage = D3D11_USAGE_DEFAULT;
+		desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET;
+		desc.CPUAccessFlags = 0;
+		desc.MiscFlags |= D3D11_RESOURCE_MISC_GENERATE_MIPS;
+
+		ID3D11Texture2D* texture = NULL;
+		ID3D11ShaderResourceView* srv = NULL;
+		if (FAILED(device->CreateTexture2D(&desc, NULL, &texture)) || FAILED(device->CreateShaderResourceView(texture, NULL, &srv)))
+		{
+			ReleaseObject(texture);
+			std::wstring msg = L"[ER Logger][ER_RHI_DX11_GPUTexture] Failed to create the mip chain of texture: " + debugName + L". Keeping the texture without mips. \n";
+			ER_OUTPUT_LOG(msg.c_str());
+			return;
+		}
+
+		context->CopySubresourceRegion(texture, 0, 0, 0, 0, mTexture2D, 0, NULL);
+		context->GenerateMips(srv);
+
+		ReleaseObject(mSRV);
+		ReleaseObject(mTexture2D);
+		mSRV = srv;
+		mTexture2D = texture;
+
+		mTexture2D->GetDesc(&desc);
+		mMipLevels = desc.MipLevels;
+	}
+
+	void ER_RHI_DX11_GPUTexture::LoadFallbackTexture(ER_RHI* aRHI, ID3D11Resource** texture, ID3D11ShaderResourceView** textureView)
+	{
+		assert(aRHI);
+		ER_RHI_DX11* aRHIDX11 = static_cast<ER_RHI_DX11*>(aRHI);
+		ID3D11Device* device = aRHIDX11->GetDevice();
+		assert(device);
+		ID3D11DeviceContext1* context = ER_RHI::IsLoadingThread() ? nullptr : aRHIDX11->GetContext();
+
 		DirectX::CreateWICTextureFromFile(device, context, EveryRay_Core::ER_Utility::GetFilePath(L"content\\textures\\uvChecker.jpg").c_str(), texture, textureView);
 	}
 }
@@ -11,8 +11,9 @@ namespace EveryRay_Core
 
 		virtual void CreateGPUTextureResource(ER_RHI* aRHI, UINT width, UINT height, UINT samples, ER_RHI_FORMAT format, ER_RHI_BIND_FLAG bindFlags = ER_BIND_NONE,
 			int mip = 1, int depth = -1, int arraySize = 1, bool isCubemap = false, int cubemapArraySize = -1) override;
-		virtual void CreateGPUTextureResource(ER_RHI* aRHI, const std::string& aPath, bool isFullPath = false, bool is3D = false, bool skipFallback = false, bool* statusFlag = nullptr, bool isSilent = false) override;
-		virtual void CreateGPUTextureResource(ER_RHI* aRHI, const std::wstring& aPath, bool isFullPath = false, bool is3D = false, bool skipFallback = false, bool* statusFlag = nullptr, bool isSilent = false) override;
+		virtual void CreateGPUTextureResource(ER_RHI* aRHI, const std::string& aPath, bool isFullPath = false, bool is3D = false, bool skipFallback = false, bool* statusFlag = nullptr, bool isSilent = false, UINT maxSize = 0) override;
+		virtual void CreateGPUTextureResource(ER_RHI* aRHI, const std::wstring& aPath, bool isFullPath = false, bool is3D = false, bool skipFallback = false, bool* statusFlag = nullptr, bool isSilent = false, UINT maxSize = 0) override;
+		virtual bool StreamGPUTextureResource(ER_RHI* aRHI, const std::vector<char>& aFileData, UINT maxSize) override;
 
 		virtual void* GetRTV(void* aEmpty = nullptr) override { return mRTVs[0]; }
 		virtual void* GetRTV(int index) override { return mRTVs[index]; }
@@ -44,6 +45,7 @@ namespace EveryRay_Core
 
 	private:
 		void LoadFallbackTexture(ER_RHI* aRHI, ID3D11Resource** texture, ID3D11ShaderResourceView** textureView);
+		void GenerateMipChain(ER_RHI_DX11* aRHIDX11);
 
 		ID3D11RenderTargetView** mRTVs = nullptr;
 		ID3D11UnorderedAccessView** mUAVs = nullptr;
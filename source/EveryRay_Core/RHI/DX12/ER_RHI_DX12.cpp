@@ -9,6 +9,8 @@
 #include "..\..\ER_CoreException.h"
 #include "..\..\ER_Utility.h"
 
+#include <algorithm>
+
 namespace EveryRay_Core
 {
 	static ER_RHI_DX12_DescriptorHandle sNullSRV2DHandle;
@@ -21,6 +23,7 @@ namespace EveryRay_Core
 
 	ER_RHI_DX12::~ER_RHI_DX12()
 	{
+		WaitForGpuOnComputeFence();
 		WaitForGpuOnGraphicsFence();
 		DeleteObject(mGenerateMips2DCS);
 		DeleteObject(mGenerateMips2DRS);
@@ -209,9 +212,61 @@ namespace EveryRay_Core
 			}
 		}
 
-		//TODO create compute queue data 
+		// Create compute command queue data
 		{
-			//...
+			D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+			queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+			queueDesc.Type = D3D12_COMMAND_LIST_TYPE_COMPUTE;
+
+			if (FAILED(mDevice->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(mCommandQueueCompute.ReleaseAndGetAddressOf()))))
+				throw ER_CoreException("ER_RHI_DX12: Could not create compute command queue");
+			mCommandQueueCompute->SetName(L"ER_RHI_DX12: Compute command queue");
+
+			for (int j = 0; j < DX12_MAX_BACK_BUFFER_COUNT; j++)
+			{
+				for (int i = 0; i < ER_RHI_MAX_COMPUTE_COMMAND_LISTS; i++)
+				{
+					// Create a command allocator for each back buffer that will be rendered to.
+					if (FAILED(mDevice->CreateCommandAllocator(queueDesc.Type, IID_PPV_ARGS(mCommandAllocatorsCompute[j][i].ReleaseAndGetAddressOf()))))
+					{
+						std::string message = "ER_RHI_DX12: Could not create compute command allocator " + std::to_string(j) + " " + std::to_string(i);
+						throw ER_CoreException(message.c_str());
+					}
+
+					if (j == 0)
+					{
+						// Create a command list for recording compute commands.
+						if (FAILED(mDevice->CreateCommandList(0, queueDesc.Type, mCommandAllocatorsCompute[0][i].Get(), nullptr, IID_PPV_ARGS(mCommandListCompute[i].ReleaseAndGetAddressOf()))))
+						{
+							std::string message = "ER_RHI_DX12: Could not create compute command list " + std::to_string(i);
+							throw ER_CoreException(message.c_str());
+						}
+						mCommandListCompute[i]->Close();
+					}
+				}
+			}
+
+			// fences
+			{
+				// Create a fence for tracking GPU execution progress.
+				mFenceValuesCompute = 0;
+				if (FAILED(mDevice->CreateFence(mFenceValuesCompute, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(mFenceCompute.ReleaseAndGetAddressOf()))))
+					throw ER_CoreException("ER_RHI_DX12: Could not create compute fence");
+
+				mFenceValuesCompute++;
+				mLastSignaledComputeFenceValue = 0;
+				mLastWaitedComputeFenceValue = 0;
+				mFenceEventCompute.Attach(CreateEventEx(nullptr, nullptr, 0, EVENT_MODIFY_STATE | SYNCHRONIZE));
+				if (!mFenceEventCompute.IsValid())
+					throw ER_CoreException("ER_RHI_DX12: Could not create event for compute fence");
+				mFenceCompute->SetName(L"ER_RHI_DX12: Compute fence");
+
+				// Create a fence for the compute queue to wait on graphics submissions.
+				mFenceValuesGraphicsSubmissions = 0;
+				if (FAILED(mDevice->CreateFence(mFenceValuesGraphicsSubmissions, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(mFenceGraphicsSubmissions.ReleaseAndGetAddressOf()))))
+					throw ER_CoreException("ER_RHI_DX12: Could not create graphics submissions fence");
+				mFenceGraphicsSubmissions->SetName(L"ER_RHI_DX12: Graphics submissions fence");
+			}
 		}
 
 		WaitForGpuOnGraphicsFence();
@@ -331,6 +386,19 @@ namespace EveryRay_Core
 			if (FAILED(mDevice->CreateCommandSignature(&commandSignatureDesc, nullptr, IID_PPV_ARGS(mCommandSignature_DrawIndexed.ReleaseAndGetAddressOf()))))
 				throw ER_CoreException("ER_RHI_DX12: Could not create command signature (Draw Indexed)");
 		}
+		{
+			// Dispatch call
+			D3D12_INDIRECT_ARGUMENT_DESC argumentDescs[1] = {};
+			argumentDescs[0].Type = D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH;
+
+			D3D12_COMMAND_SIGNATURE_DESC commandSignatureDesc = {};
+			commandSignatureDesc.pArgumentDescs = argumentDescs;
+			commandSignatureDesc.NumArgumentDescs = _countof(argumentDescs);
+			commandSignatureDesc.ByteStride = sizeof(D3D12_DISPATCH_ARGUMENTS);
+
+			if (FAILED(mDevice->CreateCommandSignature(&commandSignatureDesc, nullptr, IID_PPV_ARGS(mCommandSignature_Dispatch.ReleaseAndGetAddressOf()))))
+				throw ER_CoreException("ER_RHI_DX12: Could not create command signature (Dispatch)");
+		}
 		return true;
 	}
 
@@ -349,6 +417,10 @@ namespace EveryRay_Core
 
 					// Increment the fence value for the current frame.
 					mFenceValuesGraphics[mBackBufferIndex]++;
+
+					// GPU is idle, nothing references the retired resources anymore
+					for (int i = 0; i < DX12_MAX_BACK_BUFFER_COUNT; i++)
+						mDeferredReleaseResources[i].clear();
 				}
 			}
 		}
@@ -356,7 +428,22 @@ namespace EveryRay_Core
 
 	void ER_RHI_DX12::WaitForGpuOnComputeFence()
 	{
-		//TODO
+		if (mCommandQueueCompute && mFenceCompute && mFenceEventCompute.IsValid())
+		{
+			// Schedule a Signal command in the GPU queue.
+			UINT64 fenceValue = mFenceValuesCompute;
+			if (SUCCEEDED(mCommandQueueCompute->Signal(mFenceCompute.Get(), fenceValue)))
+			{
+				// Wait until the Signal has been processed.
+				if (SUCCEEDED(mFenceCompute->SetEventOnCompletion(fenceValue, mFenceEventCompute.Get())))
+				{
+					WaitForSingleObjectEx(mFenceEventCompute.Get(), INFINITE, FALSE);
+
+					// Increment the fence value.
+					mFenceValuesCompute++;
+				}
+			}
+		}
 	}
 
 	void ER_RHI_DX12::WaitForGpuOnCopyFence()
@@ -390,6 +477,14 @@ namespace EveryRay_Core
 		}
 	}
 
+	// Keeps the resource alive until the GPU finishes the frames that might still reference it (i.e., after a texture was re-created by the streaming system)
+	void ER_RHI_DX12::DeferResourceRelease(ComPtr<ID3D12Resource>& aResource)
+	{
+		if (aResource)
+			mDeferredReleaseResources[mBackBufferIndex].push_back(aResource);
+		aResource.Reset();
+	}
+
 	void ER_RHI_DX12::ResetDescriptorManager()
 	{
 		DeleteObject(mDescriptorHeapManager);
@@ -420,12 +515,12 @@ namespace EveryRay_Core
 
 	void ER_RHI_DX12::BeginEventTag(const std::string& aName, bool isComputeQueue)
 	{
-		PIXBeginEvent(isComputeQueue ? mCommandListCompute[mCurrentComputeCommandListIndex].Get() : mCommandListGraphics[mCurrentGraphicsCommandListIndex].Get(), 0, aName.c_str());
+		PIXBeginEvent(GetCurrentCommandList(isComputeQueue), 0, aName.c_str());
 	}
 
 	void ER_RHI_DX12::EndEventTag(bool isComputeQueue)
 	{
-		PIXEndEvent(isComputeQueue ? mCommandListCompute[mCurrentComputeCommandListIndex].Get() : mCommandListGraphics[mCurrentGraphicsCommandListIndex].Get());
+		PIXEndEvent(GetCurrentCommandList(isComputeQueue));
 	}
 
 	void ER_RHI_DX12::BeginGraphicsCommandList(int index)
@@ -463,6 +558,193 @@ namespace EveryRay_Core
 		}
 	}
 
+	void ER_RHI_DX12::BeginComputeCommandList(int index)
+	{
+		assert(index < ER_RHI_MAX_COMPUTE_COMMAND_LISTS);
+		assert(GetCurrentGraphicsCommandListIndex() > -1);
+		assert(mDescriptorHeapManager);
+
+		HRESULT hr;
+		if (!mIsComputeCommandAllocatorReset[index])
+		{
+			if (FAILED(hr = mCommandAllocatorsCompute[mBackBufferIndex][index]->Reset()))
+			{
+				std::string message = "ER_RHI_DX12:: Could not Reset() command allocator (compute) " + std::to_string(index);
+				throw ER_CoreException(message.c_str());
+			}
+			mIsComputeCommandAllocatorReset[index] = true;
+		}
+
+		if (FAILED(hr = mCommandListCompute[index]->Reset(mCommandAllocatorsCompute[mBackBufferIndex][index].Get(), nullptr)))
+		{
+			std::string message = "ER_RHI_DX12:: Could not Reset() command list (compute) " + std::to_string(index);
+			throw ER_CoreException(message.c_str());
+		}
+
+		mCurrentComputeCommandListIndex = index;
+		mCurrentSetComputeQueuePSOName = "";
+
+		// same GPU heap as the graphics command list (no reset)
+		ID3D12DescriptorHeap* ppHeaps[] = { mDescriptorHeapManager->GetGPUHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV)->GetHeap() };
+		mCommandListCompute[index]->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
+	}
+
+	void ER_RHI_DX12::EndComputeCommandList(int index)
+	{
+		assert(index < ER_RHI_MAX_COMPUTE_COMMAND_LISTS);
+		mCurrentComputeCommandListIndex = -1;
+
+		HRESULT hr;
+		if (mIsHandoffCommandListPending)
+		{
+			if (FAILED(hr = mCommandListGraphics[mHandoffGraphicsCommandListIndex]->Close()))
+				throw ER_CoreException("ER_RHI_DX12:: Could not close command list (graphics-to-compute handoff)");
+		}
+
+		if (FAILED(hr = mCommandListCompute[index]->Close()))
+		{
+			std::string message = "ER_RHI_DX12:: Could not close command list (compute) " + std::to_string(index);
+			throw ER_CoreException(message.c_str());
+		}
+	}
+
+	void ER_RHI_DX12::BeginHandoffCommandList()
+	{
+		if (mIsHandoffCommandListPending)
+			return;
+
+		HRESULT hr;
+		if (!mIsHandoffCommandAllocatorReset)
+		{
+			if (FAILED(hr = mCommandAllocatorsGraphics[mBackBufferIndex][mHandoffGraphicsCommandListIndex]->Reset()))
+				throw ER_CoreException("ER_RHI_DX12:: Could not Reset() command allocator (graphics-to-compute handoff)");
+			mIsHandoffCommandAllocatorReset = true;
+		}
+
+		if (FAILED(hr = mCommandListGraphics[mHandoffGraphicsCommandListIndex]->Reset(mCommandAllocatorsGraphics[mBackBufferIndex][mHandoffGraphicsCommandListIndex].Get(), nullptr)))
+			throw ER_CoreException("ER_RHI_DX12:: Could not Reset() command list (graphics-to-compute handoff)");
+
+		mIsHandoffCommandListPending = true;
+	}
+
+	void ER_RHI_DX12::FlushGraphicsCommandList()
+	{
+		SubmitMainGraphicsCommandList({});
+	}
+
+	// Submits the main graphics command list (and the parallel ones after it) and continues recording into the same command list
+	void ER_RHI_DX12::SubmitMainGraphicsCommandList(const std::vector<int>& aParallelIndices)
+	{
+		assert(mCurrentGraphicsCommandListIndex > -1);
+		assert(GetThreadGraphicsCommandListIndex() == -1);
+		const int index = mCurrentGraphicsCommandListIndex;
+
+		HRESULT hr;
+		if (FAILED(hr = mCommandListGraphics[index]->Close()))
+		{
+			std::string message = "ER_RHI_DX12:: Could not close command list (graphics) during flush " + std::to_string(index);
+			throw ER_CoreException(message.c_str());
+		}
+
+		std::vector<ID3D12CommandList*> commandLists = { mCommandListGraphics[index].Get() };
+		for (int parallelIndex : aParallelIndices)
+			commandLists.push_back(mCommandListGraphics[parallelIndex].Get());
+		mCommandQueueGraphics->ExecuteCommandLists(static_cast<UINT>(commandLists.size()), commandLists.data());
+		if (mFenceGraphicsSubmissions)
+			mCommandQueueGraphics->Signal(mFenceGraphicsSubmissions.Get(), ++mFenceValuesGraphicsSubmissions);
+
+		// a command list can be reset right after it was submitted: its allocator keeps the memory until the frame is finished on the GPU
+		if (FAILED(hr = mCommandListGraphics[index]->Reset(mCommandAllocatorsGraphics[mBackBufferIndex][index].Get(), nullptr)))
+		{
+			std::string message = "ER_RHI_DX12:: Could not Reset() command list (graphics) during flush " + std::to_string(index);
+			throw ER_CoreException(message.c_str());
+		}
+
+		// restore the state that the passes expect to be set (render targets and root parameters are always set by the passes)
+		ER_RHI_DX12_RecordingState& state = mRecordingStates[index];
+		ID3D12DescriptorHeap* ppHeaps[] = { mDescriptorHeapManager->GetGPUHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV)->GetHeap() };
+		mCommandListGraphics[index]->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
+		if (state.GraphicsRootSignature)
+			mCommandListGraphics[index]->SetGraphicsRootSignature(state.GraphicsRootSignature);
+		if (state.ComputeRootSignature)
+			mCommandListGraphics[index]->SetComputeRootSignature(state.ComputeRootSignature);
+		mCommandListGraphics[index]->IASetPrimitiveTopology(state.Topology);
+		SetViewport(state.Viewport);
+		SetRect(state.Rect);
+
+		state.SetGraphicsPSOName = "";
+		state.SetComputePSOName = "";
+		state.IsInstancedBufferBound = false;
+	}
+
+	void ER_RHI_DX12::BeginParallelGraphicsCommandList(int index)
+	{
+		assert(index > 0 && index <= ER_RHI_MAX_PARALLEL_GRAPHICS_COMMAND_LISTS);
+		assert(GetThreadGraphicsCommandListIndex() == -1);
+		assert(mDescriptorHeapManager);
+
+		HRESULT hr;
+		if (!mIsGraphicsCommandAllocatorReset[index])
+		{
+			if (FAILED(hr = mCommandAllocatorsGraphics[mBackBufferIndex][index]->Reset()))
+			{
+				std::string message = "ER_RHI_DX12:: Could not Reset() command allocator (parallel graphics) " + std::to_string(index);
+				throw ER_CoreException(message.c_str());
+			}
+			mIsGraphicsCommandAllocatorReset[index] = true;
+		}
+
+		if (FAILED(hr = mCommandListGraphics[index]->Reset(mCommandAllocatorsGraphics[mBackBufferIndex][index].Get(), nullptr)))
+		{
+			std::string message = "ER_RHI_DX12:: Could not Reset() command list (parallel graphics) " + std::to_string(index);
+			throw ER_CoreException(message.c_str());
+		}
+
+		GetThreadGraphicsCommandListIndex() = index;
+		mRecordingStates[index] = ER_RHI_DX12_RecordingState();
+
+		// same GPU heap as the main command list (no reset)
+		ID3D12DescriptorHeap* ppHeaps[] = { mDescriptorHeapManager->GetGPUHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV)->GetHeap() };
+		mCommandListGraphics[index]->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
+	}
+
+	void ER_RHI_DX12::EndParallelGraphicsCommandList(int index)
+	{
+		assert(GetThreadGraphicsCommandListIndex() == index);
+		GetThreadGraphicsCommandListIndex() = -1;
+
+		HRESULT hr;
+		if (FAILED(hr = mCommandListGraphics[index]->Close()))
+		{
+			std::string message = "ER_RHI_DX12:: Could not close command list (parallel graphics) " + std::to_string(index);
+			throw ER_CoreException(message.c_str());
+		}
+	}
+
+	void ER_RHI_DX12::ExecuteParallelGraphicsCommandLists(const std::vector<int>& aIndices)
+	{
+		SubmitMainGraphicsCommandList(aIndices);
+	}
+
+	void ER_RHI_DX12::WaitForComputeOnGraphicsQueue()
+	{
+		if (mLastSignaledComputeFenceValue > mLastWaitedComputeFenceValue)
+		{
+			if (FAILED(mCommandQueueGraphics->Wait(mFenceCompute.Get(), mLastSignaledComputeFenceValue)))
+				throw ER_CoreException("ER_RHI_DX12: Could not wait on the compute fence in the graphics queue");
+			mLastWaitedComputeFenceValue = mLastSignaledComputeFenceValue;
+		}
+	}
+
+	void ER_RHI_DX12::WaitForGraphicsOnComputeQueue()
+	{
+		if (mFenceValuesGraphicsSubmissions > 0)
+		{
+			if (FAILED(mCommandQueueCompute->Wait(mFenceGraphicsSubmissions.Get(), mFenceValuesGraphicsSubmissions)))
+				throw ER_CoreException("ER_RHI_DX12: Could not wait on the graphics submissions fence in the compute queue");
+		}
+	}
+
 	void ER_RHI_DX12::BeginCopyCommandList(int index /*= 0*/)
 	{
 		HRESULT hr;
@@ -482,49 +764,49 @@ namespace EveryRay_Core
 
 	void ER_RHI_DX12::ClearMainRenderTarget(float colors[4])
 	{
-		assert(mCurrentGraphicsCommandListIndex > -1);
+		assert(GetCurrentGraphicsCommandListIndex() > -1);
 		CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(mMainRenderTarget[mBackBufferIndex].Get(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_RENDER_TARGET);
-		mCommandListGraphics[mCurrentGraphicsCommandListIndex]->ResourceBarrier(1, &barrier);
-		mCommandListGraphics[mCurrentGraphicsCommandListIndex]->ClearRenderTargetView(GetMainRenderTargetView(), colors, 0, nullptr);
+		mCommandListGraphics[GetCurrentGraphicsCommandListIndex()]->ResourceBarrier(1, &barrier);
+		mCommandListGraphics[GetCurrentGraphicsCommandListIndex()]->ClearRenderTargetView(GetMainRenderTargetView(), colors, 0, nullptr);
 	}
 
 	void ER_RHI_DX12::ClearMainDepthStencilTarget(float depth, UINT stencil /*= 0*/)
 	{
-		assert(mCurrentGraphicsCommandListIndex > -1);
-		mCommandListGraphics[mCurrentGraphicsCommandListIndex]->ClearDepthStencilView(GetMainDepthStencilView(), D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, depth, stencil, 0, nullptr);
+		assert(GetCurrentGraphicsCommandListIndex() > -1);
+		mCommandListGraphics[GetCurrentGraphicsCommandListIndex()]->ClearDepthStencilView(GetMainDepthStencilView(), D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, depth, stencil, 0, nullptr);
 	}
 
 	void ER_RHI_DX12::ClearRenderTarget(ER_RHI_GPUTexture* aRenderTarget, float colors[4], int rtvArrayIndex)
 	{
-		assert(mCurrentGraphicsCommandListIndex > -1);
+		assert(GetCurrentGraphicsCommandListIndex() > -1);
 		assert(aRenderTarget);
 		TransitionResources({ static_cast<ER_RHI_GPUResource*>(aRenderTarget) }, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_RENDER_TARGET);
 		if (rtvArrayIndex > 0)
 		{
 			ER_RHI_DX12_DescriptorHandle& handle = static_cast<ER_RHI_DX12_GPUTexture*>(aRenderTarget)->GetRTVHandle(rtvArrayIndex);
-			mCommandListGraphics[mCurrentGraphicsCommandListIndex]->ClearRenderTargetView(handle.GetCPUHandle(), colors, 0, nullptr);
+			mCommandListGraphics[GetCurrentGraphicsCommandListIndex()]->ClearRenderTargetView(handle.GetCPUHandle(), colors, 0, nullptr);
 		}
 		else
 		{
 			ER_RHI_DX12_DescriptorHandle& handle = static_cast<ER_RHI_DX12_GPUTexture*>(aRenderTarget)->GetRTVHandle();
-			mCommandListGraphics[mCurrentGraphicsCommandListIndex]->ClearRenderTargetView(handle.GetCPUHandle(), colors, 0, nullptr);
+			mCommandListGraphics[GetCurrentGraphicsCommandListIndex()]->ClearRenderTargetView(handle.GetCPUHandle(), colors, 0, nullptr);
 		}
 	}
 
 	void ER_RHI_DX12::ClearDepthStencilTarget(ER_RHI_GPUTexture* aDepthTarget, float depth, UINT stencil)
 	{
-		assert(mCurrentGraphicsCommandListIndex > -1);
+		assert(GetCurrentGraphicsCommandListIndex() > -1);
 		assert(aDepthTarget);
 		ER_RHI_DX12_GPUTexture* dtDX12 = static_cast<ER_RHI_DX12_GPUTexture*>(aDepthTarget);
 		assert(dtDX12);
 		TransitionResources({ aDepthTarget }, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_DEPTH_WRITE);
-		mCommandListGraphics[mCurrentGraphicsCommandListIndex]->ClearDepthStencilView(dtDX12->GetDSVHandle().GetCPUHandle(), (stencil == -1) ? D3D12_CLEAR_FLAG_DEPTH : D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, depth, stencil, 0, nullptr);
+		mCommandListGraphics[GetCurrentGraphicsCommandListIndex()]->ClearDepthStencilView(dtDX12->GetDSVHandle().GetCPUHandle(), (stencil == -1) ? D3D12_CLEAR_FLAG_DEPTH : D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, depth, stencil, 0, nullptr);
 	}
 
 	// Two versions are available (shader and command). Shader is the default one at the moment
 	void ER_RHI_DX12::ClearUAV(ER_RHI_GPUResource* aRenderTarget, float colors[4])
 	{
-		assert(mCurrentGraphicsCommandListIndex > -1);
+		assert(GetCurrentGraphicsCommandListIndex() > -1);
 		assert(aRenderTarget);
 		ER_RHI_DX12_GPUTexture* uavDX12 = static_cast<ER_RHI_DX12_GPUTexture*>(aRenderTarget);
 		assert(uavDX12);
@@ -533,10 +815,14 @@ namespace EveryRay_Core
 			return; //quick fix for not touching the resource that was created on a different back buffer's heap
 
 		bool is3D = uavDX12->GetDepth() > 0;
-		TransitionResources({ aRenderTarget }, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_UNORDERED_ACCESS, mCurrentGraphicsCommandListIndex);
+		const bool isComputeQueue = IsRecordingComputeQueue();
+		if (isComputeQueue)
+			TransitionResourcesOnComputeQueue({ aRenderTarget }, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_UNORDERED_ACCESS);
+		else
+			TransitionResources({ aRenderTarget }, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_UNORDERED_ACCESS, GetCurrentGraphicsCommandListIndex());
 
 		#pragma region SHADER_CLEAR
-		auto cmdList = mCommandListGraphics[mCurrentGraphicsCommandListIndex];
+		auto cmdList = GetCurrentCommandList(true);
 
 		const std::string psoName = is3D ? mClearUAV3DPSOName : mClearUAV2DPSOName;
 		ER_RHI_GPURootSignature* rs = is3D ? mClearUAV3DRS : mClearUAV2DRS;
@@ -568,7 +854,10 @@ namespace EveryRay_Core
 			cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::UAV(static_cast<ID3D12Resource*>(aRenderTarget->GetResource())));
 		}
 		UnsetPSO();
-		TransitionResources({ aRenderTarget }, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, mCurrentGraphicsCommandListIndex);
+		if (isComputeQueue)
+			TransitionResourcesOnComputeQueue({ aRenderTarget }, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_COMPUTE_SHADER_RESOURCE);
+		else
+			TransitionResources({ aRenderTarget }, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, GetCurrentGraphicsCommandListIndex());
 #pragma endregion
 
 		#pragma region COMMAND_CLEAR
@@ -580,7 +869,7 @@ namespace EveryRay_Core
 		//	D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle = uavDX12->GetUAVHandle().GetCPUHandle();
 		//	D3D12_GPU_DESCRIPTOR_HANDLE gpuHandle = uavDX12->GetUAVHandleGPU().GetGPUHandle();
 		//
-		//	mCommandListGraphics[mCurrentGraphicsCommandListIndex]->ClearUnorderedAccessViewFloat(gpuHandle, cpuHandle, static_cast<ID3D12Resource*>(uavDX12->GetResource()), colors, 0, nullptr);
+		//	mCommandListGraphics[GetCurrentGraphicsCommandListIndex()]->ClearUnorderedAccessViewFloat(gpuHandle, cpuHandle, static_cast<ID3D12Resource*>(uavDX12->GetResource()), colors, 0, nullptr);
 		//}
 		//else
 		//{
@@ -589,7 +878,7 @@ namespace EveryRay_Core
 		//		D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle = uavDX12->GetUAVHandle(i).GetCPUHandle();
 		//		D3D12_GPU_DESCRIPTOR_HANDLE gpuHandle = uavDX12->GetUAVHandleGPU(i).GetGPUHandle();
 		//
-		//		mCommandListGraphics[mCurrentGraphicsCommandListIndex]->ClearUnorderedAccessViewFloat(gpuHandle, cpuHandle, static_cast<ID3D12Resource*>(uavDX12->GetResource()), colors, 0, nullptr);
+		//		mCommandListGraphics[GetCurrentGraphicsCommandListIndex()]->ClearUnorderedAccessViewFloat(gpuHandle, cpuHandle, static_cast<ID3D12Resource*>(uavDX12->GetResource()), colors, 0, nullptr);
 		//	}
 		//}
 #pragma endregion
@@ -700,7 +989,7 @@ namespace EveryRay_Core
 	void ER_RHI_DX12::CopyGPUTextureSubresourceRegion(ER_RHI_GPUResource* aDestBuffer, UINT DstSubresource, UINT DstX, UINT DstY, UINT DstZ, ER_RHI_GPUResource* aSrcBuffer, UINT SrcSubresource, bool isInCopyQueueOrSkipTransitions)
 	{
 		if (!isInCopyQueueOrSkipTransitions)
-			assert(mCurrentGraphicsCommandListIndex > -1);
+			assert(GetCurrentGraphicsCommandListIndex() > -1);
 		assert(aDestBuffer);
 		assert(aSrcBuffer);
 
@@ -712,7 +1001,7 @@ namespace EveryRay_Core
 		if (!isInCopyQueueOrSkipTransitions)
 		{
 			TransitionResources({ static_cast<ER_RHI_GPUResource*>(dstbuffer), static_cast<ER_RHI_GPUResource*>(srcbuffer) },
-				{ ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_COPY_DEST, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_COPY_SOURCE }, mCurrentGraphicsCommandListIndex);
+				{ ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_COPY_DEST, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_COPY_SOURCE }, GetCurrentGraphicsCommandListIndex());
 		}
 
 		D3D12_TEXTURE_COPY_LOCATION dstLocation;
@@ -725,7 +1014,7 @@ namespace EveryRay_Core
 		srcLocation.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
 		srcLocation.SubresourceIndex = SrcSubresource;
 		
-		mCommandListGraphics[mCurrentGraphicsCommandListIndex]->CopyTextureRegion(&dstLocation, DstX, DstY, DstZ, &srcLocation, NULL);
+		mCommandListGraphics[GetCurrentGraphicsCommandListIndex()]->CopyTextureRegion(&dstLocation, DstX, DstY, DstZ, &srcLocation, NULL);
 		//else if (dstbuffer->GetTexture3D() && srcbuffer->GetTexture3D())
 		//else
 		//	throw ER_CoreException("ER_RHI_DX12:: One of the resources is NULL during CopyGPUTextureSubresourceRegion()");
@@ -733,56 +1022,69 @@ namespace EveryRay_Core
 		if (!isInCopyQueueOrSkipTransitions)
 		{
 			TransitionResources({ static_cast<ER_RHI_GPUResource*>(dstbuffer), static_cast<ER_RHI_GPUResource*>(srcbuffer) },
-				{ ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE }, mCurrentGraphicsCommandListIndex);
+				{ ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE }, GetCurrentGraphicsCommandListIndex());
 		}
 	}
 
 	void ER_RHI_DX12::Draw(UINT VertexCount)
 	{
-		assert(mCurrentGraphicsCommandListIndex > -1);
+		assert(GetCurrentGraphicsCommandListIndex() > -1);
 		assert(VertexCount > 0);
-		mCommandListGraphics[mCurrentGraphicsCommandListIndex]->DrawInstanced(VertexCount, 1, 0, 0);
+		mCommandListGraphics[GetCurrentGraphicsCommandListIndex()]->DrawInstanced(VertexCount, 1, 0, 0);
 	}
 
 	void ER_RHI_DX12::DrawIndexed(UINT IndexCount)
 	{
-		assert(mCurrentGraphicsCommandListIndex > -1);
+		assert(GetCurrentGraphicsCommandListIndex() > -1);
 		assert(IndexCount > 0);
-		mCommandListGraphics[mCurrentGraphicsCommandListIndex]->DrawIndexedInstanced(IndexCount, 1, 0, 0, 0);
+		mCommandListGraphics[GetCurrentGraphicsCommandListIndex()]->DrawIndexedInstanced(IndexCount, 1, 0, 0, 0);
 	}
 
 	void ER_RHI_DX12::DrawInstanced(UINT VertexCountPerInstance, UINT InstanceCount, UINT StartVertexLocation, UINT StartInstanceLocation)
 	{
 		assert(VertexCountPerInstance > 0);
 		assert(InstanceCount > 0);
-		assert(mCurrentGraphicsCommandListIndex > -1);
+		assert(GetCurrentGraphicsCommandListIndex() > -1);
 
-		mCommandListGraphics[mCurrentGraphicsCommandListIndex]->DrawInstanced(VertexCountPerInstance, InstanceCount, StartVertexLocation, StartInstanceLocation);
+		mCommandListGraphics[GetCurrentGraphicsCommandListIndex()]->DrawInstanced(VertexCountPerInstance, InstanceCount, StartVertexLocation, StartInstanceLocation);
 	}
 
 	void ER_RHI_DX12::DrawIndexedInstanced(UINT IndexCountPerInstance, UINT InstanceCount, UINT StartIndexLocation, INT BaseVertexLocation, UINT StartInstanceLocation)
 	{
-		assert(mCurrentGraphicsCommandListIndex > -1);
+		assert(GetCurrentGraphicsCommandListIndex() > -1);
 		assert(IndexCountPerInstance > 0);
 		assert(InstanceCount > 0);
 
-		mCommandListGraphics[mCurrentGraphicsCommandListIndex]->DrawIndexedInstanced(IndexCountPerInstance, InstanceCount, StartIndexLocation, BaseVertexLocation, StartInstanceLocation);
+		mCommandListGraphics[GetCurrentGraphicsCommandListIndex()]->DrawIndexedInstanced(IndexCountPerInstance, InstanceCount, StartIndexLocation, BaseVertexLocation, StartInstanceLocation);
 	}
 
 	void ER_RHI_DX12::DrawIndexedInstancedIndirect(ER_RHI_GPUBuffer* anArgsBuffer, UINT alignedByteOffset)
 	{
 		assert(anArgsBuffer);
-		assert(mCurrentGraphicsCommandListIndex > -1);
+		assert(GetCurrentGraphicsCommandListIndex() > -1);
 
-		TransitionResources({ anArgsBuffer }, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_INDIRECT_ARGUMENT);
+		TransitionResources({ anArgsBuffer }, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_INDIRECT_ARGUMENT, GetCurrentGraphicsCommandListIndex());
 
-		mCommandListGraphics[mCurrentGraphicsCommandListIndex]->ExecuteIndirect(mCommandSignature_DrawIndexed.Get(), 1, static_cast<ID3D12Resource*>(anArgsBuffer->GetResource()), alignedByteOffset, nullptr, 0);
+		mCommandListGraphics[GetCurrentGraphicsCommandListIndex()]->ExecuteIndirect(mCommandSignature_DrawIndexed.Get(), 1, static_cast<ID3D12Resource*>(anArgsBuffer->GetResource()), alignedByteOffset, nullptr, 0);
 	}
 
 	void ER_RHI_DX12::Dispatch(UINT ThreadGroupCountX, UINT ThreadGroupCountY, UINT ThreadGroupCountZ)
 	{
-		assert(mCurrentGraphicsCommandListIndex > -1);
-		mCommandListGraphics[mCurrentGraphicsCommandListIndex]->Dispatch(ThreadGroupCountX, ThreadGroupCountY, ThreadGroupCountZ);
+		assert(GetCurrentGraphicsCommandListIndex() > -1);
+		GetCurrentCommandList(true)->Dispatch(ThreadGroupCountX, ThreadGroupCountY, ThreadGroupCountZ);
+	}
+
+	void ER_RHI_DX12::DispatchIndirect(ER_RHI_GPUBuffer* anArgsBuffer, UINT alignedByteOffset)
+	{
+		assert(anArgsBuffer);
+		assert(GetCurrentGraphicsCommandListIndex() > -1);
+
+		if (IsRecordingComputeQueue())
+			TransitionResourcesOnComputeQueue({ anArgsBuffer }, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_INDIRECT_ARGUMENT);
+		else
+			TransitionResources({ anArgsBuffer }, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_INDIRECT_ARGUMENT, GetCurrentGraphicsCommandListIndex());
+
+		GetCurrentCommandList(true)->ExecuteIndirect(mCommandSignature_Dispatch.Get(), 1, static_cast<ID3D12Resource*>(anArgsBuffer->GetResource()), alignedByteOffset, nullptr, 0);
 	}
 
 	void ER_RHI_DX12::ExecuteCommandLists(int commandListIndex /*= 0*/, bool isCompute /*= false*/)
@@ -791,8 +1093,30 @@ namespace EveryRay_Core
 		{
 			ID3D12CommandList* ppCommandLists[] = { mCommandListGraphics[commandListIndex].Get() };
 			mCommandQueueGraphics->ExecuteCommandLists(1, ppCommandLists);
+
+			if (mFenceGraphicsSubmissions)
+				mCommandQueueGraphics->Signal(mFenceGraphicsSubmissions.Get(), ++mFenceValuesGraphicsSubmissions);
+		}
+		else
+		{
+			assert(commandListIndex < ER_RHI_MAX_COMPUTE_COMMAND_LISTS);
+
+			// resources that were left in graphics-only states are transitioned on the graphics queue first
+			if (mIsHandoffCommandListPending)
+			{
+				ExecuteCommandLists(mHandoffGraphicsCommandListIndex);
+				WaitForGraphicsOnComputeQueue();
+				mIsHandoffCommandListPending = false;
+			}
+
+			ID3D12CommandList* ppCommandLists[] = { mCommandListCompute[commandListIndex].Get() };
+			mCommandQueueCompute->ExecuteCommandLists(1, ppCommandLists);
+
+			if (FAILED(mCommandQueueCompute->Signal(mFenceCompute.Get(), mFenceValuesCompute)))
+				throw ER_CoreException("ER_RHI_DX12: Could not signal compute command queue");
+			mLastSignaledComputeFenceValue = mFenceValuesCompute;
+			mFenceValuesCompute++;
 		}
-		//else TODO
 	}
 
 	void ER_RHI_DX12::ExecuteCopyCommandList()
@@ -812,7 +1136,7 @@ namespace EveryRay_Core
 		const UINT rootParamIndexUav = 1;
 		const UINT rootParamIndexConstant = 2;
 
-		assert(mCurrentGraphicsCommandListIndex > -1);
+		assert(GetCurrentGraphicsCommandListIndex() > -1);
 
 		UINT srcWidth = aTexture->GetWidth();
 		UINT srcHeight = aTexture->GetHeight();
@@ -824,7 +1148,11 @@ namespace EveryRay_Core
 		UINT mipCount = (aTexture->GetMips() > 1) ? aTexture->GetMips() : aTexture->GetCalculatedMipCount();
 		assert(mipCount > 1);
 
-		auto cmdList = mCommandListGraphics[mCurrentGraphicsCommandListIndex];
+		const bool isComputeQueue = IsRecordingComputeQueue();
+		if (isComputeQueue && IsGraphicsQueueOnlyState(aTexture->GetCurrentState()))
+			TransitionResourcesOnComputeQueue({ aTexture }, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_UNORDERED_ACCESS);
+
+		auto cmdList = GetCurrentCommandList(true);
 
 		const std::string& psoName = is3D ? mGenerateMips3DPSOName : mGenerateMips2DPSOName;
 		ER_RHI_GPURootSignature* rs = is3D ? mGenerateMips3DRS : mGenerateMips2DRS;
@@ -841,13 +1169,15 @@ namespace EveryRay_Core
 
 		//transition first mip to non-pixel shader resource (because we will read from it) and all other mips to unordered access
 		std::vector< CD3DX12_RESOURCE_BARRIER> barriers;
-		barriers.emplace_back(CD3DX12_RESOURCE_BARRIER::Transition(static_cast<ID3D12Resource*>(aTexture->GetResource()), GetState(aTexture->GetCurrentState()), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, 0));
+		if (GetState(aTexture->GetCurrentState()) != D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE)
+			barriers.emplace_back(CD3DX12_RESOURCE_BARRIER::Transition(static_cast<ID3D12Resource*>(aTexture->GetResource()), GetState(aTexture->GetCurrentState()), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, 0));
 		for (UINT mip = 1; mip < mipCount; mip++)
 		{
 			if (GetState(aTexture->GetCurrentState()) != D3D12_RESOURCE_STATE_UNORDERED_ACCESS)
 				barriers.emplace_back(CD3DX12_RESOURCE_BARRIER::Transition(static_cast<ID3D12Resource*>(aTexture->GetResource()), GetState(aTexture->GetCurrentState()), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, mip));
 		}
-		cmdList->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
+		if (!barriers.empty())
+			cmdList->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
 
 		SetShaderResources(ER_COMPUTE, { !aSRGBTexture ? aTexture : aSRGBTexture }, 0, rs, rootParamIndexSrv, true, true);
 
@@ -873,21 +1203,24 @@ namespace EveryRay_Core
 		}
 		UnsetPSO();
 
-		//reset the transitions
+		//reset the transitions (pixel shader resource state is not supported on the compute queue)
+		const D3D12_RESOURCE_STATES finalState = isComputeQueue ? D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE : D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
 		std::vector< CD3DX12_RESOURCE_BARRIER> barriersFinal;
-		barriersFinal.emplace_back(CD3DX12_RESOURCE_BARRIER::Transition(static_cast<ID3D12Resource*>(aTexture->GetResource()), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, 0));
+		if (finalState != D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE)
+			barriersFinal.emplace_back(CD3DX12_RESOURCE_BARRIER::Transition(static_cast<ID3D12Resource*>(aTexture->GetResource()), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, finalState, 0));
 		for (UINT mip = 1; mip < mipCount; mip++)
-			barriersFinal.emplace_back(CD3DX12_RESOURCE_BARRIER::Transition(static_cast<ID3D12Resource*>(aTexture->GetResource()), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, mip));
+			barriersFinal.emplace_back(CD3DX12_RESOURCE_BARRIER::Transition(static_cast<ID3D12Resource*>(aTexture->GetResource()), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, finalState, mip));
 		cmdList->ResourceBarrier(static_cast<UINT>(barriersFinal.size()), barriersFinal.data());
-		aTexture->SetCurrentState(ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+		aTexture->SetCurrentState(isComputeQueue ? ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_COMPUTE_SHADER_RESOURCE : ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 	}
 
 	void ER_RHI_DX12::GenerateMipsWithTextureReplacement(ER_RHI_GPUTexture** aTexture, std::function<void(ER_RHI_GPUTexture**)> aReplacementCallback)
 	{
+		assert(!IsLoadingThread()); // records into the main command list
 		if ((*aTexture)->GetMips() > 1) //probably the texture already has mips
 			return;
 
-		if (mGenerateMipsWithReplacementCurrentTextureIndexInPool > DX12_MAX_GENERATE_MIPS_TEXTURES_IN_POOL)
+		if (mGenerateMipsWithReplacementCurrentTextureIndexInPool >= DX12_MAX_GENERATE_MIPS_TEXTURES_IN_POOL)
 			throw ER_CoreException("ER_RHI_DX12:: There is no space left in the temp texture pool for mip generation! Bump DX12_MAX_GENERATE_MIPS_TEXTURES_IN_POOL.");
 
 		ER_RHI_DX12_GPUTexture* dx12Texture = static_cast<ER_RHI_DX12_GPUTexture*>(*aTexture);
@@ -943,6 +1276,9 @@ namespace EveryRay_Core
 		}
 		else
 		{
+			// the frame is finished only when its compute work is finished, too (so that we can reset the compute allocators of this back buffer later)
+			WaitForComputeOnGraphicsQueue();
+
 			// Schedule a Signal command in the queue.
 			const UINT64 currentFenceValue = mFenceValuesGraphics[mBackBufferIndex];
 			if (FAILED(mCommandQueueGraphics->Signal(mFenceGraphics.Get(), currentFenceValue)))
@@ -958,9 +1294,18 @@ namespace EveryRay_Core
 				WaitForSingleObjectEx(mFenceEventGraphics.Get(), INFINITE, FALSE);
 			}
 
+			// the frame that was previously recorded with this back buffer index has finished on the GPU
+			mDeferredReleaseResources[mBackBufferIndex].clear();
+
 			// Set the fence value for the next frame.
 			mFenceValuesGraphics[mBackBufferIndex] = currentFenceValue + 1;
 
+			for (int i = 0; i < ER_RHI_MAX_COMPUTE_COMMAND_LISTS; i++)
+				mIsComputeCommandAllocatorReset[i] = false;
+			for (int i = 0; i < ER_RHI_MAX_GRAPHICS_COMMAND_LISTS; i++)
+				mIsGraphicsCommandAllocatorReset[i] = false;
+			mIsHandoffCommandAllocatorReset = false;
+
 			if (!mDXGIFactory->IsCurrent())
 			{
 				if (FAILED(CreateDXGIFactory2(mDXGIFactoryFlags, IID_PPV_ARGS(mDXGIFactory.ReleaseAndGetAddressOf()))))
@@ -971,14 +1316,13 @@ namespace EveryRay_Core
 
 	void ER_RHI_DX12::PresentCompute()
 	{
-		//mCommandListCompute->Close();
-		//
-		//ID3D12CommandList* ppCommandLists[] = { mCommandListCompute };
-		//mCommandQueueCompute->ExecuteCommandLists(1, ppCommandLists);
+		// submits the open compute command list (graphics queue will wait for it before the frame is finished)
+		if (!IsRecordingComputeQueue())
+			return;
 
-		//UINT64 fenceValue = mFenceValuesCompute;
-		//mCommandQueueCompute->Signal(mFenceCompute.Get(), fenceValue);
-		//mFenceValuesCompute++;
+		const int index = mCurrentComputeCommandListIndex;
+		EndComputeCommandList(index);
+		ExecuteCommandLists(index, true);
 	}
 
 	bool ER_RHI_DX12::ProjectCubemapToSH(ER_RHI_GPUTexture* aTexture, UINT order, float* resultR, float* resultG, float* resultB)
@@ -999,7 +1343,7 @@ namespace EveryRay_Core
 
 	void ER_RHI_DX12::SetRenderTargets(const std::vector<ER_RHI_GPUTexture*>& aRenderTargets, ER_RHI_GPUTexture* aDepthTarget /*= nullptr*/, ER_RHI_GPUTexture* aUAV /*= nullptr*/, int rtvArrayIndex)
 	{
-		assert(mCurrentGraphicsCommandListIndex > -1);
+		assert(GetCurrentGraphicsCommandListIndex() > -1);
 		if (!aUAV)
 		{
 			if (rtvArrayIndex > 0)
@@ -1030,15 +1374,19 @@ namespace EveryRay_Core
 				for (UINT i = 0; i < rtCount; i++)
 					transitions[i] = ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_RENDER_TARGET;
 
+				const bool isInRenderGraphState = IsInRenderGraphState(resources, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_RENDER_TARGET) &&
+					IsInRenderGraphState({ static_cast<ER_RHI_GPUResource*>(aDepthTarget) }, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_DEPTH_WRITE);
 				resources.push_back(static_cast<ER_RHI_GPUResource*>(aDepthTarget));
 				transitions.push_back(ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_DEPTH_WRITE);
-				TransitionResources(resources, transitions);
-				mCommandListGraphics[mCurrentGraphicsCommandListIndex]->OMSetRenderTargets(rtCount, rtvHandles, FALSE, &dsvHandle);
+				if (!isInRenderGraphState)
+					TransitionResources(resources, transitions);
+				mCommandListGraphics[GetCurrentGraphicsCommandListIndex()]->OMSetRenderTargets(rtCount, rtvHandles, FALSE, &dsvHandle);
 			}
 			else
 			{
-				TransitionResources(resources, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_RENDER_TARGET);
-				mCommandListGraphics[mCurrentGraphicsCommandListIndex]->OMSetRenderTargets(rtCount, rtvHandles, FALSE, NULL);
+				if (!IsInRenderGraphState(resources, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_RENDER_TARGET))
+					TransitionResources(resources, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_RENDER_TARGET);
+				mCommandListGraphics[GetCurrentGraphicsCommandListIndex()]->OMSetRenderTargets(rtCount, rtvHandles, FALSE, NULL);
 			}
 
 		}
@@ -1051,23 +1399,23 @@ namespace EveryRay_Core
 
 	void ER_RHI_DX12::SetDepthTarget(ER_RHI_GPUTexture* aDepthTarget)
 	{
-		assert(mCurrentGraphicsCommandListIndex > -1);
+		assert(GetCurrentGraphicsCommandListIndex() > -1);
 
 		assert(aDepthTarget);
 		D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = static_cast<ER_RHI_DX12_GPUTexture*>(aDepthTarget)->GetDSVHandle().GetCPUHandle();
 		TransitionResources({ static_cast<ER_RHI_GPUResource*>(aDepthTarget) }, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_DEPTH_WRITE);
 
-		mCommandListGraphics[mCurrentGraphicsCommandListIndex]->OMSetRenderTargets(0, nullptr, FALSE, &dsvHandle);
+		mCommandListGraphics[GetCurrentGraphicsCommandListIndex()]->OMSetRenderTargets(0, nullptr, FALSE, &dsvHandle);
 	}
 
 	void ER_RHI_DX12::SetRenderTargetFormats(const std::vector<ER_RHI_GPUTexture*>& aRenderTargets, ER_RHI_GPUTexture* aDepthTarget /*= nullptr*/)
 	{
-		if (mCurrentPSOState == ER_RHI_DX12_PSO_STATE::COMPUTE)
+		if (GetRecordingState().PSOState == ER_RHI_DX12_PSO_STATE::COMPUTE)
 			return;
 
-		assert(mCurrentPSOState == ER_RHI_DX12_PSO_STATE::GRAPHICS);
+		assert(GetRecordingState().PSOState == ER_RHI_DX12_PSO_STATE::GRAPHICS);
 
-		ER_RHI_DX12_GraphicsPSO& pso = mGraphicsPSONames.at(mCurrentGraphicsPSOName);
+		ER_RHI_DX12_GraphicsPSO& pso = mGraphicsPSONames.at(GetRecordingState().GraphicsPSOName);
 		int rtCount = static_cast<int>(aRenderTargets.size());
 		assert(rtCount <= 8);
 
@@ -1079,24 +1427,24 @@ namespace EveryRay_Core
 
 	void ER_RHI_DX12::SetMainRenderTargetFormats()
 	{
-		assert(mCurrentPSOState == ER_RHI_DX12_PSO_STATE::GRAPHICS);
+		assert(GetRecordingState().PSOState == ER_RHI_DX12_PSO_STATE::GRAPHICS);
 
-		ER_RHI_DX12_GraphicsPSO& pso = mGraphicsPSONames.at(mCurrentGraphicsPSOName);
+		ER_RHI_DX12_GraphicsPSO& pso = mGraphicsPSONames.at(GetRecordingState().GraphicsPSOName);
 		pso.SetRenderTargetFormats(1, &mMainRTBufferFormat, mMainDepthBufferFormat);
 	}
 
 	void ER_RHI_DX12::SetDepthStencilState(ER_RHI_DEPTH_STENCIL_STATE aDS, UINT stencilRef)
 	{
-		if (mCurrentPSOState == ER_RHI_DX12_PSO_STATE::UNSET)
+		if (GetRecordingState().PSOState == ER_RHI_DX12_PSO_STATE::UNSET)
 			return;
 
-		assert(mCurrentPSOState == ER_RHI_DX12_PSO_STATE::GRAPHICS);
+		assert(GetRecordingState().PSOState == ER_RHI_DX12_PSO_STATE::GRAPHICS);
 
 		auto it = mDepthStates.find(aDS);
 		if (it != mDepthStates.end())
 		{
 			mCurrentDS = aDS;
-			ER_RHI_DX12_GraphicsPSO& pso = mGraphicsPSONames.at(mCurrentGraphicsPSOName);
+			ER_RHI_DX12_GraphicsPSO& pso = mGraphicsPSONames.at(GetRecordingState().GraphicsPSOName);
 			pso.SetDepthStencilState(it->second);
 		}
 		else
@@ -1105,16 +1453,16 @@ namespace EveryRay_Core
 
 	void ER_RHI_DX12::SetBlendState(ER_RHI_BLEND_STATE aBS, const float BlendFactor[4], UINT SampleMask)
 	{
-		if (mCurrentPSOState == ER_RHI_DX12_PSO_STATE::UNSET)
+		if (GetRecordingState().PSOState == ER_RHI_DX12_PSO_STATE::UNSET)
 			return;
 
-		assert(mCurrentPSOState == ER_RHI_DX12_PSO_STATE::GRAPHICS);
+		assert(GetRecordingState().PSOState == ER_RHI_DX12_PSO_STATE::GRAPHICS);
 
 		auto it = mBlendStates.find(aBS);
 		if (it != mBlendStates.end())
 		{
 			mCurrentBS = aBS;
-			ER_RHI_DX12_GraphicsPSO& pso = mGraphicsPSONames.at(mCurrentGraphicsPSOName);
+			ER_RHI_DX12_GraphicsPSO& pso = mGraphicsPSONames.at(GetRecordingState().GraphicsPSOName);
 			pso.SetBlendState(it->second);
 		}
 		else
@@ -1123,16 +1471,16 @@ namespace EveryRay_Core
 
 	void ER_RHI_DX12::SetRasterizerState(ER_RHI_RASTERIZER_STATE aRS)
 	{
-		if (mCurrentPSOState == ER_RHI_DX12_PSO_STATE::UNSET)
+		if (GetRecordingState().PSOState == ER_RHI_DX12_PSO_STATE::UNSET)
 			return;
 
-		assert(mCurrentPSOState == ER_RHI_DX12_PSO_STATE::GRAPHICS);
+		assert(GetRecordingState().PSOState == ER_RHI_DX12_PSO_STATE::GRAPHICS);
 
 		auto it = mRasterizerStates.find(aRS);
 		if (it != mRasterizerStates.end())
 		{
 			mCurrentRS = aRS;
-			ER_RHI_DX12_GraphicsPSO& pso = mGraphicsPSONames.at(mCurrentGraphicsPSOName);
+			ER_RHI_DX12_GraphicsPSO& pso = mGraphicsPSONames.at(GetRecordingState().GraphicsPSOName);
 			pso.SetRasterizerState(it->second);
 		}
 		else
@@ -1149,26 +1497,26 @@ namespace EveryRay_Core
 		viewport.MinDepth = aViewport.MinDepth;
 		viewport.MaxDepth = aViewport.MaxDepth;
 
-		mCurrentViewport = aViewport;
-		assert(mCurrentGraphicsCommandListIndex > -1);
+		GetRecordingState().Viewport = aViewport;
+		assert(GetCurrentGraphicsCommandListIndex() > -1);
 
-		mCommandListGraphics[mCurrentGraphicsCommandListIndex]->RSSetViewports(1, &viewport);
+		mCommandListGraphics[GetCurrentGraphicsCommandListIndex()]->RSSetViewports(1, &viewport);
 	}
 
 	void ER_RHI_DX12::SetRect(const ER_RHI_Rect& rect)
 	{
-		mCurrentRect = rect;
-		assert(mCurrentGraphicsCommandListIndex > -1);
+		GetRecordingState().Rect = rect;
+		assert(GetCurrentGraphicsCommandListIndex() > -1);
 
 		D3D12_RECT currentRect = { rect.left, rect.top, rect.right, rect.bottom };
-		mCommandListGraphics[mCurrentGraphicsCommandListIndex]->RSSetScissorRects(1, &currentRect);
+		mCommandListGraphics[GetCurrentGraphicsCommandListIndex()]->RSSetScissorRects(1, &currentRect);
 	}
 
 	void ER_RHI_DX12::SetShader(ER_RHI_GPUShader* aShader)
 	{
 		assert(aShader);
 
-		assert(mCurrentPSOState != ER_RHI_DX12_PSO_STATE::UNSET);
+		assert(GetRecordingState().PSOState != ER_RHI_DX12_PSO_STATE::UNSET);
 
 		ER_RHI_DX12_GPUShader* aDX12_Shader = static_cast<ER_RHI_DX12_GPUShader*>(aShader);
 		assert(aDX12_Shader);
@@ -1176,9 +1524,9 @@ namespace EveryRay_Core
 		ID3DBlob* blob = static_cast<ID3DBlob*>(aDX12_Shader->GetShaderObject());
 		assert(blob);
 
-		if (mCurrentPSOState == ER_RHI_DX12_PSO_STATE::GRAPHICS)
+		if (GetRecordingState().PSOState == ER_RHI_DX12_PSO_STATE::GRAPHICS)
 		{
-			ER_RHI_DX12_GraphicsPSO& pso = mGraphicsPSONames.at(mCurrentGraphicsPSOName);
+			ER_RHI_DX12_GraphicsPSO& pso = mGraphicsPSONames.at(GetRecordingState().GraphicsPSOName);
 
 			switch (aShader->mShaderType)
 			{
@@ -1201,7 +1549,7 @@ namespace EveryRay_Core
 		}
 		else
 		{
-			ER_RHI_DX12_ComputePSO& pso = mComputePSONames.at(mCurrentComputePSOName);
+			ER_RHI_DX12_ComputePSO& pso = mComputePSONames.at(GetRecordingState().ComputePSOName);
 			pso.SetComputeShader(blob->GetBufferPointer(), blob->GetBufferSize());
 		}
 	}
@@ -1215,7 +1563,7 @@ namespace EveryRay_Core
 		assert(srvCount > 0 && srvCount <= DX12_MAX_BOUND_SHADER_RESOURCE_VIEWS);
 		//assert(srvCount <= rs->GetRootParameterSRVCount(rootParamIndex));
 		assert(mDescriptorHeapManager);
-		assert(mCurrentGraphicsCommandListIndex > -1);
+		assert(GetCurrentGraphicsCommandListIndex() > -1);
 
 		ER_RHI_DX12_GPUDescriptorHeap* gpuDescriptorHeap = mDescriptorHeapManager->GetGPUHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 		ER_RHI_DX12_DescriptorHandle& srvHandle = gpuDescriptorHeap->GetHandleBlock(srvCount);
@@ -1233,15 +1581,20 @@ namespace EveryRay_Core
 
 		}
 
+		const bool isComputeQueue = isComputeRS && IsRecordingComputeQueue();
 		if (!skipAutomaticTransition)
-			TransitionResources(aSRVs, aShaderType == ER_RHI_SHADER_TYPE::ER_PIXEL ? ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE : ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, mCurrentGraphicsCommandListIndex);
+		{
+			const ER_RHI_RESOURCE_STATE state = aShaderType == ER_RHI_SHADER_TYPE::ER_PIXEL ? ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE : ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+			if (isComputeQueue)
+				TransitionResourcesOnComputeQueue(aSRVs, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_COMPUTE_SHADER_RESOURCE);
+			else if (!IsInRenderGraphState(aSRVs, state))
+				TransitionResources(aSRVs, state, GetCurrentGraphicsCommandListIndex());
+		}
 
 		if (!isComputeRS)
-			mCommandListGraphics[mCurrentGraphicsCommandListIndex]->SetGraphicsRootDescriptorTable(rootParamIndex, srvHandle.GetGPUHandle());
+			mCommandListGraphics[GetCurrentGraphicsCommandListIndex()]->SetGraphicsRootDescriptorTable(rootParamIndex, srvHandle.GetGPUHandle());
 		else
-			mCommandListGraphics[mCurrentGraphicsCommandListIndex]->SetComputeRootDescriptorTable(rootParamIndex, srvHandle.GetGPUHandle());
-
-		//TODO compute queue
+			GetCurrentCommandList(true)->SetComputeRootDescriptorTable(rootParamIndex, srvHandle.GetGPUHandle());
 	}
 
 	void ER_RHI_DX12::SetUnorderedAccessResources(ER_RHI_SHADER_TYPE aShaderType, const std::vector<ER_RHI_GPUResource*>& aUAVs, UINT startSlot /*= 0*/,
@@ -1253,7 +1606,7 @@ namespace EveryRay_Core
 		assert(uavCount > 0 && uavCount <= DX12_MAX_BOUND_UNORDERED_ACCESS_VIEWS);
 		//assert(uavCount <= rs->GetRootParameterUAVCount(rootParamIndex));
 		assert(mDescriptorHeapManager);
-		assert(mCurrentGraphicsCommandListIndex > -1);
+		assert(GetCurrentGraphicsCommandListIndex() > -1);
 
 		ER_RHI_DX12_GPUDescriptorHeap* gpuDescriptorHeap = mDescriptorHeapManager->GetGPUHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 		ER_RHI_DX12_DescriptorHandle& uavHandle = gpuDescriptorHeap->GetHandleBlock(uavCount);
@@ -1266,15 +1619,19 @@ namespace EveryRay_Core
 				gpuDescriptorHeap->AddToHandle(mDevice.Get(), uavHandle, static_cast<ER_RHI_DX12_GPUTexture*>(aUAVs[i])->GetUAVHandle(startSlot));
 		}
 
+		const bool isComputeQueue = isComputeRS && IsRecordingComputeQueue();
 		if (!skipAutomaticTransition)
-			TransitionResources(aUAVs, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_UNORDERED_ACCESS, mCurrentGraphicsCommandListIndex);
+		{
+			if (isComputeQueue)
+				TransitionResourcesOnComputeQueue(aUAVs, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_UNORDERED_ACCESS);
+			else if (!IsInRenderGraphState(aUAVs, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_UNORDERED_ACCESS))
+				TransitionResources(aUAVs, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_UNORDERED_ACCESS, GetCurrentGraphicsCommandListIndex());
+		}
 
 		if (!isComputeRS)
-			mCommandListGraphics[mCurrentGraphicsCommandListIndex]->SetGraphicsRootDescriptorTable(rootParamIndex, uavHandle.GetGPUHandle());
+			mCommandListGraphics[GetCurrentGraphicsCommandListIndex()]->SetGraphicsRootDescriptorTable(rootParamIndex, uavHandle.GetGPUHandle());
 		else
-			mCommandListGraphics[mCurrentGraphicsCommandListIndex]->SetComputeRootDescriptorTable(rootParamIndex, uavHandle.GetGPUHandle());
-
-		//TODO compute queue
+			GetCurrentCommandList(true)->SetComputeRootDescriptorTable(rootParamIndex, uavHandle.GetGPUHandle());
 	}
 
 	void ER_RHI_DX12::SetConstantBuffers(ER_RHI_SHADER_TYPE aShaderType, const std::vector<ER_RHI_GPUBuffer*>& aCBs, UINT startSlot /*= 0*/,
@@ -1286,7 +1643,7 @@ namespace EveryRay_Core
 		assert(cbvCount > 0 && cbvCount <= DX12_MAX_BOUND_CONSTANT_BUFFERS);
 		//assert(cbvCount <= rs->GetRootParameterCBVCount(rootParamIndex));
 		assert(mDescriptorHeapManager);
-		assert(mCurrentGraphicsCommandListIndex > -1);
+		assert(GetCurrentGraphicsCommandListIndex() > -1);
 
 		ER_RHI_DX12_GPUDescriptorHeap* gpuDescriptorHeap = mDescriptorHeapManager->GetGPUHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 		ER_RHI_DX12_DescriptorHandle& cbvHandle = gpuDescriptorHeap->GetHandleBlock(cbvCount);
@@ -1297,11 +1654,9 @@ namespace EveryRay_Core
 		}
 
 		if (!isComputeRS)
-			mCommandListGraphics[mCurrentGraphicsCommandListIndex]->SetGraphicsRootDescriptorTable(rootParamIndex, cbvHandle.GetGPUHandle());
+			mCommandListGraphics[GetCurrentGraphicsCommandListIndex()]->SetGraphicsRootDescriptorTable(rootParamIndex, cbvHandle.GetGPUHandle());
 		else
-			mCommandListGraphics[mCurrentGraphicsCommandListIndex]->SetComputeRootDescriptorTable(rootParamIndex, cbvHandle.GetGPUHandle());
-
-		//TODO compute queue
+			GetCurrentCommandList(true)->SetComputeRootDescriptorTable(rootParamIndex, cbvHandle.GetGPUHandle());
 	}
 
 	void ER_RHI_DX12::SetSamplers(ER_RHI_SHADER_TYPE aShaderType, const std::vector<ER_RHI_SAMPLER_STATE>& aSamplers, UINT startSlot /*= 0*/, ER_RHI_GPURootSignature* rs)
@@ -1314,10 +1669,10 @@ namespace EveryRay_Core
 
 	void ER_RHI_DX12::SetInputLayout(ER_RHI_InputLayout* aIL)
 	{
-		assert(mCurrentPSOState == ER_RHI_DX12_PSO_STATE::GRAPHICS);
+		assert(GetRecordingState().PSOState == ER_RHI_DX12_PSO_STATE::GRAPHICS);
 		assert(aIL);
 
-		ER_RHI_DX12_GraphicsPSO& pso = mGraphicsPSONames.at(mCurrentGraphicsPSOName);
+		ER_RHI_DX12_GraphicsPSO& pso = mGraphicsPSONames.at(GetRecordingState().GraphicsPSOName);
 		pso.SetInputLayout(this, aIL->mInputElementDescriptionCount, aIL->mInputElementDescriptions);
 	}
 
@@ -1328,19 +1683,19 @@ namespace EveryRay_Core
 
 	void ER_RHI_DX12::SetIndexBuffer(ER_RHI_GPUBuffer* aBuffer, UINT offset /*= 0*/)
 	{
-		assert(mCurrentGraphicsCommandListIndex > -1);
+		assert(GetCurrentGraphicsCommandListIndex() > -1);
 
 		assert(aBuffer);
 		ER_RHI_DX12_GPUBuffer* buf = static_cast<ER_RHI_DX12_GPUBuffer*>(aBuffer);
 		assert(buf);
 
 		D3D12_INDEX_BUFFER_VIEW view = buf->GetIndexBufferView();
-		mCommandListGraphics[mCurrentGraphicsCommandListIndex]->IASetIndexBuffer(&view);
+		mCommandListGraphics[GetCurrentGraphicsCommandListIndex()]->IASetIndexBuffer(&view);
 	}
 
 	void ER_RHI_DX12::SetVertexBuffers(const std::vector<ER_RHI_GPUBuffer*>& aVertexBuffers)
 	{
-		assert(mCurrentGraphicsCommandListIndex > -1);
+		assert(GetCurrentGraphicsCommandListIndex() > -1);
 
 		assert(aVertexBuffers.size() > 0 && aVertexBuffers.size() <= ER_RHI_MAX_BOUND_VERTEX_BUFFERS);
 		if (aVertexBuffers.size() == 1)
@@ -1351,11 +1706,11 @@ namespace EveryRay_Core
 			assert(buffer);
 
 			D3D12_VERTEX_BUFFER_VIEW view = buffer->GetVertexBufferView();
-			mCommandListGraphics[mCurrentGraphicsCommandListIndex]->IASetVertexBuffers(0, 1, &view);
-			if (mIsInstancedBufferBound)
+			mCommandListGraphics[GetCurrentGraphicsCommandListIndex()]->IASetVertexBuffers(0, 1, &view);
+			if (GetRecordingState().IsInstancedBufferBound)
 			{
-				mCommandListGraphics[mCurrentGraphicsCommandListIndex]->IASetVertexBuffers(1, 1, nullptr);
-				mIsInstancedBufferBound = false;
+				mCommandListGraphics[GetCurrentGraphicsCommandListIndex()]->IASetVertexBuffers(1, 1, nullptr);
+				GetRecordingState().IsInstancedBufferBound = false;
 			}
 		}
 		else //+ instance buffer
@@ -1371,47 +1726,53 @@ namespace EveryRay_Core
 			assert(instanceBuffer);
 
 			D3D12_VERTEX_BUFFER_VIEW views[2] = { vertexBuffer->GetVertexBufferView(), instanceBuffer->GetVertexBufferView() };
-			mCommandListGraphics[mCurrentGraphicsCommandListIndex]->IASetVertexBuffers(0, 2, views);
+			mCommandListGraphics[GetCurrentGraphicsCommandListIndex()]->IASetVertexBuffers(0, 2, views);
 
-			mIsInstancedBufferBound = true;
+			GetRecordingState().IsInstancedBufferBound = true;
 		}
 	}
 
 	void ER_RHI_DX12::SetTopologyType(ER_RHI_PRIMITIVE_TYPE aType)
 	{
-		assert(mCurrentGraphicsCommandListIndex > -1);
-		mCommandListGraphics[mCurrentGraphicsCommandListIndex]->IASetPrimitiveTopology(GetTopology(aType));
+		assert(GetCurrentGraphicsCommandListIndex() > -1);
+		GetRecordingState().Topology = GetTopology(aType);
+		mCommandListGraphics[GetCurrentGraphicsCommandListIndex()]->IASetPrimitiveTopology(GetRecordingState().Topology);
 	}
 
 	void ER_RHI_DX12::SetRootSignature(ER_RHI_GPURootSignature* rs, bool isCompute)
 	{
 		assert(rs);
-		assert(mCurrentGraphicsCommandListIndex > -1);
+		assert(GetCurrentGraphicsCommandListIndex() > -1);
+		ID3D12RootSignature* signature = static_cast<ER_RHI_DX12_GPURootSignature*>(rs)->GetSignature();
 		if (!isCompute)
-			mCommandListGraphics[mCurrentGraphicsCommandListIndex]->SetGraphicsRootSignature(static_cast<ER_RHI_DX12_GPURootSignature*>(rs)->GetSignature());
+		{
+			mCommandListGraphics[GetCurrentGraphicsCommandListIndex()]->SetGraphicsRootSignature(signature);
+			GetRecordingState().GraphicsRootSignature = signature;
+		}
+		else if (IsRecordingComputeQueue())
+			mCommandListCompute[mCurrentComputeCommandListIndex]->SetComputeRootSignature(signature);
 		else
-			mCommandListGraphics[mCurrentGraphicsCommandListIndex]->SetComputeRootSignature(static_cast<ER_RHI_DX12_GPURootSignature*>(rs)->GetSignature());
-
-		//TODO compute queue
+		{
+			mCommandListGraphics[GetCurrentGraphicsCommandListIndex()]->SetComputeRootSignature(signature);
+			GetRecordingState().ComputeRootSignature = signature;
+		}
 	}
 
 	void ER_RHI_DX12::SetRootConstant(UINT aConstant, UINT aRootIndex, UINT anOffset, bool isCompute)
 	{
 		if (!isCompute)
-			mCommandListGraphics[mCurrentGraphicsCommandListIndex]->SetGraphicsRoot32BitConstant(aRootIndex, aConstant, anOffset);
+			mCommandListGraphics[GetCurrentGraphicsCommandListIndex()]->SetGraphicsRoot32BitConstant(aRootIndex, aConstant, anOffset);
 		else
-			mCommandListGraphics[mCurrentGraphicsCommandListIndex]->SetComputeRoot32BitConstant(aRootIndex, aConstant, anOffset);
-
-		//TODO compute queue
+			GetCurrentCommandList(true)->SetComputeRoot32BitConstant(aRootIndex, aConstant, anOffset);
 	}
 
 	void ER_RHI_DX12::SetTopologyTypeToPSO(const std::string& aName, ER_RHI_PRIMITIVE_TYPE aType)
 	{
-		if (mCurrentPSOState == ER_RHI_DX12_PSO_STATE::UNSET)
+		if (GetRecordingState().PSOState == ER_RHI_DX12_PSO_STATE::UNSET)
 			return;
 
-		assert(mCurrentPSOState == ER_RHI_DX12_PSO_STATE::GRAPHICS);
-		assert(mCurrentGraphicsPSOName == aName);
+		assert(GetRecordingState().PSOState == ER_RHI_DX12_PSO_STATE::GRAPHICS);
+		assert(GetRecordingState().GraphicsPSOName == aName);
 		mGraphicsPSONames.at(aName).SetPrimitiveTopologyType(GetTopologyType(aType));
 	}
 
@@ -1424,14 +1785,14 @@ namespace EveryRay_Core
 	void ER_RHI_DX12::SetGPUDescriptorHeap(ER_RHI_DESCRIPTOR_HEAP_TYPE aType, bool aReset)
 	{
 		assert(mDescriptorHeapManager);
-		assert(mCurrentGraphicsCommandListIndex > -1);
+		assert(GetCurrentGraphicsCommandListIndex() > -1);
 
 		ER_RHI_DX12_GPUDescriptorHeap* gpuDescriptorHeap = mDescriptorHeapManager->GetGPUHeap(GetHeapType(aType));
 		if (aReset)
 			gpuDescriptorHeap->Reset();
 
 		ID3D12DescriptorHeap* ppHeaps[] = { gpuDescriptorHeap->GetHeap() };
-		mCommandListGraphics[mCurrentGraphicsCommandListIndex]->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
+		mCommandListGraphics[GetCurrentGraphicsCommandListIndex()]->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
 	}
 
 	void ER_RHI_DX12::SetGPUDescriptorHeapImGui(int cmdListIndex)
@@ -1462,17 +1823,19 @@ namespace EveryRay_Core
 
 	void ER_RHI_DX12::InitializePSO(const std::string& aName, bool isCompute)
 	{
+		assert(GetThreadGraphicsCommandListIndex() == -1); // PSOs are not created during parallel recording (the maps are shared between the threads)
+
 		if (isCompute)
 		{
 			mComputePSONames.insert(std::make_pair(aName, ER_RHI_DX12_ComputePSO(aName)));
-			mCurrentComputePSOName = aName;
-			mCurrentPSOState = ER_RHI_DX12_PSO_STATE::COMPUTE;
+			GetRecordingState().ComputePSOName = aName;
+			GetRecordingState().PSOState = ER_RHI_DX12_PSO_STATE::COMPUTE;
 		}
 		else
 		{
 			mGraphicsPSONames.insert(std::make_pair(aName, ER_RHI_DX12_GraphicsPSO(aName)));
-			mCurrentGraphicsPSOName = aName;
-			mCurrentPSOState = ER_RHI_DX12_PSO_STATE::GRAPHICS;
+			GetRecordingState().GraphicsPSOName = aName;
+			GetRecordingState().PSOState = ER_RHI_DX12_PSO_STATE::GRAPHICS;
 			SetRasterizerState(ER_RHI_RASTERIZER_STATE::ER_BACK_CULLING); // set default RS to all gfx PSO on init
 		}
 	}
@@ -1485,12 +1848,12 @@ namespace EveryRay_Core
 
 		if (!isCompute)
 		{
-			assert(mCurrentGraphicsPSOName == aName);
+			assert(GetRecordingState().GraphicsPSOName == aName);
 			mGraphicsPSONames.at(aName).SetRootSignature(*rsDX12);
 		}
 		else
 		{
-			assert(mCurrentComputePSOName == aName);
+			assert(GetRecordingState().ComputePSOName == aName);
 			mComputePSONames.at(aName).SetRootSignature(*rsDX12);
 		}
 	}
@@ -1499,19 +1862,19 @@ namespace EveryRay_Core
 	{
 		if (!isCompute)
 		{
-			assert(mCurrentGraphicsPSOName == aName);
+			assert(GetRecordingState().GraphicsPSOName == aName);
 			mGraphicsPSONames.at(aName).Finalize(mDevice.Get());
 		}
 		else
 		{
-			assert(mCurrentComputePSOName == aName);
+			assert(GetRecordingState().ComputePSOName == aName);
 			mComputePSONames.at(aName).Finalize(mDevice.Get());
 		}
 	}
 
 	void ER_RHI_DX12::SetPSO(const std::string& aName, bool isCompute)
 	{
-		assert(mCurrentGraphicsCommandListIndex > -1);
+		assert(GetCurrentGraphicsCommandListIndex() > -1);
 		auto resetPSO = [&](const std::string& name, bool comp)
 		{
 			std::wstring msg = L"[ER Logger][ER_RHI_DX12] Could not find PSO to set, adding it now and trying to reset: " + ER_Utility::ToWideString(aName) + L'\n';
@@ -1525,17 +1888,17 @@ namespace EveryRay_Core
 			auto it = mGraphicsPSONames.find(aName);
 			if (it != mGraphicsPSONames.end())
 			{
-				if (mCurrentGraphicsPSOName == aName && mCurrentSetGraphicsPSOName == aName)
+				if (GetRecordingState().GraphicsPSOName == aName && GetRecordingState().SetGraphicsPSOName == aName)
 				{
-					mCurrentPSOState = ER_RHI_DX12_PSO_STATE::GRAPHICS;
+					GetRecordingState().PSOState = ER_RHI_DX12_PSO_STATE::GRAPHICS;
 					return;
 				}
 				else
 				{
-					mCommandListGraphics[mCurrentGraphicsCommandListIndex]->SetPipelineState(it->second.GetPipelineStateObject());
-					mCurrentGraphicsPSOName = it->first;
-					mCurrentSetGraphicsPSOName = mCurrentGraphicsPSOName;
-					mCurrentPSOState = ER_RHI_DX12_PSO_STATE::GRAPHICS;
+					mCommandListGraphics[GetCurrentGraphicsCommandListIndex()]->SetPipelineState(it->second.GetPipelineStateObject());
+					GetRecordingState().GraphicsPSOName = it->first;
+					GetRecordingState().SetGraphicsPSOName = GetRecordingState().GraphicsPSOName;
+					GetRecordingState().PSOState = ER_RHI_DX12_PSO_STATE::GRAPHICS;
 
 #if defined(_DEBUG) || defined (DEBUG)
 					mCurrentPSOSwitchesCount++;
@@ -1550,16 +1913,17 @@ namespace EveryRay_Core
 			auto it = mComputePSONames.find(aName);
 			if (it != mComputePSONames.end())
 			{
-				if (mCurrentComputePSOName == aName && mCurrentSetComputePSOName == aName)
+				std::string& currentSetPSOName = IsRecordingComputeQueue() ? mCurrentSetComputeQueuePSOName : GetRecordingState().SetComputePSOName;
+				if (GetRecordingState().ComputePSOName == aName && currentSetPSOName == aName)
 				{
-					mCurrentPSOState = ER_RHI_DX12_PSO_STATE::COMPUTE;
+					GetRecordingState().PSOState = ER_RHI_DX12_PSO_STATE::COMPUTE;
 					return;
 				}
 				{
-					mCommandListGraphics[mCurrentGraphicsCommandListIndex]->SetPipelineState(it->second.GetPipelineStateObject());
-					mCurrentComputePSOName = it->first;
-					mCurrentSetComputePSOName = mCurrentComputePSOName;
-					mCurrentPSOState = ER_RHI_DX12_PSO_STATE::COMPUTE;
+					GetCurrentCommandList(true)->SetPipelineState(it->second.GetPipelineStateObject());
+					GetRecordingState().ComputePSOName = it->first;
+					currentSetPSOName = GetRecordingState().ComputePSOName;
+					GetRecordingState().PSOState = ER_RHI_DX12_PSO_STATE::COMPUTE;
 
 #if defined(_DEBUG) || defined (DEBUG)
 					mCurrentPSOSwitchesCount++;
@@ -1573,9 +1937,10 @@ namespace EveryRay_Core
 
 	void ER_RHI_DX12::UnsetPSO()
 	{
-		mCurrentPSOState = ER_RHI_DX12_PSO_STATE::UNSET;
-		mCurrentSetGraphicsPSOName = "";
-		mCurrentSetComputePSOName = "";
+		GetRecordingState().PSOState = ER_RHI_DX12_PSO_STATE::UNSET;
+		GetRecordingState().SetGraphicsPSOName = "";
+		GetRecordingState().SetComputePSOName = "";
+		mCurrentSetComputeQueuePSOName = "";
 	}
 
 	void ER_RHI_DX12::TransitionResources(const std::vector<ER_RHI_GPUResource*>& aResources, const std::vector<ER_RHI_RESOURCE_STATE>& aStates, int cmdListIndex, bool isCopyQueue, int subresourceIndex)
@@ -1590,6 +1955,11 @@ namespace EveryRay_Core
 				aResources[i]->GetCurrentState() == ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE)
 				continue;
 
+			// compute queue's shader resource state is enough for non-pixel shaders (and the resource can still be read on the compute queue at the same time)
+			if (aStates[i] == ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE &&
+				aResources[i]->GetCurrentState() == ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_COMPUTE_SHADER_RESOURCE)
+				continue;
+
 			if (aResources[i] && aResources[i]->GetCurrentState() != aStates[i])
 			{
 				barriers.emplace_back(CD3DX12_RESOURCE_BARRIER::Transition(static_cast<ID3D12Resource*>(aResources[i]->GetResource()), GetState(aResources[i]->GetCurrentState()), GetState(aStates[i]),
@@ -1622,6 +1992,11 @@ namespace EveryRay_Core
 				aResources[i]->GetCurrentState() == ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE)
 				continue;
 
+			// compute queue's shader resource state is enough for non-pixel shaders (and the resource can still be read on the compute queue at the same time)
+			if (aState == ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE &&
+				aResources[i]->GetCurrentState() == ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_COMPUTE_SHADER_RESOURCE)
+				continue;
+
 			if (aResources[i] && aResources[i]->GetCurrentState() != aState)
 			{
 				barriers.emplace_back(CD3DX12_RESOURCE_BARRIER::Transition(static_cast<ID3D12Resource*>(aResources[i]->GetResource()), GetState(aResources[i]->GetCurrentState()), GetState(aState),
@@ -1640,6 +2015,80 @@ namespace EveryRay_Core
 		}
 	}
 
+	// Resources that the render graph has transitioned for the current pass (and that are still in that state) do not need the per-binding transitions
+	bool ER_RHI_DX12::IsInRenderGraphState(const std::vector<ER_RHI_GPUResource*>& aResources, ER_RHI_RESOURCE_STATE aState)
+	{
+		if (mRenderGraphResources.empty())
+			return false;
+
+		for (ER_RHI_GPUResource* resource : aResources)
+		{
+			if (!resource)
+				continue;
+
+			auto it = std::find(mRenderGraphResources.begin(), mRenderGraphResources.end(), resource);
+			if (it == mRenderGraphResources.end())
+				return false;
+
+			// pixel shader resource state is also satisfied by the non-pixel one (see TransitionResources())
+			const ER_RHI_RESOURCE_STATE graphState = mRenderGraphResourcesStates[it - mRenderGraphResources.begin()];
+			const bool isSameState = graphState == aState ||
+				(aState == ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE && graphState == ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+			if (!isSameState || resource->GetCurrentState() != graphState)
+				return false;
+		}
+		return true;
+	}
+
+	bool ER_RHI_DX12::IsGraphicsQueueOnlyState(ER_RHI_RESOURCE_STATE aState)
+	{
+		switch (aState)
+		{
+		case ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_INDEX_BUFFER:
+		case ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_RENDER_TARGET:
+		case ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_DEPTH_WRITE:
+		case ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_DEPTH_READ:
+		case ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE: // has the pixel shader bit, too
+		case ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE:
+		case ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_GENERIC_READ:
+		case ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_PRESENT:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	void ER_RHI_DX12::TransitionResourcesOnComputeQueue(const std::vector<ER_RHI_GPUResource*>& aResources, ER_RHI_RESOURCE_STATE aState, int subresourceIndex)
+	{
+		assert(IsRecordingComputeQueue());
+		assert(!IsGraphicsQueueOnlyState(aState));
+
+		std::vector<CD3DX12_RESOURCE_BARRIER> barriers;
+		std::vector<CD3DX12_RESOURCE_BARRIER> handoffBarriers;
+		for (auto resource : aResources)
+		{
+			if (!resource || resource->GetCurrentState() == aState)
+				continue;
+
+			CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(static_cast<ID3D12Resource*>(resource->GetResource()), GetState(resource->GetCurrentState()), GetState(aState),
+				subresourceIndex < 0 ? D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES : subresourceIndex);
+			if (IsGraphicsQueueOnlyState(resource->GetCurrentState()))
+				handoffBarriers.push_back(barrier);
+			else
+				barriers.push_back(barrier);
+			resource->SetCurrentState(aState);
+		}
+
+		if (handoffBarriers.size() > 0)
+		{
+			BeginHandoffCommandList();
+			mCommandListGraphics[mHandoffGraphicsCommandListIndex]->ResourceBarrier(static_cast<UINT>(handoffBarriers.size()), handoffBarriers.data());
+		}
+
+		if (barriers.size() > 0)
+			mCommandListCompute[mCurrentComputeCommandListIndex]->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
+	}
+
 	void ER_RHI_DX12::TransitionMainRenderTargetToPresent(int cmdListIndex)
 	{
 		CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(mMainRenderTarget[mBackBufferIndex].Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
@@ -1648,8 +2097,8 @@ namespace EveryRay_Core
 
 	void ER_RHI_DX12::UnbindRenderTargets()
 	{
-		assert(mCurrentGraphicsCommandListIndex > -1);
-		mCommandListGraphics[mCurrentGraphicsCommandListIndex]->OMSetRenderTargets(0, nullptr, false, nullptr);
+		assert(GetCurrentGraphicsCommandListIndex() > -1);
+		mCommandListGraphics[GetCurrentGraphicsCommandListIndex()]->OMSetRenderTargets(0, nullptr, false, nullptr);
 	}
 
 	void ER_RHI_DX12::UpdateBuffer(ER_RHI_GPUBuffer* aBuffer, void* aData, int dataSize, bool updateForAllBackBuffers)
@@ -1865,6 +2314,8 @@ namespace EveryRay_Core
 			return D3D12_RESOURCE_STATES::D3D12_RESOURCE_STATE_GENERIC_READ;
 		case ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_PRESENT:
 			return D3D12_RESOURCE_STATES::D3D12_RESOURCE_STATE_PRESENT;
+		case ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_COMPUTE_SHADER_RESOURCE:
+			return D3D12_RESOURCE_STATES::D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
 		default:
 			throw ER_CoreException("ER_RHI_DX12: Could not convert the resource state!");
 			return D3D12_RESOURCE_STATES::D3D12_RESOURCE_STATE_COMMON;
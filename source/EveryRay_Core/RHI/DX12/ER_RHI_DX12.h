@@ -13,6 +13,8 @@
 
 #include "imgui_impl_dx12.h"
 
+#include <atomic>
+
 #define DX12_MAX_BOUND_RENDER_TARGETS_VIEWS 8
 #define DX12_MAX_BOUND_SHADER_RESOURCE_VIEWS 64 
 #define DX12_MAX_BOUND_UNORDERED_ACCESS_VIEWS 8 
@@ -32,6 +34,22 @@ namespace EveryRay_Core
 		COMPUTE
 	};
 
+	// binding state of a graphics command list (worker threads record into their own command lists)
+	struct ER_RHI_DX12_RecordingState
+	{
+		std::string GraphicsPSOName; // which is being initialized or was set last
+		std::string ComputePSOName;
+		std::string SetGraphicsPSOName; //which was set to command list already
+		std::string SetComputePSOName; //which was set to command list already
+		ID3D12RootSignature* GraphicsRootSignature = nullptr; // to restore the state after "FlushGraphicsCommandList()"
+		ID3D12RootSignature* ComputeRootSignature = nullptr;
+		D3D12_PRIMITIVE_TOPOLOGY Topology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+		ER_RHI_DX12_PSO_STATE PSOState = ER_RHI_DX12_PSO_STATE::UNSET;
+		ER_RHI_Viewport Viewport;
+		ER_RHI_Rect Rect;
+		bool IsInstancedBufferBound = false;
+	};
+
 	class ER_RHI_DX12_GraphicsPSO;
 	class ER_RHI_DX12_ComputePSO;
 	class ER_RHI_DX12_GPURootSignature;
@@ -49,8 +67,8 @@ namespace EveryRay_Core
 		virtual void BeginGraphicsCommandList(int index = 0) override;
 		virtual void EndGraphicsCommandList(int index = 0) override;
 
-		virtual void BeginComputeCommandList(int index = 0) override {}; //TODO
-		virtual void EndComputeCommandList(int index = 0) override {}; //TODO
+		virtual void BeginComputeCommandList(int index = 0) override;
+		virtual void EndComputeCommandList(int index = 0) override;
 
 		virtual void BeginCopyCommandList(int index = 0) override;
 		virtual void EndCopyCommandList(int index = 0) override;
@@ -87,7 +105,7 @@ namespace EveryRay_Core
 		virtual void DrawIndexedInstancedIndirect(ER_RHI_GPUBuffer* anArgsBuffer, UINT alignedByteOffset) override;
 
 		virtual void Dispatch(UINT ThreadGroupCountX, UINT ThreadGroupCountY, UINT ThreadGroupCountZ) override;
-		//TODO DispatchIndirect
+		virtual void DispatchIndirect(ER_RHI_GPUBuffer* anArgsBuffer, UINT alignedByteOffset) override;
 
 		virtual void ExecuteCommandLists(int commandListIndex = 0, bool isCompute = false) override;
 		virtual void ExecuteCopyCommandList() override;
@@ -181,11 +199,27 @@ namespace EveryRay_Core
 		virtual void BeginEventTag(const std::string& aName, bool isComputeQueue = false) override;
 		virtual void EndEventTag(bool isComputeQueue = false) override;
 
+		virtual bool IsAsyncComputeSupported() override { return mCommandQueueCompute != nullptr; }
+		virtual void FlushGraphicsCommandList() override;
+		virtual void WaitForComputeOnGraphicsQueue() override;
+		virtual void WaitForGraphicsOnComputeQueue() override;
+
+		virtual bool IsParallelRecordingSupported() override { return true; }
+		virtual void BeginParallelGraphicsCommandList(int index) override;
+		virtual void EndParallelGraphicsCommandList(int index) override;
+		virtual void ExecuteParallelGraphicsCommandLists(const std::vector<int>& aIndices) override;
+
+		virtual const ER_RHI_Viewport& GetCurrentViewport() override { return GetRecordingState().Viewport; }
+		virtual const ER_RHI_Rect& GetCurrentRect() override { return GetRecordingState().Rect; }
+
 		ID3D12Device* GetDevice() const { return mDevice.Get(); }
 		ID3D12Device5* GetDeviceRaytracing() const { return (ID3D12Device5*)mDevice.Get(); }
 		ID3D12GraphicsCommandList* GetGraphicsCommandList(int index) const { return mCommandListGraphics[index].Get(); }
 		ID3D12GraphicsCommandList* GetComputeCommandList(int index) const { return mCommandListCompute[index].Get(); }
 		ER_RHI_DX12_GPUDescriptorHeapManager* GetDescriptorHeapManager() const { return mDescriptorHeapManager; }
+		std::mutex& GetUploadMutex() { return mUploadMutex; }
+
+		void DeferResourceRelease(ComPtr<ID3D12Resource>& aResource);
 
 		const D3D12_SAMPLER_DESC& FindSamplerState(ER_RHI_SAMPLER_STATE aState);
 		DXGI_FORMAT GetFormat(ER_RHI_FORMAT aFormat);
@@ -206,6 +240,23 @@ namespace EveryRay_Core
 
 		D3D12_DESCRIPTOR_HEAP_TYPE GetHeapType(ER_RHI_DESCRIPTOR_HEAP_TYPE aType);
 
+		// compute work goes to the compute queue only when the compute command list is open for an async pass of the render graph (and only from the main thread)
+		inline bool IsRecordingComputeQueue() const { return mIsRecordingAsyncComputePass && mCurrentComputeCommandListIndex > -1 && GetThreadGraphicsCommandListIndex() == -1; }
+		inline ID3D12GraphicsCommandList* GetCurrentCommandList(bool isCompute)
+		{
+			return (isCompute && IsRecordingComputeQueue()) ? mCommandListCompute[mCurrentComputeCommandListIndex].Get() : mCommandListGraphics[GetCurrentGraphicsCommandListIndex()].Get();
+		}
+		inline ER_RHI_DX12_RecordingState& GetRecordingState()
+		{
+			const int index = GetCurrentGraphicsCommandListIndex();
+			return mRecordingStates[index > -1 ? index : 0];
+		}
+		void SubmitMainGraphicsCommandList(const std::vector<int>& aParallelIndices);
+		bool IsGraphicsQueueOnlyState(ER_RHI_RESOURCE_STATE aState);
+		bool IsInRenderGraphState(const std::vector<ER_RHI_GPUResource*>& aResources, ER_RHI_RESOURCE_STATE aState);
+		void TransitionResourcesOnComputeQueue(const std::vector<ER_RHI_GPUResource*>& aResources, ER_RHI_RESOURCE_STATE aState, int subresourceIndex = -1);
+		void BeginHandoffCommandList();
+
 		DXGI_FORMAT ChangeFormatToNonSRGB(DXGI_FORMAT aFormat);
 		DXGI_FORMAT ChangeFormatToUncompressed(DXGI_FORMAT aFormat);
 		bool IsFormatSRGB(DXGI_FORMAT aFormat);
@@ -250,6 +301,23 @@ namespace EveryRay_Core
 		ComPtr<ID3D12Fence> mFenceCompute;
 		UINT64 mFenceValuesCompute;
 		Wrappers::Event mFenceEventCompute;
+		UINT64 mLastSignaledComputeFenceValue = 0;
+		UINT64 mLastWaitedComputeFenceValue = 0; // by the graphics queue
+		bool mIsComputeCommandAllocatorReset[ER_RHI_MAX_COMPUTE_COMMAND_LISTS] = {}; // allocators are reset once per frame, lists can be reset after every submission
+
+		// parallel recording
+		ER_RHI_DX12_RecordingState mRecordingStates[ER_RHI_MAX_GRAPHICS_COMMAND_LISTS];
+		bool mIsGraphicsCommandAllocatorReset[ER_RHI_MAX_GRAPHICS_COMMAND_LISTS] = {}; // for the parallel lists (same as for the compute ones)
+
+		// graphics submissions (for the compute queue to wait on)
+		ComPtr<ID3D12Fence> mFenceGraphicsSubmissions;
+		UINT64 mFenceValuesGraphicsSubmissions = 0;
+
+		// the compute queue can not transition resources from graphics-only states (render target, depth, pixel shader resource, etc.),
+		// so these barriers are recorded into a small graphics command list that is executed right before the compute one
+		const int mHandoffGraphicsCommandListIndex = ER_RHI_MAX_GRAPHICS_COMMAND_LISTS - 3;
+		bool mIsHandoffCommandListPending = false;
+		bool mIsHandoffCommandAllocatorReset = false;
 		
 		// copy
 		ComPtr<ID3D12CommandQueue> mCommandQueueCopy;
@@ -267,24 +335,20 @@ namespace EveryRay_Core
 
 		std::map<std::string, ER_RHI_DX12_GraphicsPSO> mGraphicsPSONames;
 		std::map<std::string, ER_RHI_DX12_ComputePSO> mComputePSONames;
-		std::string mCurrentGraphicsPSOName;
-		std::string mCurrentComputePSOName;
-		std::string mCurrentSetGraphicsPSOName; //which was set to command list already
-		std::string mCurrentSetComputePSOName; //which was set to command list already
-		ER_RHI_DX12_PSO_STATE mCurrentPSOState = ER_RHI_DX12_PSO_STATE::UNSET;
+		std::string mCurrentSetComputeQueuePSOName; //which was set to compute command list already
 #if defined(_DEBUG) || defined (DEBUG)
-		UINT mCurrentPSOSwitchesCount = 0; // to debug how many times we switch our PSOs per frame
+		std::atomic<UINT> mCurrentPSOSwitchesCount { 0 }; // to debug how many times we switch our PSOs per frame
 #endif
 
 		ER_RHI_DX12_GPUDescriptorHeapManager* mDescriptorHeapManager = nullptr;
 
 		ComPtr<ID3D12CommandSignature> mCommandSignature_DrawIndexed;
+		ComPtr<ID3D12CommandSignature> mCommandSignature_Dispatch;
 
 		D3D12_SAMPLER_DESC mEmptySampler;
 
 		bool mIsRaytracingTierAvailable = false;
 		bool mIsContextReadingBuffer = false;
-		bool mIsInstancedBufferBound = false;
 
 		ER_RHI_GPURootSignature* mClearUAV2DRS = nullptr;
 		ER_RHI_GPUShader* mClearUAV2DCS = nullptr;
@@ -304,6 +368,10 @@ namespace EveryRay_Core
 
 		ER_RHI_GPUTexture* mGenerateMipsWithReplacementReadyTexturesPool[DX12_MAX_GENERATE_MIPS_TEXTURES_IN_POOL] = { nullptr };
 		std::function<void(ER_RHI_GPUTexture**)> mGenerateMipsWithReplacementCallbacks[DX12_MAX_GENERATE_MIPS_TEXTURES_IN_POOL];
-		int mGenerateMipsWithReplacementCurrentTextureIndexInPool = 0; // should be atomic (in the future), at the moment we do not use multithreading for submitting mip generation commands
+		int mGenerateMipsWithReplacementCurrentTextureIndexInPool = 0; // only used on the main thread (loading threads queue the mip generation with EnqueueLoadingCommand())
+
+		std::vector<ComPtr<ID3D12Resource>> mDeferredReleaseResources[DX12_MAX_BACK_BUFFER_COUNT]; // released when the GPU is done with the frame they were retired in
+
+		std::mutex mUploadMutex; // uploads that are recorded right away (not queued by the loading threads) can still come from multiple threads
 	};
 }
\ No newline at end of file
@@ -134,7 +134,29 @@ namespace EveryRay_Core
 		}
 
 		if (aData && !mIsDynamic)
-			UpdateSubresource(aRHI, aData, mSize, aRHIDX12->GetCurrentGraphicsCommandListIndex());
+		{
+			// loading threads only fill the upload buffer: the copy is recorded on the main thread (see ER_RHI::EnqueueLoadingCommand())
+			if (ER_RHI::IsLoadingThread())
+			{
+				const int uploadIndex = ER_RHI_DX12::mBackBufferIndex;
+				void* uploadData = nullptr;
+				CD3DX12_RANGE readRange(0, 0);
+				if (FAILED(mBufferUpload[uploadIndex]->Map(0, &readRange, &uploadData)))
+					throw ER_CoreException("ER_RHI_DX12: Failed to map GPU buffer (upload).");
+				memcpy(uploadData, aData, mSize);
+				mBufferUpload[uploadIndex]->Unmap(0, nullptr);
+
+				aRHIDX12->EnqueueLoadingCommand([this, aRHIDX12, uploadIndex]()
+				{
+					const int cmdListIndex = aRHIDX12->GetCurrentGraphicsCommandListIndex();
+					aRHIDX12->TransitionResources({ static_cast<ER_RHI_GPUResource*>(this) }, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_COPY_DEST, cmdListIndex);
+					aRHIDX12->GetGraphicsCommandList(cmdListIndex)->CopyBufferRegion(mBuffer.Get(), 0, mBufferUpload[uploadIndex].Get(), 0, mSize);
+					TransitionToReadState(aRHIDX12, cmdListIndex);
+				});
+			}
+			else
+				UpdateSubresource(aRHI, aData, mSize, aRHIDX12->GetCurrentGraphicsCommandListIndex());
+		}
 
 		if (bindFlags & ER_BIND_VERTEX_BUFFER)
 		{
@@ -218,9 +240,14 @@ namespace EveryRay_Core
 		data.RowPitch = dataSize;
 		data.SlicePitch = dataSize;
 
+		std::lock_guard<std::mutex> lock(aRHIDX12->GetUploadMutex());
 		aRHIDX12->TransitionResources({ static_cast<ER_RHI_GPUResource*>(this) }, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_COPY_DEST, cmdListIndex);
 		UpdateSubresources(aRHIDX12->GetGraphicsCommandList(cmdListIndex), mBuffer.Get(), mBufferUpload[ER_RHI_DX12::mBackBufferIndex].Get(), 0, 0, 1, &data);
+		TransitionToReadState(aRHIDX12, cmdListIndex);
+	}
 
+	void ER_RHI_DX12_GPUBuffer::TransitionToReadState(ER_RHI_DX12* aRHIDX12, int cmdListIndex)
+	{
 		if (mBindFlags & ER_BIND_CONSTANT_BUFFER || mBindFlags & ER_BIND_VERTEX_BUFFER)
 			aRHIDX12->TransitionResources({ static_cast<ER_RHI_GPUResource*>(this) }, ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER, cmdListIndex);
 		else if (mBindFlags & ER_BIND_INDEX_BUFFER)
@@ -37,6 +37,7 @@ namespace EveryRay_Core
 		DXGI_FORMAT GetFormat() { return mFormat; }
 	private:
 		void UpdateSubresource(ER_RHI* aRHI, void* aData, int aSize, int cmdListIndex);
+		void TransitionToReadState(ER_RHI_DX12* aRHIDX12, int cmdListIndex);
 		ComPtr<ID3D12Resource> mBuffer;
 		ComPtr<ID3D12Resource> mBufferUpload[DX12_MAX_BACK_BUFFER_COUNT];
 
@@ -43,6 +43,8 @@ namespace EveryRay_Core
 
 	ER_RHI_DX12_DescriptorHandle ER_RHI_DX12_CPUDescriptorHeap::GetNewHandle()
 	{
+		std::lock_guard<std::mutex> lock(mMutex);
+
 		UINT newHandleID = 0;
 
 		if (mCurrentDescriptorIndex < mMaxNumDescriptors)
@@ -70,6 +72,8 @@ namespace EveryRay_Core
 
 	void ER_RHI_DX12_CPUDescriptorHeap::FreeHandle(ER_RHI_DX12_DescriptorHandle& handle)
 	{
+		std::lock_guard<std::mutex> lock(mMutex);
+
 		mFreeDescriptors.push_back(handle.GetHeapIndex());
 
 		if (mActiveHandleCount == 0)
@@ -86,15 +90,8 @@ namespace EveryRay_Core
 
 	ER_RHI_DX12_DescriptorHandle ER_RHI_DX12_GPUDescriptorHeap::GetHandleBlock(UINT count)
 	{
-		UINT newHandleID = 0;
-		UINT blockEnd = mCurrentDescriptorIndex + count;
-
-		if (blockEnd < mMaxNumDescriptors)
-		{
-			newHandleID = mCurrentDescriptorIndex;
-			mCurrentDescriptorIndex = blockEnd;
-		}
-		else
+		const UINT newHandleID = mCurrentDescriptorIndex.fetch_add(count);
+		if (newHandleID + count >= mMaxNumDescriptors)
 			throw ER_CoreException("ER_RHI_DX12: Ran out of GPU descriptor heap handles, need to increase heap size");
 
 		ER_RHI_DX12_DescriptorHandle newHandle;
@@ -2,6 +2,8 @@
 
 #include "ER_RHI_DX12.h"
 
+#include <atomic>
+
 namespace EveryRay_Core
 {
 	class ER_RHI_DX12_DescriptorHandle
@@ -79,6 +81,7 @@ namespace EveryRay_Core
 		std::vector<UINT> mFreeDescriptors;
 		UINT mCurrentDescriptorIndex;
 		UINT mActiveHandleCount;
+		std::mutex mMutex; // resources can be created from multiple threads (i.e., loading)
 	};
 
 	class ER_RHI_DX12_GPUDescriptorHeap : public ER_RHI_DX12_DescriptorHeap
@@ -91,7 +94,7 @@ namespace EveryRay_Core
 		ER_RHI_DX12_DescriptorHandle GetHandleBlock(UINT count);
 
 	private:
-		UINT mCurrentDescriptorIndex;
+		std::atomic<UINT> mCurrentDescriptorIndex; // blocks are suballocated from multiple threads (parallel command lists recording)
 	};
 
 	class ER_RHI_DX12_GPUDescriptorHeapManager
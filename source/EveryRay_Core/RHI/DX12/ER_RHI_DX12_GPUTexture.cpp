@@ -301,11 +301,11 @@ namespace EveryRay_Core
 			mResourceUpload->SetName(uploadname.c_str());
 		}
 	}
-	void ER_RHI_DX12_GPUTexture::CreateGPUTextureResource(ER_RHI* aRHI, const std::string& aPath, bool isFullPath /*= false*/, bool is3D, bool skipFallback, bool* statusFlag, bool isSilent)
+	void ER_RHI_DX12_GPUTexture::CreateGPUTextureResource(ER_RHI* aRHI, const std::string& aPath, bool isFullPath /*= false*/, bool is3D, bool skipFallback, bool* statusFlag, bool isSilent, UINT maxSize)
 	{
-		CreateGPUTextureResource(aRHI, EveryRay_Core::ER_Utility::ToWideString(aPath), isFullPath, is3D, skipFallback, statusFlag, isSilent);
+		CreateGPUTextureResource(aRHI, EveryRay_Core::ER_Utility::ToWideString(aPath), isFullPath, is3D, skipFallback, statusFlag, isSilent, maxSize);
 	}
-	void ER_RHI_DX12_GPUTexture::CreateGPUTextureResource(ER_RHI* aRHI, const std::wstring& aPath, bool isFullPath /*= false*/, bool is3D, bool skipFallback, bool* statusFlag, bool isSilent)
+	void ER_RHI_DX12_GPUTexture::CreateGPUTextureResource(ER_RHI* aRHI, const std::wstring& aPath, bool isFullPath /*= false*/, bool is3D, bool skipFallback, bool* statusFlag, bool isSilent, UINT maxSize)
 	{
 		assert(aRHI);
 		ER_RHI_DX12* aRHIDX12 = static_cast<ER_RHI_DX12*>(aRHI);
@@ -334,7 +334,7 @@ namespace EveryRay_Core
 			std::unique_ptr<uint8_t[]> ddsData;
 			std::vector<D3D12_SUBRESOURCE_DATA> subresources;
 			bool isCubemap = false;
-			if (FAILED(DirectX::LoadDDSTextureFromFile(device, isFullPath ? aPath.c_str() : EveryRay_Core::ER_Utility::GetFilePath(aPath).c_str(), &mResource, ddsData, subresources, 0, nullptr, &isCubemap)))
+			if (FAILED(DirectX::LoadDDSTextureFromFile(device, isFullPath ? aPath.c_str() : EveryRay_Core::ER_Utility::GetFilePath(aPath).c_str(), &mResource, ddsData, subresources, maxSize, nullptr, &isCubemap)))
 			{
 				outputLog(isFullPath ? aPath.c_str() : EveryRay_Core::ER_Utility::GetFilePath(aPath).c_str());
 				if (!skipFallback)
@@ -343,57 +343,7 @@ namespace EveryRay_Core
 				return;
 			}
 
-			// Create the GPU upload buffer and update subresources
-			const UINT64 uploadBufferSize = GetRequiredIntermediateSize(mResource.Get(), 0, static_cast<UINT>(subresources.size()));
-			if (FAILED(device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE, &CD3DX12_RESOURCE_DESC::Buffer(uploadBufferSize), D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&mResourceUpload))))
-				throw ER_CoreException("ER_RHI_DX12: Could not create a committed resource for the GPU texture resource (upload)");
-
-			{
-				int cmdIndex = aRHIDX12->GetCurrentGraphicsCommandListIndex();
-				auto commandList = aRHIDX12->GetGraphicsCommandList(cmdIndex);
-				UpdateSubresources(commandList, mResource.Get(), mResourceUpload.Get(), 0, 0, static_cast<UINT>(subresources.size()), subresources.data());
-
-				auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(mResource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-				commandList->ResourceBarrier(1, &barrier);
-
-				mCurrentResourceState = ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
-			}
-
-			mSRVHandle = descriptorHeapManager->CreateCPUHandle(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-			D3D12_RESOURCE_DESC desc = mResource->GetDesc();
-			D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-			srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-			srvDesc.Format = desc.Format;
-			if (isCubemap)
-			{
-				srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBE;
-				srvDesc.TextureCube.MipLevels = desc.MipLevels;
-			}
-			else if (desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE2D)
-			{
-				if (desc.DepthOrArraySize > 1)
-				{
-					srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
-					srvDesc.Texture2DArray.MipLevels = desc.MipLevels;
-					srvDesc.Texture2DArray.ArraySize = desc.DepthOrArraySize;
-				}
-				else
-				{
-					srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-					srvDesc.Texture2D.MipLevels = desc.MipLevels;
-				}
-			}
-			else if (desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D)
-			{
-				srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE3D;
-				srvDesc.Texture3D.MipLevels = desc.MipLevels;
-			}
-			device->CreateShaderResourceView(mResource.Get(), &srvDesc, mSRVHandle.GetCPUHandle());
-			
-			mMipLevels = desc.MipLevels;
-			mFormat = desc.Format;
-			mWidth = static_cast<UINT>(desc.Width);
-			mHeight = static_cast<UINT>(desc.Height);
+			UploadLoadedSubresources(aRHIDX12, subresources, isCubemap);
 
 			if (statusFlag)
 				*statusFlag = true;
@@ -401,9 +351,9 @@ namespace EveryRay_Core
 		else
 		{
 			std::unique_ptr<uint8_t[]> decodedData;
-			D3D12_SUBRESOURCE_DATA subresource;
+			std::vector<D3D12_SUBRESOURCE_DATA> subresources(1);
 
-			if (FAILED(DirectX::LoadWICTextureFromFile(device, isFullPath ? aPath.c_str() : EveryRay_Core::ER_Utility::GetFilePath(aPath).c_str(), &mResource, decodedData, subresource)))
+			if (FAILED(DirectX::LoadWICTextureFromFile(device, isFullPath ? aPath.c_str() : EveryRay_Core::ER_Utility::GetFilePath(aPath).c_str(), &mResource, decodedData, subresources[0], maxSize)))
 			{
 				outputLog(isFullPath ? aPath.c_str() : EveryRay_Core::ER_Utility::GetFilePath(aPath).c_str());
 				if (!skipFallback)
@@ -411,35 +361,8 @@ namespace EveryRay_Core
 
 				return;
 			}
-			// Create the GPU upload buffer and update subresources
-			const UINT64 uploadBufferSize = GetRequiredIntermediateSize(mResource.Get(), 0, 1);
-			if (FAILED(device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE, &CD3DX12_RESOURCE_DESC::Buffer(uploadBufferSize), D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&mResourceUpload))))
-				throw ER_CoreException("ER_RHI_DX12: Could not create a committed resource for the GPU texture resource (upload)");
 
-			{
-				int cmdIndex = aRHIDX12->GetCurrentGraphicsCommandListIndex();
-				auto commandList = aRHIDX12->GetGraphicsCommandList(cmdIndex);
-				UpdateSubresources(commandList, mResource.Get(), mResourceUpload.Get(), 0, 0, 1, &subresource);
-
-				auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(mResource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-				commandList->ResourceBarrier(1, &barrier);
-
-				mCurrentResourceState = ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
-			}
-
-			mSRVHandle = descriptorHeapManager->CreateCPUHandle(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-			D3D12_RESOURCE_DESC desc = mResource->GetDesc();
-			D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-			srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-			srvDesc.Format = desc.Format;
-			srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-			srvDesc.Texture2D.MipLevels = 1;
-			device->CreateShaderResourceView(mResource.Get(), &srvDesc, mSRVHandle.GetCPUHandle());
-			
-			mMipLevels = desc.MipLevels;
-			mFormat = desc.Format;
-			mWidth = static_cast<UINT>(desc.Width);
-			mHeight = static_cast<UINT>(desc.Height);
+			UploadLoadedSubresources(aRHIDX12, subresources, false);
 
 			if (statusFlag)
 				*statusFlag = true;
@@ -452,6 +375,152 @@ namespace EveryRay_Core
 		}
 	}
 
+	bool ER_RHI_DX12_GPUTexture::StreamGPUTextureResource(ER_RHI* aRHI, const std::vector<char>& aFileData, UINT maxSize)
+	{
+		assert(aRHI);
+		ER_RHI_DX12* aRHIDX12 = static_cast<ER_RHI_DX12*>(aRHI);
+		ID3D12Device* device = aRHIDX12->GetDevice();
+		assert(device);
+
+		assert(mIsLoadedFromFile);
+		if (aFileData.size() < sizeof(uint32_t) || !mResource)
+			return false;
+
+		const uint8_t* data = reinterpret_cast<const uint8_t*>(aFileData.data());
+		const bool isDDS = *reinterpret_cast<const uint32_t*>(data) == 0x20534444; // "DDS "
+
+		ComPtr<ID3D12Resource> newResource;
+		std::unique_ptr<uint8_t[]> decodedData;
+		std::vector<D3D12_SUBRESOURCE_DATA> subresources;
+		bool isCubemap = false;
+		HRESULT hr;
+		if (isDDS)
+			hr = DirectX::LoadDDSTextureFromMemory(device, data, aFileData.size(), &newResource, subresources, maxSize, nullptr, &isCubemap);
+		else
+		{
+			subresources.resize(1);
+			hr = DirectX::LoadWICTextureFromMemory(device, data, aFileData.size(), &newResource, decodedData, subresources[0], maxSize);
+		}
+
+		if (FAILED(hr))
+		{
+			std::wstring msg = L"[ER Logger][ER_RHI_DX12_GPUTexture] Failed to stream texture: " + mDebugName + L". Keeping the resident mips. \n";
+			ER_OUTPUT_LOG(msg.c_str());
+			return false;
+		}
+
+		// frames in flight might still sample the old resource, so it is released later by the RHI
+		aRHIDX12->DeferResourceRelease(mResource);
+		aRHIDX12->DeferResourceRelease(mResourceUpload);
+		mResource = newResource;
+		mCurrentResourceState = ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_COPY_DEST;
+
+		UploadLoadedSubresources(aRHIDX12, subresources, isCubemap);
+
+		if (!mDebugName.empty())
+			mResource->SetName(mDebugName.c_str());
+
+		return true;
+	}
+
+	// Fills the upload buffer with the subresources and records the copy into the current graphics command list.
+	// Loading threads only fill the upload buffer: the copy is recorded on the main thread (see ER_RHI::EnqueueLoadingCommand()), so the data does not need to outlive this call.
+	void ER_RHI_DX12_GPUTexture::UploadSubresourcesData(ER_RHI_DX12* aRHIDX12, const std::vector<D3D12_SUBRESOURCE_DATA>& subresources)
+	{
+		ID3D12Device* device = aRHIDX12->GetDevice();
+		assert(device);
+
+		const UINT subresourcesCount = static_cast<UINT>(subresources.size());
+		const UINT64 uploadBufferSize = GetRequiredIntermediateSize(mResource.Get(), 0, subresourcesCount);
+		if (FAILED(device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE, &CD3DX12_RESOURCE_DESC::Buffer(uploadBufferSize), D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&mResourceUpload))))
+			throw ER_CoreException("ER_RHI_DX12: Could not create a committed resource for the GPU texture resource (upload)");
+
+		std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts(subresourcesCount);
+		std::vector<UINT> rowsCounts(subresourcesCount);
+		std::vector<UINT64> rowsSizes(subresourcesCount);
+		D3D12_RESOURCE_DESC desc = mResource->GetDesc();
+		device->GetCopyableFootprints(&desc, 0, subresourcesCount, 0, layouts.data(), rowsCounts.data(), rowsSizes.data(), nullptr);
+
+		BYTE* uploadData = nullptr;
+		if (FAILED(mResourceUpload->Map(0, nullptr, reinterpret_cast<void**>(&uploadData))))
+			throw ER_CoreException("ER_RHI_DX12: Could not map the upload resource of the GPU texture");
+		for (UINT i = 0; i < subresourcesCount; i++)
+		{
+			D3D12_MEMCPY_DEST destData = { uploadData + layouts[i].Offset, layouts[i].Footprint.RowPitch, SIZE_T(layouts[i].Footprint.RowPitch) * SIZE_T(rowsCounts[i]) };
+			MemcpySubresource(&destData, &subresources[i], static_cast<SIZE_T>(rowsSizes[i]), rowsCounts[i], layouts[i].Footprint.Depth);
+		}
+		mResourceUpload->Unmap(0, nullptr);
+
+		// resources are captured (not read from the members later): streaming can replace them before the command is recorded
+		mCurrentResourceState = ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+		ComPtr<ID3D12Resource> resource = mResource;
+		ComPtr<ID3D12Resource> resourceUpload = mResourceUpload;
+		aRHIDX12->EnqueueLoadingCommand([aRHIDX12, resource, resourceUpload, layouts]()
+		{
+			std::lock_guard<std::mutex> lock(aRHIDX12->GetUploadMutex());
+			auto commandList = aRHIDX12->GetGraphicsCommandList(aRHIDX12->GetCurrentGraphicsCommandListIndex());
+			for (UINT i = 0; i < static_cast<UINT>(layouts.size()); i++)
+			{
+				CD3DX12_TEXTURE_COPY_LOCATION dst(resource.Get(), i);
+				CD3DX12_TEXTURE_COPY_LOCATION src(resourceUpload.Get(), layouts[i]);
+				commandList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+			}
+
+			auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+			commandList->ResourceBarrier(1, &barrier);
+		});
+	}
+
+	// Uploads the loaded subresources and writes the SRV.
+	// The SRV handle is created only once: DX12 copies CPU descriptors into the shader-visible heap on binding, so re-writing it is enough for all users.
+	void ER_RHI_DX12_GPUTexture::UploadLoadedSubresources(ER_RHI_DX12* aRHIDX12, std::vector<D3D12_SUBRESOURCE_DATA>& subresources, bool isCubemap)
+	{
+		ID3D12Device* device = aRHIDX12->GetDevice();
+		assert(device);
+
+		ER_RHI_DX12_GPUDescriptorHeapManager* descriptorHeapManager = aRHIDX12->GetDescriptorHeapManager();
+		assert(descriptorHeapManager);
+
+		UploadSubresourcesData(aRHIDX12, subresources);
+
+		if (!mSRVHandle.IsValid())
+			mSRVHandle = descriptorHeapManager->CreateCPUHandle(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+		D3D12_RESOURCE_DESC desc = mResource->GetDesc();
+		D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+		srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+		srvDesc.Format = desc.Format;
+		if (isCubemap)
+		{
+			srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBE;
+			srvDesc.TextureCube.MipLevels = desc.MipLevels;
+		}
+		else if (desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE2D)
+		{
+			if (desc.DepthOrArraySize > 1)
+			{
+				srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
+				srvDesc.Texture2DArray.MipLevels = desc.MipLevels;
+				srvDesc.Texture2DArray.ArraySize = desc.DepthOrArraySize;
+			}
+			else
+			{
+				srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+				srvDesc.Texture2D.MipLevels = desc.MipLevels;
+			}
+		}
+		else if (desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D)
+		{
+			srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE3D;
+			srvDesc.Texture3D.MipLevels = desc.MipLevels;
+		}
+		device->CreateShaderResourceView(mResource.Get(), &srvDesc, mSRVHandle.GetCPUHandle());
+
+		mMipLevels = desc.MipLevels;
+		mFormat = desc.Format;
+		mWidth = static_cast<UINT>(desc.Width);
+		mHeight = static_cast<UINT>(desc.Height);
+	}
+
 	void ER_RHI_DX12_GPUTexture::CreateSimpleGPUTexture2DResource(ER_RHI* aRHI, UINT width, UINT height, DXGI_FORMAT format, ER_RHI_BIND_FLAG bindFlags /*= ER_BIND_NONE*/, int mip)
 	{
 		assert(aRHI);
@@ -593,21 +662,7 @@ namespace EveryRay_Core
 		D3D12_SUBRESOURCE_DATA subresource;
 		DirectX::LoadWICTextureFromFile(device, EveryRay_Core::ER_Utility::GetFilePath(L"content\\textures\\uvChecker.jpg").c_str(), &mResource, decodedData, subresource);
 
-		// Create the GPU upload buffer and update subresources
-		const UINT64 uploadBufferSize = GetRequiredIntermediateSize(mResource.Get(), 0, 1);
-		if (FAILED(device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE, &CD3DX12_RESOURCE_DESC::Buffer(uploadBufferSize), D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&mResourceUpload))))
-			throw ER_CoreException("ER_RHI_DX12: Could not create a committed resource for the GPU texture resource (upload)");
-
-		{
-			int cmdIndex = aRHIDX12->GetCurrentGraphicsCommandListIndex();
-			auto commandList = aRHIDX12->GetGraphicsCommandList(cmdIndex);
-			UpdateSubresources(commandList, mResource.Get(), mResourceUpload.Get(), 0, 0, 1, &subresource);
-
-			auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(mResource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-			commandList->ResourceBarrier(1, &barrier);
-
-			mCurrentResourceState = ER_RHI_RESOURCE_STATE::ER_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
-		}
+		UploadSubresourcesData(aRHIDX12, { subresource });
 
 		mSRVHandle = descriptorHeapManager->CreateCPUHandle(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 		D3D12_RESOURCE_DESC desc = mResource->GetDesc();
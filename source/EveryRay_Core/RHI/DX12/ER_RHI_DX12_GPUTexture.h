@@ -12,8 +12,9 @@ namespace EveryRay_Core
 
 		virtual void CreateGPUTextureResource(ER_RHI* aRHI, UINT width, UINT height, UINT samples, ER_RHI_FORMAT format, ER_RHI_BIND_FLAG bindFlags = ER_BIND_NONE,
 			int mip = 1, int depth = -1, int arraySize = 1, bool isCubemap = false, int cubemapArraySize = -1) override;
-		virtual void CreateGPUTextureResource(ER_RHI* aRHI, const std::string& aPath, bool isFullPath = false, bool is3D = false, bool skipFallback = false, bool* statusFlag = nullptr, bool isSilent = false) override;
-		virtual void CreateGPUTextureResource(ER_RHI* aRHI, const std::wstring& aPath, bool isFullPath = false, bool is3D = false, bool skipFallback = false, bool* statusFlag = nullptr, bool isSilent = false) override;
+		virtual void CreateGPUTextureResource(ER_RHI* aRHI, const std::string& aPath, bool isFullPath = false, bool is3D = false, bool skipFallback = false, bool* statusFlag = nullptr, bool isSilent = false, UINT maxSize = 0) override;
+		virtual void CreateGPUTextureResource(ER_RHI* aRHI, const std::wstring& aPath, bool isFullPath = false, bool is3D = false, bool skipFallback = false, bool* statusFlag = nullptr, bool isSilent = false, UINT maxSize = 0) override;
+		virtual bool StreamGPUTextureResource(ER_RHI* aRHI, const std::vector<char>& aFileData, UINT maxSize) override;
 		void CreateSimpleGPUTexture2DResource(ER_RHI* aRHI, UINT width, UINT height, DXGI_FORMAT format, ER_RHI_BIND_FLAG bindFlags = ER_BIND_NONE, int mip = 1);
 
 		virtual void* GetRTV(void* aEmpty = nullptr) override { return nullptr; /* Not needed on DX12 */ }
@@ -46,6 +47,8 @@ namespace EveryRay_Core
 		int GetBackBufferIndex() { return mBackBufferIndex; }
 	private:
 		void LoadFallbackTexture(ER_RHI* aRHI);
+		void UploadLoadedSubresources(ER_RHI_DX12* aRHIDX12, std::vector<D3D12_SUBRESOURCE_DATA>& subresources, bool isCubemap);
+		void UploadSubresourcesData(ER_RHI_DX12* aRHIDX12, const std::vector<D3D12_SUBRESOURCE_DATA>& subresources);
 
 		ER_RHI_DX12_DescriptorHandle mSRVHandle;
 		ER_RHI_DX12_DescriptorHandle mDSVHandle;
@@ -2,6 +2,7 @@
 #include "..\Common.h"
 
 #define ER_RHI_MAX_GRAPHICS_COMMAND_LISTS 8
+#define ER_RHI_MAX_PARALLEL_GRAPHICS_COMMAND_LISTS 4 // recorded on worker threads: indices [1, ER_RHI_MAX_PARALLEL_GRAPHICS_COMMAND_LISTS] (0 is the main one, the last ones are reserved)
 #define ER_RHI_MAX_COMPUTE_COMMAND_LISTS 2
 #define ER_RHI_MAX_BOUND_VERTEX_BUFFERS 2 //we only support 1 vertex buffer + 1 instance buffer
 
@@ -99,7 +100,8 @@ namespace EveryRay_Core
 		ER_RESOURCE_STATE_COPY_SOURCE,
 		ER_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE,
 		ER_RESOURCE_STATE_GENERIC_READ,
-		ER_RESOURCE_STATE_PRESENT
+		ER_RESOURCE_STATE_PRESENT,
+		ER_RESOURCE_STATE_COMPUTE_SHADER_RESOURCE // non-pixel shader resource that is also legal on the compute queue (DX12 only)
 	};
 
 	enum ER_RHI_FORMAT
@@ -311,7 +313,8 @@ namespace EveryRay_Core
 		virtual void DrawIndexedInstancedIndirect(ER_RHI_GPUBuffer* anArgsBuffer, UINT alignedByteOffset) = 0;
 
 		virtual void Dispatch(UINT ThreadGroupCountX, UINT ThreadGroupCountY, UINT ThreadGroupCountZ) = 0;
-		//TODO DispatchIndirect
+		// thread group counts are read from the buffer on the GPU (3 UINTs at the offset, buffer has to be created with ER_RESOURCE_MISC_DRAWINDIRECT_ARGS)
+		virtual void DispatchIndirect(ER_RHI_GPUBuffer* anArgsBuffer, UINT alignedByteOffset) = 0;
 
 		virtual void GenerateMips(ER_RHI_GPUTexture* aTexture, ER_RHI_GPUTexture* aSRGBTexture = nullptr) = 0;
 		virtual void GenerateMipsWithTextureReplacement(ER_RHI_GPUTexture** aTexture, std::function<void(ER_RHI_GPUTexture**)> aReplacementCallback) = 0;
@@ -410,8 +413,67 @@ namespace EveryRay_Core
 		virtual void BeginEventTag(const std::string& aName, bool isComputeQueue = false) = 0;
 		virtual void EndEventTag(bool isComputeQueue = false) = 0;
 
+		// Async compute: while a compute command list is open ("BeginComputeCommandList()") and an async pass is recorded ("SetIsRecordingAsyncComputePass()"), all compute work
+		// (compute root signatures/PSOs/resources, dispatches, mips generation, UAV clears) is recorded into it instead of the graphics command list; event tags go there only with "isComputeQueue".
+		// Queues are synchronized on the GPU with the methods below (no CPU waits).
+		virtual bool IsAsyncComputeSupported() = 0;
+		virtual void FlushGraphicsCommandList() = 0; // submits the graphics work recorded so far and continues recording into the same command list
+		virtual void WaitForComputeOnGraphicsQueue() = 0; // next graphics submissions will start after the last compute submission
+		virtual void WaitForGraphicsOnComputeQueue() = 0; // next compute submissions will start after the last graphics submission
+
+		// Parallel recording: worker threads record graphics work into their own command lists (binding state is tracked per command list).
+		// "Begin/EndParallelGraphicsCommandList()" are called on the worker thread, "ExecuteParallelGraphicsCommandLists()" - on the main thread after the workers are joined:
+		// the work recorded into the main command list so far is submitted first, then the parallel lists in the given order.
+		// PSOs have to be ready (initialized on the main thread) before recording in parallel; resources that need transitions should not be shared between the workers.
+		virtual bool IsParallelRecordingSupported() = 0;
+		virtual void BeginParallelGraphicsCommandList(int index) = 0;
+		virtual void EndParallelGraphicsCommandList(int index) = 0;
+		virtual void ExecuteParallelGraphicsCommandLists(const std::vector<int>& aIndices) = 0;
+
+		// Loading threads (scene loading jobs, streamed cells) only create resources and fill them with data: the work that has to be recorded into the main context/command list
+		// (i.e., copies from the upload resources, mips generation) is queued from them with "EnqueueLoadingCommand()" and recorded by "ExecuteLoadingCommands()" on the main thread after they have finished.
+		// On other threads the command is recorded right away.
+		void EnqueueLoadingCommand(const std::function<void()>& aCommand)
+		{
+			if (!IsLoadingThread())
+			{
+				aCommand();
+				return;
+			}
+
+			const std::lock_guard<std::mutex> lock(mLoadingCommandsMutex);
+			mLoadingCommands.push_back(aCommand);
+		}
+		void ExecuteLoadingCommands()
+		{
+			assert(!IsLoadingThread());
+
+			std::vector<std::function<void()>> commands;
+			{
+				const std::lock_guard<std::mutex> lock(mLoadingCommandsMutex);
+				commands.swap(mLoadingCommands);
+			}
+			for (auto& command : commands)
+				command();
+		}
+		static void SetIsLoadingThread(bool aIsLoading) { GetThreadIsLoading() = aIsLoading; }
+		static bool IsLoadingThread() { return GetThreadIsLoading(); }
+
+		// Render graph: set around the passes that it has marked as async compute (graphics passes are never recorded into the compute command list, even if it is open)
+		void SetIsRecordingAsyncComputePass(bool aIsAsync) { mIsRecordingAsyncComputePass = aIsAsync; }
+		bool IsRecordingAsyncComputePass() const { return mIsRecordingAsyncComputePass; }
+
+		// Render graph: resources (and their states) that the graph has transitioned for the graphics pass it is executing, empty outside of the passes (see ER_RenderGraph::Execute()).
+		// Binding them in that state skips the automatic per-binding transitions (unless something has transitioned them to another state within the pass).
+		void SetRenderGraphResources(const std::vector<ER_RHI_GPUResource*>& aResources, const std::vector<ER_RHI_RESOURCE_STATE>& aStates)
+		{
+			assert(aResources.size() == aStates.size());
+			mRenderGraphResources = aResources;
+			mRenderGraphResourcesStates = aStates;
+		}
+
 		inline const int GetPrepareGraphicsCommandListIndex() { return mPrepareGraphicsCommandListIndex; }
-		inline const int GetCurrentGraphicsCommandListIndex() { return mCurrentGraphicsCommandListIndex; }
+		inline const int GetCurrentGraphicsCommandListIndex() { return GetThreadGraphicsCommandListIndex() > -1 ? GetThreadGraphicsCommandListIndex() : mCurrentGraphicsCommandListIndex; }
 		inline const int GetCurrentComputeCommandListIndex() { return mCurrentComputeCommandListIndex; }
 
 		ER_GRAPHICS_API GetAPI() { return mAPI; }
@@ -431,6 +493,16 @@ namespace EveryRay_Core
 		const int mPrepareGraphicsCommandListIndex = ER_RHI_MAX_GRAPHICS_COMMAND_LISTS - 1; // command list for prepare commands (on init)
 		int mCurrentGraphicsCommandListIndex = -1;
 		int mCurrentComputeCommandListIndex = -1;
+
+		static int& GetThreadGraphicsCommandListIndex() { static thread_local int index = -1; return index; } // parallel command list of the calling worker thread (if any)
+		static bool& GetThreadIsLoading() { static thread_local bool isLoading = false; return isLoading; }
+
+		std::vector<std::function<void()>> mLoadingCommands;
+		std::mutex mLoadingCommandsMutex;
+
+		bool mIsRecordingAsyncComputePass = false;
+		std::vector<ER_RHI_GPUResource*> mRenderGraphResources;
+		std::vector<ER_RHI_RESOURCE_STATE> mRenderGraphResourcesStates;
 	};
 
 	class ER_RHI_GPURootSignature
@@ -476,8 +548,11 @@ namespace EveryRay_Core
 
 		virtual void CreateGPUTextureResource(ER_RHI* aRHI, UINT width, UINT height, UINT samples, ER_RHI_FORMAT format, ER_RHI_BIND_FLAG bindFlags = ER_BIND_NONE,
 			int mip = 1, int depth = -1, int arraySize = 1, bool isCubemap = false, int cubemapArraySize = -1) { AbstractRHIMethodAssert();	}
-		virtual void CreateGPUTextureResource(ER_RHI* aRHI, const std::string& aPath, bool isFullPath = false, bool is3D = false, bool skipFallback = false, bool* statusFlag = nullptr, bool isSilent = false) { AbstractRHIMethodAssert(); }
-		virtual void CreateGPUTextureResource(ER_RHI* aRHI, const std::wstring& aPath, bool isFullPath = false, bool is3D = false, bool skipFallback = false, bool* statusFlag = nullptr, bool isSilent = false) { AbstractRHIMethodAssert(); }
+		virtual void CreateGPUTextureResource(ER_RHI* aRHI, const std::string& aPath, bool isFullPath = false, bool is3D = false, bool skipFallback = false, bool* statusFlag = nullptr, bool isSilent = false, UINT maxSize = 0) { AbstractRHIMethodAssert(); }
+		virtual void CreateGPUTextureResource(ER_RHI* aRHI, const std::wstring& aPath, bool isFullPath = false, bool is3D = false, bool skipFallback = false, bool* statusFlag = nullptr, bool isSilent = false, UINT maxSize = 0) { AbstractRHIMethodAssert(); }
+		// Re-creates a texture that was loaded from disk with a different amount of resident top mips ("maxSize" is the max dimension of the new top mip, 0 - all mips).
+		// "aFileData" is the whole file in memory (read in the background). The object (and its views) stays the same for all users of the texture.
+		virtual bool StreamGPUTextureResource(ER_RHI* aRHI, const std::vector<char>& aFileData, UINT maxSize) { AbstractRHIMethodAssert(); return false; }
 
 		virtual void* GetRTV(void* aEmpty = nullptr) { AbstractRHIMethodAssert(); return nullptr; }
 		virtual void* GetRTV(int index) { AbstractRHIMethodAssert(); return nullptr; }
@@ -2,6 +2,8 @@
 
 #include "..\EveryRay_Core\ER_RuntimeCore.h"
 #include "..\EveryRay_Core\ER_CoreException.h"
+#include "..\EveryRay_Core\ER_TextureCooker.h"
+#include "..\EveryRay_Core\ER_Utility.h"
 #include "..\EveryRay_Core\RHI\ER_RHI.h"
 #include "..\EveryRay_Core\RHI\DX12\ER_RHI_DX12.h"
 
@@ -18,6 +20,20 @@ int WINAPI WinMain(HINSTANCE instance, HINSTANCE previousInstance, LPSTR command
 	if (FAILED(CoInitializeEx(nullptr, COINIT_MULTITHREADED)))
 		throw ER_CoreException("Failed to call CoInitializeEx");
 
+	// offline texture cooking step: generates mip chains (and optionally block compression) for the content and exits
+	if (strstr(commandLine, "-cooktextures"))
+	{
+		TextureCookingCompression compression = TEXTURE_COOKING_COMPRESSION_NONE;
+		if (strstr(commandLine, "-bc7"))
+			compression = TEXTURE_COOKING_COMPRESSION_BC7;
+		else if (strstr(commandLine, "-bc1bc3"))
+			compression = TEXTURE_COOKING_COMPRESSION_BC1_BC3;
+
+		ER_TextureCooker::CookDirectory(ER_Utility::GetFilePath(L"content"), compression);
+		CoUninitialize();
+		return 0;
+	}
+
 	//#if defined(DEBUG) || defined(_DEBUG)
 	//_CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF|_CRTDBG_LEAK_CHECK_DF);
 	//#endif
@@ -0,0 +1,13 @@
+#pragma once
+
+// Empty SAL annotations for the platforms without the Windows SDK (DirectXMath includes "sal.h")
+#define _Analysis_assume_(expr)
+#define _In_
+#define _In_reads_(size)
+#define _In_reads_bytes_(size)
+#define _Out_
+#define _Out_opt_
+#define _Out_writes_(size)
+#define _Out_writes_bytes_(size)
+#define _Success_(expr)
+#define _Use_decl_annotations_
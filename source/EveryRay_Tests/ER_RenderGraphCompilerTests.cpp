@@ -0,0 +1,203 @@
+#include "ER_Tests.h"
+#include "ER_RenderGraphCompiler.h"
+
+#include <algorithm>
+
+using namespace EveryRay_Core;
+
+// stand-ins for ER_RHI_RESOURCE_STATE (the compiler only compares them)
+enum TestResourceState
+{
+	TEST_STATE_RENDER_TARGET = 1,
+	TEST_STATE_SHADER_RESOURCE,
+	TEST_STATE_UNORDERED_ACCESS
+};
+
+static int GetPositionInExecutionOrder(const ER_RenderGraphCompiler& aGraph, int aPassIndex)
+{
+	const std::vector<int>& order = aGraph.GetExecutionOrder();
+	auto it = std::find(order.begin(), order.end(), aPassIndex);
+	return it == order.end() ? -1 : static_cast<int>(it - order.begin());
+}
+
+static bool HasDependency(const ER_RenderGraphCompiler& aGraph, int aPassIndex, int aDependency)
+{
+	const std::vector<int>& dependencies = aGraph.GetPass(aPassIndex).Dependencies;
+	return std::find(dependencies.begin(), dependencies.end(), aDependency) != dependencies.end();
+}
+
+static ER_RenderGraphTextureDesc GetTestTextureDesc(unsigned int aSize)
+{
+	ER_RenderGraphTextureDesc desc;
+	desc.Width = aSize;
+	desc.Height = aSize;
+	desc.Format = 10;
+	desc.BindFlags = 3;
+	return desc;
+}
+
+// Async compute passes are scheduled as early as possible, so only the dependencies can keep them after the graphics passes
+// that were declared before them: that is how we check that every kind of edge is enforced (not just the declaration order).
+static void TestReadAfterWrite()
+{
+	ER_RenderGraphCompiler graph;
+	graph.SetAsyncComputeEnabled(true);
+	const ER_RenderGraphResourceHandle data = graph.CreateVirtualResource("Data");
+	const ER_RenderGraphResourceHandle output = graph.CreateVirtualResource("Output", true);
+
+	const int writer = graph.AddPass("Writer");
+	graph.AddPassAccess(writer, data, TEST_STATE_RENDER_TARGET, false, true);
+	const int reader = graph.AddPass("Reader");
+	graph.SetPassAsyncCompute(reader);
+	graph.AddPassAccess(reader, data, TEST_STATE_SHADER_RESOURCE, true, false);
+	graph.AddPassAccess(reader, output, TEST_STATE_UNORDERED_ACCESS, false, true);
+
+	ER_TEST_CHECK(graph.Compile());
+	ER_TEST_CHECK(HasDependency(graph, reader, writer));
+	ER_TEST_CHECK(graph.GetPass(reader).Producers == std::vector<int>{ writer });
+	ER_TEST_CHECK(GetPositionInExecutionOrder(graph, writer) < GetPositionInExecutionOrder(graph, reader));
+}
+
+static void TestWriteAfterRead()
+{
+	ER_RenderGraphCompiler graph;
+	graph.SetAsyncComputeEnabled(true);
+	const ER_RenderGraphResourceHandle data = graph.CreateVirtualResource("Data", true);
+
+	const int reader = graph.AddPass("Reader");
+	graph.SetPassHasSideEffects(reader);
+	graph.AddPassAccess(reader, data, TEST_STATE_SHADER_RESOURCE, true, false);
+	const int writer = graph.AddPass("Writer");
+	graph.SetPassAsyncCompute(writer);
+	graph.AddPassAccess(writer, data, TEST_STATE_UNORDERED_ACCESS, false, true);
+
+	ER_TEST_CHECK(graph.Compile());
+	ER_TEST_CHECK(HasDependency(graph, writer, reader));
+	ER_TEST_CHECK(graph.GetPass(writer).Producers.empty()); // ordering only, no data
+	ER_TEST_CHECK(GetPositionInExecutionOrder(graph, reader) < GetPositionInExecutionOrder(graph, writer));
+}
+
+static void TestWriteAfterWrite()
+{
+	ER_RenderGraphCompiler graph;
+	graph.SetAsyncComputeEnabled(true);
+	const ER_RenderGraphResourceHandle data = graph.CreateVirtualResource("Data", true);
+
+	const int firstWriter = graph.AddPass("First Writer");
+	graph.AddPassAccess(firstWriter, data, TEST_STATE_RENDER_TARGET, false, true);
+	const int secondWriter = graph.AddPass("Second Writer");
+	graph.SetPassAsyncCompute(secondWriter);
+	graph.AddPassAccess(secondWriter, data, TEST_STATE_UNORDERED_ACCESS, false, true);
+
+	ER_TEST_CHECK(graph.Compile());
+	ER_TEST_CHECK(HasDependency(graph, secondWriter, firstWriter));
+	ER_TEST_CHECK(GetPositionInExecutionOrder(graph, firstWriter) < GetPositionInExecutionOrder(graph, secondWriter));
+}
+
+static void TestCulling()
+{
+	ER_RenderGraphCompiler graph;
+	const ER_RenderGraphResourceHandle used = graph.CreateTexture("Used", GetTestTextureDesc(64));
+	const ER_RenderGraphResourceHandle unused = graph.CreateTexture("Unused", GetTestTextureDesc(64));
+	const ER_RenderGraphResourceHandle output = graph.CreateVirtualResource("Output", true);
+
+	const int producer = graph.AddPass("Producer");
+	graph.AddPassAccess(producer, used, TEST_STATE_RENDER_TARGET, false, true);
+	const int deadProducer = graph.AddPass("Dead Producer");
+	graph.AddPassAccess(deadProducer, unused, TEST_STATE_RENDER_TARGET, false, true);
+	const int consumer = graph.AddPass("Consumer");
+	graph.AddPassAccess(consumer, used, TEST_STATE_SHADER_RESOURCE, true, false);
+	graph.AddPassAccess(consumer, output, TEST_STATE_RENDER_TARGET, false, true);
+	const int sideEffects = graph.AddPass("Side Effects");
+	graph.SetPassHasSideEffects(sideEffects);
+
+	ER_TEST_CHECK(graph.Compile());
+	ER_TEST_CHECK(!graph.GetPass(producer).IsCulled);
+	ER_TEST_CHECK(graph.GetPass(deadProducer).IsCulled);
+	ER_TEST_CHECK(!graph.GetPass(consumer).IsCulled);
+	ER_TEST_CHECK(!graph.GetPass(sideEffects).IsCulled);
+	ER_TEST_CHECK(graph.GetCulledPassesCount() == 1);
+	ER_TEST_CHECK(GetPositionInExecutionOrder(graph, deadProducer) == -1);
+	ER_TEST_CHECK(graph.GetResourceInfo(unused).PhysicalIndex == -1); // never allocated
+}
+
+static void TestAliasing()
+{
+	ER_RenderGraphCompiler graph;
+	const ER_RenderGraphResourceHandle first = graph.CreateTexture("First", GetTestTextureDesc(128));
+	const ER_RenderGraphResourceHandle second = graph.CreateTexture("Second", GetTestTextureDesc(128));
+	const ER_RenderGraphResourceHandle overlapping = graph.CreateTexture("Overlapping", GetTestTextureDesc(128));
+	const ER_RenderGraphResourceHandle otherSize = graph.CreateTexture("Other Size", GetTestTextureDesc(256));
+	const ER_RenderGraphResourceHandle output = graph.CreateVirtualResource("Output", true);
+
+	// "First" dies before "Second" is written, "Overlapping" is alive during both of them
+	const int writeFirst = graph.AddPass("Write First");
+	graph.AddPassAccess(writeFirst, first, TEST_STATE_RENDER_TARGET, false, true);
+	graph.AddPassAccess(writeFirst, overlapping, TEST_STATE_RENDER_TARGET, false, true);
+	const int readFirst = graph.AddPass("Read First");
+	graph.AddPassAccess(readFirst, first, TEST_STATE_SHADER_RESOURCE, true, false);
+	graph.AddPassAccess(readFirst, output, TEST_STATE_RENDER_TARGET, true, true);
+	const int writeSecond = graph.AddPass("Write Second");
+	graph.AddPassAccess(writeSecond, second, TEST_STATE_RENDER_TARGET, false, true);
+	graph.AddPassAccess(writeSecond, otherSize, TEST_STATE_RENDER_TARGET, false, true);
+	const int readSecond = graph.AddPass("Read Second");
+	graph.AddPassAccess(readSecond, second, TEST_STATE_SHADER_RESOURCE, true, false);
+	graph.AddPassAccess(readSecond, overlapping, TEST_STATE_SHADER_RESOURCE, true, false);
+	graph.AddPassAccess(readSecond, otherSize, TEST_STATE_SHADER_RESOURCE, true, false);
+	graph.AddPassAccess(readSecond, output, TEST_STATE_RENDER_TARGET, true, true);
+
+	ER_TEST_CHECK(graph.Compile());
+	ER_TEST_CHECK(graph.GetCulledPassesCount() == 0);
+	ER_TEST_CHECK(graph.GetResourceInfo(first).PhysicalIndex == graph.GetResourceInfo(second).PhysicalIndex);
+	ER_TEST_CHECK(graph.GetResourceInfo(overlapping).PhysicalIndex != graph.GetResourceInfo(first).PhysicalIndex);
+	ER_TEST_CHECK(graph.GetResourceInfo(otherSize).PhysicalIndex != graph.GetResourceInfo(first).PhysicalIndex);
+	ER_TEST_CHECK(graph.GetResourceInfo(otherSize).PhysicalIndex != graph.GetResourceInfo(overlapping).PhysicalIndex);
+	ER_TEST_CHECK(graph.GetPhysicalTexturesCount() == 3);
+}
+
+static void TestBatchedTransitions()
+{
+	ER_RenderGraphCompiler graph;
+	const ER_RenderGraphResourceHandle texture = graph.CreateTexture("Texture", GetTestTextureDesc(64));
+	const ER_RenderGraphResourceHandle output = graph.CreateVirtualResource("Output", true);
+
+	const int write = graph.AddPass("Write");
+	graph.AddPassAccess(write, texture, TEST_STATE_RENDER_TARGET, false, true);
+	const int blend = graph.AddPass("Blend");
+	graph.AddPassAccess(blend, texture, TEST_STATE_RENDER_TARGET, true, true); // same state: no transition
+	const int read = graph.AddPass("Read");
+	graph.AddPassAccess(read, texture, TEST_STATE_SHADER_RESOURCE, true, false);
+	graph.AddPassAccess(read, output, TEST_STATE_RENDER_TARGET, false, true);
+
+	ER_TEST_CHECK(graph.Compile());
+	ER_TEST_CHECK(graph.GetPass(write).Transitions.size() == 1);
+	ER_TEST_CHECK(graph.GetPass(blend).Transitions.empty());
+	ER_TEST_CHECK(graph.GetPass(read).Transitions.size() == 1); // virtual resources are never transitioned
+	ER_TEST_CHECK(graph.GetPass(read).Transitions[0].State == TEST_STATE_SHADER_RESOURCE);
+	ER_TEST_CHECK(graph.GetTransitionsCount() == 2);
+}
+
+static void TestReadBeforeWriteMessage()
+{
+	ER_RenderGraphCompiler graph;
+	const ER_RenderGraphResourceHandle texture = graph.CreateTexture("Never Written", GetTestTextureDesc(64));
+
+	const int read = graph.AddPass("Read");
+	graph.SetPassHasSideEffects(read);
+	graph.AddPassAccess(read, texture, TEST_STATE_SHADER_RESOURCE, true, false);
+
+	ER_TEST_CHECK(graph.Compile());
+	ER_TEST_CHECK(graph.GetCompileMessages().size() == 1);
+}
+
+int main()
+{
+	ER_TEST_RUN(TestReadAfterWrite);
+	ER_TEST_RUN(TestWriteAfterRead);
+	ER_TEST_RUN(TestWriteAfterWrite);
+	ER_TEST_RUN(TestCulling);
+	ER_TEST_RUN(TestAliasing);
+	ER_TEST_RUN(TestBatchedTransitions);
+	ER_TEST_RUN(TestReadBeforeWriteMessage);
+	return ER_TEST_RESULT();
+}
@@ -0,0 +1,120 @@
+#include "ER_Tests.h"
+#include "ER_SceneDescription.h"
+
+#include <chrono>
+#include <fstream>
+#include <iterator>
+
+#define SCENE_PARSE_ITERATIONS 20
+
+using namespace EveryRay_Core;
+
+static std::string GetLevelPath(const std::string& aSceneName)
+{
+	return std::string(ER_CONTENT_DIR) + "/levels/" + aSceneName + "/" + aSceneName + ".json";
+}
+
+// cached nodes have to be the elements of their sections (in order)
+static bool AreNodesResolved(const ER_SceneDescription& aDescription, const char* aSectionName, const std::vector<const Json::Value*>& aNodes)
+{
+	const Json::Value& section = aDescription.Root[aSectionName];
+	if (!section.isArray())
+		return aNodes.empty();
+	if (aNodes.size() != section.size())
+		return false;
+
+	for (Json::Value::ArrayIndex i = 0; i != section.size(); i++)
+	{
+		if (aNodes[i] != &section[i])
+			return false;
+	}
+	return true;
+}
+
+static void TestBundledScenes()
+{
+	const char* sceneNames[] = { "testScene", "testScene_simple", "sponzaScene", "terrainScene" };
+	for (const char* sceneName : sceneNames)
+	{
+		ER_SceneDescription description;
+		std::string errors;
+		ER_TEST_CHECK(description.LoadFromFile(GetLevelPath(sceneName), errors));
+		ER_TEST_CHECK(errors.empty());
+		ER_TEST_CHECK(AreNodesResolved(description, "rendering_objects", description.RenderingObjects));
+		ER_TEST_CHECK(AreNodesResolved(description, "point_lights", description.PointLights));
+		ER_TEST_CHECK(AreNodesResolved(description, "foliage_zones", description.FoliageZones));
+		ER_TEST_CHECK(AreNodesResolved(description, "posteffects_volumes", description.PostEffectsVolumes));
+	}
+}
+
+static void TestSceneNodesCounts()
+{
+	ER_SceneDescription description;
+	std::string errors;
+	ER_TEST_CHECK(description.LoadFromFile(GetLevelPath("testScene"), errors));
+
+	// content/levels/testScene/testScene.json
+	ER_TEST_CHECK(description.RenderingObjects.size() == 79);
+	ER_TEST_CHECK(description.PointLights.size() == 3);
+	ER_TEST_CHECK(description.FoliageZones.size() == 9);
+	ER_TEST_CHECK(description.PostEffectsVolumes.size() == 3);
+	for (int i = 0; i < static_cast<int>(description.RenderingObjects.size()); i++)
+		ER_TEST_CHECK(description.GetRenderingObject(i).isMember("name") && description.GetRenderingObject(i).isMember("model_path"));
+}
+
+static void TestInvalidScene()
+{
+	const std::string content = "{ \"rendering_objects\": [ { \"name\": \"Broken\" ";
+
+	ER_SceneDescription description;
+	std::string errors;
+	ER_TEST_CHECK(!description.Parse(content.data(), content.data() + content.size(), errors));
+	ER_TEST_CHECK(!errors.empty());
+	ER_TEST_CHECK(description.RenderingObjects.empty());
+
+	ER_TEST_CHECK(!description.LoadFromFile(GetLevelPath("missingScene"), errors));
+}
+
+static void TestResolveAfterChanges()
+{
+	const std::string content = "{ \"point_lights\": [ { \"color\": [1, 1, 1, 1] } ] }";
+
+	ER_SceneDescription description;
+	std::string errors;
+	ER_TEST_CHECK(description.Parse(content.data(), content.data() + content.size(), errors));
+	ER_TEST_CHECK(description.PointLights.size() == 1);
+	ER_TEST_CHECK(description.RenderingObjects.empty());
+
+	description.Root["point_lights"].append(Json::Value(Json::objectValue));
+	description.Root["rendering_objects"].append(Json::Value(Json::objectValue));
+	description.ResolveNodes();
+	ER_TEST_CHECK(AreNodesResolved(description, "point_lights", description.PointLights) && description.PointLights.size() == 2);
+	ER_TEST_CHECK(AreNodesResolved(description, "rendering_objects", description.RenderingObjects) && description.RenderingObjects.size() == 1);
+}
+
+// not a check: prints the parse time of the biggest bundled scene (from memory, so the disk is not measured)
+static void MeasureParseTime()
+{
+	std::ifstream file(GetLevelPath("testScene").c_str(), std::ifstream::binary);
+	const std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	ER_SceneDescription description;
+	std::string errors;
+	const auto start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < SCENE_PARSE_ITERATIONS; i++)
+		ER_TEST_CHECK(description.Parse(content.data(), content.data() + content.size(), errors));
+	const auto end = std::chrono::high_resolution_clock::now();
+
+	std::printf("testScene.json (%d KB): %.3f ms per parse\n", static_cast<int>(content.size() / 1024),
+		std::chrono::duration<double, std::milli>(end - start).count() / SCENE_PARSE_ITERATIONS);
+}
+
+int main()
+{
+	ER_TEST_RUN(TestBundledScenes);
+	ER_TEST_RUN(TestSceneNodesCounts);
+	ER_TEST_RUN(TestInvalidScene);
+	ER_TEST_RUN(TestResolveAfterChanges);
+	ER_TEST_RUN(MeasureParseTime);
+	return ER_TEST_RESULT();
+}
@@ -0,0 +1,89 @@
+#include "ER_SoftwareOcclusionCuller.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+
+using namespace EveryRay_Core;
+
+#define BENCHMARK_OCCLUDERS_COUNT 2000 // boxes of 12 triangles
+#define BENCHMARK_TESTED_BOXES_COUNT 100000
+#define BENCHMARK_ITERATIONS 20
+
+// Rasterization (single and multithreaded) and AABB tests of a city-like scene: random boxes in front of the camera
+static void GetBoxGeometry(std::vector<XMFLOAT3>& outVertices, std::vector<unsigned int>& outIndices)
+{
+	outVertices.clear();
+	for (int i = 0; i < 8; i++)
+		outVertices.push_back(XMFLOAT3((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f));
+	outIndices = { 0, 1, 3, 0, 3, 2, 4, 6, 7, 4, 7, 5, 0, 4, 5, 0, 5, 1, 2, 3, 7, 2, 7, 6, 0, 2, 6, 0, 6, 4, 1, 5, 7, 1, 7, 3 };
+}
+
+template<typename Func>
+static double MeasureMilliseconds(const Func& aFunc)
+{
+	const auto start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < BENCHMARK_ITERATIONS; i++)
+		aFunc();
+	const auto end = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double, std::milli>(end - start).count() / BENCHMARK_ITERATIONS;
+}
+
+int main()
+{
+	const XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(0.0f, 10.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 10.0f, 1.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+	const XMMATRIX projection = XMMatrixPerspectiveFovLH(XM_PIDIV4, static_cast<float>(SOFTWARE_OCCLUSION_WIDTH) / SOFTWARE_OCCLUSION_HEIGHT, 0.1f, 1000.0f);
+	const XMMATRIX viewProjection = view * projection;
+
+	std::mt19937 random(42);
+	std::uniform_real_distribution<float> positionX(-300.0f, 300.0f);
+	std::uniform_real_distribution<float> positionZ(20.0f, 600.0f);
+	std::uniform_real_distribution<float> size(2.0f, 15.0f);
+
+	std::vector<XMFLOAT3> vertices;
+	std::vector<unsigned int> indices;
+	GetBoxGeometry(vertices, indices);
+
+	std::vector<XMFLOAT4X4> occludersWorlds(BENCHMARK_OCCLUDERS_COUNT);
+	for (XMFLOAT4X4& world : occludersWorlds)
+	{
+		const float height = size(random) * 2.0f;
+		XMStoreFloat4x4(&world, XMMatrixScaling(size(random), height, size(random)) * XMMatrixTranslation(positionX(random), height, positionZ(random)));
+	}
+
+	std::vector<ER_AABB> testedBoxes(BENCHMARK_TESTED_BOXES_COUNT);
+	for (ER_AABB& box : testedBoxes)
+	{
+		const XMFLOAT3 center(positionX(random), 1.0f, positionZ(random));
+		box = ER_AABB(XMFLOAT3(center.x - 1.0f, center.y - 1.0f, center.z - 1.0f), XMFLOAT3(center.x + 1.0f, center.y + 1.0f, center.z + 1.0f));
+	}
+
+	ER_SoftwareOcclusionCuller culler;
+	auto addOccluders = [&]()
+	{
+		culler.BeginFrame(viewProjection);
+		for (const XMFLOAT4X4& world : occludersWorlds)
+			culler.AddOccluder(vertices, indices, XMLoadFloat4x4(&world));
+	};
+
+	const double setupTime = MeasureMilliseconds([&]() { addOccluders(); });
+	const double singleThreadedTime = MeasureMilliseconds([&]() { addOccluders(); culler.Rasterize(1); }) - setupTime;
+	const int threadsCount = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+	const double multiThreadedTime = MeasureMilliseconds([&]() { addOccluders(); culler.Rasterize(threadsCount); }) - setupTime;
+
+	int occludedCount = 0;
+	const double testTime = MeasureMilliseconds([&]()
+	{
+		occludedCount = 0;
+		for (const ER_AABB& box : testedBoxes)
+			occludedCount += culler.IsOccluded(box) ? 1 : 0;
+	});
+
+	std::printf("Occluders: %d (%d triangles after clipping)\n", BENCHMARK_OCCLUDERS_COUNT, culler.GetTrianglesCount());
+	std::printf("Transform, clip and bin: %.3f ms\n", setupTime);
+	std::printf("Rasterize (1 thread): %.3f ms\n", singleThreadedTime);
+	std::printf("Rasterize (%d threads): %.3f ms\n", threadsCount, multiThreadedTime);
+	std::printf("Test %d boxes: %.3f ms (%d occluded)\n", BENCHMARK_TESTED_BOXES_COUNT, testTime, occludedCount);
+	return 0;
+}
@@ -0,0 +1,111 @@
+#include "ER_Tests.h"
+#include "ER_SoftwareOcclusionCuller.h"
+
+using namespace EveryRay_Core;
+
+// camera is at the origin and looks along +Z
+static XMMATRIX GetTestViewProjection()
+{
+	const XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 0.0f, 1.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+	const XMMATRIX projection = XMMatrixPerspectiveFovLH(XM_PIDIV4, static_cast<float>(SOFTWARE_OCCLUSION_WIDTH) / SOFTWARE_OCCLUSION_HEIGHT, 0.1f, 500.0f);
+	return view * projection;
+}
+
+// quad of 2x2 facing the camera (at z = 0 in its local space)
+static void GetQuadGeometry(std::vector<XMFLOAT3>& outVertices, std::vector<unsigned int>& outIndices)
+{
+	outVertices = { XMFLOAT3(-1.0f, -1.0f, 0.0f), XMFLOAT3(-1.0f, 1.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 0.0f), XMFLOAT3(1.0f, -1.0f, 0.0f) };
+	outIndices = { 0, 1, 2, 0, 2, 3 };
+}
+
+static ER_AABB GetBox(const XMFLOAT3& aCenter, float aHalfSize)
+{
+	return ER_AABB(XMFLOAT3(aCenter.x - aHalfSize, aCenter.y - aHalfSize, aCenter.z - aHalfSize), XMFLOAT3(aCenter.x + aHalfSize, aCenter.y + aHalfSize, aCenter.z + aHalfSize));
+}
+
+static void RasterizeWall(ER_SoftwareOcclusionCuller& aCuller, int aThreadsCount)
+{
+	std::vector<XMFLOAT3> vertices;
+	std::vector<unsigned int> indices;
+	GetQuadGeometry(vertices, indices);
+
+	// 10x10 wall at z = 10
+	aCuller.BeginFrame(GetTestViewProjection());
+	aCuller.AddOccluder(vertices, indices, XMMatrixScaling(5.0f, 5.0f, 1.0f) * XMMatrixTranslation(0.0f, 0.0f, 10.0f));
+	aCuller.Rasterize(aThreadsCount);
+}
+
+static void TestNotReadyBeforeRasterize()
+{
+	ER_SoftwareOcclusionCuller culler;
+	ER_TEST_CHECK(!culler.IsReady());
+	ER_TEST_CHECK(!culler.IsOccluded(GetBox(XMFLOAT3(0.0f, 0.0f, 20.0f), 1.0f)));
+}
+
+static void TestBoxBehindOccluder()
+{
+	ER_SoftwareOcclusionCuller culler;
+	RasterizeWall(culler, 1);
+
+	ER_TEST_CHECK(culler.IsReady());
+	ER_TEST_CHECK(culler.GetTrianglesCount() == 2);
+	ER_TEST_CHECK(culler.IsOccluded(GetBox(XMFLOAT3(0.0f, 0.0f, 20.0f), 1.0f)));
+	ER_TEST_CHECK(culler.IsOccluded(GetBox(XMFLOAT3(2.0f, -2.0f, 50.0f), 3.0f)));
+}
+
+static void TestBoxInFrontOfOccluder()
+{
+	ER_SoftwareOcclusionCuller culler;
+	RasterizeWall(culler, 1);
+
+	ER_TEST_CHECK(!culler.IsOccluded(GetBox(XMFLOAT3(0.0f, 0.0f, 5.0f), 1.0f)));
+	ER_TEST_CHECK(!culler.IsOccluded(GetBox(XMFLOAT3(0.0f, 0.0f, 10.0f), 1.0f))); // intersects the occluder
+}
+
+static void TestBoxOutsideOfOccluder()
+{
+	ER_SoftwareOcclusionCuller culler;
+	RasterizeWall(culler, 1);
+
+	ER_TEST_CHECK(!culler.IsOccluded(GetBox(XMFLOAT3(15.0f, 0.0f, 20.0f), 1.0f))); // next to the wall
+	ER_TEST_CHECK(!culler.IsOccluded(GetBox(XMFLOAT3(10.0f, 0.0f, 20.0f), 1.0f))); // only partially behind the wall
+	ER_TEST_CHECK(!culler.IsOccluded(GetBox(XMFLOAT3(0.0f, 0.0f, 20.0f), 15.0f))); // bigger than the wall
+}
+
+static void TestOccluderCrossingNearPlane()
+{
+	std::vector<XMFLOAT3> vertices;
+	std::vector<unsigned int> indices;
+	GetQuadGeometry(vertices, indices);
+
+	// floor that starts behind the camera: it is clipped, not dropped
+	ER_SoftwareOcclusionCuller culler;
+	culler.BeginFrame(GetTestViewProjection());
+	culler.AddOccluder(vertices, indices, XMMatrixScaling(50.0f, 50.0f, 1.0f) * XMMatrixRotationX(XM_PIDIV2) * XMMatrixTranslation(0.0f, -1.0f, 40.0f));
+	culler.Rasterize(1);
+
+	ER_TEST_CHECK(culler.GetTrianglesCount() > 0);
+	ER_TEST_CHECK(culler.IsOccluded(GetBox(XMFLOAT3(0.0f, -5.0f, 20.0f), 1.0f))); // under the floor
+	ER_TEST_CHECK(!culler.IsOccluded(GetBox(XMFLOAT3(0.0f, 2.0f, 20.0f), 1.0f))); // above the floor
+}
+
+static void TestMultithreadedRasterization()
+{
+	ER_SoftwareOcclusionCuller singleThreaded;
+	ER_SoftwareOcclusionCuller multiThreaded;
+	RasterizeWall(singleThreaded, 1);
+	RasterizeWall(multiThreaded, 4);
+
+	ER_TEST_CHECK(singleThreaded.GetDepth() == multiThreaded.GetDepth());
+}
+
+int main()
+{
+	ER_TEST_RUN(TestNotReadyBeforeRasterize);
+	ER_TEST_RUN(TestBoxBehindOccluder);
+	ER_TEST_RUN(TestBoxInFrontOfOccluder);
+	ER_TEST_RUN(TestBoxOutsideOfOccluder);
+	ER_TEST_RUN(TestOccluderCrossingNearPlane);
+	ER_TEST_RUN(TestMultithreadedRasterization);
+	return ER_TEST_RESULT();
+}
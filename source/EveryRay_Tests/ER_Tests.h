@@ -0,0 +1,25 @@
+#pragma once
+#include <cstdio>
+
+// Minimal checks for the headless tests of the engine's portable parts (every test is a separate executable registered in CTest)
+static int gFailedChecksCount = 0;
+
+#define ER_TEST_CHECK(condition) \
+	do \
+	{ \
+		if (!(condition)) \
+		{ \
+			std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+			gFailedChecksCount++; \
+		} \
+	} while (0)
+
+#define ER_TEST_RUN(testFunc) \
+	do \
+	{ \
+		const int failedChecksBefore = gFailedChecksCount; \
+		testFunc(); \
+		std::printf("[%s] %s\n", gFailedChecksCount == failedChecksBefore ? "PASSED" : "FAILED", #testFunc); \
+	} while (0)
+
+#define ER_TEST_RESULT() (gFailedChecksCount == 0 ? 0 : 1)